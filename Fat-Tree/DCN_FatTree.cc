@@ -4,38 +4,41 @@
  * ============================================================================
  * 
  * 描述:
- *   本程序实现了一个 k=4 的 Fat-Tree 数据中心网络架构，包含:
- *   - 16 台服务器 (分布在 4 个 Pod 中，每个 Pod 4 台)
- *   - 16 个接入/汇聚层交换机 (每个 Pod 4 个交换机)
- *   - 4 个核心层交换机
+ *   本程序实现了一个参数化的 k-ary Fat-Tree 数据中心网络架构 (默认 k=4)，包含:
+ *   - k^3/4 台服务器 (分布在 k 个 Pod 中，每个 Pod (k/2)^2 台)
+ *   - k^2 个接入/汇聚层交换机 (每个 Pod k 个交换机)
+ *   - (k/2)^2 个核心层交换机
  *   
  *   功能特性:
  *   - 使用 ECMP (等价多路径) 路由实现负载均衡
- *   - 支持 UDP 和 TCP 流量测试
+ *   - 支持 UDP 和 TCP 流量测试，可选全网置换 (permutation) 流量
  *   - 生成 FlowMonitor 统计数据 (吞吐量、延迟、丢包率等)
  *   - 生成 NetAnim 可视化动画文件
  *   - 捕获 PCAP 数据包用于 Wireshark 分析
+ *   - 支持 MPI 分布式仿真: 按 Pod 划分到各进程 (rank)，汇聚-核心链路为跨进程边界
+ *   - 支持无 MPI 的单机并行仿真 (--partitions): 按 Pod 划分为多个进程，经共享内存同步
+ *   - 可选事件调度器 (--scheduler)，包括基数堆调度器和按前缀试跑的自动选择
  *
  * IP 地址分配规则:
- *   - Pod 内链路: 10.PodID.SubnetID.0/30
- *     例如: Pod 0 使用 10.0.0.0/30 ~ 10.0.7.0/30
- *   - 核心层链路: 10.10.SubnetID.0/30
- *     例如: 10.10.0.0/30 ~ 10.10.15.0/30
+ *   - Pod 内链路: 10.PodID.(i%256).((i/256)*4)/30，i 为 Pod 内链路序号
+ *     例如: k=4 时 Pod 0 使用 10.0.0.0/30 ~ 10.0.7.0/30
+ *   - 核心层链路: 10.max(10,k).(j%256).((j/256)*4)/30，j 为核心链路序号
+ *     例如: k=4 时使用 10.10.0.0/30 ~ 10.10.15.0/30
  *
  * 拓扑结构:
- *   每个 Pod 包含:
- *     - 4 台服务器 (节点 0-3)
- *     - 2 个接入层交换机 (节点 4-5)
- *     - 2 个汇聚层交换机 (节点 6-7)
+ *   每个 Pod 包含 (k=4 时括号内为节点编号):
+ *     - (k/2)^2 台服务器 (节点 0-3)
+ *     - k/2 个接入层交换机 (节点 4-5)
+ *     - k/2 个汇聚层交换机 (节点 6-7)
  *   
  *   连接关系:
- *     - 每个接入交换机连接 2 台服务器
- *     - 接入交换机与汇聚交换机全连接 (2x2=4 条链路)
- *     - 每个汇聚交换机连接所有核心交换机 (2x4=8 条链路/Pod)
+ *     - 每个接入交换机连接 k/2 台服务器
+ *     - 接入交换机与汇聚交换机全连接 ((k/2)^2 条链路)
+ *     - 第 a 个汇聚交换机连接核心交换机 a*(k/2) ~ a*(k/2)+k/2-1
  *
  * 原作者: Amit Khandu Bhalerao (2016-12-17)
  * 修改者: [Liu Mengxuan] (2025-11-09)
- * 版本: 2.0
+ * 版本: 2.1
  * ns-3 版本: 3.44
  * ============================================================================
  */
@@ -54,6 +57,22 @@
 #include "ns3/netanim-module.h"           // NetAnim 动画生成
 #include "ns3/ipv4-global-routing-helper.h" // 全局路由助手 (ECMP)
 #include "ns3/flow-monitor-helper.h"      // 流量监控助手
+#ifdef NS3_MPI
+#include "ns3/mpi-interface.h"            // MPI 分布式仿真 (需 --enable-mpi 编译)
+#endif
+#include "fat-tree-shm-simulator-impl.h" // 单机共享内存并行仿真
+#include "fat-tree-scheduler.h"           // 事件调度器选择与基数堆调度器
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cmath>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <set>
+#include <tuple>
+#include <vector>
 
 using namespace ns3;
 using namespace std;
@@ -61,6 +80,267 @@ using namespace std;
 // 定义日志组件，用于调试输出
 NS_LOG_COMPONENT_DEFINE("DCN_FatTree_Simulation");
 
+// ============================================================================
+// 辅助函数
+// ============================================================================
+
+// 第 index 条 /30 链路的网络地址: 10.second.(index%256).((index/256)*4)
+// index < 256 时与原始方案 (10.second.index.0/30) 完全一致，
+// 之后在第四个八位组中继续按 /30 递增，最多容纳 64*256 条链路
+static Ipv4Address
+LinkSubnet(uint32_t second, uint32_t index)
+{
+	NS_ABORT_MSG_IF(index >= 64 * 256, "Too many /30 links in 10." << second << ".0.0/16");
+	return Ipv4Address((10u << 24) | (second << 16) | ((index % 256) << 8) | ((index / 256) * 4));
+}
+
+// 一条数据流的统计 (按五元组汇总)
+// 发送端和接收端各自记录自己的一半 (见 DataFlowRecorder)，共享内存并行时跨分区的流的
+// 两半落在两个进程中，按五元组合并即可还原整条流
+struct DataFlowRecord
+{
+	uint64_t txPackets = 0;
+	uint64_t rxPackets = 0;
+	uint64_t rxBytes = 0;
+	int64_t delaySumNs = 0;
+	int64_t firstTxNs = -1; // 第一个包的发送时间，-1 表示本进程没有发送记录
+	int64_t lastRxNs = -1;  // 最后一个包的到达时间，-1 表示本进程没有接收记录
+};
+
+// 五元组: 源地址、目的地址、协议、源端口、目的端口
+typedef std::tuple<uint32_t, uint32_t, uint32_t, uint32_t, uint32_t> FlowTuple;
+typedef std::map<FlowTuple, DataFlowRecord> DataFlowTable;
+
+// 把 rec 合并进 table[key]: 计数相加，首发时间取最早，末收时间取最晚
+static void
+MergeDataFlow(DataFlowTable &table, const FlowTuple &key, const DataFlowRecord &rec)
+{
+	DataFlowRecord &dst = table[key];
+	dst.txPackets += rec.txPackets;
+	dst.rxPackets += rec.rxPackets;
+	dst.rxBytes += rec.rxBytes;
+	dst.delaySumNs += rec.delaySumNs;
+	if (rec.firstTxNs >= 0 && (dst.firstTxNs < 0 || rec.firstTxNs < dst.firstTxNs))
+	{
+		dst.firstTxNs = rec.firstTxNs;
+	}
+	dst.lastRxNs = std::max(dst.lastRxNs, rec.lastRxNs);
+}
+
+// 数据包发送时间的字节标签 (纳秒)
+// 字节标签随数据包一起序列化，经共享内存或 MPI 跨分区传递后接收端仍能算出时延
+class DataFlowTxTag : public Tag
+{
+public:
+	static TypeId GetTypeId()
+	{
+		static TypeId tid = TypeId("DataFlowTxTag").SetParent<Tag>().AddConstructor<DataFlowTxTag>();
+		return tid;
+	}
+	TypeId GetInstanceTypeId() const override { return GetTypeId(); }
+	uint32_t GetSerializedSize() const override { return 8; }
+	void Serialize(TagBuffer buf) const override { buf.WriteU64(static_cast<uint64_t>(m_txNs)); }
+	void Deserialize(TagBuffer buf) override { m_txNs = static_cast<int64_t>(buf.ReadU64()); }
+	void Print(std::ostream &os) const override { os << "txNs=" << m_txNs; }
+
+	int64_t m_txNs = 0;
+};
+
+NS_OBJECT_ENSURE_REGISTERED(DataFlowTxTag);
+
+// 按五元组记录服务器上的数据流，只保留目的端口在 dataPorts 中的流 (应用数据方向)，
+// TCP ACK 的反向流不计入 FCT
+// FlowMonitor 按进程分配流编号、只认本进程记录过发送的包，跨分区的流在接收端进程里
+// 收不到任何记录；这里在 IP 层的 SendOutgoing 记发送 (并打上发送时间标签)，
+// 在 LocalDeliver 记接收，两半都只依赖五元组，各进程分别记录本地节点上发生的一半
+class DataFlowRecorder
+{
+public:
+	explicit DataFlowRecorder(const std::set<uint16_t> &dataPorts) : m_dataPorts(dataPorts) {}
+
+	// 在服务器的 IPv4 协议栈上挂接发送和接收 trace
+	void Install(Ptr<Node> server)
+	{
+		Ptr<Ipv4L3Protocol> ipv4 = server->GetObject<Ipv4L3Protocol>();
+		ipv4->TraceConnectWithoutContext("SendOutgoing", MakeCallback(&DataFlowRecorder::SendOutgoing, this));
+		ipv4->TraceConnectWithoutContext("LocalDeliver", MakeCallback(&DataFlowRecorder::LocalDeliver, this));
+	}
+
+	const DataFlowTable &GetFlows() const { return m_flows; }
+
+private:
+	// 从 IP 头和 L4 报文中取出五元组，不是 dataPorts 中的数据流时返回 false
+	bool GetKey(const Ipv4Header &ipHeader, Ptr<const Packet> packet, FlowTuple &key) const
+	{
+		uint16_t sport, dport;
+		if (ipHeader.GetProtocol() == TcpL4Protocol::PROT_NUMBER)
+		{
+			TcpHeader tcp;
+			packet->PeekHeader(tcp);
+			sport = tcp.GetSourcePort();
+			dport = tcp.GetDestinationPort();
+		}
+		else if (ipHeader.GetProtocol() == UdpL4Protocol::PROT_NUMBER)
+		{
+			UdpHeader udp;
+			packet->PeekHeader(udp);
+			sport = udp.GetSourcePort();
+			dport = udp.GetDestinationPort();
+		}
+		else
+		{
+			return false;
+		}
+		if (m_dataPorts.count(dport) == 0)
+		{
+			return false;
+		}
+		key = FlowTuple(ipHeader.GetSource().Get(), ipHeader.GetDestination().Get(), ipHeader.GetProtocol(),
+		                sport, dport);
+		return true;
+	}
+
+	void SendOutgoing(const Ipv4Header &ipHeader, Ptr<const Packet> packet, uint32_t /* interface */)
+	{
+		FlowTuple key;
+		if (!GetKey(ipHeader, packet, key))
+		{
+			return;
+		}
+		DataFlowTxTag tag;
+		tag.m_txNs = Simulator::Now().GetNanoSeconds();
+		packet->AddByteTag(tag);
+		DataFlowRecord &rec = m_flows[key];
+		++rec.txPackets;
+		if (rec.firstTxNs < 0)
+		{
+			rec.firstTxNs = tag.m_txNs;
+		}
+	}
+
+	void LocalDeliver(const Ipv4Header &ipHeader, Ptr<const Packet> packet, uint32_t /* interface */)
+	{
+		FlowTuple key;
+		if (!GetKey(ipHeader, packet, key))
+		{
+			return;
+		}
+		// 与 FlowMonitor 相同，接收字节数包含 IP 头
+		int64_t now = Simulator::Now().GetNanoSeconds();
+		DataFlowRecord &rec = m_flows[key];
+		++rec.rxPackets;
+		rec.rxBytes += packet->GetSize() + ipHeader.GetSerializedSize();
+		DataFlowTxTag tag;
+		if (packet->FindFirstMatchingByteTag(tag))
+		{
+			rec.delaySumNs += now - tag.m_txNs;
+		}
+		rec.lastRxNs = now;
+	}
+
+	std::set<uint16_t> m_dataPorts;
+	DataFlowTable m_flows;
+};
+
+// 分区进程的中间文件: 第一行 "events N"，之后每条流一行 (五元组 + DataFlowRecord)
+static bool
+WriteDataFlows(const std::string &path, const DataFlowTable &table, uint64_t events)
+{
+	std::ofstream out(path);
+	if (!out)
+	{
+		return false;
+	}
+	out << "events " << events << "\n";
+	for (const auto &[key, rec] : table)
+	{
+		out << std::get<0>(key) << " " << std::get<1>(key) << " " << std::get<2>(key) << " "
+		    << std::get<3>(key) << " " << std::get<4>(key) << " " << rec.txPackets << " "
+		    << rec.rxPackets << " " << rec.rxBytes << " " << rec.delaySumNs << " " << rec.firstTxNs
+		    << " " << rec.lastRxNs << "\n";
+	}
+	return static_cast<bool>(out);
+}
+
+// 读取 WriteDataFlows 写出的文件并合并进 table，事件数累加到 events
+static bool
+ReadDataFlows(const std::string &path, DataFlowTable &table, uint64_t &events)
+{
+	std::ifstream in(path);
+	std::string tag;
+	uint64_t n = 0;
+	if (!(in >> tag >> n) || tag != "events")
+	{
+		return false;
+	}
+	events += n;
+	uint32_t src, dst, proto, sport, dport;
+	DataFlowRecord rec;
+	while (in >> src >> dst >> proto >> sport >> dport >> rec.txPackets >> rec.rxPackets >> rec.rxBytes
+	       >> rec.delaySumNs >> rec.firstTxNs >> rec.lastRxNs)
+	{
+		MergeDataFlow(table, FlowTuple(src, dst, proto, sport, dport), rec);
+	}
+	return in.eof();
+}
+
+// 把本次运行的汇总指标写成 name=value 行，供参数扫描/重复实验脚本合并
+// lostPackets = 发送但在仿真结束时仍未收到的包数 (应用在 10 s 停止，仿真在 11 s 结束)
+// FCT (流完成时间) = 最后一个包到达时间 - 第一个包发送时间，只统计收到过数据的流
+static bool
+WriteRunSummary(const std::string &path, const DataFlowTable &table, uint64_t events, double wallSeconds)
+{
+	uint64_t txPackets = 0, rxPackets = 0, lostPackets = 0, rxBytes = 0;
+	double delaySum = 0.0;
+	std::vector<double> fcts;
+	for (const auto &[key, rec] : table)
+	{
+		txPackets += rec.txPackets;
+		rxPackets += rec.rxPackets;
+		lostPackets += rec.txPackets > rec.rxPackets ? rec.txPackets - rec.rxPackets : 0;
+		rxBytes += rec.rxBytes;
+		delaySum += rec.delaySumNs * 1e-9;
+		if (rec.rxPackets > 0 && rec.firstTxNs >= 0)
+		{
+			fcts.push_back((rec.lastRxNs - rec.firstTxNs) * 1e-9);
+		}
+	}
+	std::sort(fcts.begin(), fcts.end());
+	auto percentile = [&fcts](double q) {
+		if (fcts.empty())
+		{
+			return 0.0;
+		}
+		size_t rank = static_cast<size_t>(std::ceil(q * fcts.size()));
+		return fcts[std::max<size_t>(rank, 1) - 1];
+	};
+	double fctSum = 0.0;
+	for (double fct : fcts)
+	{
+		fctSum += fct;
+	}
+
+	std::ofstream out(path);
+	if (!out)
+	{
+		return false;
+	}
+	out << "flows=" << table.size() << "\n"
+	    << "completedFlows=" << fcts.size() << "\n"
+	    << "txPackets=" << txPackets << "\n"
+	    << "rxPackets=" << rxPackets << "\n"
+	    << "lostPackets=" << lostPackets << "\n"
+	    << "rxBytes=" << rxBytes << "\n"
+	    << "meanDelayUs=" << (rxPackets > 0 ? delaySum / rxPackets * 1e6 : 0.0) << "\n"
+	    << "meanFctUs=" << (fcts.empty() ? 0.0 : fctSum / fcts.size() * 1e6) << "\n"
+	    << "p50FctUs=" << percentile(0.50) * 1e6 << "\n"
+	    << "p99FctUs=" << percentile(0.99) * 1e6 << "\n"
+	    << "maxFctUs=" << percentile(1.0) * 1e6 << "\n"
+	    << "events=" << events << "\n"
+	    << "wallSeconds=" << wallSeconds << "\n";
+	return static_cast<bool>(out);
+}
+
 // ============================================================================
 // 主函数
 // ============================================================================
@@ -73,25 +353,115 @@ int main(int argc, char *argv[])
 	// 1.1 命令行参数解析
 	CommandLine cmd;
 	bool ECMProuting = true; // 默认启用 ECMP (等价多路径) 路由
+	uint32_t k = 4;          // Fat-Tree 端口数 (偶数)
+	bool pcap = true;        // 是否为服务器链路生成 PCAP
+	bool netanim = true;     // 是否生成 NetAnim 动画 (仅单进程)
+	bool nullmsg = false;    // 分布式仿真是否使用 Null Message 同步算法
+	uint64_t permutationBytes = 0; // 置换流量每条流字节数 (0 表示不启用)
+	uint32_t partitions = 0; // 单机并行仿真的分区数 (0 表示顺序仿真)
+	uint32_t Corequeuesize = 8;  // 核心层交换机队列: 8 个数据包
+	uint32_t Leafqueuesize = 4;  // 接入/汇聚层交换机队列: 4 个数据包
+	std::string summaryFile = ""; // 非空时把汇总指标写入该文件 (name=value 行)
+	std::string scheduler = "map"; // 事件调度器 (map 为 ns-3 默认)
+	Time autoPrefix = Seconds(1.6); // --scheduler=auto 时每个候选试跑到的仿真时间
 	cmd.AddValue("ECMProuting", "Enable ECMP routing (true/false)", ECMProuting);
+	cmd.AddValue("k", "Fat-Tree arity (even, 4..40)", k);
+	cmd.AddValue("pcap", "Capture pcap on server links of local nodes", pcap);
+	cmd.AddValue("netanim", "Write animation.xml (single process only)", netanim);
+	cmd.AddValue("nullmsg", "Use the null-message distributed simulator instead of granted time window", nullmsg);
+	cmd.AddValue("permutationBytes",
+	             "Bytes per flow of a server permutation load (server i -> i + (k/2)^2); 0 disables",
+	             permutationBytes);
+	cmd.AddValue("partitions",
+	             "Run on N pod-aligned partitions (forked processes, shared-memory sync); 0 = sequential",
+	             partitions);
+	cmd.AddValue("coreQueue", "DropTail queue size (packets) of the 50ns switch links", Corequeuesize);
+	cmd.AddValue("leafQueue", "DropTail queue size (packets) of the 70ns switch links", Leafqueuesize);
+	cmd.AddValue("summary", "Write run metrics (flows, FCT percentiles, wall time) to this file", summaryFile);
+	cmd.AddValue("scheduler",
+	             "Event scheduler: map, heap, list, calendar, priority, radix, or auto (benchmark on a prefix)",
+	             scheduler);
+	cmd.AddValue("autoPrefix", "Simulated time each candidate runs for with --scheduler=auto", autoPrefix);
 	cmd.Parse(argc, argv);
 	
-	// 1.2 设置时间精度为纳秒级别 (数据中心网络需要高精度)
+	// k 必须为偶数; 核心链路数 k^3/4 受地址方案限制 (k <= 40)
+	NS_ABORT_MSG_IF(k < 4 || k % 2 != 0 || k > 40, "k must be an even number in [4, 40]");
+
+	// 1.2 初始化并行仿真
+	// 两种方式都把 Pod 划分到若干分区，每个分区只执行本分区节点上的事件:
+	//   - MPI (需 --enable-mpi 编译，用 mpirun 启动): 每个 rank 一个分区，跨进程数据包通过 MPI 消息传递
+	//   - --partitions=N: 单机上 fork 出 N 个进程，跨分区数据包经共享内存邮箱传递
+	// systemId 为 MPI rank，nPartitions 为分区数；顺序运行时分别为 0 和 1
+	uint32_t systemId = 0;
+	uint32_t nPartitions = 1;
+	if (partitions > 0)
+	{
+		GlobalValue::Bind("SimulatorImplementationType",
+		                  StringValue("ns3::FatTreeShmSimulatorImpl"));
+		nPartitions = partitions;
+	}
+#ifdef NS3_MPI
+	else if (nullmsg)
+	{
+		GlobalValue::Bind("SimulatorImplementationType",
+		                  StringValue("ns3::NullMessageSimulatorImpl"));
+	}
+	else
+	{
+		GlobalValue::Bind("SimulatorImplementationType",
+		                  StringValue("ns3::DistributedSimulatorImpl"));
+	}
+	if (partitions == 0)
+	{
+		MpiInterface::Enable(&argc, &argv);
+		systemId = MpiInterface::GetSystemId();
+		nPartitions = MpiInterface::GetSize();
+	}
+#else
+	NS_ABORT_MSG_IF(nullmsg, "--nullmsg requires ns-3 built with --enable-mpi");
+#endif
+
+	// 1.3 设置时间精度为纳秒级别 (数据中心网络需要高精度)
 	Time::SetResolution(Time::NS);
 	
-	// 1.3 启用应用层日志输出，便于调试和观察数据包收发
-	LogComponentEnable("UdpEchoClientApplication", LOG_LEVEL_INFO);
-	LogComponentEnable("UdpEchoServerApplication", LOG_LEVEL_INFO);
+	// 1.4 启用应用层日志输出，便于调试和观察数据包收发
+	// 大规模拓扑时日志量过大，仅在 k=4 时启用
+	if (k == 4)
+	{
+		LogComponentEnable("UdpEchoClientApplication", LOG_LEVEL_INFO);
+		LogComponentEnable("UdpEchoServerApplication", LOG_LEVEL_INFO);
+	}
 	
-	// 1.4 配置全局路由参数
+	// 1.5 配置全局路由参数
 	// ECMP 路由: 当存在多条等价路径时，随机选择一条路径进行负载均衡
 	Config::SetDefault("ns3::Ipv4GlobalRouting::RandomEcmpRouting", BooleanValue(ECMProuting));
 	
-	// 1.5 定义队列大小参数
+	// 1.6 队列大小参数 (--coreQueue / --leafQueue)
 	// 队列大小影响缓冲能力和延迟，需要根据链路带宽和延迟特性调整
-	uint32_t Corequeuesize, Leafqueuesize;
-	Corequeuesize = 8;  // 核心层交换机队列: 8 个数据包
-	Leafqueuesize = 4;  // 接入/汇聚层交换机队列: 4 个数据包
+	NS_ABORT_MSG_IF(Corequeuesize == 0 || Leafqueuesize == 0, "Queue sizes must be positive");
+
+	// 1.7 拓扑规模
+	const uint32_t half = k / 2;
+	const uint32_t serversPerPod = half * half;       // 每个 Pod 的服务器数
+	const uint32_t nodesPerPod = serversPerPod + k;   // 服务器 + 接入 + 汇聚
+	const uint32_t accessBase = serversPerPod;        // Pod 内接入交换机起始编号
+	const uint32_t aggrBase = serversPerPod + half;   // Pod 内汇聚交换机起始编号
+	const uint32_t nCore = half * half;               // 核心交换机数
+	const uint32_t coreOctet = std::max<uint32_t>(10, k); // 核心链路第二个八位组, 避开 Pod 地址
+
+	// 1.8 选择事件调度器 (--scheduler)
+	// 高负载时事件队列是主要热点，radix 为针对纳秒时间戳单调事件流的基数堆 (见 fat-tree-scheduler.h)
+	// 必须在创建节点之前绑定，仿真器在第一次使用时按 SchedulerType 创建事件队列
+	// auto 在 7.4 中对各调度器试跑一段前缀后再决定，需要 fork，只能用于顺序仿真
+	const bool autoScheduler = (scheduler == "auto");
+	if (!autoScheduler)
+	{
+		GlobalValue::Bind("SchedulerType", StringValue(FatTreeSchedulerType(scheduler)));
+	}
+#ifdef NS3_MPI
+	NS_ABORT_MSG_IF(autoScheduler, "--scheduler=auto cannot fork MPI processes; choose a scheduler explicitly");
+#endif
+	NS_ABORT_MSG_IF(autoScheduler && partitions > 0, "--scheduler=auto requires a sequential run (--partitions=0)");
 
 	// ========================================================================
 	// 2. 定义链路助手 (配置不同层级的链路特性)
@@ -106,6 +476,7 @@ int main(int argc, char *argv[])
 
 	// 2.2 汇聚层到核心层交换机链路 (上行链路)
 	// 特点: 高带宽 (40Gbps)，低延迟 (50ns)，较大队列
+	// 分布式仿真时这是唯一的跨进程链路，其 50ns 延迟即为各进程间的 lookahead
 	PointToPointHelper SWToSW_50ns;
 	SWToSW_50ns.SetDeviceAttribute("DataRate", StringValue("40Gbps"));
 	SWToSW_50ns.SetChannelAttribute("Delay", StringValue("50ns"));
@@ -122,45 +493,58 @@ int main(int argc, char *argv[])
 	                     StringValue(std::to_string(Leafqueuesize) + "p")); 
 	
 	// ========================================================================
-	// 3. 创建节点 (k=4 Fat-Tree 拓扑)
+	// 3. 创建节点 (k-ary Fat-Tree 拓扑)
 	// ========================================================================
 	
-	// 3.1 创建 Pod 节点容器
-	// k=4 Fat-Tree 包含 4 个 Pod，每个 Pod 有 8 个节点:
-	//   - 节点 0-3: 服务器 (Server 0-3)
-	//   - 节点 4-5: 接入层交换机 (Access Switch 4-5)
-	//   - 节点 6-7: 汇聚层交换机 (Aggregation Switch 6-7)
-	NodeContainer pod0, pod1, pod2, pod3, core;
-	pod0.Create(8); // Pod 0
-	pod1.Create(8); // Pod 1
-	pod2.Create(8); // Pod 2
-	pod3.Create(8); // Pod 3
-	
-	// 3.2 创建核心层交换机
-	// k=4 Fat-Tree 需要 (k/2)^2 = 4 个核心交换机
-	core.Create(4);
+	// 3.1 节点到分区的划分 (分区即 MPI rank 或共享内存并行的进程)
+	// Pod 按连续区间分配: Pod p -> 分区 p*nPartitions/k，Pod 内链路不跨分区;
+	// 核心交换机同样按连续区间均分到各分区，因此只有汇聚-核心链路可能跨分区
+	NS_ABORT_MSG_IF(nPartitions > k, "Number of partitions (" << nPartitions
+	                << ") must not exceed the number of pods (" << k << ")");
+	auto podRank = [&](uint32_t p) { return p * nPartitions / k; };
+	auto coreRank = [&](uint32_t c) { return c * nPartitions / nCore; };
+	
+	// 3.2 创建 Pod 节点容器
+	// 每个 Pod 有 (k/2)^2 + k 个节点 (k=4 时为 8 个):
+	//   - 节点 0 ~ (k/2)^2-1: 服务器
+	//   - 之后 k/2 个: 接入层交换机
+	//   - 最后 k/2 个: 汇聚层交换机
+	// 所有进程都创建完整拓扑，但节点只在其 systemId 对应的分区上执行事件
+	std::vector<NodeContainer> pods(k);
+	NodeContainer core;
+	for (uint32_t p = 0; p < k; ++p)
+	{
+		pods[p].Create(nodesPerPod, podRank(p));
+	}
+
+	// 3.3 创建核心层交换机
+	// k-ary Fat-Tree 需要 (k/2)^2 个核心交换机
+	for (uint32_t c = 0; c < nCore; ++c)
+	{
+		core.Create(1, coreRank(c));
+	}
 
-	// 3.3 为所有节点设置移动性模型
+	// 3.4 为所有节点设置移动性模型
 	// 虽然数据中心节点是静态的，但 NetAnim 需要位置信息来渲染动画
 	// 使用 ConstantPositionMobilityModel 表示节点位置固定不变
 	MobilityHelper mobility;
 	mobility.SetMobilityModel("ns3::ConstantPositionMobilityModel");
-	mobility.Install(pod0);
-	mobility.Install(pod1);
-	mobility.Install(pod2);
-	mobility.Install(pod3);
+	for (uint32_t p = 0; p < k; ++p)
+	{
+		mobility.Install(pods[p]);
+	}
 	mobility.Install(core);
 	
-	// 3.4 安装互联网协议栈 (TCP/IP)
+	// 3.5 安装互联网协议栈 (TCP/IP)
 	// 为所有节点安装完整的 TCP/IP 协议栈，包括:
 	//   - IPv4 协议
 	//   - TCP/UDP 传输层协议
 	//   - 全局路由协议 (用于 ECMP)
 	InternetStackHelper stack;
-	stack.Install(pod0);
-	stack.Install(pod1);
-	stack.Install(pod2);
-	stack.Install(pod3);
+	for (uint32_t p = 0; p < k; ++p)
+	{
+		stack.Install(pods[p]);
+	}
 	stack.Install(core);
 	
 	
@@ -168,215 +552,89 @@ int main(int argc, char *argv[])
 	// 4. 构建拓扑：连接节点 (创建物理链路)
 	// ========================================================================
 	
-	// 4.1 Pod 0 内部连接
-	// 拓扑结构:
+	// 4.1 Pod 内部连接
+	// 拓扑结构 (k=4):
 	//   Server0,1 -> AccessSW4 -> AggrSW6,7
 	//   Server2,3 -> AccessSW5 -> AggrSW6,7
-	NetDeviceContainer pod0_dev, pod0_dev2, pod0_dev3, pod0_dev4;
-	NetDeviceContainer pod0_dev5, pod0_dev6, pod0_dev7, pod0_dev8;
-	
-	// 服务器到接入交换机 (边缘层)
-	pod0_dev  = NodeToSW.Install(pod0.Get(0), pod0.Get(4)); // Server0 -> AccessSW4
-	pod0_dev2 = NodeToSW.Install(pod0.Get(1), pod0.Get(4)); // Server1 -> AccessSW4
-	pod0_dev3 = NodeToSW.Install(pod0.Get(2), pod0.Get(5)); // Server2 -> AccessSW5
-	pod0_dev4 = NodeToSW.Install(pod0.Get(3), pod0.Get(5)); // Server3 -> AccessSW5
-	
-	// 接入交换机到汇聚交换机 (全连接，提供冗余路径)
-	pod0_dev5 = SWToSW_50ns.Install(pod0.Get(4), pod0.Get(6)); // AccessSW4 -> AggrSW6
-	pod0_dev6 = SWToSW_70ns.Install(pod0.Get(4), pod0.Get(7)); // AccessSW4 -> AggrSW7
-	pod0_dev7 = SWToSW_50ns.Install(pod0.Get(5), pod0.Get(6)); // AccessSW5 -> AggrSW6
-	pod0_dev8 = SWToSW_70ns.Install(pod0.Get(5), pod0.Get(7)); // AccessSW5 -> AggrSW7
-	
-	// 4.2 Pod 1 内部连接 (结构同 Pod 0)
-	NetDeviceContainer pod1_dev, pod1_dev2, pod1_dev3, pod1_dev4;
-	NetDeviceContainer pod1_dev5, pod1_dev6, pod1_dev7, pod1_dev8;
-	pod1_dev  = NodeToSW.Install(pod1.Get(0), pod1.Get(4));
-	pod1_dev2 = NodeToSW.Install(pod1.Get(1), pod1.Get(4));
-	pod1_dev3 = NodeToSW.Install(pod1.Get(2), pod1.Get(5));
-	pod1_dev4 = NodeToSW.Install(pod1.Get(3), pod1.Get(5));
-	pod1_dev5 = SWToSW_50ns.Install(pod1.Get(4), pod1.Get(6));
-	pod1_dev6 = SWToSW_70ns.Install(pod1.Get(4), pod1.Get(7));
-	pod1_dev7 = SWToSW_50ns.Install(pod1.Get(5), pod1.Get(6));
-	pod1_dev8 = SWToSW_70ns.Install(pod1.Get(5), pod1.Get(7));
-	
-	// 4.3 Pod 2 内部连接 (结构同 Pod 0)
-	NetDeviceContainer pod2_dev, pod2_dev2, pod2_dev3, pod2_dev4;
-	NetDeviceContainer pod2_dev5, pod2_dev6, pod2_dev7, pod2_dev8;
-	pod2_dev  = NodeToSW.Install(pod2.Get(0), pod2.Get(4));
-	pod2_dev2 = NodeToSW.Install(pod2.Get(1), pod2.Get(4));
-	pod2_dev3 = NodeToSW.Install(pod2.Get(2), pod2.Get(5));
-	pod2_dev4 = NodeToSW.Install(pod2.Get(3), pod2.Get(5));
-	pod2_dev5 = SWToSW_50ns.Install(pod2.Get(4), pod2.Get(6));
-	pod2_dev6 = SWToSW_70ns.Install(pod2.Get(4), pod2.Get(7));
-	pod2_dev7 = SWToSW_50ns.Install(pod2.Get(5), pod2.Get(6));
-	pod2_dev8 = SWToSW_70ns.Install(pod2.Get(5), pod2.Get(7));
-	
-	// 4.4 Pod 3 内部连接 (结构同 Pod 0)
-	NetDeviceContainer pod3_dev, pod3_dev2, pod3_dev3, pod3_dev4;
-	NetDeviceContainer pod3_dev5, pod3_dev6, pod3_dev7, pod3_dev8;
-	pod3_dev  = NodeToSW.Install(pod3.Get(0), pod3.Get(4));
-	pod3_dev2 = NodeToSW.Install(pod3.Get(1), pod3.Get(4));
-	pod3_dev3 = NodeToSW.Install(pod3.Get(2), pod3.Get(5));
-	pod3_dev4 = NodeToSW.Install(pod3.Get(3), pod3.Get(5));
-	pod3_dev5 = SWToSW_50ns.Install(pod3.Get(4), pod3.Get(6));
-	pod3_dev6 = SWToSW_70ns.Install(pod3.Get(4), pod3.Get(7));
-	pod3_dev7 = SWToSW_50ns.Install(pod3.Get(5), pod3.Get(6));
-	pod3_dev8 = SWToSW_70ns.Install(pod3.Get(5), pod3.Get(7));
-	
-	// 4.5 汇聚层到核心层连接 (跨 Pod 通信路径)
-	// 每个 Pod 的每个汇聚交换机都连接到所有核心交换机
+	// 链路按 "先服务器链路、后接入-汇聚链路" 的顺序保存，其序号即子网序号
+	std::vector<std::vector<NetDeviceContainer>> podDevs(k);
+	for (uint32_t p = 0; p < k; ++p)
+	{
+		// 服务器到接入交换机 (边缘层): 服务器 s 连接接入交换机 s/(k/2)
+		for (uint32_t s = 0; s < serversPerPod; ++s)
+		{
+			podDevs[p].push_back(NodeToSW.Install(pods[p].Get(s), pods[p].Get(accessBase + s / half)));
+		}
+	
+		// 接入交换机到汇聚交换机 (全连接，提供冗余路径)
+		// 与原始 k=4 拓扑一致: 第一个汇聚交换机的下联为 50ns 链路，其余为 70ns
+		for (uint32_t e = 0; e < half; ++e)
+		{
+			for (uint32_t a = 0; a < half; ++a)
+			{
+				PointToPointHelper &link = (a == 0) ? SWToSW_50ns : SWToSW_70ns;
+				podDevs[p].push_back(link.Install(pods[p].Get(accessBase + e), pods[p].Get(aggrBase + a)));
+			}
+		}
+	}
+	
+	// 4.2 汇聚层到核心层连接 (跨 Pod 通信路径)
+	// 核心交换机 c 连接每个 Pod 的第 c/(k/2) 个汇聚交换机
 	// 这提供了 Pod 间通信的多条等价路径，是 ECMP 的基础
-	NetDeviceContainer core_dev, core_dev2, core_dev3, core_dev4;
-	NetDeviceContainer core_dev5, core_dev6, core_dev7, core_dev8;
-	NetDeviceContainer core_dev9, core_dev10, core_dev11, core_dev12;
-	NetDeviceContainer core_dev13, core_dev14, core_dev15, core_dev16;
-	
-	// 所有 Pod 的 AggrSW6 连接到 Core0
-	core_dev  = SWToSW_50ns.Install(pod0.Get(6), core.Get(0));
-	core_dev2 = SWToSW_50ns.Install(pod1.Get(6), core.Get(0));
-	core_dev3 = SWToSW_50ns.Install(pod2.Get(6), core.Get(0));
-	core_dev4 = SWToSW_50ns.Install(pod3.Get(6), core.Get(0));
-	
-	// 所有 Pod 的 AggrSW6 连接到 Core1
-	core_dev5 = SWToSW_50ns.Install(pod0.Get(6), core.Get(1));
-	core_dev6 = SWToSW_50ns.Install(pod1.Get(6), core.Get(1));
-	core_dev7 = SWToSW_50ns.Install(pod2.Get(6), core.Get(1));
-	core_dev8 = SWToSW_50ns.Install(pod3.Get(6), core.Get(1));
-	
-	// 所有 Pod 的 AggrSW7 连接到 Core2
-	core_dev9  = SWToSW_50ns.Install(pod0.Get(7), core.Get(2));
-	core_dev10 = SWToSW_50ns.Install(pod1.Get(7), core.Get(2));
-	core_dev11 = SWToSW_50ns.Install(pod2.Get(7), core.Get(2));
-	core_dev12 = SWToSW_50ns.Install(pod3.Get(7), core.Get(2));
-	
-	// 所有 Pod 的 AggrSW7 连接到 Core3
-	core_dev13 = SWToSW_50ns.Install(pod0.Get(7), core.Get(3));
-	core_dev14 = SWToSW_50ns.Install(pod1.Get(7), core.Get(3));
-	core_dev15 = SWToSW_50ns.Install(pod2.Get(7), core.Get(3));
-	core_dev16 = SWToSW_50ns.Install(pod3.Get(7), core.Get(3));
+	// MPI: 两端节点位于不同进程时，PointToPointHelper 会自动创建远程信道 (PointToPointRemoteChannel)
+	// 共享内存并行: PointToPointHelper 的信道类型固定，改用 InstallFatTreeShmLink 创建 FatTreeShmChannel
+	std::vector<NetDeviceContainer> coreDevs;
+	uint32_t crossRankLinks = 0;
+	for (uint32_t c = 0; c < nCore; ++c)
+	{
+		for (uint32_t p = 0; p < k; ++p)
+		{
+			Ptr<Node> aggr = pods[p].Get(aggrBase + c / half);
+			if (partitions > 0)
+			{
+				coreDevs.push_back(InstallFatTreeShmLink(aggr, core.Get(c), DataRate("40Gbps"), NanoSeconds(50),
+				                                         QueueSize(std::to_string(Corequeuesize) + "p")));
+			}
+			else
+			{
+				coreDevs.push_back(SWToSW_50ns.Install(aggr, core.Get(c)));
+			}
+			if (podRank(p) != coreRank(c))
+			{
+				crossRankLinks++;
+			}
+		}
+	}
 		
 	// --- 5. 分配 IP 地址 (使用规律化的 P2P 独立子网方案) ---
-	// IP 地址分配规则: 10.Pod.Subnet.0/30
-	// Pod 0: 10.0.x.0/30  (x=0~7 for pod内链路)
-	// Pod 1: 10.1.x.0/30
-	// Pod 2: 10.2.x.0/30
-	// Pod 3: 10.3.x.0/30
-	// Core:  10.10.x.0/30 (x=0~15 for 16条核心链路)
+	// IP 地址分配规则 (k=4 时与 2.0 版本完全相同):
+	// Pod p: 10.p.x.0/30   (x=0~7 for pod内链路)
+	// Core:  10.10.x.0/30  (x=0~15 for 16条核心链路)
+	// k > 10 时核心链路改用 10.k.x.x，避免与 Pod 10 冲突
 	
 	Ipv4AddressHelper address;
+	std::vector<std::vector<Ipv4InterfaceContainer>> podIfaces(k);
+	for (uint32_t p = 0; p < k; ++p)
+	{
+		for (uint32_t i = 0; i < podDevs[p].size(); ++i)
+		{
+			address.SetBase(LinkSubnet(p, i), Ipv4Mask("255.255.255.252"));
+			podIfaces[p].push_back(address.Assign(podDevs[p][i]));
+		}
+	}
 
-	// === Pod 0: 10.0.x.0/30 ===
-	Ipv4InterfaceContainer pod0_Iface,pod0_Iface2,pod0_Iface3,pod0_Iface4,pod0_Iface5,pod0_Iface6,pod0_Iface7,pod0_Iface8;
-	address.SetBase("10.0.0.0","255.255.255.252");  // Server0-AccessSW4
-	pod0_Iface = address.Assign (pod0_dev);
-	address.SetBase("10.0.1.0","255.255.255.252");  // Server1-AccessSW4
-	pod0_Iface2 = address.Assign(pod0_dev2);
-	address.SetBase("10.0.2.0","255.255.255.252");  // Server2-AccessSW5
-	pod0_Iface3 = address.Assign(pod0_dev3);
-	address.SetBase("10.0.3.0","255.255.255.252");  // Server3-AccessSW5
-	pod0_Iface4 = address.Assign(pod0_dev4);
-	address.SetBase("10.0.4.0","255.255.255.252");  // AccessSW4-AggrSW6
-	pod0_Iface5 = address.Assign(pod0_dev5);
-	address.SetBase("10.0.5.0","255.255.255.252");  // AccessSW4-AggrSW7
-	pod0_Iface6 = address.Assign(pod0_dev6);
-	address.SetBase("10.0.6.0","255.255.255.252");  // AccessSW5-AggrSW6
-	pod0_Iface7 = address.Assign(pod0_dev7);
-	address.SetBase("10.0.7.0","255.255.255.252");  // AccessSW5-AggrSW7
-	pod0_Iface8 = address.Assign(pod0_dev8);
-
-	// === Pod 1: 10.1.x.0/30 ===
-	Ipv4InterfaceContainer pod1_Iface,pod1_Iface2,pod1_Iface3,pod1_Iface4,pod1_Iface5,pod1_Iface6,pod1_Iface7,pod1_Iface8;
-	address.SetBase("10.1.0.0","255.255.255.252");  // Server0-AccessSW4
-	pod1_Iface = address.Assign (pod1_dev);
-	address.SetBase("10.1.1.0","255.255.255.252");  // Server1-AccessSW4
-	pod1_Iface2 = address.Assign(pod1_dev2);
-	address.SetBase("10.1.2.0","255.255.255.252");  // Server2-AccessSW5
-	pod1_Iface3 = address.Assign(pod1_dev3);
-	address.SetBase("10.1.3.0","255.255.255.252");  // Server3-AccessSW5
-	pod1_Iface4 = address.Assign(pod1_dev4);
-	address.SetBase("10.1.4.0","255.255.255.252");  // AccessSW4-AggrSW6
-	pod1_Iface5 = address.Assign(pod1_dev5);
-	address.SetBase("10.1.5.0","255.255.255.252");  // AccessSW4-AggrSW7
-	pod1_Iface6 = address.Assign(pod1_dev6);
-	address.SetBase("10.1.6.0","255.255.255.252");  // AccessSW5-AggrSW6
-	pod1_Iface7 = address.Assign(pod1_dev7);
-	address.SetBase("10.1.7.0","255.255.255.252");  // AccessSW5-AggrSW7
-	pod1_Iface8 = address.Assign(pod1_dev8);
-
-	// === Pod 2: 10.2.x.0/30 ===
-	Ipv4InterfaceContainer pod2_Iface,pod2_Iface2,pod2_Iface3,pod2_Iface4,pod2_Iface5,pod2_Iface6,pod2_Iface7,pod2_Iface8;
-	address.SetBase("10.2.0.0","255.255.255.252");  // Server0-AccessSW4
-	pod2_Iface = address.Assign (pod2_dev);
-	address.SetBase("10.2.1.0","255.255.255.252");  // Server1-AccessSW4
-	pod2_Iface2 = address.Assign(pod2_dev2);
-	address.SetBase("10.2.2.0","255.255.255.252");  // Server2-AccessSW5
-	pod2_Iface3 = address.Assign(pod2_dev3);
-	address.SetBase("10.2.3.0","255.255.255.252");  // Server3-AccessSW5
-	pod2_Iface4 = address.Assign(pod2_dev4);
-	address.SetBase("10.2.4.0","255.255.255.252");  // AccessSW4-AggrSW6
-	pod2_Iface5 = address.Assign(pod2_dev5);
-	address.SetBase("10.2.5.0","255.255.255.252");  // AccessSW4-AggrSW7
-	pod2_Iface6 = address.Assign(pod2_dev6);
-	address.SetBase("10.2.6.0","255.255.255.252");  // AccessSW5-AggrSW6
-	pod2_Iface7 = address.Assign(pod2_dev7);
-	address.SetBase("10.2.7.0","255.255.255.252");  // AccessSW5-AggrSW7
-	pod2_Iface8 = address.Assign(pod2_dev8);
-
-	// === Pod 3: 10.3.x.0/30 ===
-	Ipv4InterfaceContainer pod3_Iface,pod3_Iface2,pod3_Iface3,pod3_Iface4,pod3_Iface5,pod3_Iface6,pod3_Iface7,pod3_Iface8;
-	address.SetBase("10.3.0.0","255.255.255.252");  // Server0-AccessSW4
-	pod3_Iface = address.Assign (pod3_dev);
-	address.SetBase("10.3.1.0","255.255.255.252");  // Server1-AccessSW4
-	pod3_Iface2 = address.Assign(pod3_dev2);
-	address.SetBase("10.3.2.0","255.255.255.252");  // Server2-AccessSW5
-	pod3_Iface3 = address.Assign(pod3_dev3);
-	address.SetBase("10.3.3.0","255.255.255.252");  // Server3-AccessSW5
-	pod3_Iface4 = address.Assign(pod3_dev4);
-	address.SetBase("10.3.4.0","255.255.255.252");  // AccessSW4-AggrSW6
-	pod3_Iface5 = address.Assign(pod3_dev5);
-	address.SetBase("10.3.5.0","255.255.255.252");  // AccessSW4-AggrSW7
-	pod3_Iface6 = address.Assign(pod3_dev6);
-	address.SetBase("10.3.6.0","255.255.255.252");  // AccessSW5-AggrSW6
-	pod3_Iface7 = address.Assign(pod3_dev7);
-	address.SetBase("10.3.7.0","255.255.255.252");  // AccessSW5-AggrSW7
-	pod3_Iface8 = address.Assign(pod3_dev8);
-	
-	// === 核心层链路: 10.10.x.0/30 ===
-	// 使用 10.10.x.0 来表示核心链路，便于识别
-	Ipv4InterfaceContainer core_Iface,core_Iface2,core_Iface3,core_Iface4,core_Iface5,core_Iface6,core_Iface7,core_Iface8;
-	Ipv4InterfaceContainer core_Iface9,core_Iface10,core_Iface11,core_Iface12,core_Iface13,core_Iface14,core_Iface15,core_Iface16;
-	address.SetBase("10.10.0.0","255.255.255.252");   // Pod0.AggrSW6-Core0
-	core_Iface = address.Assign(core_dev);
-	address.SetBase("10.10.1.0","255.255.255.252");   // Pod1.AggrSW6-Core0
-	core_Iface2 = address.Assign(core_dev2);
-	address.SetBase("10.10.2.0","255.255.255.252");   // Pod2.AggrSW6-Core0
-	core_Iface3 = address.Assign(core_dev3);
-	address.SetBase("10.10.3.0","255.255.255.252");   // Pod3.AggrSW6-Core0
-	core_Iface4 = address.Assign(core_dev4);
-	address.SetBase("10.10.4.0","255.255.255.252");   // Pod0.AggrSW6-Core1
-	core_Iface5 = address.Assign(core_dev5);
-	address.SetBase("10.10.5.0","255.255.255.252");   // Pod1.AggrSW6-Core1
-	core_Iface6 = address.Assign(core_dev6);
-	address.SetBase("10.10.6.0","255.255.255.252");   // Pod2.AggrSW6-Core1
-	core_Iface7 = address.Assign(core_dev7);
-	address.SetBase("10.10.7.0","255.255.255.252");   // Pod3.AggrSW6-Core1
-	core_Iface8 = address.Assign(core_dev8);
-	address.SetBase("10.10.8.0","255.255.255.252");   // Pod0.AggrSW7-Core2
-	core_Iface9 = address.Assign(core_dev9);
-	address.SetBase("10.10.9.0","255.255.255.252");   // Pod1.AggrSW7-Core2
-	core_Iface10 = address.Assign(core_dev10);
-	address.SetBase("10.10.10.0","255.255.255.252");  // Pod2.AggrSW7-Core2
-	core_Iface11 = address.Assign(core_dev11);
-	address.SetBase("10.10.11.0","255.255.255.252");  // Pod3.AggrSW7-Core2
-	core_Iface12 = address.Assign(core_dev12);
-	address.SetBase("10.10.12.0","255.255.255.252");  // Pod0.AggrSW7-Core3
-	core_Iface13 = address.Assign(core_dev13);
-	address.SetBase("10.10.13.0","255.255.255.252");  // Pod1.AggrSW7-Core3
-	core_Iface14 = address.Assign(core_dev14);
-	address.SetBase("10.10.14.0","255.255.255.252");  // Pod2.AggrSW7-Core3
-	core_Iface15 = address.Assign(core_dev15);
-	address.SetBase("10.10.15.0","255.255.255.252");  // Pod3.AggrSW7-Core3
-	core_Iface16 = address.Assign(core_dev16);
+	// === 核心层链路 ===
+	for (uint32_t j = 0; j < coreDevs.size(); ++j)
+	{
+		address.SetBase(LinkSubnet(coreOctet, j), Ipv4Mask("255.255.255.252"));
+		address.Assign(coreDevs[j]);
+	}
+
+	// 服务器地址: Pod p 的服务器 s 即第 s 条链路的 .1 端
+	auto serverAddress = [&](uint32_t p, uint32_t s) { return podIfaces[p][s].GetAddress(0); };
+	// 节点是否由本进程负责 (应用、PCAP、FlowMonitor 只安装在本地节点上)
+	// 共享内存并行时 Run() 之前只有一个进程，所有节点都在本地安装，fork 后各分区只执行自己的部分
+	auto isLocal = [&](Ptr<Node> node) { return partitions > 0 || node->GetSystemId() == systemId; };
 	
 	// ========================================================================
 	// 6. 计算并填充路由表
@@ -385,6 +643,7 @@ int main(int argc, char *argv[])
 	// 使用全局路由助手计算所有节点之间的最短路径
 	// 这会运行 Dijkstra 算法，并在每个节点上填充路由表
 	// 当启用 ECMP 时，会自动识别等价路径并进行负载均衡
+	// 分布式仿真时每个进程都持有完整拓扑，各自独立计算出相同的路由表
 	Ipv4GlobalRoutingHelper::PopulateRoutingTables();
 	
 	// ========================================================================
@@ -396,47 +655,120 @@ int main(int argc, char *argv[])
 	// 客户端: Pod1.Server0 (10.1.0.1)
 	// 用途: 验证基本的跨 Pod 通信和往返延迟
 	UdpEchoServerHelper echoServer(9);
-	ApplicationContainer serverApps = echoServer.Install(pod0.Get(0));
-	serverApps.Start(Seconds(1.0));
-	serverApps.Stop(Seconds(10.0));
+	if (isLocal(pods[0].Get(0)))
+	{
+		ApplicationContainer serverApps = echoServer.Install(pods[0].Get(0));
+		serverApps.Start(Seconds(1.0));
+		serverApps.Stop(Seconds(10.0));
+	}
 
-	UdpEchoClientHelper echoClient(pod0_Iface.GetAddress(0), 9);
+	UdpEchoClientHelper echoClient(serverAddress(0, 0), 9);
 	echoClient.SetAttribute("MaxPackets", UintegerValue(1));      // 发送 1 个数据包
 	echoClient.SetAttribute("Interval", TimeValue(Seconds(1.0))); // 发送间隔 1 秒
 	echoClient.SetAttribute("PacketSize", UintegerValue(1024));   // 数据包大小 1024 字节
-	ApplicationContainer clientApps = echoClient.Install(pod1.Get(0));
-	clientApps.Start(Seconds(2.0));
-	clientApps.Stop(Seconds(10.0));
+	if (isLocal(pods[1].Get(0)))
+	{
+		ApplicationContainer clientApps = echoClient.Install(pods[1].Get(0));
+		clientApps.Start(Seconds(2.0));
+		clientApps.Stop(Seconds(10.0));
+	}
 
 	// 7.2 TCP BulkSend 应用 (测试吞吐量和 ECMP 负载均衡)
 	// Sink (接收端): Pod2.Server0 (10.2.0.1:80)
 	// Source (发送端): Pod3.Server0 (10.3.0.1)
 	// 用途: 生成大量 TCP 流量，测试网络吞吐量和 ECMP 效果
 	uint16_t port = 80;
+	uint16_t permPort = 5000; // 置换流量的端口
 	
 	// 创建 TCP 接收端 (Sink)
 	PacketSinkHelper sink("ns3::TcpSocketFactory", 
 	                      InetSocketAddress(Ipv4Address::GetAny(), port));
-	ApplicationContainer sinkApp = sink.Install(pod2.Get(0));
-	sinkApp.Start(Seconds(1.0));
-	sinkApp.Stop(Seconds(10.0));
+	if (isLocal(pods[2].Get(0)))
+	{
+		ApplicationContainer sinkApp = sink.Install(pods[2].Get(0));
+		sinkApp.Start(Seconds(1.0));
+		sinkApp.Stop(Seconds(10.0));
+	}
  
 	// 创建 TCP 发送端 (BulkSend)
 	BulkSendHelper source("ns3::TcpSocketFactory", 
-	                      InetSocketAddress(pod2_Iface.GetAddress(0), port));
+	                      InetSocketAddress(serverAddress(2, 0), port));
 	source.SetAttribute("MaxBytes", UintegerValue(1000000)); // 发送 1 MB 数据
-	ApplicationContainer sourceApps = source.Install(pod3.Get(0));
-	sourceApps.Start(Seconds(1.5)); // 稍晚启动，避免与 UDP 冲突
-	sourceApps.Stop(Seconds(10.0));
+	if (isLocal(pods[3].Get(0)))
+	{
+		ApplicationContainer sourceApps = source.Install(pods[3].Get(0));
+		sourceApps.Start(Seconds(1.5)); // 稍晚启动，避免与 UDP 冲突
+		sourceApps.Stop(Seconds(10.0));
+	}
+
+	// 7.3 置换流量 (可选，用于大规模负载测试)
+	// 全局第 i 台服务器向第 (i + (k/2)^2) 台服务器发送 permutationBytes 字节，
+	// 即每台服务器都向下一个 Pod 的同位置服务器发送，所有流都经过核心层
+	if (permutationBytes > 0)
+	{
+		PacketSinkHelper permSink("ns3::TcpSocketFactory",
+		                          InetSocketAddress(Ipv4Address::GetAny(), permPort));
+		for (uint32_t p = 0; p < k; ++p)
+		{
+			for (uint32_t s = 0; s < serversPerPod; ++s)
+			{
+				Ptr<Node> server = pods[p].Get(s);
+				if (!isLocal(server))
+				{
+					continue;
+				}
+				ApplicationContainer permSinkApp = permSink.Install(server);
+				permSinkApp.Start(Seconds(1.0));
+				permSinkApp.Stop(Seconds(10.0));
+
+				BulkSendHelper permSource("ns3::TcpSocketFactory",
+				                          InetSocketAddress(serverAddress((p + 1) % k, s), permPort));
+				permSource.SetAttribute("MaxBytes", UintegerValue(permutationBytes));
+				ApplicationContainer permSourceApp = permSource.Install(server);
+				permSourceApp.Start(Seconds(1.5));
+				permSourceApp.Stop(Seconds(10.0));
+			}
+		}
+	}
+
+	// 7.4 自动选择事件调度器 (--scheduler=auto)
+	// 此时拓扑、路由和应用都已就绪，而 PCAP、FlowMonitor、NetAnim 还没有打开任何文件:
+	// 每个候选在 fork 出的副本上从同一状态运行到 autoPrefix，取 Run() 墙钟时间最短者
+	// list 的插入为 O(n)，放在最后，一旦慢于已测得的最快者就被提前结束
+	if (autoScheduler)
+	{
+		std::cout << "Benchmarking event schedulers up to " << autoPrefix.GetSeconds() << " s:" << std::endl;
+		scheduler = FatTreeAutoSelectScheduler({"map", "heap", "calendar", "priority", "radix", "list"},
+		                                       autoPrefix, true);
+		std::cout << "Selected scheduler: " << scheduler << std::endl;
+	}
  
 	// ========================================================================
 	// 8. 配置监控与可视化
 	// ========================================================================
 	
 	// 8.1 启用 PCAP 数据包捕获
-	// 为所有服务器到交换机的链路生成 .pcap 文件
+	// 为本进程负责的服务器到交换机链路生成 .pcap 文件
 	// 可以使用 Wireshark 打开这些文件进行详细的数据包分析
-	NodeToSW.EnablePcapAll("DCN_FatTree_CSMA_Pcap");
+	// 共享内存并行时 PCAP 文件在 fork 前打开，会被所有分区进程同时写入，因此关闭
+	if (pcap && partitions > 1)
+	{
+		std::cout << "pcap disabled: capture files would be shared by all partition processes" << std::endl;
+		pcap = false;
+	}
+	if (pcap)
+	{
+		for (uint32_t p = 0; p < k; ++p)
+		{
+			for (uint32_t s = 0; s < serversPerPod; ++s)
+			{
+				if (isLocal(pods[p].Get(s)))
+				{
+					NodeToSW.EnablePcap("DCN_FatTree_CSMA_Pcap", podDevs[p][s]);
+				}
+			}
+		}
+	}
 	
 	// 8.2 安装 FlowMonitor (流量监控器)
 	// FlowMonitor 会自动跟踪网络中的所有流 (Flow)
@@ -445,59 +777,101 @@ int main(int argc, char *argv[])
 	//   - 延迟 (Delay)
 	//   - 抖动 (Jitter)
 	//   - 丢包率 (Packet Loss Rate)
+	// 分布式仿真时每个进程只监控本地节点。FlowMonitor 的流编号按进程分配，接收端进程
+	// 不认识其他进程发出的包，跨进程流的接收统计 (rxPackets、时延、timeLastRxPacket) 会丢失，
+	// 每个进程的 .flowmon 文件只有本进程内部的流是完整的
 	FlowMonitorHelper flowmonHelper;
-	flowmonHelper.InstallAll();
-	
-	// 8.3 配置 NetAnim 动画
+	NodeContainer localNodes;
+	for (uint32_t p = 0; p < k; ++p)
+	{
+		if (partitions > 0 || podRank(p) == systemId)
+		{
+			localNodes.Add(pods[p]);
+		}
+	}
+	for (uint32_t c = 0; c < nCore; ++c)
+	{
+		if (partitions > 0 || coreRank(c) == systemId)
+		{
+			localNodes.Add(core.Get(c));
+		}
+	}
+	flowmonHelper.Install(localNodes);
+
+	// 8.3 记录运行摘要用的数据流统计 (见 DataFlowRecorder)
+	// 发送和接收都按五元组记在本地服务器上，跨分区的流在合并后同样是完整的
+	const std::set<uint16_t> dataPorts = {9, port, permPort};
+	DataFlowRecorder recorder(dataPorts);
+	for (uint32_t p = 0; p < k; ++p)
+	{
+		for (uint32_t s = 0; s < serversPerPod; ++s)
+		{
+			if (isLocal(pods[p].Get(s)))
+			{
+				recorder.Install(pods[p].Get(s));
+			}
+		}
+	}
+	
+	// 8.4 配置 NetAnim 动画
 	// 为每个节点设置固定的二维坐标，用于在 NetAnim 中可视化拓扑
 	// NetAnim 可以播放仿真过程，显示数据包在网络中的传输路径
-	AnimationInterface anim("animation.xml");
-	
-	// Pod 0 节点位置 (左侧)
-	anim.SetConstantPosition(pod0.Get(0), 1.0, 20.0);  // Server 0
-	anim.SetConstantPosition(pod0.Get(1), 2.0, 20.0);  // Server 1
-	anim.SetConstantPosition(pod0.Get(2), 3.0, 20.0);  // Server 2
-	anim.SetConstantPosition(pod0.Get(3), 4.0, 20.0);  // Server 3
-	anim.SetConstantPosition(pod0.Get(4), 1.5, 16.0);  // Access SW 4
-	anim.SetConstantPosition(pod0.Get(5), 3.5, 16.0);  // Access SW 5
-	anim.SetConstantPosition(pod0.Get(6), 1.5, 12.0);  // Aggr SW 6
-	anim.SetConstantPosition(pod0.Get(7), 3.5, 12.0);  // Aggr SW 7
-	
-	// Pod 1 节点位置 (中左)
-	anim.SetConstantPosition(pod1.Get(0), 6.0, 20.0);
-	anim.SetConstantPosition(pod1.Get(1), 7.0, 20.0);
-	anim.SetConstantPosition(pod1.Get(2), 8.0, 20.0);
-	anim.SetConstantPosition(pod1.Get(3), 9.0, 20.0);
-	anim.SetConstantPosition(pod1.Get(4), 6.5, 16.0);
-	anim.SetConstantPosition(pod1.Get(5), 8.5, 16.0);
-	anim.SetConstantPosition(pod1.Get(6), 6.5, 12.0);
-	anim.SetConstantPosition(pod1.Get(7), 8.5, 12.0);
-	
-	// Pod 2 节点位置 (中右)
-	anim.SetConstantPosition(pod2.Get(0), 11.0, 20.0);
-	anim.SetConstantPosition(pod2.Get(1), 12.0, 20.0);
-	anim.SetConstantPosition(pod2.Get(2), 13.0, 20.0);
-	anim.SetConstantPosition(pod2.Get(3), 14.0, 20.0);
-	anim.SetConstantPosition(pod2.Get(4), 11.5, 16.0);
-	anim.SetConstantPosition(pod2.Get(5), 13.5, 16.0);
-	anim.SetConstantPosition(pod2.Get(6), 11.5, 12.0);
-	anim.SetConstantPosition(pod2.Get(7), 13.5, 12.0);
-	
-	// Pod 3 节点位置 (右侧)
-	anim.SetConstantPosition(pod3.Get(0), 16.0, 20.0);
-	anim.SetConstantPosition(pod3.Get(1), 17.0, 20.0);
-	anim.SetConstantPosition(pod3.Get(2), 18.0, 20.0);
-	anim.SetConstantPosition(pod3.Get(3), 19.0, 20.0);
-	anim.SetConstantPosition(pod3.Get(4), 16.5, 16.0);
-	anim.SetConstantPosition(pod3.Get(5), 18.5, 16.0);
-	anim.SetConstantPosition(pod3.Get(6), 16.5, 12.0);
-	anim.SetConstantPosition(pod3.Get(7), 18.5, 12.0);
-	
-	// 核心层交换机位置 (底部中央，均匀分布)
-	anim.SetConstantPosition(core.Get(0), 2.5, 7.0);   // Core 0
-	anim.SetConstantPosition(core.Get(1), 7.5, 7.0);   // Core 1
-	anim.SetConstantPosition(core.Get(2), 12.5, 7.0);  // Core 2
-	anim.SetConstantPosition(core.Get(3), 17.5, 7.0);  // Core 3
+	// AnimationInterface 需要观察全部节点，因此只在单分区运行时启用
+	std::unique_ptr<AnimationInterface> anim;
+	if (netanim && nPartitions == 1)
+	{
+		anim = std::make_unique<AnimationInterface>("animation.xml");
+	
+		// 每个 Pod 占据 (k/2)^2 + 1 个单位宽度，服务器间隔 1 个单位
+		// k=4 时与 2.0 版本的坐标完全相同
+		const double podWidth = serversPerPod + 1;
+		for (uint32_t p = 0; p < k; ++p)
+		{
+			double x0 = 1.0 + p * podWidth;
+			for (uint32_t s = 0; s < serversPerPod; ++s)
+			{
+				anim->SetConstantPosition(pods[p].Get(s), x0 + s, 20.0);                 // Server
+			}
+			for (uint32_t i = 0; i < half; ++i)
+			{
+				double x = x0 + 0.5 + i * double(serversPerPod - 2) / (half - 1);
+				anim->SetConstantPosition(pods[p].Get(accessBase + i), x, 16.0);          // Access SW
+				anim->SetConstantPosition(pods[p].Get(aggrBase + i), x, 12.0);            // Aggr SW
+			}
+		}
+	
+		// 核心层交换机位置 (底部，均匀分布)
+		const double coreSpacing = k * podWidth / nCore;
+		for (uint32_t c = 0; c < nCore; ++c)
+		{
+			anim->SetConstantPosition(core.Get(c), 2.5 + c * coreSpacing, 7.0);
+		}
+	}
+	
+	// 8.5 输出划分摘要 (仅 rank 0)
+	const std::string unit = (partitions > 0) ? "partition" : "rank";
+	if (systemId == 0)
+	{
+		std::cout << "Fat-Tree k=" << k << ": " << k * serversPerPod << " servers, "
+		          << k * k << " pod switches, " << nCore << " core switches" << std::endl;
+		for (uint32_t r = 0; r < nPartitions; ++r)
+		{
+			uint32_t nPods = 0;
+			uint32_t nCores = 0;
+			for (uint32_t p = 0; p < k; ++p)
+			{
+				nPods += (podRank(p) == r) ? 1 : 0;
+			}
+			for (uint32_t c = 0; c < nCore; ++c)
+			{
+				nCores += (coreRank(c) == r) ? 1 : 0;
+			}
+			std::cout << "  " << unit << " " << r << ": " << nPods << " pods, " << nCores
+			          << " core switches, " << nPods * nodesPerPod + nCores << " nodes" << std::endl;
+		}
+		std::cout << "  cross-" << unit << " links: " << crossRankLinks << " of " << coreDevs.size()
+		          << " aggregation-core links (lookahead 50ns)" << std::endl;
+	}
 			
 	// ========================================================================
 	// 9. 运行仿真与收尾
@@ -509,20 +883,92 @@ int main(int argc, char *argv[])
 	
 	// 9.2 启动仿真
 	NS_LOG_INFO("Starting simulation...");
+	auto wallStart = std::chrono::steady_clock::now();
 	Simulator::Run();
+	double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
 	NS_LOG_INFO("Simulation completed.");
+	// 共享内存并行时 Run() 返回后每个分区进程都继续执行，partitionId 为本进程的分区
+	const uint32_t partitionId = Simulator::GetSystemId();
+	if (partitions == 0)
+	{
+		std::cout << "rank " << systemId << ": " << localNodes.GetN() << " local nodes, wall time "
+		          << wallSeconds << " s" << std::endl;
+	}
+	else if (partitionId == 0)
+	{
+		// 各分区的事件数、同步开销由 FatTreeShmSimulatorImpl 在 Run() 结束时输出
+		std::cout << nPartitions << " partitions: wall time " << wallSeconds << " s" << std::endl;
+	}
 	
 	// 9.3 导出 FlowMonitor 统计数据
 	// 生成 DCN_FatTree_FlowStat.flowmon 文件，包含所有流的详细统计信息
+	// 多分区时每个进程写各自的文件: DCN_FatTree_FlowStat_rank<N>.flowmon，
+	// 跨分区的流只有发送端的记录 (见 8.2)，整条流的指标见 9.4 的运行摘要
 	// 参数说明:
 	//   - 第一个 true: 包含每个流的详细信息
 	//   - 第二个 true: 包含每个探针 (Probe) 的详细信息
-	flowmonHelper.SerializeToXmlFile("DCN_FatTree_FlowStat.flowmon", true, true);
-	NS_LOG_INFO("FlowMonitor statistics exported to DCN_FatTree_FlowStat.flowmon");
-	
-	// 9.4 清理仿真器，释放所有分配的内存
+	std::string flowmonFile = "DCN_FatTree_FlowStat.flowmon";
+	if (nPartitions > 1)
+	{
+		flowmonFile = "DCN_FatTree_FlowStat_rank" + std::to_string(partitionId) + ".flowmon";
+	}
+	flowmonHelper.SerializeToXmlFile(flowmonFile, true, true);
+	NS_LOG_INFO("FlowMonitor statistics exported to " << flowmonFile);
+	
+	// 9.4 写出运行摘要
+	//   - 顺序运行: 直接写 <summary>
+	//   - 共享内存并行: 每个分区先写 <summary>.rank<N>.flows (本分区的逐流统计)，
+	//     9.5 中 LP 0 等所有子进程退出后按五元组合并，写出与顺序运行相同格式的 <summary>
+	//   - MPI: 各 rank 之间没有共同的退出点，每个 rank 写 <summary>.rank<N>，只含本 rank 服务器上
+	//     记录的一半: 跨 rank 的流在发送端的文件中没有接收记录，不是整条流的统计
+	if (!summaryFile.empty())
+	{
+		const DataFlowTable &flows = recorder.GetFlows();
+		std::string path = summaryFile;
+		bool ok;
+		if (partitions > 1)
+		{
+			path += ".rank" + std::to_string(partitionId) + ".flows";
+			ok = WriteDataFlows(path, flows, Simulator::GetEventCount());
+		}
+		else
+		{
+			if (nPartitions > 1)
+			{
+				path += ".rank" + std::to_string(partitionId);
+			}
+			ok = WriteRunSummary(path, flows, Simulator::GetEventCount(), wallSeconds);
+		}
+		if (!ok)
+		{
+			std::cerr << "Cannot write summary to " << path << std::endl;
+		}
+	}
+
+	// 9.5 清理仿真器，释放所有分配的内存
+	// 共享内存并行时 LP 0 的 Destroy() 会等待所有子进程退出，之后才能合并各分区的摘要
 	Simulator::Destroy();
+#ifdef NS3_MPI
+	MpiInterface::Disable();
+#endif
+	if (!summaryFile.empty() && partitions > 1 && partitionId == 0)
+	{
+		DataFlowTable flows;
+		uint64_t events = 0;
+		bool ok = true;
+		for (uint32_t r = 0; r < nPartitions; ++r)
+		{
+			std::string part = summaryFile + ".rank" + std::to_string(r) + ".flows";
+			ok = ReadDataFlows(part, flows, events) && ok;
+			std::remove(part.c_str());
+		}
+		if (!ok || !WriteRunSummary(summaryFile, flows, events, wallSeconds))
+		{
+			std::cerr << "Cannot merge partition summaries into " << summaryFile << std::endl;
+			return 1;
+		}
+	}
 	NS_LOG_INFO("Simulation resources cleaned up. Done.");
 
 	return 0;
-}
\ No newline at end of file
+}
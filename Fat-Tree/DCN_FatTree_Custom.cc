@@ -42,6 +42,7 @@
 #include "ns3/mobility-module.h"
 #include "ns3/netanim-module.h"
 #include "ns3/flow-monitor-helper.h"
+#include "fat-tree-scheduler.h"  // 事件调度器选择
 
 using namespace ns3;
 using namespace std;
@@ -90,7 +91,10 @@ int main(int argc, char *argv[])
 	// ========================================================================
 	
 	CommandLine cmd;
+	std::string scheduler = "map";  // 事件调度器 (map 为 ns-3 默认，见 fat-tree-scheduler.h)
+	cmd.AddValue("scheduler", "Event scheduler: map, heap, list, calendar, priority or radix", scheduler);
 	cmd.Parse(argc, argv);
+	GlobalValue::Bind("SchedulerType", StringValue(FatTreeSchedulerType(scheduler)));
 	
 	Time::SetResolution(Time::NS);
 	LogComponentEnable("UdpEchoClientApplication", LOG_LEVEL_INFO);
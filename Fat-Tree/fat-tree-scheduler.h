@@ -0,0 +1,503 @@
+/*
+ * ============================================================================
+ * 标题: 事件调度器选择与基数堆 (radix heap) 调度器
+ * ============================================================================
+ *
+ * 【设计目的】
+ *   高负载时 Fat-Tree 仿真的大部分时间花在事件队列上: 每个数据包在每一跳
+ *   都要插入和取出若干事件 (发送完成、到达接收端)。ns-3 默认的 MapScheduler
+ *   是红黑树，每次插入/取出都是 O(log n) 的指针跳转。本文件提供:
+ *   - FatTreeRadixHeapScheduler: 针对纳秒时间戳的单调事件流的基数堆
+ *   - FatTreeSchedulerType(): 把 map/heap/list/calendar/priority/radix 映射为 TypeId
+ *   - FatTreeAutoSelectScheduler(): 在拓扑副本上试跑一小段前缀，选出最快的调度器
+ *
+ * 【基数堆的原理】
+ *   离散事件仿真的事件键是单调的: 新事件的时间戳总是 >= 当前时间，
+ *   也就是 >= 最后一个取出的事件的时间戳 (记为 last)。
+ *   把事件放入第 b 个桶，b 为 ts XOR last 的最高位位置 (相等时 b = 0):
+ *   - 插入只需一次异或和一次 clz，O(1)
+ *   - 桶 i 中所有事件都早于桶 i+1 中的事件，桶 0 中事件的时间戳都等于 last
+ *   - 桶 0 为空时，找到最低的非空桶，以其中最小的时间戳为新的 last 重新分配，
+ *     每个事件只会向更低的桶移动，总共最多移动 64 次，均摊 O(1)
+ *   40G 链路上一个 1500 字节的包只需 300ns，大量事件集中在当前时间之后的
+ *   几微秒内，对应的都是低位桶，重新分配的代价很小。
+ *   同一时间戳的事件按 uid (调度顺序) 先后执行，与其他调度器一致。
+ *
+ * 【调度器自动选择】(--scheduler=auto)
+ *   拓扑和应用建好之后 (仿真时间 0)，对每个候选调度器 fork 一个子进程:
+ *   子进程切换调度器，运行到前缀时间，把 Run() 的墙钟时间经管道交给父进程后退出。
+ *   每个子进程都从完全相同的状态开始，测量的是同一段事件序列。
+ *   父进程选出最快的调度器后用 Simulator::SetScheduler() 切换，再运行完整仿真。
+ *   已经比当前最快者慢的子进程会被提前结束，因此 list 这类慢调度器不会拖长选择过程。
+ *
+ * 【使用限制】
+ *   - 自动选择只适用于顺序仿真 (不能与 MPI 或 --partitions 同时使用)
+ *   - 必须在打开 PCAP、NetAnim 等输出文件之前调用，否则子进程会写入同一文件;
+ *     子进程在父进程创建的临时目录中运行 (结束后由父进程删除)，并丢弃标准输出
+ *   - 只在 Linux/POSIX 上可用 (fork, pipe)
+ *
+ * 作者: Liu Mengxuan
+ * ns-3 版本: 3.44
+ * ============================================================================
+ */
+
+#ifndef FAT_TREE_SCHEDULER_H
+#define FAT_TREE_SCHEDULER_H
+
+#include "ns3/core-module.h"
+
+#include <fcntl.h>
+#include <ftw.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * @brief 单调整数键上的基数堆调度器
+ *
+ * 事件键的单调性由仿真器保证 (新事件时间戳 >= 当前时间)。
+ * 为了在任何用法下都正确 (例如分区仿真器筛选事件后重新插入)，
+ * 插入早于 last 的事件时会把 last 下调并重新分配所有事件，代价为 O(n)，正常运行中不会发生。
+ */
+class FatTreeRadixHeapScheduler : public Scheduler
+{
+  public:
+    static TypeId GetTypeId();
+
+    FatTreeRadixHeapScheduler();
+    ~FatTreeRadixHeapScheduler() override;
+
+    void Insert(const Event& ev) override;
+    bool IsEmpty() const override;
+    Event PeekNext() const override;
+    Event RemoveNext() override;
+    void Remove(const Event& ev) override;
+
+  private:
+    static const uint32_t BUCKETS = 65; ///< 桶 0 + 64 个位位置
+
+    /** 时间戳相对 m_last 所在的桶 */
+    uint32_t BucketOf(uint64_t ts) const;
+    /** 放入对应的桶; 桶 0 保持按 uid 有序 */
+    void Place(const Event& ev);
+    /** 最低的非空桶 (不含桶 0) 中最小事件的下标，结果缓存在 m_min* 中 */
+    void FindMin() const;
+    /** 以最低非空桶中的最小时间戳为新的 last，把该桶分配到更低的桶 */
+    void Redistribute();
+    /** 把 last 下调到 ts 并重新分配所有事件 (只用于非单调插入) */
+    void Rebase(uint64_t ts);
+
+    std::vector<Event> m_buckets[BUCKETS];
+    std::size_t m_head;        ///< 桶 0 的队头 (已取出的前缀不立即擦除)
+    uint64_t m_mask;           ///< 第 i-1 位表示桶 i (1..64) 非空
+    uint64_t m_last;           ///< 最后取出的时间戳
+    std::size_t m_size;        ///< 事件总数
+
+    mutable bool m_minValid;   ///< m_minBucket/m_minIndex 是否有效
+    mutable uint32_t m_minBucket;
+    mutable std::size_t m_minIndex;
+};
+
+NS_OBJECT_ENSURE_REGISTERED(FatTreeRadixHeapScheduler);
+
+inline TypeId
+FatTreeRadixHeapScheduler::GetTypeId()
+{
+    static TypeId tid = TypeId("ns3::FatTreeRadixHeapScheduler")
+                            .SetParent<Scheduler>()
+                            .SetGroupName("Core")
+                            .AddConstructor<FatTreeRadixHeapScheduler>();
+    return tid;
+}
+
+inline FatTreeRadixHeapScheduler::FatTreeRadixHeapScheduler()
+    : m_head(0),
+      m_mask(0),
+      m_last(0),
+      m_size(0),
+      m_minValid(false),
+      m_minBucket(0),
+      m_minIndex(0)
+{
+}
+
+inline FatTreeRadixHeapScheduler::~FatTreeRadixHeapScheduler()
+{
+}
+
+inline uint32_t
+FatTreeRadixHeapScheduler::BucketOf(uint64_t ts) const
+{
+    uint64_t diff = ts ^ m_last;
+    return diff == 0 ? 0 : 64 - __builtin_clzll(diff);
+}
+
+inline void
+FatTreeRadixHeapScheduler::Place(const Event& ev)
+{
+    uint32_t b = BucketOf(ev.key.m_ts);
+    std::vector<Event>& bucket = m_buckets[b];
+    if (b == 0)
+    {
+        // 当前时间的新事件 uid 最大，通常直接追加
+        if (bucket.size() == m_head || bucket.back().key.m_uid < ev.key.m_uid)
+        {
+            bucket.push_back(ev);
+        }
+        else
+        {
+            auto pos = std::upper_bound(bucket.begin() + m_head, bucket.end(), ev);
+            bucket.insert(pos, ev);
+        }
+        return;
+    }
+    bucket.push_back(ev);
+    m_mask |= uint64_t(1) << (b - 1);
+    // 缓存的最小事件仍在原位置 (只在桶尾追加)，只需与新事件比较
+    if (m_minValid && ev < m_buckets[m_minBucket][m_minIndex])
+    {
+        m_minBucket = b;
+        m_minIndex = bucket.size() - 1;
+    }
+}
+
+inline void
+FatTreeRadixHeapScheduler::Insert(const Event& ev)
+{
+    if (ev.key.m_ts < m_last)
+    {
+        Rebase(ev.key.m_ts);
+    }
+    Place(ev);
+    m_size++;
+}
+
+inline bool
+FatTreeRadixHeapScheduler::IsEmpty() const
+{
+    return m_size == 0;
+}
+
+inline void
+FatTreeRadixHeapScheduler::FindMin() const
+{
+    if (m_minValid)
+    {
+        return;
+    }
+    NS_ASSERT(m_mask != 0);
+    uint32_t b = __builtin_ctzll(m_mask) + 1;
+    const std::vector<Event>& bucket = m_buckets[b];
+    std::size_t best = 0;
+    for (std::size_t i = 1; i < bucket.size(); ++i)
+    {
+        if (bucket[i] < bucket[best])
+        {
+            best = i;
+        }
+    }
+    m_minBucket = b;
+    m_minIndex = best;
+    m_minValid = true;
+}
+
+inline Scheduler::Event
+FatTreeRadixHeapScheduler::PeekNext() const
+{
+    NS_ASSERT(!IsEmpty());
+    if (m_buckets[0].size() > m_head)
+    {
+        return m_buckets[0][m_head];
+    }
+    FindMin();
+    return m_buckets[m_minBucket][m_minIndex];
+}
+
+inline void
+FatTreeRadixHeapScheduler::Redistribute()
+{
+    FindMin();
+    uint32_t b = m_minBucket;
+    std::vector<Event> moving;
+    moving.swap(m_buckets[b]);
+    m_mask &= ~(uint64_t(1) << (b - 1));
+    m_minValid = false;
+
+    m_buckets[0].clear();
+    m_head = 0;
+    m_last = moving[m_minIndex].key.m_ts;
+    for (const Event& ev : moving)
+    {
+        uint32_t nb = BucketOf(ev.key.m_ts);
+        m_buckets[nb].push_back(ev);
+        if (nb != 0)
+        {
+            m_mask |= uint64_t(1) << (nb - 1);
+        }
+    }
+    // 桶 0 中的事件来自同一个旧桶，顺序任意，按 uid 排好
+    std::sort(m_buckets[0].begin(), m_buckets[0].end());
+    // 重新分配后 moving 的容量留给原桶复用，避免反复分配
+    moving.clear();
+    m_buckets[b].swap(moving);
+}
+
+inline Scheduler::Event
+FatTreeRadixHeapScheduler::RemoveNext()
+{
+    NS_ASSERT(!IsEmpty());
+    if (m_buckets[0].size() == m_head)
+    {
+        Redistribute();
+    }
+    Event ev = m_buckets[0][m_head++];
+    if (m_head == m_buckets[0].size())
+    {
+        m_buckets[0].clear();
+        m_head = 0;
+    }
+    m_size--;
+    return ev;
+}
+
+inline void
+FatTreeRadixHeapScheduler::Remove(const Event& ev)
+{
+    uint32_t b = BucketOf(ev.key.m_ts);
+    std::vector<Event>& bucket = m_buckets[b];
+    std::size_t begin = (b == 0) ? m_head : 0;
+    for (std::size_t i = begin; i < bucket.size(); ++i)
+    {
+        if (bucket[i].key.m_uid == ev.key.m_uid)
+        {
+            NS_ASSERT(bucket[i].impl == ev.impl);
+            bucket.erase(bucket.begin() + i);
+            if (b != 0 && bucket.empty())
+            {
+                m_mask &= ~(uint64_t(1) << (b - 1));
+            }
+            if (b != 0)
+            {
+                m_minValid = false;
+            }
+            m_size--;
+            return;
+        }
+    }
+    NS_ASSERT_MSG(false, "FatTreeRadixHeapScheduler: event to remove not found");
+}
+
+inline void
+FatTreeRadixHeapScheduler::Rebase(uint64_t ts)
+{
+    std::vector<Event> all;
+    all.reserve(m_size);
+    for (uint32_t b = 0; b < BUCKETS; ++b)
+    {
+        std::size_t begin = (b == 0) ? m_head : 0;
+        all.insert(all.end(), m_buckets[b].begin() + begin, m_buckets[b].end());
+        m_buckets[b].clear();
+    }
+    m_head = 0;
+    m_mask = 0;
+    m_minValid = false;
+    m_last = ts;
+    for (const Event& ev : all)
+    {
+        Place(ev);
+    }
+}
+
+// ============================================================================
+// 调度器选择
+// ============================================================================
+
+/**
+ * @brief 把调度器的简称映射为 TypeId 名称
+ *
+ * map / heap / list / calendar / priority 为 ns-3 自带的调度器，radix 为本文件的基数堆;
+ * 以 "ns3::" 开头的名字原样返回。未知名称直接终止。
+ */
+inline std::string
+FatTreeSchedulerType(const std::string& name)
+{
+    if (name == "map")
+    {
+        return "ns3::MapScheduler";
+    }
+    if (name == "heap")
+    {
+        return "ns3::HeapScheduler";
+    }
+    if (name == "list")
+    {
+        return "ns3::ListScheduler";
+    }
+    if (name == "calendar")
+    {
+        return "ns3::CalendarScheduler";
+    }
+    if (name == "priority")
+    {
+        return "ns3::PriorityQueueScheduler";
+    }
+    if (name == "radix")
+    {
+        return "ns3::FatTreeRadixHeapScheduler";
+    }
+    if (name.rfind("ns3::", 0) == 0)
+    {
+        return name;
+    }
+    NS_ABORT_MSG("Unknown scheduler '" << name
+                 << "' (expected map, heap, list, calendar, priority, radix or auto)");
+    return "";
+}
+
+/**
+ * @brief 在当前仿真状态的副本上试跑各候选调度器，切换到最快的一个并返回其简称
+ * @param candidates 调度器简称，按顺序测量 (第一个作为基准，应选一个不会很慢的)
+ * @param prefix 每个候选运行到的仿真时间 (绝对时间)
+ * @param verbose 是否输出每个候选的测量结果
+ *
+ * 必须在仿真开始之前 (Simulator::Now() 为 0) 调用，见文件头的使用限制。
+ */
+inline std::string
+FatTreeAutoSelectScheduler(const std::vector<std::string>& candidates, Time prefix, bool verbose)
+{
+    NS_ABORT_MSG_IF(candidates.empty(), "FatTreeAutoSelectScheduler: no candidates");
+    NS_ABORT_MSG_IF(prefix <= Simulator::Now(), "FatTreeAutoSelectScheduler: prefix must be in the future");
+
+    // 子进程写回的测量结果
+    struct Measurement
+    {
+        double seconds;
+        uint64_t events;
+    };
+
+    std::string best;
+    double bestSeconds = 0; // 最快者的 Run() 时间 (选择依据)
+    double bestElapsed = 0; // 最快者从 fork 到退出的总时间 (提前结束的依据)
+    for (const std::string& name : candidates)
+    {
+        ObjectFactory factory;
+        factory.SetTypeId(FatTreeSchedulerType(name));
+
+        // 子进程的工作目录由父进程创建和删除: 被提前结束 (SIGKILL) 的子进程来不及自己清理
+        char dir[] = "/tmp/fat-tree-sched-XXXXXX";
+        NS_ABORT_MSG_IF(mkdtemp(dir) == nullptr, "FatTreeAutoSelectScheduler: mkdtemp failed");
+        int fds[2];
+        NS_ABORT_MSG_IF(pipe(fds) != 0, "FatTreeAutoSelectScheduler: pipe failed");
+        // fork 前清空输出缓冲，否则子进程会重复输出父进程尚未写出的内容
+        std::cout.flush();
+        std::cerr.flush();
+        auto start = std::chrono::steady_clock::now();
+        pid_t pid = fork();
+        NS_ABORT_MSG_IF(pid < 0, "FatTreeAutoSelectScheduler: fork failed");
+        if (pid == 0)
+        {
+            // 子进程: 丢弃输出，在临时目录中运行，避免覆盖父进程的输出文件
+            close(fds[0]);
+            int devnull = open("/dev/null", O_WRONLY);
+            if (devnull >= 0)
+            {
+                dup2(devnull, STDOUT_FILENO);
+                dup2(devnull, STDERR_FILENO);
+            }
+            if (chdir(dir) != 0)
+            {
+                _exit(1);
+            }
+            Simulator::SetScheduler(factory);
+            Simulator::Stop(prefix - Simulator::Now());
+            uint64_t before = Simulator::GetEventCount();
+            auto runStart = std::chrono::steady_clock::now();
+            Simulator::Run();
+            Measurement m;
+            m.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - runStart).count();
+            m.events = Simulator::GetEventCount() - before;
+            bool ok = write(fds[1], &m, sizeof(m)) == ssize_t(sizeof(m));
+            _exit(ok ? 0 : 1);
+        }
+        close(fds[1]);
+
+        // 父进程: 子进程的总时间明显超过当前最快者时不可能胜出，直接结束
+        // (总时间包含 fork 和切换调度器的开销，留 0.1 s 余量)
+        int status = 0;
+        bool killed = false;
+        double elapsed = 0;
+        while (waitpid(pid, &status, WNOHANG) == 0)
+        {
+            elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            if (!best.empty() && elapsed > bestElapsed + 0.1)
+            {
+                kill(pid, SIGKILL);
+                waitpid(pid, &status, 0);
+                killed = true;
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        Measurement m;
+        bool ok = !killed && WIFEXITED(status) && WEXITSTATUS(status) == 0 &&
+                  read(fds[0], &m, sizeof(m)) == ssize_t(sizeof(m));
+        close(fds[0]);
+        // 删除子进程在工作目录中写下的所有文件
+        nftw(
+            dir,
+            [](const char* path, const struct stat*, int, struct FTW*) { return std::remove(path); },
+            16,
+            FTW_DEPTH | FTW_PHYS);
+
+        if (verbose)
+        {
+            std::cout << "  scheduler " << std::setw(8) << std::left << name << std::right;
+            if (ok)
+            {
+                std::cout << std::fixed << std::setprecision(3) << m.seconds << " s, " << m.events
+                          << " events, " << std::setprecision(0) << m.events / std::max(m.seconds, 1e-9)
+                          << " events/s" << std::defaultfloat << std::setprecision(6) << std::endl;
+            }
+            else if (killed)
+            {
+                std::cout << "stopped after " << std::fixed << std::setprecision(3) << elapsed
+                          << " s (slower than " << best << ")" << std::defaultfloat
+                          << std::setprecision(6) << std::endl;
+            }
+            else
+            {
+                std::cout << "failed" << std::endl;
+            }
+        }
+        if (ok && (best.empty() || m.seconds < bestSeconds))
+        {
+            best = name;
+            bestSeconds = m.seconds;
+            bestElapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+    }
+    NS_ABORT_MSG_IF(best.empty(), "FatTreeAutoSelectScheduler: every candidate failed");
+
+    ObjectFactory factory;
+    factory.SetTypeId(FatTreeSchedulerType(best));
+    Simulator::SetScheduler(factory);
+    return best;
+}
+
+} // namespace ns3
+
+#endif /* FAT_TREE_SCHEDULER_H */
@@ -0,0 +1,936 @@
+/*
+ * ============================================================================
+ * 标题: 基于共享内存的保守并行仿真器 (按 Pod 划分的逻辑进程)
+ * ============================================================================
+ *
+ * 【设计目的】
+ *   MPI 分布式仿真 (DistributedSimulatorImpl) 需要 MPI 环境，而大多数机器是
+ *   没有 MPI 的多核单机。FatTreeShmSimulatorImpl 在单机上完成同样的事情:
+ *   节点按 systemId 划分为若干逻辑进程 (LP)，每个 LP 有自己的事件队列，
+ *   在由最小跨分区链路延迟 (lookahead) 决定的安全窗口内独立推进。
+ *
+ * 【为什么是进程而不是线程】
+ *   ns-3.44 的核心数据结构不是线程安全的: Buffer 和 PacketMetadata 的空闲链表、
+ *   Packet 的全局 uid 计数器、Ptr 的非原子引用计数都是进程级全局状态，
+ *   多个线程同时收发数据包会破坏它们。因此 Run() 在拓扑建好之后 fork 出
+ *   N-1 个子进程，每个进程持有完整对象图的私有副本，只执行本 LP 节点上的事件；
+ *   跨分区的数据包经共享内存 (mmap) 邮箱传递，同步用共享内存中的自旋屏障。
+ *   这与 MPI 版本的模型完全相同 (每个 rank 都创建完整拓扑)，只是传输层不同。
+ *
+ * 【同步算法】(YAWNS 风格的保守时间窗口，每个窗口一次屏障)
+ *   1. 每个 LP 发布 min(本地下一个事件时间, 上个窗口发出的消息的最早到达时间)
+ *   2. 屏障; 所有 LP 计算相同的下界 LBTS = 各 LP 发布值的最小值
+ *   3. 取出上个窗口发给自己的消息，作为 PointToPointNetDevice::Receive 事件入队
+ *   4. 处理时间戳 < LBTS + lookahead 的本地事件，跨分区发送的数据包写入邮箱
+ *   发布槽和邮箱都按窗口奇偶双缓冲，保证读写不会在同一窗口内交叠。
+ *
+ * 【使用方法】
+ *   - 节点用 NodeContainer::Create(n, systemId) 指定所属分区 (0..N-1)
+ *   - 跨分区链路必须用 InstallFatTreeShmLink() 创建 (FatTreeShmChannel)，
+ *     其他信道跨分区时 Run() 报错; lookahead 为跨分区 FatTreeShmChannel 延迟的最小值
+ *   - 绑定 SimulatorImplementationType 为 ns3::FatTreeShmSimulatorImpl
+ *   - Run() 返回后每个进程都会继续执行 main 的剩余部分，
+ *     输出文件名应包含 Simulator::GetSystemId()
+ *   - PCAP、NetAnim 等在 Run() 之前打开文件的输出会被多个进程共享，不能使用
+ *
+ * 【限制】
+ *   - 仿真期间除 FatTreeShmChannel 外不能向其他分区的节点调度事件
+ *   - 只在 Linux/POSIX 上可用 (fork, mmap)
+ *
+ * 作者: Liu Mengxuan
+ * ns-3 版本: 3.44
+ * ============================================================================
+ */
+
+#ifndef FAT_TREE_SHM_SIMULATOR_IMPL_H
+#define FAT_TREE_SHM_SIMULATOR_IMPL_H
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/point-to-point-module.h"
+
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <list>
+#include <new>
+#include <thread>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * @brief 跨分区的点对点信道
+ *
+ * 对端在本分区时与 PointToPointChannel 完全相同；
+ * 对端在其他分区时把数据包序列化后交给 FatTreeShmSimulatorImpl 的邮箱
+ * (与 PointToPointRemoteChannel 交给 MpiInterface 的做法相同)。
+ */
+class FatTreeShmChannel : public PointToPointChannel
+{
+public:
+    static TypeId GetTypeId();
+
+    bool TransmitStart(Ptr<const Packet> p, Ptr<PointToPointNetDevice> src, Time txTime) override;
+
+    /**
+     * @brief 链路传播延迟 (用于计算 lookahead)
+     */
+    Time GetLinkDelay() const;
+};
+
+/**
+ * @brief 按 systemId 分区、基于 fork + 共享内存的保守并行仿真器
+ */
+class FatTreeShmSimulatorImpl : public SimulatorImpl
+{
+public:
+    static TypeId GetTypeId();
+
+    FatTreeShmSimulatorImpl();
+    ~FatTreeShmSimulatorImpl() override;
+
+    // SimulatorImpl
+    void Destroy() override;
+    bool IsFinished() const override;
+    void Stop() override;
+    EventId Stop(const Time& delay) override;
+    EventId Schedule(const Time& delay, EventImpl* event) override;
+    void ScheduleWithContext(uint32_t context, const Time& delay, EventImpl* event) override;
+    EventId ScheduleNow(EventImpl* event) override;
+    EventId ScheduleDestroy(EventImpl* event) override;
+    void Remove(const EventId& id) override;
+    void Cancel(const EventId& id) override;
+    bool IsExpired(const EventId& id) const override;
+    void Run() override;
+    Time Now() const override;
+    Time GetDelayLeft(const EventId& id) const override;
+    Time GetMaximumSimulationTime() const override;
+    void SetScheduler(ObjectFactory schedulerFactory) override;
+    uint32_t GetSystemId() const override;
+    uint32_t GetContext() const override;
+    uint64_t GetEventCount() const override;
+
+    /**
+     * @brief 正在并行运行的实例 (供 FatTreeShmChannel 使用)，未运行时为 nullptr
+     */
+    static FatTreeShmSimulatorImpl* GetRunning();
+
+    /**
+     * @brief 节点是否属于本 LP
+     */
+    bool IsLocal(uint32_t nodeId) const;
+
+    /**
+     * @brief 把数据包发往其他分区的节点，在 rxTime 时刻交给其网卡的 Receive()
+     */
+    void SendPacket(Ptr<const Packet> p, Time rxTime, uint32_t nodeId, uint32_t ifIndex);
+
+protected:
+    void DoDispose() override;
+
+private:
+    static constexpr uint64_t NEVER = std::numeric_limits<uint64_t>::max();
+    static constexpr uint32_t NO_CONTEXT = 0xffffffff;
+
+    // 共享内存中的结构都只包含无锁原子量和普通数据，可以跨进程使用
+    struct alignas(64) Slot
+    {
+        uint64_t next;  // 本 LP 发布的时间下界
+        uint32_t stop;  // 本 LP 已执行 Stop()
+    };
+
+    struct alignas(64) LpStats
+    {
+        uint64_t events;
+        uint64_t windows;
+        uint64_t sent;
+        uint64_t received;
+        double busySeconds;  // 处理事件的时间
+        double syncSeconds;  // 屏障等待和取邮箱的时间
+    };
+
+    struct MessageHeader
+    {
+        uint64_t ts;       // 到达时间 (time step)
+        uint32_t nodeId;   // 目的节点
+        uint32_t ifIndex;  // 目的网卡
+        uint32_t size;     // 序列化后的数据包长度
+        uint32_t pad;
+    };
+
+    struct Shared
+    {
+        alignas(64) std::atomic<uint32_t> arrived;
+        alignas(64) std::atomic<uint32_t> generation;
+        alignas(64) std::atomic<uint32_t> failed;
+    };
+
+    void ProcessOneEvent();
+    uint64_t NextTs() const;
+    void Partition();
+    void RunWindows();
+    void Barrier();
+    void Drain(uint32_t parity);
+    void Report(double wallSeconds) const;
+
+    Slot& GetSlot(uint32_t parity, uint32_t lp) const;
+    LpStats& GetStats(uint32_t lp) const;
+    uint8_t* GetMailbox(uint32_t parity, uint32_t src, uint32_t dst) const;
+
+    // 事件队列 (与 DefaultSimulatorImpl 相同)
+    Ptr<Scheduler> m_events;
+    std::list<EventId> m_destroyEvents;
+    uint32_t m_uid;
+    uint32_t m_currentUid;
+    uint64_t m_currentTs;
+    uint32_t m_currentContext;
+    uint64_t m_eventCount;
+    int m_unscheduledEvents;
+    bool m_stop;
+
+    // 分区
+    uint32_t m_mailboxBytes;              // 每个 (源, 目的, 奇偶) 邮箱的容量
+    uint32_t m_lp;                        // 本进程的 LP 编号
+    uint32_t m_nLps;                      // LP 数量
+    std::vector<uint32_t> m_partitionOf;  // 节点 id -> LP
+    uint64_t m_lookahead;                 // time step
+    uint32_t m_parity;                    // 当前窗口的奇偶
+    uint64_t m_sentMin;                   // 本窗口发出消息的最早到达时间
+    std::vector<pid_t> m_children;        // 仅 LP 0: 子进程
+    pid_t m_parent;
+
+    // 共享内存
+    uint8_t* m_shm;
+    size_t m_shmBytes;
+    Shared* m_shared;
+    size_t m_slotOffset;
+    size_t m_statsOffset;
+    size_t m_mailboxOffset;
+
+    inline static FatTreeShmSimulatorImpl* s_running = nullptr;
+};
+
+/**
+ * @brief 在 a 和 b 之间创建一条 FatTreeShmChannel 点对点链路
+ *
+ * 等价于 PointToPointHelper::Install (网卡、DropTail 队列、NetDeviceQueueInterface)，
+ * 只是信道类型不同; PointToPointHelper 的信道类型固定，无法替换。
+ */
+inline NetDeviceContainer
+InstallFatTreeShmLink(Ptr<Node> a,
+                      Ptr<Node> b,
+                      DataRate rate,
+                      Time delay,
+                      QueueSize queueSize)
+{
+    NetDeviceContainer devices;
+    Ptr<FatTreeShmChannel> channel = CreateObject<FatTreeShmChannel>();
+    channel->SetAttribute("Delay", TimeValue(delay));
+    for (Ptr<Node> node : {a, b})
+    {
+        Ptr<PointToPointNetDevice> dev = CreateObject<PointToPointNetDevice>();
+        dev->SetAddress(Mac48Address::Allocate());
+        dev->SetDataRate(rate);
+        node->AddDevice(dev);
+        Ptr<DropTailQueue<Packet>> queue = CreateObject<DropTailQueue<Packet>>();
+        queue->SetMaxSize(queueSize);
+        dev->SetQueue(queue);
+        Ptr<NetDeviceQueueInterface> ndqi = CreateObject<NetDeviceQueueInterface>();
+        ndqi->GetTxQueue(0)->ConnectQueueTraces(queue);
+        dev->AggregateObject(ndqi);
+        dev->Attach(channel);
+        devices.Add(dev);
+    }
+    return devices;
+}
+
+// ============================================================================
+// FatTreeShmChannel
+// ============================================================================
+
+NS_OBJECT_ENSURE_REGISTERED(FatTreeShmChannel);
+
+inline TypeId
+FatTreeShmChannel::GetTypeId()
+{
+    static TypeId tid = TypeId("ns3::FatTreeShmChannel")
+        .SetParent<PointToPointChannel>()
+        .SetGroupName("PointToPoint")
+        .AddConstructor<FatTreeShmChannel>();
+    return tid;
+}
+
+inline bool
+FatTreeShmChannel::TransmitStart(Ptr<const Packet> p, Ptr<PointToPointNetDevice> src, Time txTime)
+{
+    uint32_t wire = src == GetSource(0) ? 0 : 1;
+    Ptr<PointToPointNetDevice> dst = GetDestination(wire);
+    FatTreeShmSimulatorImpl* impl = FatTreeShmSimulatorImpl::GetRunning();
+    if (impl == nullptr || impl->IsLocal(dst->GetNode()->GetId()))
+    {
+        return PointToPointChannel::TransmitStart(p, src, txTime);
+    }
+    impl->SendPacket(p, Simulator::Now() + txTime + GetDelay(), dst->GetNode()->GetId(),
+                     dst->GetIfIndex());
+    return true;
+}
+
+inline Time
+FatTreeShmChannel::GetLinkDelay() const
+{
+    return GetDelay();
+}
+
+// ============================================================================
+// FatTreeShmSimulatorImpl
+// ============================================================================
+
+NS_OBJECT_ENSURE_REGISTERED(FatTreeShmSimulatorImpl);
+
+inline TypeId
+FatTreeShmSimulatorImpl::GetTypeId()
+{
+    static TypeId tid = TypeId("ns3::FatTreeShmSimulatorImpl")
+        .SetParent<SimulatorImpl>()
+        .SetGroupName("Core")
+        .AddConstructor<FatTreeShmSimulatorImpl>()
+        .AddAttribute("MailboxBytes",
+                      "Capacity of each (source, destination) shared-memory mailbox per window",
+                      UintegerValue(1 << 20),
+                      MakeUintegerAccessor(&FatTreeShmSimulatorImpl::m_mailboxBytes),
+                      MakeUintegerChecker<uint32_t>(4096));
+    return tid;
+}
+
+inline FatTreeShmSimulatorImpl::FatTreeShmSimulatorImpl()
+    : m_uid(EventId::UID::VALID),
+      m_currentUid(EventId::UID::INVALID),
+      m_currentTs(0),
+      m_currentContext(NO_CONTEXT),
+      m_eventCount(0),
+      m_unscheduledEvents(0),
+      m_stop(false),
+      m_mailboxBytes(1 << 20),
+      m_lp(0),
+      m_nLps(1),
+      m_lookahead(NEVER),
+      m_parity(0),
+      m_sentMin(NEVER),
+      m_parent(0),
+      m_shm(nullptr),
+      m_shmBytes(0),
+      m_shared(nullptr),
+      m_slotOffset(0),
+      m_statsOffset(0),
+      m_mailboxOffset(0)
+{
+}
+
+inline FatTreeShmSimulatorImpl::~FatTreeShmSimulatorImpl()
+{
+}
+
+inline void
+FatTreeShmSimulatorImpl::DoDispose()
+{
+    while (m_events && !m_events->IsEmpty())
+    {
+        Scheduler::Event next = m_events->RemoveNext();
+        next.impl->Unref();
+    }
+    m_events = nullptr;
+    SimulatorImpl::DoDispose();
+}
+
+inline void
+FatTreeShmSimulatorImpl::Destroy()
+{
+    while (!m_destroyEvents.empty())
+    {
+        Ptr<EventImpl> ev = m_destroyEvents.front().PeekEventImpl();
+        m_destroyEvents.pop_front();
+        if (!ev->IsCancelled())
+        {
+            ev->Invoke();
+        }
+    }
+
+    // LP 0 等待子进程写完各自的输出后再退出
+    for (pid_t child : m_children)
+    {
+        int status = 0;
+        waitpid(child, &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        {
+            std::cerr << "FatTreeShm: partition process " << child << " exited abnormally"
+                      << std::endl;
+        }
+    }
+    m_children.clear();
+    if (m_shm != nullptr)
+    {
+        munmap(m_shm, m_shmBytes);
+        m_shm = nullptr;
+        m_shared = nullptr;
+    }
+}
+
+inline bool
+FatTreeShmSimulatorImpl::IsFinished() const
+{
+    return m_events->IsEmpty() || m_stop;
+}
+
+inline void
+FatTreeShmSimulatorImpl::Stop()
+{
+    m_stop = true;
+}
+
+inline EventId
+FatTreeShmSimulatorImpl::Stop(const Time& delay)
+{
+    return Simulator::Schedule(delay, &Simulator::Stop);
+}
+
+inline EventId
+FatTreeShmSimulatorImpl::Schedule(const Time& delay, EventImpl* event)
+{
+    NS_ASSERT_MSG(delay.IsPositive(), "FatTreeShmSimulatorImpl::Schedule(): negative delay");
+    Scheduler::Event ev;
+    ev.impl = event;
+    ev.key.m_ts = m_currentTs + delay.GetTimeStep();
+    ev.key.m_context = m_currentContext;
+    ev.key.m_uid = m_uid++;
+    m_unscheduledEvents++;
+    m_events->Insert(ev);
+    return EventId(event, ev.key.m_ts, ev.key.m_context, ev.key.m_uid);
+}
+
+inline void
+FatTreeShmSimulatorImpl::ScheduleWithContext(uint32_t context, const Time& delay, EventImpl* event)
+{
+    // 仿真期间只有 FatTreeShmChannel 能跨分区，其他路径说明拓扑没有按分区建好
+    if (s_running == this && context != NO_CONTEXT && !IsLocal(context))
+    {
+        NS_FATAL_ERROR("FatTreeShm: event for node " << context << " in partition "
+                       << m_partitionOf[context] << " scheduled from partition " << m_lp
+                       << "; cross-partition links must use FatTreeShmChannel");
+    }
+    Scheduler::Event ev;
+    ev.impl = event;
+    ev.key.m_ts = m_currentTs + delay.GetTimeStep();
+    ev.key.m_context = context;
+    ev.key.m_uid = m_uid++;
+    m_unscheduledEvents++;
+    m_events->Insert(ev);
+}
+
+inline EventId
+FatTreeShmSimulatorImpl::ScheduleNow(EventImpl* event)
+{
+    return Schedule(TimeStep(0), event);
+}
+
+inline EventId
+FatTreeShmSimulatorImpl::ScheduleDestroy(EventImpl* event)
+{
+    EventId id(Ptr<EventImpl>(event, false), m_currentTs, NO_CONTEXT, EventId::UID::DESTROY);
+    m_destroyEvents.push_back(id);
+    m_uid++;
+    return id;
+}
+
+inline void
+FatTreeShmSimulatorImpl::Remove(const EventId& id)
+{
+    if (id.GetUid() == EventId::UID::DESTROY)
+    {
+        for (auto i = m_destroyEvents.begin(); i != m_destroyEvents.end(); ++i)
+        {
+            if (*i == id)
+            {
+                m_destroyEvents.erase(i);
+                break;
+            }
+        }
+        return;
+    }
+    if (IsExpired(id))
+    {
+        return;
+    }
+    Scheduler::Event event;
+    event.impl = id.PeekEventImpl();
+    event.key.m_ts = id.GetTs();
+    event.key.m_context = id.GetContext();
+    event.key.m_uid = id.GetUid();
+    m_events->Remove(event);
+    event.impl->Cancel();
+    event.impl->Unref();
+    m_unscheduledEvents--;
+}
+
+inline void
+FatTreeShmSimulatorImpl::Cancel(const EventId& id)
+{
+    if (!IsExpired(id))
+    {
+        id.PeekEventImpl()->Cancel();
+    }
+}
+
+inline bool
+FatTreeShmSimulatorImpl::IsExpired(const EventId& id) const
+{
+    if (id.GetUid() == EventId::UID::DESTROY)
+    {
+        if (id.PeekEventImpl() == nullptr || id.PeekEventImpl()->IsCancelled())
+        {
+            return true;
+        }
+        for (const EventId& ev : m_destroyEvents)
+        {
+            if (ev == id)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+    return id.PeekEventImpl() == nullptr || id.GetTs() < m_currentTs ||
+           (id.GetTs() == m_currentTs && id.GetUid() <= m_currentUid) ||
+           id.PeekEventImpl()->IsCancelled();
+}
+
+inline Time
+FatTreeShmSimulatorImpl::Now() const
+{
+    return TimeStep(m_currentTs);
+}
+
+inline Time
+FatTreeShmSimulatorImpl::GetDelayLeft(const EventId& id) const
+{
+    if (IsExpired(id))
+    {
+        return TimeStep(0);
+    }
+    return TimeStep(id.GetTs() - m_currentTs);
+}
+
+inline Time
+FatTreeShmSimulatorImpl::GetMaximumSimulationTime() const
+{
+    return TimeStep(0x7fffffffffffffffLL);
+}
+
+inline void
+FatTreeShmSimulatorImpl::SetScheduler(ObjectFactory schedulerFactory)
+{
+    Ptr<Scheduler> scheduler = schedulerFactory.Create<Scheduler>();
+    if (m_events)
+    {
+        while (!m_events->IsEmpty())
+        {
+            scheduler->Insert(m_events->RemoveNext());
+        }
+    }
+    m_events = scheduler;
+}
+
+inline uint32_t
+FatTreeShmSimulatorImpl::GetSystemId() const
+{
+    return m_lp;
+}
+
+inline uint32_t
+FatTreeShmSimulatorImpl::GetContext() const
+{
+    return m_currentContext;
+}
+
+inline uint64_t
+FatTreeShmSimulatorImpl::GetEventCount() const
+{
+    return m_eventCount;
+}
+
+inline FatTreeShmSimulatorImpl*
+FatTreeShmSimulatorImpl::GetRunning()
+{
+    return s_running;
+}
+
+inline bool
+FatTreeShmSimulatorImpl::IsLocal(uint32_t nodeId) const
+{
+    return nodeId >= m_partitionOf.size() || m_partitionOf[nodeId] == m_lp;
+}
+
+inline void
+FatTreeShmSimulatorImpl::ProcessOneEvent()
+{
+    Scheduler::Event next = m_events->RemoveNext();
+    m_currentTs = next.key.m_ts;
+    m_currentContext = next.key.m_context;
+    m_currentUid = next.key.m_uid;
+    m_unscheduledEvents--;
+    m_eventCount++;
+    next.impl->Invoke();
+    next.impl->Unref();
+}
+
+inline uint64_t
+FatTreeShmSimulatorImpl::NextTs() const
+{
+    return m_events->IsEmpty() ? NEVER : m_events->PeekNext().key.m_ts;
+}
+
+inline FatTreeShmSimulatorImpl::Slot&
+FatTreeShmSimulatorImpl::GetSlot(uint32_t parity, uint32_t lp) const
+{
+    return reinterpret_cast<Slot*>(m_shm + m_slotOffset)[parity * m_nLps + lp];
+}
+
+inline FatTreeShmSimulatorImpl::LpStats&
+FatTreeShmSimulatorImpl::GetStats(uint32_t lp) const
+{
+    return reinterpret_cast<LpStats*>(m_shm + m_statsOffset)[lp];
+}
+
+inline uint8_t*
+FatTreeShmSimulatorImpl::GetMailbox(uint32_t parity, uint32_t src, uint32_t dst) const
+{
+    // 每个邮箱开头 8 字节是已写入的长度，之后是消息
+    size_t index = (static_cast<size_t>(parity) * m_nLps + src) * m_nLps + dst;
+    return m_shm + m_mailboxOffset + index * (static_cast<size_t>(m_mailboxBytes) + 8);
+}
+
+inline void
+FatTreeShmSimulatorImpl::Partition()
+{
+    // 按节点的 systemId 划分 LP
+    m_nLps = 1;
+    m_partitionOf.assign(NodeList::GetNNodes(), 0);
+    for (uint32_t i = 0; i < NodeList::GetNNodes(); ++i)
+    {
+        m_partitionOf[i] = NodeList::GetNode(i)->GetSystemId();
+        m_nLps = std::max(m_nLps, m_partitionOf[i] + 1);
+    }
+
+    // lookahead: 跨分区 FatTreeShmChannel 的最小延迟; 其他信道不允许跨分区
+    m_lookahead = NEVER;
+    for (uint32_t i = 0; i < ChannelList::GetNChannels(); ++i)
+    {
+        Ptr<Channel> channel = ChannelList::GetChannel(i);
+        bool cross = false;
+        for (std::size_t d = 1; d < channel->GetNDevices(); ++d)
+        {
+            cross = cross || channel->GetDevice(d)->GetNode()->GetSystemId() !=
+                                 channel->GetDevice(0)->GetNode()->GetSystemId();
+        }
+        if (!cross)
+        {
+            continue;
+        }
+        Ptr<FatTreeShmChannel> shm = DynamicCast<FatTreeShmChannel>(channel);
+        NS_ABORT_MSG_IF(shm == nullptr, "FatTreeShm: channel " << i << " ("
+                        << channel->GetInstanceTypeId().GetName()
+                        << ") crosses partitions; use InstallFatTreeShmLink()");
+        NS_ABORT_MSG_IF(!shm->GetLinkDelay().IsStrictlyPositive(),
+                        "FatTreeShm: cross-partition links need a positive delay");
+        m_lookahead = std::min<uint64_t>(m_lookahead, shm->GetLinkDelay().GetTimeStep());
+    }
+
+    // 共享内存布局: 屏障 | 发布槽 [2][N] | 统计 [N] | 邮箱 [2][N][N]
+    m_slotOffset = (sizeof(Shared) + 63) / 64 * 64;
+    m_statsOffset = m_slotOffset + 2 * m_nLps * sizeof(Slot);
+    m_mailboxOffset = m_statsOffset + m_nLps * sizeof(LpStats);
+    m_shmBytes = m_mailboxOffset +
+                 2 * static_cast<size_t>(m_nLps) * m_nLps * (static_cast<size_t>(m_mailboxBytes) + 8);
+    void* mem = mmap(nullptr, m_shmBytes, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    NS_ABORT_MSG_IF(mem == MAP_FAILED, "FatTreeShm: mmap of " << m_shmBytes << " bytes failed");
+    m_shm = static_cast<uint8_t*>(mem);
+    m_shared = new (m_shm) Shared();
+    m_shared->arrived.store(0);
+    m_shared->generation.store(0);
+    m_shared->failed.store(0);
+    // 匿名映射已清零: 发布槽、统计和邮箱长度初始都是 0
+
+    // fork 前清空输出缓冲，否则子进程会重复输出父进程尚未写出的内容
+    std::cout.flush();
+    std::cerr.flush();
+    std::fflush(nullptr);
+
+    m_parent = getpid();
+    m_lp = 0;
+    for (uint32_t lp = 1; lp < m_nLps; ++lp)
+    {
+        pid_t pid = fork();
+        NS_ABORT_MSG_IF(pid < 0, "FatTreeShm: fork failed");
+        if (pid == 0)
+        {
+            m_lp = lp;
+            m_children.clear();
+            break;
+        }
+        m_children.push_back(pid);
+    }
+
+    // 每个进程都复制了全部事件，只保留本 LP 节点的事件和无上下文的全局事件 (如 Stop)
+    std::vector<Scheduler::Event> keep;
+    while (!m_events->IsEmpty())
+    {
+        Scheduler::Event ev = m_events->RemoveNext();
+        if (ev.key.m_context == NO_CONTEXT || IsLocal(ev.key.m_context))
+        {
+            keep.push_back(ev);
+        }
+        else
+        {
+            // 标记为已取消，使其他对象持有的 EventId 立即过期
+            ev.impl->Cancel();
+            ev.impl->Unref();
+            m_unscheduledEvents--;
+        }
+    }
+    for (const Scheduler::Event& ev : keep)
+    {
+        m_events->Insert(ev);
+    }
+}
+
+inline void
+FatTreeShmSimulatorImpl::Barrier()
+{
+    uint32_t generation = m_shared->generation.load(std::memory_order_acquire);
+    if (m_shared->arrived.fetch_add(1, std::memory_order_acq_rel) + 1 == m_nLps)
+    {
+        m_shared->arrived.store(0, std::memory_order_relaxed);
+        m_shared->generation.fetch_add(1, std::memory_order_acq_rel);
+        return;
+    }
+    uint64_t spins = 0;
+    while (m_shared->generation.load(std::memory_order_acquire) == generation)
+    {
+        if (++spins < 4096)
+        {
+#if defined(__x86_64__) || defined(__i386__)
+            __builtin_ia32_pause();
+#endif
+            continue;
+        }
+        std::this_thread::yield();
+        if (spins % 65536 != 0)
+        {
+            continue;
+        }
+        // 某个进程异常退出时屏障永远等不齐，定期检查
+        if (m_shared->failed.load(std::memory_order_relaxed) != 0)
+        {
+            NS_FATAL_ERROR("FatTreeShm: another partition failed");
+        }
+        if (m_lp == 0)
+        {
+            int status = 0;
+            pid_t pid = waitpid(-1, &status, WNOHANG);
+            if (pid > 0)
+            {
+                m_shared->failed.store(1, std::memory_order_relaxed);
+                NS_FATAL_ERROR("FatTreeShm: partition process " << pid << " exited during the run");
+            }
+        }
+        else if (getppid() != m_parent)
+        {
+            _exit(1);
+        }
+    }
+}
+
+inline void
+FatTreeShmSimulatorImpl::SendPacket(Ptr<const Packet> p, Time rxTime, uint32_t nodeId, uint32_t ifIndex)
+{
+    uint32_t dst = m_partitionOf[nodeId];
+    uint64_t ts = rxTime.GetTimeStep();
+    NS_ASSERT_MSG(ts >= m_currentTs + m_lookahead, "FatTreeShm: message violates the lookahead");
+
+    uint8_t* box = GetMailbox(m_parity, m_lp, dst);
+    uint64_t& used = *reinterpret_cast<uint64_t*>(box);
+    uint32_t size = p->GetSerializedSize();
+    uint64_t need = sizeof(MessageHeader) + (size + 7) / 8 * 8;
+    NS_ABORT_MSG_IF(used + need > m_mailboxBytes,
+                    "FatTreeShm: mailbox " << m_lp << " -> " << dst << " overflow; raise "
+                    "ns3::FatTreeShmSimulatorImpl::MailboxBytes (now " << m_mailboxBytes << ")");
+
+    uint8_t* data = box + 8 + used;
+    MessageHeader header{ts, nodeId, ifIndex, size, 0};
+    std::memcpy(data, &header, sizeof(header));
+    uint32_t ok = p->Serialize(data + sizeof(header), size);
+    NS_ABORT_MSG_IF(ok == 0, "FatTreeShm: packet serialization failed");
+    used += need;
+
+    m_sentMin = std::min(m_sentMin, ts);
+    GetStats(m_lp).sent++;
+}
+
+inline void
+FatTreeShmSimulatorImpl::Drain(uint32_t parity)
+{
+    // 按源 LP 顺序取出，保证同一时刻到达的数据包在各次运行中顺序一致
+    for (uint32_t src = 0; src < m_nLps; ++src)
+    {
+        if (src == m_lp)
+        {
+            continue;
+        }
+        uint8_t* box = GetMailbox(parity, src, m_lp);
+        uint64_t& used = *reinterpret_cast<uint64_t*>(box);
+        uint64_t offset = 0;
+        while (offset < used)
+        {
+            MessageHeader header;
+            std::memcpy(&header, box + 8 + offset, sizeof(header));
+            Ptr<Packet> packet = Create<Packet>(box + 8 + offset + sizeof(header), header.size, true);
+            Ptr<PointToPointNetDevice> dev =
+                DynamicCast<PointToPointNetDevice>(NodeList::GetNode(header.nodeId)->GetDevice(header.ifIndex));
+            NS_ASSERT_MSG(dev, "FatTreeShm: message for a non point-to-point device");
+
+            Scheduler::Event ev;
+            ev.impl = MakeEvent(&PointToPointNetDevice::Receive, dev, packet);
+            ev.key.m_ts = header.ts;
+            ev.key.m_context = header.nodeId;
+            ev.key.m_uid = m_uid++;
+            m_unscheduledEvents++;
+            m_events->Insert(ev);
+
+            offset += sizeof(MessageHeader) + (header.size + 7) / 8 * 8;
+            GetStats(m_lp).received++;
+        }
+        used = 0;
+    }
+}
+
+inline void
+FatTreeShmSimulatorImpl::RunWindows()
+{
+    using Clock = std::chrono::steady_clock;
+    LpStats& stats = GetStats(m_lp);
+    m_parity = 0;
+    while (true)
+    {
+        auto syncStart = Clock::now();
+
+        // 1. 发布本 LP 的时间下界
+        Slot& slot = GetSlot(m_parity, m_lp);
+        slot.next = std::min(NextTs(), m_sentMin);
+        slot.stop = m_stop ? 1 : 0;
+        m_sentMin = NEVER;
+
+        // 2. 屏障后所有 LP 得到相同的 LBTS
+        Barrier();
+        uint64_t lbts = NEVER;
+        bool stop = false;
+        for (uint32_t lp = 0; lp < m_nLps; ++lp)
+        {
+            lbts = std::min(lbts, GetSlot(m_parity, lp).next);
+            stop = stop || GetSlot(m_parity, lp).stop != 0;
+        }
+        if (stop || lbts == NEVER)
+        {
+            break;
+        }
+
+        // 3. 取出上个窗口发给本 LP 的消息
+        Drain(m_parity ^ 1);
+
+        auto busyStart = Clock::now();
+        stats.syncSeconds += std::chrono::duration<double>(busyStart - syncStart).count();
+
+        // 4. 处理安全窗口内的事件
+        uint64_t windowEnd = (m_lookahead > NEVER - lbts) ? NEVER : lbts + m_lookahead;
+        while (!m_stop && !m_events->IsEmpty() && m_events->PeekNext().key.m_ts < windowEnd)
+        {
+            ProcessOneEvent();
+        }
+        stats.busySeconds += std::chrono::duration<double>(Clock::now() - busyStart).count();
+        stats.windows++;
+        m_parity ^= 1;
+    }
+    stats.events = m_eventCount;
+}
+
+inline void
+FatTreeShmSimulatorImpl::Run()
+{
+    auto wallStart = std::chrono::steady_clock::now();
+    m_stop = false;
+    Partition();
+
+    s_running = this;
+    RunWindows();
+    s_running = nullptr;
+
+    // 所有 LP 写完统计后由 LP 0 汇总输出
+    Barrier();
+    if (m_lp == 0)
+    {
+        Report(std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count());
+    }
+}
+
+inline void
+FatTreeShmSimulatorImpl::Report(double wallSeconds) const
+{
+    std::ostream& os = std::cout;
+    double busyTotal = 0;
+    uint64_t windows = 0;
+    for (uint32_t lp = 0; lp < m_nLps; ++lp)
+    {
+        busyTotal += GetStats(lp).busySeconds;
+        windows = std::max(windows, GetStats(lp).windows);
+    }
+
+    os << "FatTreeShm: " << m_nLps << " partitions, lookahead ";
+    if (m_lookahead == NEVER)
+    {
+        os << "unbounded";
+    }
+    else
+    {
+        os << TimeStep(m_lookahead).As(Time::NS);
+    }
+    os << ", " << windows << " windows, wall " << std::fixed << std::setprecision(3) << wallSeconds
+       << " s" << std::endl;
+    for (uint32_t lp = 0; lp < m_nLps; ++lp)
+    {
+        const LpStats& s = GetStats(lp);
+        double total = s.busySeconds + s.syncSeconds;
+        os << "  lp " << lp << ": " << s.events << " events, busy " << s.busySeconds << " s, sync "
+           << s.syncSeconds << " s (" << std::setprecision(1)
+           << (total > 0 ? 100.0 * s.syncSeconds / total : 0.0) << "%), sent " << s.sent
+           << ", received " << s.received << std::setprecision(3) << std::endl;
+    }
+    // 顺序执行的耗时近似为各 LP 处理事件时间之和 (不含缓存效应)
+    os << "  estimated speedup over sequential: " << std::setprecision(2)
+       << (wallSeconds > 0 ? busyTotal / wallSeconds : 0.0) << "x (sum of busy time / wall time)"
+       << std::endl;
+    os << std::defaultfloat << std::setprecision(6);
+}
+
+} // namespace ns3
+
+#endif /* FAT_TREE_SHM_SIMULATOR_IMPL_H */
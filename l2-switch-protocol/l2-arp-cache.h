@@ -0,0 +1,175 @@
+/*
+ * ============================================================================
+ * 标题: ARP 抑制缓存 (ARP Suppression Cache)
+ * ============================================================================
+ *
+ * 【设计目的】
+ *   两台主机第一次通信前都要广播 ARP 请求，这个广播会被每一台交换机泛洪到
+ *   同一 VLAN 的所有端口。主机数量很多时，ARP 广播是控制流量的主要部分。
+ *
+ *   交换机可以监听 (snoop) 经过它的 ARP 报文，记录 IP -> MAC 的对应关系:
+ *   - 收到 ARP 请求时，如果缓存中有目标 IP，直接代替目标主机回复 (代理 ARP)，
+ *     请求不再泛洪
+ *   - 缓存中没有时照常泛洪，目标主机的回复经过交换机时被记录下来
+ *
+ * 【老化】
+ *   每个表项记录最后一次被确认的时间，超过超时时间的表项在查找时视为不存在
+ *   (惰性删除)，不需要定时事件。
+ *
+ * 【冲突检测】
+ *   同一个 IP 在有效期内被另一个 MAC 声明时，说明 IP 冲突 (或 ARP 欺骗)。
+ *   此时删除表项并返回 CONFLICT，之后对这个 IP 的请求照常泛洪，
+ *   由真正的主机自己回复，交换机不会替错误的主机回答。
+ *
+ * 作者: Liu Mengxuan
+ * ns-3 版本: 3.44
+ * ============================================================================
+ */
+
+#ifndef L2_ARP_CACHE_H
+#define L2_ARP_CACHE_H
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+
+#include <cstdint>
+#include <unordered_map>
+
+namespace ns3
+{
+
+class L2ArpCache
+{
+public:
+    /**
+     * @brief Learn() 的结果
+     */
+    enum LearnResult
+    {
+        ARP_NEW,        // 新的 IP
+        ARP_REFRESHED,  // IP 和 MAC 都没变，刷新时间
+        ARP_MOVED,      // 同一个 MAC 换了端口
+        ARP_CONFLICT    // 有效期内的 IP 被另一个 MAC 声明，表项已删除
+    };
+
+    /**
+     * @brief 一个表项
+     */
+    struct Entry
+    {
+        Mac48Address mac;  // IP 对应的 MAC 地址
+        uint16_t port;     // 学习到的端口 (逻辑端口号)
+        Time lastSeen;     // 最后一次确认的时间
+    };
+
+    L2ArpCache();
+
+    /**
+     * @brief 设置表项超时时间
+     */
+    void SetTimeout(Time timeout);
+
+    /**
+     * @brief 记录一个 IP -> MAC 对应关系
+     * @param vlan IP 所在的 VLAN (不同 VLAN 可以使用相同的地址)
+     * @param ip IPv4 地址
+     * @param mac MAC 地址
+     * @param port 收到报文的端口
+     * @param now 当前时间
+     */
+    LearnResult Learn(uint16_t vlan, Ipv4Address ip, Mac48Address mac, uint16_t port, Time now);
+
+    /**
+     * @brief 查找有效的表项
+     * @return 表项指针，不存在或已超时返回 nullptr (超时的表项同时被删除)
+     */
+    const Entry* Lookup(uint16_t vlan, Ipv4Address ip, Time now);
+
+    uint32_t GetSize() const;
+    void Clear();
+
+private:
+    static uint64_t Key(uint16_t vlan, Ipv4Address ip);
+
+    std::unordered_map<uint64_t, Entry> m_entries;
+    Time m_timeout;
+};
+
+// ============================================================================
+// 实现
+// ============================================================================
+
+inline L2ArpCache::L2ArpCache()
+    : m_timeout(Seconds(300))
+{
+}
+
+inline void
+L2ArpCache::SetTimeout(Time timeout)
+{
+    m_timeout = timeout;
+}
+
+inline uint64_t
+L2ArpCache::Key(uint16_t vlan, Ipv4Address ip)
+{
+    return (uint64_t(vlan) << 32) | ip.Get();
+}
+
+inline L2ArpCache::LearnResult
+L2ArpCache::Learn(uint16_t vlan, Ipv4Address ip, Mac48Address mac, uint16_t port, Time now)
+{
+    auto [it, inserted] = m_entries.try_emplace(Key(vlan, ip), Entry{mac, port, now});
+    if (inserted)
+    {
+        return ARP_NEW;
+    }
+
+    Entry& entry = it->second;
+    bool expired = now - entry.lastSeen > m_timeout;
+    if (entry.mac != mac && !expired)
+    {
+        m_entries.erase(it);
+        return ARP_CONFLICT;
+    }
+
+    LearnResult result = (entry.mac == mac && entry.port != port) ? ARP_MOVED : ARP_REFRESHED;
+    if (expired)
+    {
+        result = ARP_NEW;
+    }
+    entry = Entry{mac, port, now};
+    return result;
+}
+
+inline const L2ArpCache::Entry*
+L2ArpCache::Lookup(uint16_t vlan, Ipv4Address ip, Time now)
+{
+    auto it = m_entries.find(Key(vlan, ip));
+    if (it == m_entries.end())
+    {
+        return nullptr;
+    }
+    if (now - it->second.lastSeen > m_timeout)
+    {
+        m_entries.erase(it);
+        return nullptr;
+    }
+    return &it->second;
+}
+
+inline uint32_t
+L2ArpCache::GetSize() const
+{
+    return static_cast<uint32_t>(m_entries.size());
+}
+
+inline void
+L2ArpCache::Clear()
+{
+    m_entries.clear();
+}
+
+} // namespace ns3
+
+#endif /* L2_ARP_CACHE_H */
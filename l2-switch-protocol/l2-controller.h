@@ -0,0 +1,236 @@
+/*
+ * ============================================================================
+ * 标题: 集中式控制器 (Controller-provisioned forwarding tables)
+ * ============================================================================
+ *
+ * 【设计目的】
+ *   交换机靠 "泛洪 + 学习" 建立 MAC 表: 每个目的地址的第一个帧都要泛洪，
+ *   仿真开始阶段的行为 (泛洪量、时延) 与稳定状态差别很大，大规模拓扑中
+ *   预热阶段的泛洪还会占去大部分仿真时间。
+ *
+ *   控制器在 Simulator::Run() 之前根据拓扑和主机位置直接算出每台交换机的
+ *   MAC 表并下发:
+ *   1. 拓扑发现: 沿交换机每个端口的信道找到对端设备。对端是交换机就是一条
+ *      交换机间链路，否则是一个主机接口 (它的 MAC 地址就是要下发的目的地址)
+ *   2. 对每个主机，从它所在的交换机开始在该主机 VLAN 的链路上做广度优先搜索，
+ *      每台交换机上指向搜索树父节点的端口就是去往该主机的出端口
+ *      (最短路径树，同一个目的地址在所有交换机上的出端口不会构成环路)
+ *   3. 通过 AddStaticMacEntry() 下发静态表项；交换机启用 ArpSuppression 时
+ *      同时下发主机的 IP -> MAC，ARP 请求也不再泛洪
+ *
+ *   学习仍然照常进行，控制器不知道的地址 (或表项被拓扑变化清除后) 由学习补上。
+ *
+ * 【注意】
+ *   - 只使用当前不是 Discarding 状态的端口。启用 RSTP 时仿真开始前端口还没有
+ *     进入转发状态，应在收敛后 (用 Simulator::Schedule) 再调用
+ *   - 本文件依赖 l2-switch-protocol.cc 中的类定义，必须在 L2SwitchProtocol 定义之后 include
+ *
+ * 作者: Liu Mengxuan
+ * ns-3 版本: 3.44
+ * ============================================================================
+ */
+
+#ifndef L2_CONTROLLER_H
+#define L2_CONTROLLER_H
+
+#include "l2-mac-table.h"
+
+#include "ns3/internet-module.h"
+#include "ns3/network-module.h"
+
+#include <deque>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+class L2SwitchController
+{
+public:
+    /**
+     * @brief 一次下发的结果
+     */
+    struct Stats
+    {
+        uint32_t switches;    // 参与计算的交换机数
+        uint32_t links;       // 交换机间链路数 (每个方向计一次)
+        uint32_t hosts;       // 发现的主机接口数
+        uint64_t macEntries;  // 下发的 MAC 表项数
+        uint64_t arpEntries;  // 下发的 ARP 表项数
+        uint64_t rejected;    // 因 MAC 表满没能下发的表项数
+    };
+
+    /**
+     * @brief 计算并下发所有交换机的 MAC 表
+     * @param switches 交换机节点 (已安装 L2SwitchProtocol 并调用过 Initialize())
+     * @return 下发结果
+     */
+    Stats Provision(NodeContainer switches);
+
+private:
+    /**
+     * @brief 一条交换机间链路 (从 port 出去到达 peer 的 peerPort)
+     */
+    struct Link
+    {
+        uint16_t port;
+        uint32_t peer;
+        uint16_t peerPort;
+    };
+
+    /**
+     * @brief 一个主机接口
+     */
+    struct Host
+    {
+        Ptr<NetDevice> device;  // 主机的设备
+        uint32_t sw;            // 所在交换机 (下标)
+        uint16_t port;          // 所在交换机的端口
+    };
+
+    /**
+     * @brief 链路的这一端能否用于 vlan 的转发
+     */
+    static bool IsUsable(Ptr<L2SwitchProtocol> protocol, uint16_t port, uint16_t vlan);
+};
+
+// ============================================================================
+// 实现
+// ============================================================================
+
+inline bool
+L2SwitchController::IsUsable(Ptr<L2SwitchProtocol> protocol, uint16_t port, uint16_t vlan)
+{
+    uint16_t logical = protocol->GetLogicalPort(port);
+    return protocol->GetPortState(logical) != L2_PORT_DISCARDING &&
+           protocol->IsVlanMember(logical, vlan);
+}
+
+inline L2SwitchController::Stats
+L2SwitchController::Provision(NodeContainer switches)
+{
+    Stats stats{};
+    uint32_t n = switches.GetN();
+    stats.switches = n;
+
+    std::vector<Ptr<L2SwitchProtocol>> protocols(n);
+    std::unordered_map<uint32_t, uint32_t> index;  // 节点 ID -> 交换机下标
+    for (uint32_t s = 0; s < n; ++s)
+    {
+        protocols[s] = switches.Get(s)->GetObject<L2SwitchProtocol>();
+        NS_ASSERT_MSG(protocols[s] && protocols[s]->GetNPorts() > 0,
+                      "L2SwitchProtocol is not installed or not initialized on node "
+                          << switches.Get(s)->GetId());
+        index[switches.Get(s)->GetId()] = s;
+    }
+
+    // 步骤 1: 拓扑发现。同一个主机设备可能连在共享信道上的多台交换机，只记录一次
+    std::vector<std::vector<Link>> links(n);
+    std::vector<Host> hosts;
+    std::set<Ptr<NetDevice>> seen;
+    for (uint32_t s = 0; s < n; ++s)
+    {
+        Ptr<Node> node = switches.Get(s);
+        for (uint16_t p = 0; p < protocols[s]->GetNPorts(); ++p)
+        {
+            Ptr<NetDevice> device = node->GetDevice(p);
+            Ptr<Channel> channel = device->GetChannel();
+            if (!channel)
+            {
+                continue;
+            }
+            for (std::size_t i = 0; i < channel->GetNDevices(); ++i)
+            {
+                Ptr<NetDevice> peer = channel->GetDevice(i);
+                if (peer == device)
+                {
+                    continue;
+                }
+                auto it = index.find(peer->GetNode()->GetId());
+                if (it != index.end())
+                {
+                    links[s].push_back(
+                        Link{p, it->second, static_cast<uint16_t>(peer->GetIfIndex())});
+                    ++stats.links;
+                }
+                else if (seen.insert(peer).second)
+                {
+                    hosts.push_back(Host{peer, s, p});
+                }
+            }
+        }
+    }
+    stats.hosts = static_cast<uint32_t>(hosts.size());
+
+    // 步骤 2: 每个主机一棵最短路径树，outPort[s] 是交换机 s 去往该主机的出端口
+    std::vector<uint16_t> outPort(n);
+    std::deque<uint32_t> queue;
+    for (const Host& host : hosts)
+    {
+        uint16_t vlan = protocols[host.sw]->GetPortVlan(host.port);
+        if (vlan == L2VlanTag::NO_VLAN || !IsUsable(protocols[host.sw], host.port, vlan))
+        {
+            continue;
+        }
+
+        outPort.assign(n, L2MacTable::NO_PORT);
+        outPort[host.sw] = host.port;
+        queue.assign(1, host.sw);
+        while (!queue.empty())
+        {
+            uint32_t s = queue.front();
+            queue.pop_front();
+            for (const Link& link : links[s])
+            {
+                if (outPort[link.peer] != L2MacTable::NO_PORT ||
+                    !IsUsable(protocols[s], link.port, vlan) ||
+                    !IsUsable(protocols[link.peer], link.peerPort, vlan))
+                {
+                    continue;
+                }
+                outPort[link.peer] = link.peerPort;
+                queue.push_back(link.peer);
+            }
+        }
+
+        // 步骤 3: 下发 MAC 表项，以及主机接口上的 IPv4 地址
+        Mac48Address mac = Mac48Address::ConvertFrom(host.device->GetAddress());
+        std::vector<Ipv4Address> addresses;
+        Ptr<Ipv4> ipv4 = host.device->GetNode()->GetObject<Ipv4>();
+        int32_t interface = ipv4 ? ipv4->GetInterfaceForDevice(host.device) : -1;
+        if (interface >= 0)
+        {
+            for (uint32_t a = 0; a < ipv4->GetNAddresses(interface); ++a)
+            {
+                addresses.push_back(ipv4->GetAddress(interface, a).GetLocal());
+            }
+        }
+
+        for (uint32_t s = 0; s < n; ++s)
+        {
+            if (outPort[s] == L2MacTable::NO_PORT)
+            {
+                continue;
+            }
+            if (!protocols[s]->AddStaticMacEntry(vlan, mac, outPort[s]))
+            {
+                ++stats.rejected;
+                continue;
+            }
+            ++stats.macEntries;
+            for (const Ipv4Address& address : addresses)
+            {
+                if (protocols[s]->AddStaticArpEntry(vlan, address, mac, outPort[s]))
+                {
+                    ++stats.arpEntries;
+                }
+            }
+        }
+    }
+
+    NS_LOG_INFO("Controller: " << stats.switches << " switches, " << stats.hosts << " hosts, "
+               << stats.macEntries << " MAC entries and " << stats.arpEntries
+               << " ARP entries installed");
+    return stats;
+}
+
+#endif /* L2_CONTROLLER_H */
@@ -0,0 +1,703 @@
+/*
+ * ============================================================================
+ * 标题: 全双工点到点以太网链路 (L2EthernetNetDevice / L2EthernetChannel)
+ * ============================================================================
+ *
+ * 【设计目的】
+ *   交换机之间和交换机到主机的链路原来只能用 CSMA:
+ *   - PointToPointNetDevice 使用 PPP 封装，不携带以太网 MAC 地址，
+ *     交换机无法按源/目的 MAC 学习和转发 (见文档第 10 章)
+ *   - CsmaNetDevice 保留 MAC 地址，但它是半双工共享介质，有载波侦听和退避，
+ *     两个方向的流量互相竞争，吞吐量受限，而且每个帧都会产生额外的事件
+ *
+ *   这里实现一个 "点到点以太网": 每条链路恰好两个端点，两个方向独立发送 (全双工)，
+ *   帧带完整的以太网帧头 (源/目的 MAC 不变)，支持混杂模式回调，
+ *   可以直接替换 CSMA 链路给 L2SwitchProtocol 使用，速率可以设置为 10/40/100Gbps。
+ *
+ * 【发送时间】
+ *   每个帧在线路上占用 前导码 8 + 帧头 14 + 负载 + FCS 4 + 帧间隔 12 字节的时间，
+ *   到达对端的时间 = 发送完成 (不含帧间隔) + 传播时延。
+ *
+ * 【注意】
+ *   本文件使用 l2-switch-protocol.cc 的日志组件，
+ *   必须在 NS_LOG_COMPONENT_DEFINE 之后 include。
+ *
+ * 作者: Liu Mengxuan
+ * ns-3 版本: 3.44
+ * ============================================================================
+ */
+
+#ifndef L2_ETHERNET_H
+#define L2_ETHERNET_H
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+
+namespace ns3
+{
+
+class L2EthernetChannel;
+
+// ============================================================================
+// L2EthernetNetDevice
+// ============================================================================
+
+class L2EthernetNetDevice : public NetDevice
+{
+public:
+    static TypeId GetTypeId();
+
+    L2EthernetNetDevice();
+    ~L2EthernetNetDevice() override;
+
+    /**
+     * @brief 连接到信道 (由 L2EthernetHelper 调用)
+     */
+    bool Attach(Ptr<L2EthernetChannel> channel);
+
+    /**
+     * @brief 设置发送队列
+     */
+    void SetQueue(Ptr<Queue<Packet>> queue);
+    Ptr<Queue<Packet>> GetQueue() const;
+
+    /**
+     * @brief 从信道收到一个帧 (带以太网帧头)
+     */
+    void Receive(Ptr<Packet> packet);
+
+    /**
+     * @brief 模拟链路断开/恢复: 断开时不发送也不接收，并通知链路状态回调
+     */
+    void SetLinkUp(bool up);
+
+    // ========== NetDevice 接口 ==========
+    void SetIfIndex(const uint32_t index) override;
+    uint32_t GetIfIndex() const override;
+    Ptr<Channel> GetChannel() const override;
+    void SetAddress(Address address) override;
+    Address GetAddress() const override;
+    bool SetMtu(const uint16_t mtu) override;
+    uint16_t GetMtu() const override;
+    bool IsLinkUp() const override;
+    void AddLinkChangeCallback(Callback<void> callback) override;
+    bool IsBroadcast() const override;
+    Address GetBroadcast() const override;
+    bool IsMulticast() const override;
+    Address GetMulticast(Ipv4Address multicastGroup) const override;
+    Address GetMulticast(Ipv6Address addr) const override;
+    bool IsBridge() const override;
+    bool IsPointToPoint() const override;
+    bool Send(Ptr<Packet> packet, const Address& dest, uint16_t protocolNumber) override;
+    bool SendFrom(Ptr<Packet> packet,
+                  const Address& source,
+                  const Address& dest,
+                  uint16_t protocolNumber) override;
+    Ptr<Node> GetNode() const override;
+    void SetNode(Ptr<Node> node) override;
+    bool NeedsArp() const override;
+    void SetReceiveCallback(NetDevice::ReceiveCallback cb) override;
+    void SetPromiscReceiveCallback(NetDevice::PromiscReceiveCallback cb) override;
+    bool SupportsSendFrom() const override;
+
+protected:
+    void DoDispose() override;
+
+private:
+    static constexpr uint32_t WIRE_OVERHEAD = 8 + 4;  // 前导码 + FCS (帧头已经在 Packet 中)
+    static constexpr uint32_t INTERFRAME_GAP = 12;    // 帧间隔 (字节)
+    static constexpr uint16_t VLAN_PROTOCOL = 0x8100; // 802.1Q 标签的 EtherType
+    static constexpr uint32_t VLAN_TAG_SIZE = 4;      // 802.1Q 标签长度 (字节)
+
+    /**
+     * @brief 发送队首的帧
+     */
+    void StartTransmission();
+
+    /**
+     * @brief 当前帧 (含帧间隔) 发送完毕
+     */
+    void TransmitComplete();
+
+    Ptr<Node> m_node;
+    Ptr<L2EthernetChannel> m_channel;
+    Ptr<Queue<Packet>> m_queue;
+    Mac48Address m_address;
+    uint32_t m_ifIndex;
+    uint16_t m_mtu;
+    DataRate m_dataRate;     // 链路速率 (属性)
+    bool m_linkUp;
+    bool m_txBusy;           // 正在发送一个帧
+
+    NetDevice::ReceiveCallback m_rxCallback;
+    NetDevice::PromiscReceiveCallback m_promiscCallback;
+    TracedCallback<> m_linkChangeCallbacks;
+
+    TracedCallback<Ptr<const Packet>> m_macTxTrace;      // 帧进入发送队列
+    TracedCallback<Ptr<const Packet>> m_macTxDropTrace;  // 发送队列满、超过 MTU 或链路断开而丢弃
+    TracedCallback<Ptr<const Packet>> m_macRxTrace;      // 收到的帧 (已去掉帧头)
+};
+
+// ============================================================================
+// L2EthernetChannel
+// ============================================================================
+
+class L2EthernetChannel : public Channel
+{
+public:
+    static TypeId GetTypeId();
+
+    L2EthernetChannel();
+
+    /**
+     * @brief 连接一个设备，最多两个
+     */
+    bool Attach(Ptr<L2EthernetNetDevice> device);
+
+    /**
+     * @brief 把一个帧送到对端
+     * @param sender 发送端设备
+     * @param packet 帧 (带以太网帧头)
+     * @param txTime 帧的发送时间 (不含帧间隔)
+     */
+    void Transmit(Ptr<L2EthernetNetDevice> sender, Ptr<Packet> packet, Time txTime);
+
+    std::size_t GetNDevices() const override;
+    Ptr<NetDevice> GetDevice(std::size_t i) const override;
+
+protected:
+    void DoDispose() override;
+
+private:
+    Ptr<L2EthernetNetDevice> m_devices[2];
+    std::size_t m_nDevices;
+    Time m_delay;  // 传播时延 (属性)
+};
+
+// ============================================================================
+// L2EthernetHelper
+// ============================================================================
+
+class L2EthernetHelper
+{
+public:
+    L2EthernetHelper();
+
+    void SetDeviceAttribute(std::string name, const AttributeValue& value);
+    void SetChannelAttribute(std::string name, const AttributeValue& value);
+
+    /**
+     * @brief 设置每个设备发送队列的最大长度 (默认 100p)
+     */
+    void SetQueueSize(QueueSize size);
+
+    /**
+     * @brief 用一条链路连接两个节点
+     * @return 两个设备，顺序与参数相同
+     */
+    NetDeviceContainer Install(Ptr<Node> a, Ptr<Node> b) const;
+
+    /**
+     * @brief 用一条链路连接容器中的前两个节点 (与 CsmaHelper::Install 的用法相同)
+     */
+    NetDeviceContainer Install(const NodeContainer& nodes) const;
+
+private:
+    ObjectFactory m_deviceFactory;
+    ObjectFactory m_channelFactory;
+    QueueSize m_queueSize;
+};
+
+// ============================================================================
+// L2EthernetNetDevice 实现
+// ============================================================================
+
+NS_OBJECT_ENSURE_REGISTERED(L2EthernetNetDevice);
+
+inline TypeId
+L2EthernetNetDevice::GetTypeId()
+{
+    static TypeId tid = TypeId("ns3::L2EthernetNetDevice")
+        .SetParent<NetDevice>()
+        .SetGroupName("Network")
+        .AddConstructor<L2EthernetNetDevice>()
+        .AddAttribute("DataRate",
+                      "Line rate of the link (each direction)",
+                      DataRateValue(DataRate("10Gbps")),
+                      MakeDataRateAccessor(&L2EthernetNetDevice::m_dataRate),
+                      MakeDataRateChecker())
+        .AddAttribute("Mtu",
+                      "Maximum payload size",
+                      UintegerValue(1500),
+                      MakeUintegerAccessor(&L2EthernetNetDevice::SetMtu,
+                                           &L2EthernetNetDevice::GetMtu),
+                      MakeUintegerChecker<uint16_t>())
+        .AddTraceSource("MacTx",
+                        "A frame was accepted for transmission",
+                        MakeTraceSourceAccessor(&L2EthernetNetDevice::m_macTxTrace),
+                        "ns3::Packet::TracedCallback")
+        .AddTraceSource("MacTxDrop",
+                        "A frame was dropped: queue full, payload above the MTU, or link down",
+                        MakeTraceSourceAccessor(&L2EthernetNetDevice::m_macTxDropTrace),
+                        "ns3::Packet::TracedCallback")
+        .AddTraceSource("MacRx",
+                        "A frame was received",
+                        MakeTraceSourceAccessor(&L2EthernetNetDevice::m_macRxTrace),
+                        "ns3::Packet::TracedCallback");
+    return tid;
+}
+
+inline L2EthernetNetDevice::L2EthernetNetDevice()
+    : m_ifIndex(0),
+      m_mtu(1500),
+      m_linkUp(false),
+      m_txBusy(false)
+{
+}
+
+inline L2EthernetNetDevice::~L2EthernetNetDevice()
+{
+}
+
+inline void
+L2EthernetNetDevice::DoDispose()
+{
+    m_node = nullptr;
+    m_channel = nullptr;
+    m_queue = nullptr;
+    m_rxCallback = MakeNullCallback<bool, Ptr<NetDevice>, Ptr<const Packet>, uint16_t,
+                                    const Address&>();
+    m_promiscCallback = MakeNullCallback<bool, Ptr<NetDevice>, Ptr<const Packet>, uint16_t,
+                                         const Address&, const Address&, PacketType>();
+    NetDevice::DoDispose();
+}
+
+inline bool
+L2EthernetNetDevice::Attach(Ptr<L2EthernetChannel> channel)
+{
+    if (!channel->Attach(this))
+    {
+        return false;
+    }
+    m_channel = channel;
+    m_linkUp = true;
+    m_linkChangeCallbacks();
+    return true;
+}
+
+inline void
+L2EthernetNetDevice::SetQueue(Ptr<Queue<Packet>> queue)
+{
+    m_queue = queue;
+}
+
+inline Ptr<Queue<Packet>>
+L2EthernetNetDevice::GetQueue() const
+{
+    return m_queue;
+}
+
+inline void
+L2EthernetNetDevice::SetLinkUp(bool up)
+{
+    if (m_linkUp == up || m_channel == nullptr)
+    {
+        return;
+    }
+    m_linkUp = up;
+    NS_LOG_INFO("L2EthernetNetDevice " << m_address << ": link " << (up ? "up" : "down"));
+    m_linkChangeCallbacks();
+}
+
+inline bool
+L2EthernetNetDevice::Send(Ptr<Packet> packet, const Address& dest, uint16_t protocolNumber)
+{
+    return SendFrom(packet, m_address, dest, protocolNumber);
+}
+
+inline bool
+L2EthernetNetDevice::SendFrom(Ptr<Packet> packet,
+                              const Address& source,
+                              const Address& dest,
+                              uint16_t protocolNumber)
+{
+    if (!m_linkUp)
+    {
+        m_macTxDropTrace(packet);
+        return false;
+    }
+    // 超过 MTU 的负载不能发送; 802.1Q 标签由交换机放在负载开头，带标签的帧允许多出 4 字节
+    uint32_t maxPayload = m_mtu + (protocolNumber == VLAN_PROTOCOL ? VLAN_TAG_SIZE : 0);
+    if (packet->GetSize() > maxPayload)
+    {
+        NS_LOG_INFO("L2EthernetNetDevice " << m_address << ": " << packet->GetSize()
+                    << "-byte payload exceeds MTU " << m_mtu << ", dropped");
+        m_macTxDropTrace(packet);
+        return false;
+    }
+
+    // 以太网帧头: 源/目的 MAC 原样保留 (这正是 PointToPoint 做不到的)
+    EthernetHeader header(false);
+    header.SetSource(Mac48Address::ConvertFrom(source));
+    header.SetDestination(Mac48Address::ConvertFrom(dest));
+    header.SetLengthType(protocolNumber);
+    packet->AddHeader(header);
+
+    m_macTxTrace(packet);
+    if (!m_queue->Enqueue(packet))
+    {
+        m_macTxDropTrace(packet);
+        return false;
+    }
+    if (!m_txBusy)
+    {
+        StartTransmission();
+    }
+    return true;
+}
+
+inline void
+L2EthernetNetDevice::StartTransmission()
+{
+    Ptr<Packet> packet = m_queue->Dequeue();
+    if (packet == nullptr)
+    {
+        return;
+    }
+    m_txBusy = true;
+
+    // 到达对端只需要帧本身的发送时间，帧间隔只推迟下一个帧
+    Time txTime = m_dataRate.CalculateBytesTxTime(packet->GetSize() + WIRE_OVERHEAD);
+    Time gap = m_dataRate.CalculateBytesTxTime(INTERFRAME_GAP);
+    if (m_linkUp)
+    {
+        m_channel->Transmit(this, packet, txTime);
+    }
+    else
+    {
+        // 入队之后链路断开: 帧仍占用发送时间，但不会到达对端
+        m_macTxDropTrace(packet);
+    }
+    Simulator::Schedule(txTime + gap, &L2EthernetNetDevice::TransmitComplete, this);
+}
+
+inline void
+L2EthernetNetDevice::TransmitComplete()
+{
+    m_txBusy = false;
+    StartTransmission();
+}
+
+inline void
+L2EthernetNetDevice::Receive(Ptr<Packet> packet)
+{
+    if (!m_linkUp)
+    {
+        return;
+    }
+
+    EthernetHeader header(false);
+    packet->RemoveHeader(header);
+    Mac48Address source = header.GetSource();
+    Mac48Address destination = header.GetDestination();
+    uint16_t protocol = header.GetLengthType();
+
+    PacketType packetType;
+    if (destination.IsBroadcast())
+    {
+        packetType = PACKET_BROADCAST;
+    }
+    else if (destination.IsGroup())
+    {
+        packetType = PACKET_MULTICAST;
+    }
+    else if (destination == m_address)
+    {
+        packetType = PACKET_HOST;
+    }
+    else
+    {
+        packetType = PACKET_OTHERHOST;
+    }
+
+    m_macRxTrace(packet);
+
+    // 与 CsmaNetDevice 相同: 先交给混杂回调，不是发给别人的帧再交给协议栈
+    if (!m_promiscCallback.IsNull())
+    {
+        m_promiscCallback(this, packet, protocol, source, destination, packetType);
+    }
+    if (packetType != PACKET_OTHERHOST && !m_rxCallback.IsNull())
+    {
+        m_rxCallback(this, packet, protocol, source);
+    }
+}
+
+inline void
+L2EthernetNetDevice::SetIfIndex(const uint32_t index)
+{
+    m_ifIndex = index;
+}
+
+inline uint32_t
+L2EthernetNetDevice::GetIfIndex() const
+{
+    return m_ifIndex;
+}
+
+inline Ptr<Channel>
+L2EthernetNetDevice::GetChannel() const
+{
+    return m_channel;
+}
+
+inline void
+L2EthernetNetDevice::SetAddress(Address address)
+{
+    m_address = Mac48Address::ConvertFrom(address);
+}
+
+inline Address
+L2EthernetNetDevice::GetAddress() const
+{
+    return m_address;
+}
+
+inline bool
+L2EthernetNetDevice::SetMtu(const uint16_t mtu)
+{
+    m_mtu = mtu;
+    return true;
+}
+
+inline uint16_t
+L2EthernetNetDevice::GetMtu() const
+{
+    return m_mtu;
+}
+
+inline bool
+L2EthernetNetDevice::IsLinkUp() const
+{
+    return m_linkUp;
+}
+
+inline void
+L2EthernetNetDevice::AddLinkChangeCallback(Callback<void> callback)
+{
+    m_linkChangeCallbacks.ConnectWithoutContext(callback);
+}
+
+inline bool
+L2EthernetNetDevice::IsBroadcast() const
+{
+    return true;
+}
+
+inline Address
+L2EthernetNetDevice::GetBroadcast() const
+{
+    return Mac48Address::GetBroadcast();
+}
+
+inline bool
+L2EthernetNetDevice::IsMulticast() const
+{
+    return true;
+}
+
+inline Address
+L2EthernetNetDevice::GetMulticast(Ipv4Address multicastGroup) const
+{
+    return Mac48Address::GetMulticast(multicastGroup);
+}
+
+inline Address
+L2EthernetNetDevice::GetMulticast(Ipv6Address addr) const
+{
+    return Mac48Address::GetMulticast(addr);
+}
+
+inline bool
+L2EthernetNetDevice::IsBridge() const
+{
+    return false;
+}
+
+inline bool
+L2EthernetNetDevice::IsPointToPoint() const
+{
+    // 虽然只有两个端点，但语义上是以太网 (需要 ARP、保留 MAC)
+    return false;
+}
+
+inline Ptr<Node>
+L2EthernetNetDevice::GetNode() const
+{
+    return m_node;
+}
+
+inline void
+L2EthernetNetDevice::SetNode(Ptr<Node> node)
+{
+    m_node = node;
+}
+
+inline bool
+L2EthernetNetDevice::NeedsArp() const
+{
+    return true;
+}
+
+inline void
+L2EthernetNetDevice::SetReceiveCallback(NetDevice::ReceiveCallback cb)
+{
+    m_rxCallback = cb;
+}
+
+inline void
+L2EthernetNetDevice::SetPromiscReceiveCallback(NetDevice::PromiscReceiveCallback cb)
+{
+    m_promiscCallback = cb;
+}
+
+inline bool
+L2EthernetNetDevice::SupportsSendFrom() const
+{
+    return true;
+}
+
+// ============================================================================
+// L2EthernetChannel 实现
+// ============================================================================
+
+NS_OBJECT_ENSURE_REGISTERED(L2EthernetChannel);
+
+inline TypeId
+L2EthernetChannel::GetTypeId()
+{
+    static TypeId tid = TypeId("ns3::L2EthernetChannel")
+        .SetParent<Channel>()
+        .SetGroupName("Network")
+        .AddConstructor<L2EthernetChannel>()
+        .AddAttribute("Delay",
+                      "Propagation delay",
+                      TimeValue(NanoSeconds(500)),
+                      MakeTimeAccessor(&L2EthernetChannel::m_delay),
+                      MakeTimeChecker());
+    return tid;
+}
+
+inline L2EthernetChannel::L2EthernetChannel()
+    : m_nDevices(0)
+{
+}
+
+inline void
+L2EthernetChannel::DoDispose()
+{
+    m_devices[0] = nullptr;
+    m_devices[1] = nullptr;
+    m_nDevices = 0;
+    Channel::DoDispose();
+}
+
+inline bool
+L2EthernetChannel::Attach(Ptr<L2EthernetNetDevice> device)
+{
+    if (m_nDevices >= 2)
+    {
+        NS_LOG_WARN("L2EthernetChannel already has two devices");
+        return false;
+    }
+    m_devices[m_nDevices++] = device;
+    return true;
+}
+
+inline void
+L2EthernetChannel::Transmit(Ptr<L2EthernetNetDevice> sender, Ptr<Packet> packet, Time txTime)
+{
+    if (m_nDevices < 2)
+    {
+        return;
+    }
+    Ptr<L2EthernetNetDevice> peer = (m_devices[0] == sender) ? m_devices[1] : m_devices[0];
+
+    // 发送端已经不再使用这个 Packet，直接交给对端 (在对端节点的上下文中执行)
+    Simulator::ScheduleWithContext(peer->GetNode()->GetId(),
+                                   txTime + m_delay,
+                                   &L2EthernetNetDevice::Receive,
+                                   peer,
+                                   packet);
+}
+
+inline std::size_t
+L2EthernetChannel::GetNDevices() const
+{
+    return m_nDevices;
+}
+
+inline Ptr<NetDevice>
+L2EthernetChannel::GetDevice(std::size_t i) const
+{
+    return m_devices[i];
+}
+
+// ============================================================================
+// L2EthernetHelper 实现
+// ============================================================================
+
+inline L2EthernetHelper::L2EthernetHelper()
+    : m_queueSize("100p")
+{
+    m_deviceFactory.SetTypeId("ns3::L2EthernetNetDevice");
+    m_channelFactory.SetTypeId("ns3::L2EthernetChannel");
+}
+
+inline void
+L2EthernetHelper::SetDeviceAttribute(std::string name, const AttributeValue& value)
+{
+    m_deviceFactory.Set(name, value);
+}
+
+inline void
+L2EthernetHelper::SetChannelAttribute(std::string name, const AttributeValue& value)
+{
+    m_channelFactory.Set(name, value);
+}
+
+inline void
+L2EthernetHelper::SetQueueSize(QueueSize size)
+{
+    m_queueSize = size;
+}
+
+inline NetDeviceContainer
+L2EthernetHelper::Install(Ptr<Node> a, Ptr<Node> b) const
+{
+    Ptr<L2EthernetChannel> channel = m_channelFactory.Create<L2EthernetChannel>();
+    NetDeviceContainer devices;
+    for (Ptr<Node> node : {a, b})
+    {
+        Ptr<L2EthernetNetDevice> device = m_deviceFactory.Create<L2EthernetNetDevice>();
+        device->SetAddress(Mac48Address::Allocate());
+        Ptr<Queue<Packet>> queue = CreateObject<DropTailQueue<Packet>>();
+        queue->SetMaxSize(m_queueSize);
+        device->SetQueue(queue);
+        node->AddDevice(device);
+        device->Attach(channel);
+        devices.Add(device);
+    }
+    return devices;
+}
+
+inline NetDeviceContainer
+L2EthernetHelper::Install(const NodeContainer& nodes) const
+{
+    NS_ASSERT_MSG(nodes.GetN() == 2, "L2EthernetHelper connects exactly two nodes");
+    return Install(nodes.Get(0), nodes.Get(1));
+}
+
+} // namespace ns3
+
+#endif /* L2_ETHERNET_H */
@@ -0,0 +1,637 @@
+/*
+ * ============================================================================
+ * 标题: 匹配-动作流表 (OpenFlow 风格的 Match-Action Pipeline)
+ * ============================================================================
+ *
+ * 【设计目的】
+ *   SDN 管理的架顶交换机不靠学习决定转发，而是由控制器下发流表项:
+ *   "匹配帧头的某些字段 -> 执行一组动作"。这里给 L2SwitchProtocol 加上一个
+ *   可选的两级流表，未命中 (table-miss) 时回到原来的 MAC 学习转发。
+ *
+ * 【两级查找】
+ *
+ *   阶段 1: 精确匹配表
+ *     所有字段都指定 (IP 地址前缀为 /32) 的表项放在哈希表中，按完整的
+ *     L2-L4 元组查找，代价是一次哈希 + 一次比较，与表项数无关 (快速路径)。
+ *
+ *   阶段 2: 通配表
+ *     其余表项按优先级从高到低排列 (同优先级按添加顺序)，逐项比较，
+ *     第一个匹配的表项生效。代价与扫描到的表项数成正比。
+ *
+ *   精确表项同样有优先级。精确匹配表命中后，只有在通配表中存在优先级更高的表项时
+ *   才扫描阶段 2，而且只扫描这些更高优先级的表项 (通配表按优先级降序排列，
+ *   表头就是最高优先级)；其中有匹配的就覆盖精确命中，例如高优先级的 ACL 丢弃规则。
+ *   优先级相同时精确表项优先。通配表项的优先级都不高于精确表项时，快速路径不变。
+ *   每个阶段统计查找次数、命中次数和比较的表项数，用来评估查找代价。
+ *
+ * 【匹配字段】
+ *   入端口 (物理端口号)、VLAN、源/目的 MAC、EtherType (去掉 802.1Q 标签后)、
+ *   IPv4 源/目的地址 (可带前缀长度)、IP 协议号、TCP/UDP 源/目的端口。
+ *   非 IPv4 帧的 IP 和端口字段为 0；IPv4 分片 (包括带 MF 的首片) 没有端口 (为 0)。
+ *
+ * 【动作】 (按顺序执行)
+ *   OUTPUT(port)   从端口发出 (端口必须处于转发状态且属于帧的 VLAN)
+ *   FLOOD          泛洪到帧所属 VLAN 的其他端口
+ *   DROP           丢弃；动作列表为空时同样丢弃
+ *   SET_ETH_SRC/SET_ETH_DST/SET_VLAN  修改字段，影响之后的输出动作
+ *   GROUP(id)      组表: ALL 复制到所有桶的端口，SELECT 按流哈希选一个端口
+ *
+ * 作者: Liu Mengxuan
+ * ns-3 版本: 3.44
+ * ============================================================================
+ */
+
+#ifndef L2_FLOW_TABLE_H
+#define L2_FLOW_TABLE_H
+
+#include "l2-lag.h"
+#include "l2-mac-table.h"
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * @brief 流表查找用的 L2-L4 元组
+ */
+struct L2FlowKey
+{
+    uint64_t ethSrc = 0;   // 打包后的源 MAC (L2MacTable::PackMac)
+    uint64_t ethDst = 0;   // 打包后的目的 MAC
+    uint32_t ipSrc = 0;
+    uint32_t ipDst = 0;
+    uint16_t inPort = 0;   // 物理入端口
+    uint16_t vlan = 0;
+    uint16_t ethType = 0;  // 去掉 802.1Q 标签后的协议类型
+    uint16_t l4Src = 0;
+    uint16_t l4Dst = 0;
+    uint8_t ipProto = 0;
+
+    bool operator==(const L2FlowKey& other) const
+    {
+        return ethSrc == other.ethSrc && ethDst == other.ethDst && ipSrc == other.ipSrc &&
+               ipDst == other.ipDst && inPort == other.inPort && vlan == other.vlan &&
+               ethType == other.ethType && l4Src == other.l4Src && l4Dst == other.l4Dst &&
+               ipProto == other.ipProto;
+    }
+
+    uint64_t Hash() const
+    {
+        uint64_t h = L2LagMix(ethSrc ^ (uint64_t(inPort) << 48));
+        h = L2LagMix(h ^ ethDst ^ (uint64_t(vlan) << 48));
+        h = L2LagMix(h ^ (uint64_t(ipSrc) << 32 | ipDst));
+        h = L2LagMix(h ^ (uint64_t(ethType) << 40 | uint64_t(ipProto) << 32 |
+                          uint64_t(l4Src) << 16 | l4Dst));
+        return h;
+    }
+
+    /**
+     * @brief 从入帧中提取元组 (只用 CopyData() 读取帧开头的几十个字节)
+     * @param packet 入帧 (tagged 时以 802.1Q 标签开头)
+     * @param tagged 入帧是否带标签
+     * @param protocol 去掉标签后的协议类型
+     */
+    static L2FlowKey Extract(Ptr<const Packet> packet,
+                             bool tagged,
+                             uint16_t protocol,
+                             uint16_t inPort,
+                             uint16_t vlan,
+                             const Mac48Address& source,
+                             const Mac48Address& destination);
+};
+
+struct L2FlowKeyHash
+{
+    std::size_t operator()(const L2FlowKey& key) const
+    {
+        return static_cast<std::size_t>(key.Hash());
+    }
+};
+
+/**
+ * @brief 匹配条件: 只比较 fields 中指定的字段
+ */
+struct L2FlowMatch
+{
+    enum Field : uint32_t
+    {
+        IN_PORT = 1u << 0,
+        VLAN = 1u << 1,
+        ETH_SRC = 1u << 2,
+        ETH_DST = 1u << 3,
+        ETH_TYPE = 1u << 4,
+        IP_SRC = 1u << 5,
+        IP_DST = 1u << 6,
+        IP_PROTO = 1u << 7,
+        L4_SRC = 1u << 8,
+        L4_DST = 1u << 9,
+        ALL_FIELDS = (1u << 10) - 1
+    };
+
+    L2FlowKey value;                  // 要匹配的值 (IP 地址已经与前缀掩码相与)
+    uint32_t fields = 0;              // 参与匹配的字段
+    uint32_t ipSrcMask = 0xffffffff;  // IP 源地址前缀掩码
+    uint32_t ipDstMask = 0xffffffff;  // IP 目的地址前缀掩码
+
+    L2FlowMatch& SetInPort(uint16_t port)
+    {
+        value.inPort = port;
+        fields |= IN_PORT;
+        return *this;
+    }
+
+    L2FlowMatch& SetVlan(uint16_t vlan)
+    {
+        value.vlan = vlan;
+        fields |= VLAN;
+        return *this;
+    }
+
+    L2FlowMatch& SetEthSrc(const Mac48Address& mac)
+    {
+        value.ethSrc = L2MacTable::PackMac(mac);
+        fields |= ETH_SRC;
+        return *this;
+    }
+
+    L2FlowMatch& SetEthDst(const Mac48Address& mac)
+    {
+        value.ethDst = L2MacTable::PackMac(mac);
+        fields |= ETH_DST;
+        return *this;
+    }
+
+    L2FlowMatch& SetEthType(uint16_t ethType)
+    {
+        value.ethType = ethType;
+        fields |= ETH_TYPE;
+        return *this;
+    }
+
+    L2FlowMatch& SetIpSrc(Ipv4Address address, uint8_t prefix = 32)
+    {
+        ipSrcMask = PrefixMask(prefix);
+        value.ipSrc = address.Get() & ipSrcMask;
+        fields |= IP_SRC;
+        return *this;
+    }
+
+    L2FlowMatch& SetIpDst(Ipv4Address address, uint8_t prefix = 32)
+    {
+        ipDstMask = PrefixMask(prefix);
+        value.ipDst = address.Get() & ipDstMask;
+        fields |= IP_DST;
+        return *this;
+    }
+
+    L2FlowMatch& SetIpProto(uint8_t proto)
+    {
+        value.ipProto = proto;
+        fields |= IP_PROTO;
+        return *this;
+    }
+
+    L2FlowMatch& SetL4Src(uint16_t port)
+    {
+        value.l4Src = port;
+        fields |= L4_SRC;
+        return *this;
+    }
+
+    L2FlowMatch& SetL4Dst(uint16_t port)
+    {
+        value.l4Dst = port;
+        fields |= L4_DST;
+        return *this;
+    }
+
+    /**
+     * @brief 是否所有字段都精确指定 (可以放进精确匹配表)
+     */
+    bool IsExact() const
+    {
+        return fields == ALL_FIELDS && ipSrcMask == 0xffffffff && ipDstMask == 0xffffffff;
+    }
+
+    bool Matches(const L2FlowKey& key) const
+    {
+        return (!(fields & IN_PORT) || key.inPort == value.inPort) &&
+               (!(fields & VLAN) || key.vlan == value.vlan) &&
+               (!(fields & ETH_SRC) || key.ethSrc == value.ethSrc) &&
+               (!(fields & ETH_DST) || key.ethDst == value.ethDst) &&
+               (!(fields & ETH_TYPE) || key.ethType == value.ethType) &&
+               (!(fields & IP_SRC) || (key.ipSrc & ipSrcMask) == value.ipSrc) &&
+               (!(fields & IP_DST) || (key.ipDst & ipDstMask) == value.ipDst) &&
+               (!(fields & IP_PROTO) || key.ipProto == value.ipProto) &&
+               (!(fields & L4_SRC) || key.l4Src == value.l4Src) &&
+               (!(fields & L4_DST) || key.l4Dst == value.l4Dst);
+    }
+
+    static uint32_t PrefixMask(uint8_t prefix)
+    {
+        return prefix == 0 ? 0 : ~uint32_t(0) << (32 - std::min<uint8_t>(prefix, 32));
+    }
+};
+
+/**
+ * @brief 一个动作
+ */
+struct L2FlowAction
+{
+    enum Type : uint8_t
+    {
+        OUTPUT,       // 从 value 指定的端口发出
+        FLOOD,        // 泛洪
+        DROP,         // 丢弃
+        SET_ETH_SRC,  // 源 MAC 改为 mac
+        SET_ETH_DST,  // 目的 MAC 改为 mac
+        SET_VLAN,     // VLAN 改为 value
+        GROUP         // 执行 value 指定的组
+    };
+
+    Type type;
+    uint32_t value = 0;
+    Mac48Address mac;
+
+    static L2FlowAction Output(uint16_t port)
+    {
+        return L2FlowAction{OUTPUT, port, Mac48Address()};
+    }
+
+    static L2FlowAction Flood()
+    {
+        return L2FlowAction{FLOOD, 0, Mac48Address()};
+    }
+
+    static L2FlowAction Drop()
+    {
+        return L2FlowAction{DROP, 0, Mac48Address()};
+    }
+
+    static L2FlowAction SetEthSrc(const Mac48Address& mac)
+    {
+        return L2FlowAction{SET_ETH_SRC, 0, mac};
+    }
+
+    static L2FlowAction SetEthDst(const Mac48Address& mac)
+    {
+        return L2FlowAction{SET_ETH_DST, 0, mac};
+    }
+
+    static L2FlowAction SetVlan(uint16_t vlan)
+    {
+        return L2FlowAction{SET_VLAN, vlan, Mac48Address()};
+    }
+
+    static L2FlowAction Group(uint32_t id)
+    {
+        return L2FlowAction{GROUP, id, Mac48Address()};
+    }
+};
+
+/**
+ * @brief 组表项
+ */
+struct L2FlowGroup
+{
+    enum Type : uint8_t
+    {
+        ALL,    // 复制到所有端口 (组播/镜像)
+        SELECT  // 按流哈希选择一个端口 (多路径负载均衡)
+    };
+
+    Type type;
+    std::vector<uint16_t> ports;  // 每个桶一个输出端口
+};
+
+/**
+ * @brief 流表项
+ */
+struct L2FlowEntry
+{
+    uint32_t id;                        // AddFlow() 返回的编号
+    uint16_t priority;                  // 优先级，越大越先匹配
+    L2FlowMatch match;
+    std::vector<L2FlowAction> actions;
+    uint64_t packets = 0;               // 命中的帧数
+    uint64_t bytes = 0;                 // 命中的字节数
+};
+
+class L2FlowTable
+{
+public:
+    /**
+     * @brief 每个查找阶段的统计
+     */
+    struct Stats
+    {
+        uint64_t exactLookups;      // 阶段 1 查找次数
+        uint64_t exactHits;         // 阶段 1 命中且生效的次数 (被更高优先级通配表项覆盖的不计)
+        uint64_t wildcardLookups;   // 阶段 2 查找次数
+        uint64_t wildcardHits;      // 阶段 2 命中次数
+        uint64_t wildcardCompares;  // 阶段 2 比较的表项总数
+        uint64_t misses;            // 两个阶段都没有命中 (table-miss)
+    };
+
+    L2FlowTable();
+
+    /**
+     * @brief 添加一个表项
+     * @param match 匹配条件 (所有字段都精确指定时进入精确匹配表)
+     * @param priority 优先级，越大越先匹配
+     * @param actions 动作列表 (为空表示丢弃)
+     * @return 表项编号；相同匹配条件的精确表项会被替换
+     */
+    uint32_t AddFlow(const L2FlowMatch& match, uint16_t priority, const std::vector<L2FlowAction>& actions);
+
+    /**
+     * @brief 删除表项
+     * @return 表项存在并被删除返回 true
+     */
+    bool RemoveFlow(uint32_t id);
+
+    /**
+     * @brief 添加或替换一个组
+     */
+    void SetGroup(uint32_t id, L2FlowGroup::Type type, const std::vector<uint16_t>& ports);
+    const L2FlowGroup* GetGroup(uint32_t id) const;
+
+    /**
+     * @brief 查找帧命中的表项，命中时更新表项计数器
+     * @param key 帧的元组
+     * @param bytes 帧长 (字节)
+     * @return 命中的表项，未命中返回 nullptr
+     */
+    L2FlowEntry* Lookup(const L2FlowKey& key, uint32_t bytes);
+
+    bool IsEmpty() const;
+    uint32_t GetNExact() const;
+    uint32_t GetNWildcard() const;
+
+    /**
+     * @brief 遍历所有表项 (先精确表，再按优先级遍历通配表)
+     * @param f 回调，签名为 void (const L2FlowEntry&)
+     */
+    template <typename F>
+    void ForEach(F f) const;
+
+    Stats GetStats() const;
+
+    /**
+     * @brief 打印每个阶段的查找代价和每个表项的计数器
+     */
+    void Report(std::ostream& os, const std::string& prefix) const;
+
+    void Clear();
+
+private:
+    std::unordered_map<L2FlowKey, L2FlowEntry, L2FlowKeyHash> m_exact;  // 阶段 1
+    std::vector<L2FlowEntry> m_wildcard;                                 // 阶段 2 (按优先级降序)
+    std::unordered_map<uint32_t, L2FlowGroup> m_groups;                  // 组表
+    uint32_t m_nextId;
+    Stats m_stats;
+};
+
+// ============================================================================
+// 实现
+// ============================================================================
+
+inline L2FlowKey
+L2FlowKey::Extract(Ptr<const Packet> packet,
+                   bool tagged,
+                   uint16_t protocol,
+                   uint16_t inPort,
+                   uint16_t vlan,
+                   const Mac48Address& source,
+                   const Mac48Address& destination)
+{
+    L2FlowKey key;
+    key.ethSrc = L2MacTable::PackMac(source);
+    key.ethDst = L2MacTable::PackMac(destination);
+    key.inPort = inPort;
+    key.vlan = vlan;
+    key.ethType = protocol;
+    if (protocol != 0x0800)
+    {
+        return key;
+    }
+
+    // 标签 4 字节 + IPv4 头最长 60 字节 + 端口 4 字节
+    uint8_t buf[4 + 60 + 4];
+    uint32_t offset = tagged ? 4 : 0;
+    uint32_t len = packet->CopyData(buf, sizeof(buf));
+    if (len < offset + 20)
+    {
+        return key;
+    }
+    auto read16 = [&buf](uint32_t pos) { return static_cast<uint16_t>((buf[pos] << 8) | buf[pos + 1]); };
+    auto read32 = [&](uint32_t pos) { return (uint32_t(read16(pos)) << 16) | read16(pos + 2); };
+
+    uint32_t ihl = (buf[offset] & 0x0f) * 4u;
+    key.ipProto = buf[offset + 9];
+    key.ipSrc = read32(offset + 12);
+    key.ipDst = read32(offset + 16);
+    bool fragment = L2Ipv4IsFragment(read16(offset + 6));  // 包括首片，与 LAG 哈希一致
+    uint32_t l4 = offset + ihl;
+    if (!fragment && ihl >= 20 && (key.ipProto == 6 || key.ipProto == 17) && len >= l4 + 4)
+    {
+        key.l4Src = read16(l4);
+        key.l4Dst = read16(l4 + 2);
+    }
+    return key;
+}
+
+inline L2FlowTable::L2FlowTable()
+    : m_nextId(1),
+      m_stats()
+{
+}
+
+inline uint32_t
+L2FlowTable::AddFlow(const L2FlowMatch& match,
+                     uint16_t priority,
+                     const std::vector<L2FlowAction>& actions)
+{
+    L2FlowEntry entry{m_nextId++, priority, match, actions};
+    if (match.IsExact())
+    {
+        m_exact[match.value] = entry;
+        return entry.id;
+    }
+
+    // 插在第一个优先级更低的表项之前，同优先级保持添加顺序
+    auto it = std::upper_bound(m_wildcard.begin(), m_wildcard.end(), priority,
+                               [](uint16_t p, const L2FlowEntry& e) { return p > e.priority; });
+    m_wildcard.insert(it, entry);
+    return entry.id;
+}
+
+inline bool
+L2FlowTable::RemoveFlow(uint32_t id)
+{
+    for (auto it = m_exact.begin(); it != m_exact.end(); ++it)
+    {
+        if (it->second.id == id)
+        {
+            m_exact.erase(it);
+            return true;
+        }
+    }
+    auto it = std::find_if(m_wildcard.begin(), m_wildcard.end(),
+                           [id](const L2FlowEntry& e) { return e.id == id; });
+    if (it == m_wildcard.end())
+    {
+        return false;
+    }
+    m_wildcard.erase(it);
+    return true;
+}
+
+inline void
+L2FlowTable::SetGroup(uint32_t id, L2FlowGroup::Type type, const std::vector<uint16_t>& ports)
+{
+    m_groups[id] = L2FlowGroup{type, ports};
+}
+
+inline const L2FlowGroup*
+L2FlowTable::GetGroup(uint32_t id) const
+{
+    auto it = m_groups.find(id);
+    return it == m_groups.end() ? nullptr : &it->second;
+}
+
+inline L2FlowEntry*
+L2FlowTable::Lookup(const L2FlowKey& key, uint32_t bytes)
+{
+    L2FlowEntry* hit = nullptr;
+
+    // 阶段 1: 精确匹配
+    L2FlowEntry* exact = nullptr;
+    if (!m_exact.empty())
+    {
+        ++m_stats.exactLookups;
+        auto it = m_exact.find(key);
+        if (it != m_exact.end())
+        {
+            exact = &it->second;
+        }
+    }
+
+    // 阶段 2: 按优先级扫描通配表。精确命中时只看优先级更高的表项，
+    // 通配表的最高优先级 (表头) 不超过精确表项时整个阶段跳过
+    if (!m_wildcard.empty() &&
+        (exact == nullptr || m_wildcard.front().priority > exact->priority))
+    {
+        ++m_stats.wildcardLookups;
+        for (L2FlowEntry& entry : m_wildcard)
+        {
+            if (exact != nullptr && entry.priority <= exact->priority)
+            {
+                break;
+            }
+            ++m_stats.wildcardCompares;
+            if (entry.match.Matches(key))
+            {
+                ++m_stats.wildcardHits;
+                hit = &entry;
+                break;
+            }
+        }
+    }
+
+    if (hit == nullptr && exact != nullptr)
+    {
+        ++m_stats.exactHits;
+        hit = exact;
+    }
+
+    if (hit == nullptr)
+    {
+        ++m_stats.misses;
+        return nullptr;
+    }
+    ++hit->packets;
+    hit->bytes += bytes;
+    return hit;
+}
+
+inline bool
+L2FlowTable::IsEmpty() const
+{
+    return m_exact.empty() && m_wildcard.empty();
+}
+
+inline uint32_t
+L2FlowTable::GetNExact() const
+{
+    return static_cast<uint32_t>(m_exact.size());
+}
+
+inline uint32_t
+L2FlowTable::GetNWildcard() const
+{
+    return static_cast<uint32_t>(m_wildcard.size());
+}
+
+template <typename F>
+void
+L2FlowTable::ForEach(F f) const
+{
+    for (const auto& [key, entry] : m_exact)
+    {
+        f(entry);
+    }
+    for (const L2FlowEntry& entry : m_wildcard)
+    {
+        f(entry);
+    }
+}
+
+inline L2FlowTable::Stats
+L2FlowTable::GetStats() const
+{
+    return m_stats;
+}
+
+inline void
+L2FlowTable::Report(std::ostream& os, const std::string& prefix) const
+{
+    os << prefix << ": flow table " << m_exact.size() << " exact + " << m_wildcard.size()
+       << " wildcard entries, " << m_groups.size() << " groups" << std::endl;
+    os << "  exact stage: " << m_stats.exactLookups << " lookups, " << m_stats.exactHits
+       << " hits" << std::endl;
+    os << "  wildcard stage: " << m_stats.wildcardLookups << " lookups, " << m_stats.wildcardHits
+       << " hits, " << m_stats.wildcardCompares << " entries compared";
+    if (m_stats.wildcardLookups > 0)
+    {
+        os << " (" << double(m_stats.wildcardCompares) / m_stats.wildcardLookups
+           << " per lookup)";
+    }
+    os << std::endl;
+    os << "  table-miss: " << m_stats.misses << " (handled by MAC learning)" << std::endl;
+    ForEach([&os](const L2FlowEntry& entry) {
+        os << "  flow " << entry.id << " priority " << entry.priority
+           << (entry.match.IsExact() ? " (exact)" : "") << ": " << entry.packets
+           << " packets, " << entry.bytes << " bytes" << std::endl;
+    });
+}
+
+inline void
+L2FlowTable::Clear()
+{
+    m_exact.clear();
+    m_wildcard.clear();
+    m_groups.clear();
+}
+
+} // namespace ns3
+
+#endif /* L2_FLOW_TABLE_H */
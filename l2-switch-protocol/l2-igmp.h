@@ -0,0 +1,254 @@
+/*
+ * ============================================================================
+ * 标题: IGMP 报文解析与构造 (IGMP Snooping)
+ * ============================================================================
+ *
+ * 【设计目的】
+ *   组播帧的目的 MAC 是组地址 (01:00:5E:xx:xx:xx)，永远不会出现在 MAC 学习表中，
+ *   不做任何处理时和未知单播一样泛洪到所有端口。
+ *
+ *   IGMP 侦听 (RFC 4541): 交换机监听主机发出的 IGMP 成员报告和离开报文，
+ *   记录每个组播组有哪些端口感兴趣，组播数据只转发到这些端口和组播路由器端口。
+ *
+ * 【支持的报文】
+ *
+ *   类型   名称                  处理
+ *   0x11   成员查询 (Query)      记录路由器端口 (收到查询的端口)
+ *   0x12   IGMPv1 成员报告       加入
+ *   0x16   IGMPv2 成员报告       加入
+ *   0x17   IGMPv2 离开           离开
+ *   0x22   IGMPv3 成员报告       按组记录: EXCLUDE/ALLOW 为加入，INCLUDE 且源列表为空为离开
+ *
+ *   ns-3 的 IPv4 协议栈没有实现 IGMP，这里直接读取 IPv4 头和 IGMP 报文的字节，
+ *   不依赖 Ipv4Header/协议栈。构造函数生成的报文是完整的 IPv4 + IGMPv2 字节 (带校验和)，
+ *   用于交换机作为查询器发送查询，也可以由仿真脚本模拟主机发送报告。
+ *
+ * 作者: Liu Mengxuan
+ * ns-3 版本: 3.44
+ * ============================================================================
+ */
+
+#ifndef L2_IGMP_H
+#define L2_IGMP_H
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * @brief 一条 IGMP 记录 (一个报文中可以有多条，IGMPv3 报告)
+ */
+struct L2IgmpRecord
+{
+    enum Kind : uint8_t
+    {
+        IGMP_QUERY,  // 成员查询 (group 为 0 时是通用查询)
+        IGMP_JOIN,   // 加入组
+        IGMP_LEAVE   // 离开组
+    };
+
+    Kind kind;
+    Ipv4Address group;
+};
+
+class L2Igmp
+{
+public:
+    static constexpr uint16_t IPV4_PROTOCOL = 0x0800;  // IPv4 的 EtherType
+    static constexpr uint8_t PROTOCOL = 2;             // IGMP 的 IP 协议号
+
+    static constexpr uint8_t TYPE_QUERY = 0x11;
+    static constexpr uint8_t TYPE_V1_REPORT = 0x12;
+    static constexpr uint8_t TYPE_V2_REPORT = 0x16;
+    static constexpr uint8_t TYPE_V2_LEAVE = 0x17;
+    static constexpr uint8_t TYPE_V3_REPORT = 0x22;
+
+    /**
+     * @brief 解析 IPv4 帧中的 IGMP 报文
+     * @param packet IPv4 帧 (offset 之后是 IPv4 头)
+     * @param offset IPv4 头的位置 (带 802.1Q 标签时为 4)
+     * @param buffer 临时缓冲区 (由调用者复用，避免每次分配)
+     * @param records [out] 解析出的记录
+     * @param source [out] IPv4 源地址
+     * @return 是否是 IGMP 报文
+     */
+    static bool Parse(Ptr<const Packet> packet,
+                      uint32_t offset,
+                      std::vector<uint8_t>& buffer,
+                      std::vector<L2IgmpRecord>& records,
+                      Ipv4Address& source);
+
+    /**
+     * @brief 构造一个 IPv4 + IGMPv2 报文
+     * @param type 报文类型 (TYPE_QUERY / TYPE_V2_REPORT / TYPE_V2_LEAVE)
+     * @param group 组地址 (通用查询为 0.0.0.0)
+     * @param source IPv4 源地址
+     * @param destination IPv4 目的地址
+     * @param maxResponse 查询的最大响应时间 (1/10 秒)
+     */
+    static Ptr<Packet> MakeMessage(uint8_t type,
+                                   Ipv4Address group,
+                                   Ipv4Address source,
+                                   Ipv4Address destination,
+                                   uint8_t maxResponse = 100);
+
+    /**
+     * @brief 是否是 224.0.0.x (本地网络控制块) 对应的 MAC，这些组总是泛洪
+     */
+    static bool IsLinkLocalGroup(const Mac48Address& mac);
+
+private:
+    static uint16_t Checksum(const uint8_t* data, uint32_t len);
+};
+
+// ============================================================================
+// 实现
+// ============================================================================
+
+inline bool
+L2Igmp::Parse(Ptr<const Packet> packet,
+              uint32_t offset,
+              std::vector<uint8_t>& buffer,
+              std::vector<L2IgmpRecord>& records,
+              Ipv4Address& source)
+{
+    records.clear();
+
+    // 先只读 IPv4 固定头部，不是 IGMP 的组播数据不需要复制更多字节
+    uint8_t head[4 + 20];
+    uint32_t len = packet->CopyData(head, offset + 20);
+    if (len < offset + 20 || (head[offset] >> 4) != 4 || head[offset + 9] != PROTOCOL)
+    {
+        return false;
+    }
+    uint32_t ihl = (head[offset] & 0x0f) * 4u;
+    uint32_t total = (uint32_t(head[offset + 2]) << 8) | head[offset + 3];
+    source = Ipv4Address((uint32_t(head[offset + 12]) << 24) | (uint32_t(head[offset + 13]) << 16) |
+                         (uint32_t(head[offset + 14]) << 8) | head[offset + 15]);
+
+    buffer.resize(std::min(packet->GetSize(), offset + total));
+    len = packet->CopyData(buffer.data(), buffer.size());
+    uint32_t igmp = offset + ihl;
+    if (ihl < 20 || len < igmp + 8)
+    {
+        return false;
+    }
+    const uint8_t* p = buffer.data() + igmp;
+    auto readAddress = [](const uint8_t* a) {
+        return Ipv4Address((uint32_t(a[0]) << 24) | (uint32_t(a[1]) << 16) |
+                           (uint32_t(a[2]) << 8) | a[3]);
+    };
+
+    switch (p[0])
+    {
+    case TYPE_QUERY:
+        records.push_back({L2IgmpRecord::IGMP_QUERY, readAddress(p + 4)});
+        break;
+    case TYPE_V1_REPORT:
+    case TYPE_V2_REPORT:
+        records.push_back({L2IgmpRecord::IGMP_JOIN, readAddress(p + 4)});
+        break;
+    case TYPE_V2_LEAVE:
+        records.push_back({L2IgmpRecord::IGMP_LEAVE, readAddress(p + 4)});
+        break;
+    case TYPE_V3_REPORT: {
+        // 8 字节头之后是 N 条组记录: 类型(1) 辅助长度(1) 源数(2) 组地址(4) 源列表 辅助数据
+        uint32_t nRecords = (uint32_t(p[6]) << 8) | p[7];
+        uint32_t pos = igmp + 8;
+        for (uint32_t i = 0; i < nRecords && pos + 8 <= len; ++i)
+        {
+            const uint8_t* r = buffer.data() + pos;
+            uint8_t recordType = r[0];
+            uint32_t nSources = (uint32_t(r[2]) << 8) | r[3];
+            Ipv4Address group = readAddress(r + 4);
+            // 1 MODE_IS_INCLUDE, 2 MODE_IS_EXCLUDE, 3 CHANGE_TO_INCLUDE,
+            // 4 CHANGE_TO_EXCLUDE, 5 ALLOW_NEW_SOURCES, 6 BLOCK_OLD_SOURCES
+            if (recordType == 2 || recordType == 4 || recordType == 5 ||
+                (recordType == 1 && nSources > 0))
+            {
+                records.push_back({L2IgmpRecord::IGMP_JOIN, group});
+            }
+            else if ((recordType == 1 || recordType == 3) && nSources == 0)
+            {
+                records.push_back({L2IgmpRecord::IGMP_LEAVE, group});
+            }
+            pos += 8 + nSources * 4 + r[1] * 4u;
+        }
+        break;
+    }
+    default:
+        break;
+    }
+    return true;
+}
+
+inline uint16_t
+L2Igmp::Checksum(const uint8_t* data, uint32_t len)
+{
+    uint32_t sum = 0;
+    for (uint32_t i = 0; i + 1 < len; i += 2)
+    {
+        sum += (uint32_t(data[i]) << 8) | data[i + 1];
+    }
+    while (sum >> 16)
+    {
+        sum = (sum & 0xffff) + (sum >> 16);
+    }
+    return static_cast<uint16_t>(~sum);
+}
+
+inline Ptr<Packet>
+L2Igmp::MakeMessage(uint8_t type,
+                    Ipv4Address group,
+                    Ipv4Address source,
+                    Ipv4Address destination,
+                    uint8_t maxResponse)
+{
+    uint8_t buf[28] = {};
+    auto writeAddress = [&buf](uint32_t pos, Ipv4Address a) {
+        uint32_t v = a.Get();
+        buf[pos] = static_cast<uint8_t>(v >> 24);
+        buf[pos + 1] = static_cast<uint8_t>(v >> 16);
+        buf[pos + 2] = static_cast<uint8_t>(v >> 8);
+        buf[pos + 3] = static_cast<uint8_t>(v);
+    };
+
+    // IPv4 头: 版本 4，头长 20，总长 28，TTL 1，协议 2
+    buf[0] = 0x45;
+    buf[3] = 28;
+    buf[8] = 1;
+    buf[9] = PROTOCOL;
+    writeAddress(12, source);
+    writeAddress(16, destination);
+    uint16_t ipSum = Checksum(buf, 20);
+    buf[10] = static_cast<uint8_t>(ipSum >> 8);
+    buf[11] = static_cast<uint8_t>(ipSum);
+
+    // IGMPv2: 类型、最大响应时间、校验和、组地址
+    buf[20] = type;
+    buf[21] = (type == TYPE_QUERY) ? maxResponse : 0;
+    writeAddress(24, group);
+    uint16_t igmpSum = Checksum(buf + 20, 8);
+    buf[22] = static_cast<uint8_t>(igmpSum >> 8);
+    buf[23] = static_cast<uint8_t>(igmpSum);
+
+    return Create<Packet>(buf, sizeof(buf));
+}
+
+inline bool
+L2Igmp::IsLinkLocalGroup(const Mac48Address& mac)
+{
+    uint8_t b[6];
+    mac.CopyTo(b);
+    return b[0] == 0x01 && b[1] == 0x00 && b[2] == 0x5e && b[3] == 0x00 && b[4] == 0x00;
+}
+
+} // namespace ns3
+
+#endif /* L2_IGMP_H */
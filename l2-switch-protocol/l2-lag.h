@@ -0,0 +1,171 @@
+/*
+ * ============================================================================
+ * 标题: 链路聚合 (Link Aggregation, LAG)
+ * ============================================================================
+ *
+ * 【设计目的】
+ *   两台交换机之间的一条链路带宽不够时，可以并联多条链路。但如果每条链路都是
+ *   独立的端口，它们会构成环路 (广播风暴)，或者被生成树阻塞到只剩一条。
+ *
+ *   链路聚合把几个物理端口当作一个逻辑端口:
+ *   - MAC 地址学习到逻辑端口上 (从哪个成员收到都一样)
+ *   - 泛洪时一个逻辑端口只发一份，入端口所在的整个聚合组都不回发
+ *   - 单播/泛洪发出时按帧头字段的哈希选择一个成员，同一条流总是走同一个成员 (不乱序)
+ *   - 成员链路断开时从可用成员中去掉，流量重新哈希到其余成员上
+ *
+ *   逻辑端口号 = 组内最小的物理端口号，所以 MAC 表、泛洪位图和 RSTP 都不需要
+ *   新的编号空间。
+ *
+ * 【哈希字段】
+ *   L2      源/目的 MAC、EtherType
+ *   L2L3    再加上源/目的 IP 地址和 IP 协议号 (IPv4/IPv6)
+ *   L2L3L4  再加上 TCP/UDP 源/目的端口 (IPv4 分片没有端口，只用 L3 字段)
+ *
+ *   只用 CopyData() 读取帧开头的几十个字节，不复制 Packet。
+ *
+ * 作者: Liu Mengxuan
+ * ns-3 版本: 3.44
+ * ============================================================================
+ */
+
+#ifndef L2_LAG_H
+#define L2_LAG_H
+
+#include "l2-mac-table.h"
+
+#include "ns3/network-module.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * @brief 选择聚合组成员时参与哈希的字段
+ */
+enum L2LagHashPolicy : uint8_t
+{
+    L2_LAG_HASH_L2,      // MAC 地址 + EtherType
+    L2_LAG_HASH_L2L3,    // + IP 地址和协议号
+    L2_LAG_HASH_L2L3L4   // + TCP/UDP 端口
+};
+
+/**
+ * @brief 一个聚合组
+ */
+struct L2LinkAggregation
+{
+    std::vector<uint16_t> members;  // 所有成员端口 (升序，第一个就是逻辑端口号)
+    std::vector<uint16_t> active;   // 链路正常的成员端口
+
+    /**
+     * @brief 按哈希值选择一个可用成员
+     * @return 物理端口号，没有可用成员时返回 L2MacTable::NO_PORT
+     */
+    uint16_t Select(uint32_t hash) const
+    {
+        return active.empty() ? L2MacTable::NO_PORT : active[hash % active.size()];
+    }
+};
+
+/**
+ * @brief 64 位混合函数 (splitmix64 的最后一步)
+ */
+inline uint64_t
+L2LagMix(uint64_t h)
+{
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebULL;
+    h ^= h >> 31;
+    return h;
+}
+
+/**
+ * @brief IPv4 报文是否为分片 (MF 标志或分片偏移非 0)
+ * @param flagsOffset IPv4 头第 6-7 字节 (标志 + 分片偏移)
+ *
+ * 带 MF 的首片也算分片: 同一个数据报的所有分片都不使用 L4 端口，
+ * LAG 哈希和流表匹配 (L2FlowKey::Extract) 对它们的处理一致，
+ * 分片不会被分到不同的成员链路，也不会命中不同的流表项。
+ */
+inline bool
+L2Ipv4IsFragment(uint16_t flagsOffset)
+{
+    return (flagsOffset & 0x3fff) != 0;
+}
+
+/**
+ * @brief 计算帧的聚合组哈希值
+ * @param packet 帧 (不含以太网帧头，tagged 时以 802.1Q 标签开头)
+ * @param tagged 帧是否带 802.1Q 标签
+ * @param protocol 去掉标签后的协议类型
+ * @param source 源 MAC
+ * @param destination 目的 MAC
+ * @param policy 参与哈希的字段
+ */
+inline uint32_t
+L2LagHash(Ptr<const Packet> packet,
+          bool tagged,
+          uint16_t protocol,
+          const Mac48Address& source,
+          const Mac48Address& destination,
+          L2LagHashPolicy policy)
+{
+    uint64_t h = L2LagMix(L2MacTable::PackMac(source) ^ (uint64_t(protocol) << 48));
+    h = L2LagMix(h ^ L2MacTable::PackMac(destination));
+    if (policy == L2_LAG_HASH_L2 || (protocol != 0x0800 && protocol != 0x86DD))
+    {
+        return static_cast<uint32_t>(h ^ (h >> 32));
+    }
+
+    // 标签 4 字节 + IPv4 头最长 60 字节 (IPv6 固定 40 字节) + 端口 4 字节
+    uint8_t buf[4 + 60 + 4];
+    uint32_t offset = tagged ? 4 : 0;
+    uint32_t len = packet->CopyData(buf, sizeof(buf));
+
+    auto read = [&](uint32_t pos, uint32_t n) -> uint64_t {
+        uint64_t v = 0;
+        for (uint32_t i = 0; i < n; ++i)
+        {
+            v = (v << 8) | buf[pos + i];
+        }
+        return v;
+    };
+
+    uint32_t l4 = 0;       // L4 头的位置，0 表示没有可用的端口
+    uint8_t l4Proto = 0;
+    if (protocol == 0x0800 && len >= offset + 20)
+    {
+        uint32_t ihl = (buf[offset] & 0x0f) * 4u;
+        l4Proto = buf[offset + 9];
+        h = L2LagMix(h ^ read(offset + 12, 8) ^ (uint64_t(l4Proto) << 56));
+        bool fragment = L2Ipv4IsFragment(static_cast<uint16_t>(read(offset + 6, 2)));
+        if (!fragment && ihl >= 20)
+        {
+            l4 = offset + ihl;
+        }
+    }
+    else if (protocol == 0x86DD && len >= offset + 40)
+    {
+        l4Proto = buf[offset + 6];
+        h = L2LagMix(h ^ read(offset + 8, 8) ^ (uint64_t(l4Proto) << 56));
+        h = L2LagMix(h ^ read(offset + 16, 8));
+        h = L2LagMix(h ^ read(offset + 24, 8));
+        h = L2LagMix(h ^ read(offset + 32, 8));
+        l4 = offset + 40;
+    }
+
+    if (policy == L2_LAG_HASH_L2L3L4 && l4 != 0 && (l4Proto == 6 || l4Proto == 17) &&
+        len >= l4 + 4)
+    {
+        h = L2LagMix(h ^ read(l4, 4));
+    }
+    return static_cast<uint32_t>(h ^ (h >> 32));
+}
+
+} // namespace ns3
+
+#endif /* L2_LAG_H */
@@ -0,0 +1,442 @@
+/*
+ * ============================================================================
+ * 标题: MAC 表快照 (Warm-start snapshot / restore)
+ * ============================================================================
+ *
+ * 【设计目的】
+ *   在同一个拓扑上扫参数时，每次运行开头都要重复同样的学习过程: 每个目的地址的
+ *   第一个帧都会泛洪。这既浪费运行时间，又给结果带来与被测参数无关的噪声。
+ *
+ *   Save() 在一次运行结束时把所有交换机的 MAC 表写进一个紧凑的二进制文件，
+ *   下一次运行在 Simulator::Run() 之前用 Load() 装回去 (热启动)。
+ *   老化信息一起保存: 每个表项记录保存时的空闲时间，恢复后老化时钟从快照时间继续，
+ *   表项在新的运行中按 AgingTime 照常老化 (AgingTime 改变时按新值计算)。
+ *   快照时间记录的是老化时钟 (GetAgingClock())，热启动的运行再保存时时钟仍然连续，
+ *   可以一次接一次地链式热启动。Check() 在保存后重新读入文件，确认它能原样装回。
+ *
+ * 【文件格式】 (所有整数为小端序)
+ *
+ *   "L2MS"  版本(u32)  快照时间(i64 纳秒，老化时钟而不是仿真时间)  交换机数(u32)
+ *   每台交换机:
+ *     节点 ID(u32)  名称长度(u16) 名称  端口数(u16)  每个端口设备的 MAC(6 字节)
+ *     表项数(u32)
+ *     每个表项: VLAN(u16)  MAC(6 字节)  端口(u16)  标志(u8)  空闲时间(i64 纳秒)
+ *
+ *   每个表项 19 字节。
+ *
+ * 【拓扑校验】
+ *   交换机数必须相同；每台交换机的节点 ID、名称、端口数和每个端口设备的 MAC 地址
+ *   都必须与快照一致 (同样的建网顺序下 ns-3 分配的 MAC 地址是确定的)。
+ *   不一致的交换机不装入任何表项，文件格式错误时整个快照都不装入。
+ *
+ * 【注意】
+ *   - Load() 必须在所有交换机 Initialize() 之后、Simulator::Run() 之前调用
+ *   - Check() 与 Save() 在同一时刻调用 (表项的空闲时间随仿真时间变化)
+ *   - Save() 先写 <path>.tmp，写完后改名为 path，path 上不会出现写了一半的文件
+ *   - 本文件依赖 l2-switch-protocol.cc 中的类定义，必须在 L2SwitchProtocol 定义之后 include
+ *
+ * 作者: Liu Mengxuan
+ * ns-3 版本: 3.44
+ * ============================================================================
+ */
+
+#ifndef L2_MAC_SNAPSHOT_H
+#define L2_MAC_SNAPSHOT_H
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+class L2MacSnapshot
+{
+public:
+    static constexpr uint32_t VERSION = 1;
+
+    /**
+     * @brief 一次保存或装入的结果
+     */
+    struct Stats
+    {
+        bool valid;          // 文件能否打开且格式正确
+        uint32_t switches;   // 快照中的交换机数
+        uint32_t mismatched; // 与当前拓扑不一致、被跳过的交换机数
+        uint64_t entries;    // 保存或装入的表项数
+        uint64_t skipped;    // 装入时被跳过的表项数 (端口无效、已过期或表满)
+    };
+
+    /**
+     * @brief 把所有交换机的 MAC 表写入文件
+     * @param path 文件路径
+     * @param switches 交换机节点
+     */
+    static Stats Save(const std::string& path, NodeContainer switches);
+
+    /**
+     * @brief 从文件装入 MAC 表
+     * @param path 文件路径
+     * @param switches 交换机节点 (必须与保存时的拓扑相同)
+     */
+    static Stats Load(const std::string& path, NodeContainer switches);
+
+    /**
+     * @brief 检查文件能否原样装回当前的 MAC 表 (保存→装入的往返校验)
+     * @param path Save() 刚写出的文件
+     * @param switches 交换机节点
+     * @return 快照时间等于每台交换机的老化时钟、表项逐项相同，且装入时不会截短任何
+     *         表项的空闲时间时返回 true
+     */
+    static bool Check(const std::string& path, NodeContainer switches);
+
+private:
+    /**
+     * @brief 读出并校验整个快照文件
+     * @param snapshotTime 快照时间
+     * @param tables 每台交换机的表项
+     * @param matched 每台交换机是否与当前拓扑一致
+     * @return 文件能否打开且格式正确
+     */
+    static bool ReadFile(const std::string& path,
+                         NodeContainer switches,
+                         Time& snapshotTime,
+                         std::vector<std::vector<L2SwitchProtocol::MacEntrySnapshot>>& tables,
+                         std::vector<bool>& matched);
+
+    /**
+     * @brief 交换机每个端口设备的 MAC 地址 (拓扑指纹)
+     */
+    static std::vector<Mac48Address> PortAddresses(Ptr<Node> node, uint16_t nPorts);
+
+    static void Write(std::ostream& os, uint64_t value, uint32_t bytes);
+    static bool Read(std::istream& is, uint64_t& value, uint32_t bytes);
+    static void WriteMac(std::ostream& os, const Mac48Address& mac);
+    static bool ReadMac(std::istream& is, Mac48Address& mac);
+};
+
+// ============================================================================
+// 实现
+// ============================================================================
+
+inline void
+L2MacSnapshot::Write(std::ostream& os, uint64_t value, uint32_t bytes)
+{
+    for (uint32_t i = 0; i < bytes; ++i)
+    {
+        os.put(static_cast<char>(value >> (8 * i)));
+    }
+}
+
+inline bool
+L2MacSnapshot::Read(std::istream& is, uint64_t& value, uint32_t bytes)
+{
+    value = 0;
+    for (uint32_t i = 0; i < bytes; ++i)
+    {
+        int c = is.get();
+        if (c == std::char_traits<char>::eof())
+        {
+            return false;
+        }
+        value |= uint64_t(static_cast<uint8_t>(c)) << (8 * i);
+    }
+    return true;
+}
+
+inline void
+L2MacSnapshot::WriteMac(std::ostream& os, const Mac48Address& mac)
+{
+    uint8_t buf[6];
+    mac.CopyTo(buf);
+    os.write(reinterpret_cast<const char*>(buf), sizeof(buf));
+}
+
+inline bool
+L2MacSnapshot::ReadMac(std::istream& is, Mac48Address& mac)
+{
+    uint8_t buf[6];
+    if (!is.read(reinterpret_cast<char*>(buf), sizeof(buf)))
+    {
+        return false;
+    }
+    mac.CopyFrom(buf);
+    return true;
+}
+
+inline std::vector<Mac48Address>
+L2MacSnapshot::PortAddresses(Ptr<Node> node, uint16_t nPorts)
+{
+    std::vector<Mac48Address> addresses;
+    for (uint16_t p = 0; p < nPorts; ++p)
+    {
+        addresses.push_back(Mac48Address::ConvertFrom(node->GetDevice(p)->GetAddress()));
+    }
+    return addresses;
+}
+
+inline L2MacSnapshot::Stats
+L2MacSnapshot::Save(const std::string& path, NodeContainer switches)
+{
+    // 先写临时文件，完整写完后再改名: 进程在写入途中被终止 (例如扫描脚本超时重试) 时
+    // 不会在 path 留下写了一半的快照
+    Stats stats{};
+    const std::string tmp = path + ".tmp";
+    std::ofstream os(tmp, std::ios::binary | std::ios::trunc);
+    if (!os)
+    {
+        NS_LOG_WARN("Cannot open MAC table snapshot " << tmp << " for writing");
+        return stats;
+    }
+
+    // 快照时间取老化时钟: 热启动的运行中它比 Simulator::Now() 多出上一次的快照时间。
+    // 所有交换机从同一个快照恢复，时钟相同；部分交换机没有恢复时取最大值，
+    // 装入时空闲时间不会因此被截短
+    Time clock = Simulator::Now();
+    for (uint32_t s = 0; s < switches.GetN(); ++s)
+    {
+        Ptr<L2SwitchProtocol> protocol = switches.Get(s)->GetObject<L2SwitchProtocol>();
+        NS_ASSERT_MSG(protocol, "L2SwitchProtocol is not installed on node "
+                      << switches.Get(s)->GetId());
+        clock = Max(clock, protocol->GetAgingClock());
+    }
+
+    os.write("L2MS", 4);
+    Write(os, VERSION, 4);
+    Write(os, static_cast<uint64_t>(clock.GetNanoSeconds()), 8);
+    Write(os, switches.GetN(), 4);
+    for (uint32_t s = 0; s < switches.GetN(); ++s)
+    {
+        Ptr<Node> node = switches.Get(s);
+        Ptr<L2SwitchProtocol> protocol = node->GetObject<L2SwitchProtocol>();
+        NS_ASSERT_MSG(protocol, "L2SwitchProtocol is not installed on node " << node->GetId());
+
+        Write(os, node->GetId(), 4);
+        const std::string& name = protocol->GetSwitchName();
+        Write(os, name.size(), 2);
+        os.write(name.data(), static_cast<std::streamsize>(name.size()));
+        uint16_t nPorts = protocol->GetNPorts();
+        Write(os, nPorts, 2);
+        for (const Mac48Address& mac : PortAddresses(node, nPorts))
+        {
+            WriteMac(os, mac);
+        }
+
+        std::vector<L2SwitchProtocol::MacEntrySnapshot> entries = protocol->GetMacEntries();
+        Write(os, entries.size(), 4);
+        for (const auto& e : entries)
+        {
+            Write(os, e.vlan, 2);
+            WriteMac(os, e.address);
+            Write(os, e.port, 2);
+            Write(os, e.isStatic ? L2MacTable::FLAG_STATIC : 0, 1);
+            Write(os, static_cast<uint64_t>(e.idle.GetNanoSeconds()), 8);
+        }
+        stats.entries += entries.size();
+        ++stats.switches;
+    }
+
+    os.close();
+    stats.valid = static_cast<bool>(os) && std::rename(tmp.c_str(), path.c_str()) == 0;
+    if (!stats.valid)
+    {
+        NS_LOG_WARN("Cannot write MAC table snapshot " << path);
+        std::remove(tmp.c_str());
+        return stats;
+    }
+    NS_LOG_INFO("Saved " << stats.entries << " MAC entries of " << stats.switches
+               << " switches to " << path);
+    return stats;
+}
+
+inline bool
+L2MacSnapshot::ReadFile(const std::string& path,
+                        NodeContainer switches,
+                        Time& snapshotTime,
+                        std::vector<std::vector<L2SwitchProtocol::MacEntrySnapshot>>& tables,
+                        std::vector<bool>& matched)
+{
+    std::ifstream is(path, std::ios::binary);
+    char magic[4];
+    uint64_t version = 0;
+    uint64_t snapshotNs = 0;
+    uint64_t nSwitches = 0;
+    if (!is || !is.read(magic, 4) || std::string(magic, 4) != "L2MS" || !Read(is, version, 4) ||
+        version != VERSION || !Read(is, snapshotNs, 8) || !Read(is, nSwitches, 4))
+    {
+        NS_LOG_WARN("Cannot read MAC table snapshot " << path);
+        return false;
+    }
+    if (nSwitches != switches.GetN())
+    {
+        NS_LOG_WARN("MAC table snapshot " << path << " has " << nSwitches
+                    << " switches, topology has " << switches.GetN());
+        return false;
+    }
+    snapshotTime = NanoSeconds(static_cast<int64_t>(snapshotNs));
+
+    tables.assign(nSwitches, {});
+    matched.assign(nSwitches, true);
+    for (uint32_t s = 0; s < nSwitches; ++s)
+    {
+        Ptr<Node> node = switches.Get(s);
+        Ptr<L2SwitchProtocol> protocol = node->GetObject<L2SwitchProtocol>();
+        NS_ASSERT_MSG(protocol, "L2SwitchProtocol is not installed on node " << node->GetId());
+
+        uint64_t nodeId = 0;
+        uint64_t nameLength = 0;
+        uint64_t nPorts = 0;
+        if (!Read(is, nodeId, 4) || !Read(is, nameLength, 2))
+        {
+            NS_LOG_WARN("MAC table snapshot " << path << " is truncated");
+            return false;
+        }
+        std::string name(nameLength, '\0');
+        if (!is.read(name.data(), static_cast<std::streamsize>(nameLength)) || !Read(is, nPorts, 2))
+        {
+            NS_LOG_WARN("MAC table snapshot " << path << " is truncated");
+            return false;
+        }
+        std::vector<Mac48Address> ports(nPorts);
+        for (auto& mac : ports)
+        {
+            if (!ReadMac(is, mac))
+            {
+                NS_LOG_WARN("MAC table snapshot " << path << " is truncated");
+                return false;
+            }
+        }
+        if (nodeId != node->GetId() || name != protocol->GetSwitchName() ||
+            nPorts != protocol->GetNPorts() ||
+            ports != PortAddresses(node, protocol->GetNPorts()))
+        {
+            NS_LOG_WARN("MAC table snapshot entry " << name << " (node " << nodeId
+                        << ") does not match " << protocol->GetSwitchName() << " (node "
+                        << node->GetId() << "), skipped");
+            matched[s] = false;
+        }
+
+        uint64_t nEntries = 0;
+        if (!Read(is, nEntries, 4))
+        {
+            NS_LOG_WARN("MAC table snapshot " << path << " is truncated");
+            return false;
+        }
+        tables[s].reserve(nEntries);
+        for (uint64_t i = 0; i < nEntries; ++i)
+        {
+            uint64_t vlan = 0;
+            uint64_t port = 0;
+            uint64_t flags = 0;
+            uint64_t idle = 0;
+            Mac48Address mac;
+            if (!Read(is, vlan, 2) || !ReadMac(is, mac) || !Read(is, port, 2) ||
+                !Read(is, flags, 1) || !Read(is, idle, 8))
+            {
+                NS_LOG_WARN("MAC table snapshot " << path << " is truncated");
+                return false;
+            }
+            tables[s].push_back(L2SwitchProtocol::MacEntrySnapshot{
+                static_cast<uint16_t>(vlan),
+                mac,
+                static_cast<uint16_t>(port),
+                (flags & L2MacTable::FLAG_STATIC) != 0,
+                NanoSeconds(static_cast<int64_t>(idle))});
+        }
+    }
+    return true;
+}
+
+inline L2MacSnapshot::Stats
+L2MacSnapshot::Load(const std::string& path, NodeContainer switches)
+{
+    // 先读出并校验整个文件，全部正确后再装入，格式错误时不留下装了一半的表
+    Stats stats{};
+    Time snapshotTime;
+    std::vector<std::vector<L2SwitchProtocol::MacEntrySnapshot>> tables;
+    std::vector<bool> matched;
+    if (!ReadFile(path, switches, snapshotTime, tables, matched))
+    {
+        return stats;
+    }
+
+    stats.valid = true;
+    stats.switches = static_cast<uint32_t>(tables.size());
+    for (uint32_t s = 0; s < tables.size(); ++s)
+    {
+        if (!matched[s])
+        {
+            ++stats.mismatched;
+            continue;
+        }
+        Ptr<L2SwitchProtocol> protocol = switches.Get(s)->GetObject<L2SwitchProtocol>();
+        uint32_t restored = protocol->RestoreMacEntries(tables[s], snapshotTime);
+        stats.entries += restored;
+        stats.skipped += tables[s].size() - restored;
+    }
+
+    NS_LOG_INFO("Loaded " << stats.entries << " MAC entries from " << path << " ("
+               << stats.skipped << " skipped, " << stats.mismatched << " switches mismatched)");
+    return stats;
+}
+
+inline bool
+L2MacSnapshot::Check(const std::string& path, NodeContainer switches)
+{
+    Time snapshotTime;
+    std::vector<std::vector<L2SwitchProtocol::MacEntrySnapshot>> tables;
+    std::vector<bool> matched;
+    if (!ReadFile(path, switches, snapshotTime, tables, matched))
+    {
+        return false;
+    }
+
+    bool ok = true;
+    for (uint32_t s = 0; s < tables.size(); ++s)
+    {
+        Ptr<L2SwitchProtocol> protocol = switches.Get(s)->GetObject<L2SwitchProtocol>();
+        const std::string& name = protocol->GetSwitchName();
+        if (!matched[s])
+        {
+            NS_LOG_WARN(name << ": snapshot does not match the topology");
+            ok = false;
+            continue;
+        }
+        // 装入时老化时钟从快照时间继续，它必须等于交换机当前的老化时钟
+        if (snapshotTime != protocol->GetAgingClock())
+        {
+            NS_LOG_WARN(name << ": snapshot time " << snapshotTime.As(Time::S)
+                        << " differs from the aging clock "
+                        << protocol->GetAgingClock().As(Time::S));
+            ok = false;
+        }
+
+        std::vector<L2SwitchProtocol::MacEntrySnapshot> live = protocol->GetMacEntries();
+        if (live.size() != tables[s].size())
+        {
+            NS_LOG_WARN(name << ": snapshot has " << tables[s].size() << " entries, table has "
+                        << live.size());
+            ok = false;
+            continue;
+        }
+        for (size_t i = 0; i < live.size(); ++i)
+        {
+            const auto& a = live[i];
+            const auto& b = tables[s][i];
+            // RestoreMacEntries() 把空闲时间截到快照时间为止，超出的部分会丢失
+            if (a.vlan != b.vlan || a.address != b.address || a.port != b.port ||
+                a.isStatic != b.isStatic || a.idle != b.idle || b.idle > snapshotTime)
+            {
+                NS_LOG_WARN(name << ": snapshot entry " << b.address << " (VLAN " << b.vlan
+                            << ") would not be restored as saved");
+                ok = false;
+                break;
+            }
+        }
+    }
+    return ok;
+}
+
+#endif /* L2_MAC_SNAPSHOT_H */
@@ -0,0 +1,487 @@
+/*
+ * ============================================================================
+ * 标题: L2 交换机 MAC 地址表 (开放寻址哈希表)
+ * ============================================================================
+ *
+ * 【设计目的】
+ *   原来的 std::map<Mac48Address, Ptr<NetDevice>> 每次查找都是一次红黑树遍历，
+ *   每个节点单独分配内存，查找时几乎每一层都是一次 cache miss；
+ *   表项中保存的 Ptr<NetDevice> 还会带来引用计数的开销。
+ *
+ *   这里改为一个扁平的开放寻址哈希表：
+ *   1. 键: 48 位 MAC 地址打包成的 uint64_t，第 48-59 位是 VLAN ID (每个 VLAN 独立学习)
+ *   2. 值: 16 位端口号 (即设备在节点上的 ifIndex) + 最后一次看到的时间 (老化 tick)
+ *   3. 冲突处理: 线性探测 (Linear Probing)，删除时使用后移删除 (Backward Shift)，
+ *      不需要墓碑标记，表项始终保持紧凑
+ *   4. 哈希函数: Fibonacci 乘法哈希，容量为 2 的幂，用移位代替取模
+ *   5. 容量上限: 可以限制最大表项数 (模拟硬件 CAM 的大小)，表满时 Learn()
+ *      返回 LEARN_FULL，由调用者决定丢弃新地址还是淘汰旧表项
+ *
+ * 【内存布局】
+ *   每个表项 16 字节，一个 64 字节的 cache line 可以容纳 4 个表项，
+ *   线性探测时相邻表项通常已经在同一个 cache line 中。
+ *
+ * 作者: Liu Mengxuan
+ * ns-3 版本: 3.44
+ * ============================================================================
+ */
+
+#ifndef L2_MAC_TABLE_H
+#define L2_MAC_TABLE_H
+
+#include "ns3/network-module.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace ns3
+{
+
+class L2MacTable
+{
+public:
+    static constexpr uint16_t NO_PORT = 0xffff;          // 查找失败时返回的端口号
+    static constexpr uint64_t EMPTY_KEY = ~uint64_t(0);  // 空槽位标记 (不是合法的 48 位 MAC)
+    static constexpr uint8_t FLAG_STATIC = 0x01;         // 静态表项: 不老化，表满时不被淘汰
+
+    /**
+     * @brief Learn() 的结果，调用者据此决定是否打印日志/更新统计
+     */
+    enum LearnResult
+    {
+        LEARN_NEW,        // 新学习到的 MAC 地址
+        LEARN_MOVED,      // MAC 地址迁移到了另一个端口
+        LEARN_REFRESHED,  // 已有表项，端口不变
+        LEARN_FULL        // 新地址，但表已满，没有插入
+    };
+
+    /**
+     * @brief 表项 (16 字节)
+     */
+    struct Entry
+    {
+        uint64_t key;       // 打包后的 MAC 地址，EMPTY_KEY 表示空槽位
+        uint32_t lastSeen;  // 最后一次学习/刷新时的老化 tick
+        uint16_t port;      // 端口号
+        uint8_t flags;      // 表项标志 (FLAG_STATIC)，新插入时为 0
+        uint8_t gen;        // 表项代数，每次新插入时递增，用于识别时间轮中过期的定时项
+    };
+
+    /**
+     * @brief 构造函数
+     * @param initialCapacity 初始槽位数 (会向上取整到 2 的幂)
+     */
+    explicit L2MacTable(uint32_t initialCapacity = 64);
+
+    /**
+     * @brief 把 MAC 地址打包成 64 位整数键
+     * @param mac MAC 地址
+     * @return 低 48 位为 MAC 地址 (网络字节序，高字节在前) 的整数
+     */
+    static uint64_t PackMac(const Mac48Address& mac);
+
+    /**
+     * @brief 把 VLAN 和 MAC 地址打包成一个键 (每个 VLAN 独立学习)
+     * @param vlan VLAN ID (12 位)，放在第 48-59 位
+     * @param mac MAC 地址，放在低 48 位
+     */
+    static uint64_t PackKey(uint16_t vlan, const Mac48Address& mac);
+
+    /**
+     * @brief 把 64 位整数键还原为 MAC 地址 (用于日志和遍历)，忽略 VLAN 部分
+     */
+    static Mac48Address UnpackMac(uint64_t key);
+
+    /**
+     * @brief 取出键中的 VLAN ID
+     */
+    static uint16_t UnpackVlan(uint64_t key);
+
+    /**
+     * @brief 学习 (插入或更新) 一个表项
+     * @param key 打包后的 MAC 地址
+     * @param port 入端口号
+     * @param now 当前老化 tick，写入表项的 lastSeen
+     * @return 学习结果
+     */
+    LearnResult Learn(uint64_t key, uint16_t port, uint32_t now = 0);
+
+    /**
+     * @brief 查找表项
+     * @param key 打包后的 MAC 地址
+     * @return 端口号，未找到返回 NO_PORT
+     */
+    uint16_t Lookup(uint64_t key) const;
+
+    /**
+     * @brief 查找完整的表项
+     * @return 表项指针，未找到返回 nullptr (表被修改后指针失效)
+     */
+    const Entry* Find(uint64_t key) const;
+
+    /**
+     * @brief 设置表项标志
+     * @return 表项存在返回 true
+     */
+    bool SetFlags(uint64_t key, uint8_t flags);
+
+    /**
+     * @brief 删除表项 (后移删除，不留墓碑)
+     * @return 表项存在并被删除返回 true
+     */
+    bool Remove(uint64_t key);
+
+    /**
+     * @brief 清空所有表项 (保留已分配的槽位)
+     */
+    void Clear();
+
+    uint32_t GetSize() const;
+    uint32_t GetCapacity() const;
+
+    /**
+     * @brief 设置最大表项数 (0 表示不限制)
+     */
+    void SetMaxEntries(uint32_t maxEntries);
+    uint32_t GetMaxEntries() const;
+
+    /**
+     * @brief 近似 LRU: 从 hint 的哈希位置开始采样若干个表项，返回 lastSeen 最早的那个
+     * (静态表项不参与采样)
+     *
+     * 精确的 LRU 需要额外维护一个链表，每帧都要移动节点；
+     * 采样的方式 (与 Redis 的近似 LRU 相同) 只在表满时才有开销。
+     *
+     * @param hint 用于确定采样起点的键 (通常是准备插入的新地址)
+     * @param samples 采样的表项数
+     * @return 被选中的键，表为空时返回 EMPTY_KEY
+     */
+    uint64_t SampleOldest(uint64_t hint, uint32_t samples) const;
+
+    /**
+     * @brief 遍历所有表项
+     * @param f 回调，签名为 void (uint64_t key, uint16_t port)
+     */
+    template <typename F>
+    void ForEach(F f) const;
+
+private:
+    uint32_t HomeSlot(uint64_t key) const;
+    void Rehash(uint32_t newCapacity);
+
+    std::vector<Entry> m_slots;  // 槽位数组，容量始终为 2 的幂
+    uint32_t m_mask;             // m_slots.size() - 1
+    uint32_t m_shift;            // 64 - log2(容量)，用于 Fibonacci 哈希
+    uint32_t m_size;             // 已占用的槽位数
+    uint32_t m_maxEntries;       // 最大表项数，0 表示不限制
+    uint8_t m_nextGen;           // 下一个新表项的代数
+};
+
+// ============================================================================
+// 实现 (头文件内联实现，整个交换机程序只有一个编译单元)
+// ============================================================================
+
+inline L2MacTable::L2MacTable(uint32_t initialCapacity)
+    : m_mask(0),
+      m_shift(64),
+      m_size(0),
+      m_maxEntries(0),
+      m_nextGen(0)
+{
+    uint32_t capacity = 8;
+    while (capacity < initialCapacity)
+    {
+        capacity <<= 1;
+    }
+    Rehash(capacity);
+}
+
+inline uint64_t
+L2MacTable::PackMac(const Mac48Address& mac)
+{
+    uint8_t buf[6];
+    mac.CopyTo(buf);
+    return (uint64_t(buf[0]) << 40) | (uint64_t(buf[1]) << 32) | (uint64_t(buf[2]) << 24) |
+           (uint64_t(buf[3]) << 16) | (uint64_t(buf[4]) << 8) | uint64_t(buf[5]);
+}
+
+inline uint64_t
+L2MacTable::PackKey(uint16_t vlan, const Mac48Address& mac)
+{
+    return (uint64_t(vlan & 0x0fff) << 48) | PackMac(mac);
+}
+
+inline uint16_t
+L2MacTable::UnpackVlan(uint64_t key)
+{
+    return static_cast<uint16_t>((key >> 48) & 0x0fff);
+}
+
+inline Mac48Address
+L2MacTable::UnpackMac(uint64_t key)
+{
+    uint8_t buf[6];
+    for (int i = 5; i >= 0; --i)
+    {
+        buf[i] = static_cast<uint8_t>(key & 0xff);
+        key >>= 8;
+    }
+    Mac48Address mac;
+    mac.CopyFrom(buf);
+    return mac;
+}
+
+inline uint32_t
+L2MacTable::HomeSlot(uint64_t key) const
+{
+    // Fibonacci 哈希: 乘以 2^64 / 黄金分割比，取高位
+    // ns-3 分配的 MAC 地址是连续递增的，乘法哈希能把它们均匀打散
+    return static_cast<uint32_t>((key * 0x9E3779B97F4A7C15ULL) >> m_shift);
+}
+
+inline L2MacTable::LearnResult
+L2MacTable::Learn(uint64_t key, uint16_t port, uint32_t now)
+{
+    uint32_t i = HomeSlot(key);
+    while (true)
+    {
+        Entry& e = m_slots[i];
+        if (e.key == key)
+        {
+            e.lastSeen = now;
+            if (e.port == port)
+            {
+                return LEARN_REFRESHED;
+            }
+            e.port = port;
+            return LEARN_MOVED;
+        }
+        if (e.key == EMPTY_KEY)
+        {
+            break;
+        }
+        i = (i + 1) & m_mask;
+    }
+
+    // 新地址
+    if (m_maxEntries != 0 && m_size >= m_maxEntries)
+    {
+        return LEARN_FULL;
+    }
+
+    // 负载因子超过 1/2 时扩容，保证线性探测的平均探测长度很短
+    if ((m_size + 1) * 2 > m_slots.size())
+    {
+        Rehash(static_cast<uint32_t>(m_slots.size()) * 2);
+        i = HomeSlot(key);
+        while (m_slots[i].key != EMPTY_KEY)
+        {
+            i = (i + 1) & m_mask;
+        }
+    }
+
+    Entry& e = m_slots[i];
+    e.key = key;
+    e.lastSeen = now;
+    e.port = port;
+    e.flags = 0;
+    e.gen = m_nextGen++;
+    ++m_size;
+    return LEARN_NEW;
+}
+
+inline uint16_t
+L2MacTable::Lookup(uint64_t key) const
+{
+    uint32_t i = HomeSlot(key);
+    while (true)
+    {
+        const Entry& e = m_slots[i];
+        if (e.key == key)
+        {
+            return e.port;
+        }
+        if (e.key == EMPTY_KEY)
+        {
+            return NO_PORT;
+        }
+        i = (i + 1) & m_mask;
+    }
+}
+
+inline const L2MacTable::Entry*
+L2MacTable::Find(uint64_t key) const
+{
+    uint32_t i = HomeSlot(key);
+    while (true)
+    {
+        const Entry& e = m_slots[i];
+        if (e.key == key)
+        {
+            return &e;
+        }
+        if (e.key == EMPTY_KEY)
+        {
+            return nullptr;
+        }
+        i = (i + 1) & m_mask;
+    }
+}
+
+inline bool
+L2MacTable::SetFlags(uint64_t key, uint8_t flags)
+{
+    Entry* e = const_cast<Entry*>(Find(key));
+    if (e == nullptr)
+    {
+        return false;
+    }
+    e->flags = flags;
+    return true;
+}
+
+inline bool
+L2MacTable::Remove(uint64_t key)
+{
+    uint32_t i = HomeSlot(key);
+    while (m_slots[i].key != key)
+    {
+        if (m_slots[i].key == EMPTY_KEY)
+        {
+            return false;
+        }
+        i = (i + 1) & m_mask;
+    }
+
+    // 后移删除: 把后面 "本应在更前面" 的表项往前挪，填补空洞
+    uint32_t hole = i;
+    uint32_t j = i;
+    while (true)
+    {
+        j = (j + 1) & m_mask;
+        if (m_slots[j].key == EMPTY_KEY)
+        {
+            break;
+        }
+        uint32_t home = HomeSlot(m_slots[j].key);
+        // 判断 home 是否在 (hole, j] 的循环区间之外
+        bool canMove = (hole <= j) ? (home <= hole || home > j) : (home <= hole && home > j);
+        if (canMove)
+        {
+            m_slots[hole] = m_slots[j];
+            hole = j;
+        }
+    }
+    m_slots[hole] = Entry{EMPTY_KEY, 0, NO_PORT, 0, 0};
+    --m_size;
+    return true;
+}
+
+inline void
+L2MacTable::Clear()
+{
+    for (auto& e : m_slots)
+    {
+        e = Entry{EMPTY_KEY, 0, NO_PORT, 0, 0};
+    }
+    m_size = 0;
+}
+
+inline uint32_t
+L2MacTable::GetSize() const
+{
+    return m_size;
+}
+
+inline uint32_t
+L2MacTable::GetCapacity() const
+{
+    return static_cast<uint32_t>(m_slots.size());
+}
+
+inline void
+L2MacTable::SetMaxEntries(uint32_t maxEntries)
+{
+    m_maxEntries = maxEntries;
+}
+
+inline uint32_t
+L2MacTable::GetMaxEntries() const
+{
+    return m_maxEntries;
+}
+
+inline uint64_t
+L2MacTable::SampleOldest(uint64_t hint, uint32_t samples) const
+{
+    if (m_size == 0)
+    {
+        return EMPTY_KEY;
+    }
+
+    uint64_t victim = EMPTY_KEY;
+    uint32_t oldest = 0;
+    uint32_t i = HomeSlot(hint);
+    for (uint32_t seen = 0, scanned = 0; seen < samples && scanned <= m_mask; ++scanned)
+    {
+        const Entry& e = m_slots[i];
+        if (e.key != EMPTY_KEY && !(e.flags & FLAG_STATIC))
+        {
+            if (victim == EMPTY_KEY || e.lastSeen < oldest)
+            {
+                victim = e.key;
+                oldest = e.lastSeen;
+            }
+            ++seen;
+        }
+        i = (i + 1) & m_mask;
+    }
+    return victim;
+}
+
+inline void
+L2MacTable::Rehash(uint32_t newCapacity)
+{
+    std::vector<Entry> old;
+    old.swap(m_slots);
+    m_slots.assign(newCapacity, Entry{EMPTY_KEY, 0, NO_PORT, 0, 0});
+    m_mask = newCapacity - 1;
+    m_shift = 64;
+    for (uint32_t c = newCapacity; c > 1; c >>= 1)
+    {
+        --m_shift;
+    }
+    m_size = 0;
+
+    for (const auto& e : old)
+    {
+        if (e.key == EMPTY_KEY)
+        {
+            continue;
+        }
+        uint32_t i = HomeSlot(e.key);
+        while (m_slots[i].key != EMPTY_KEY)
+        {
+            i = (i + 1) & m_mask;
+        }
+        m_slots[i] = e;
+        ++m_size;
+    }
+}
+
+template <typename F>
+void
+L2MacTable::ForEach(F f) const
+{
+    for (const auto& e : m_slots)
+    {
+        if (e.key != EMPTY_KEY)
+        {
+            f(e.key, e.port);
+        }
+    }
+}
+
+} // namespace ns3
+
+#endif /* L2_MAC_TABLE_H */
@@ -0,0 +1,1288 @@
+/*
+ * ============================================================================
+ * 标题: 链路状态多路径 L2 转发 (Shortest Path Bridging / TRILL 风格)
+ * ============================================================================
+ *
+ * 【设计目的】
+ *   RSTP 为了消除环路，把冗余链路全部阻塞: leaf-spine 拓扑中每台 leaf 只剩一条上联，
+ *   其余 spine 的带宽完全闲置，所有流量还要挤过同一棵树。
+ *
+ *   这里按 TRILL (RFC 6325) 的思路改为三层式的链路状态路由，但转发的仍然是二层帧:
+ *   - 交换机之间用 Hello 发现邻接，每台交换机用一个 LSP (链路状态报文) 描述自己的邻接，
+ *     LSP 泛洪到所有交换机，每台交换机都有完整的拓扑 (LSDB)
+ *   - 每台交换机在 LSDB 上跑 SPF (Dijkstra)，得到到每台交换机的所有等价下一跳 (ECMP)
+ *   - 入口交换机把发往远端主机的帧封装起来，头部写上出口交换机的昵称 (nickname)，
+ *     中间的交换机只按出口昵称和帧头熵值在等价下一跳中选择，不查主机 MAC
+ *   - 广播、组播和未知单播沿分发树 (distribution tree) 发往所有交换机，
+ *     每台交换机做 RPF 检查，保证每台交换机只收到一份、不会形成环路
+ *
+ *   交换机之间的链路 (核心端口) 不转发原生帧，主机只连接在边缘端口上。
+ *
+ * 【数据帧封装】
+ *
+ *   字段              长度   说明
+ *   Flags             1      MULTI_DESTINATION: 沿分发树转发 (Egress 是树根)
+ *   Hop Count         1      每经过一台交换机减 1，为 0 时丢弃
+ *   Egress Nickname   2      出口交换机 (多目的帧为分发树的树根)
+ *   Ingress Nickname  2      入口交换机
+ *   VLAN              2      原始帧所属的 VLAN (原始帧去掉 802.1Q 标签后封装)
+ *   Protocol          2      原始帧的 EtherType
+ *   Entropy           2      入口交换机对原始帧头的哈希，逐跳选择等价路径
+ *                     --
+ *                     12 字节
+ *
+ * 【与标准的差异】
+ *   - 昵称就是节点 ID，不做昵称协商
+ *   - 不加外层以太网头，外层 MAC 沿用原始帧的源/目的地址 (点到点链路上对端总会收到)
+ *   - LSP 没有老化和 CSNP/PSNP 同步: 新邻接建立时把整个 LSDB 发给对端，
+ *     之后靠序号泛洪保持一致
+ *   - 一个端口只有一个邻接 (点到点链路)，不支持多台交换机共享的 CSMA 网段
+ *   - 分发树的树根是昵称最小的 DistributionTrees 台交换机，入口按熵值选择一棵树
+ *
+ * 【注意】
+ *   本文件使用 l2-switch-protocol.cc 的日志组件，
+ *   必须在 NS_LOG_COMPONENT_DEFINE 之后 include。
+ *
+ * 作者: Liu Mengxuan
+ * ns-3 版本: 3.44
+ * ============================================================================
+ */
+
+#ifndef L2_MULTIPATH_H
+#define L2_MULTIPATH_H
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <ostream>
+#include <queue>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace ns3
+{
+
+// ============================================================================
+// 封装帧头
+// ============================================================================
+
+class L2MultipathHeader : public Header
+{
+public:
+    static constexpr uint8_t FLAG_MULTI_DESTINATION = 0x01;
+    static constexpr uint8_t DEFAULT_HOP_COUNT = 63;  // TRILL 的跳数字段是 6 位
+
+    L2MultipathHeader();
+
+    static TypeId GetTypeId();
+    TypeId GetInstanceTypeId() const override;
+    uint32_t GetSerializedSize() const override;
+    void Serialize(Buffer::Iterator start) const override;
+    uint32_t Deserialize(Buffer::Iterator start) override;
+    void Print(std::ostream& os) const override;
+
+    void SetMultiDestination(bool multiDestination);
+    bool IsMultiDestination() const;
+    void SetHopCount(uint8_t hops);
+    uint8_t GetHopCount() const;
+    void SetEgress(uint16_t nickname);
+    uint16_t GetEgress() const;
+    void SetIngress(uint16_t nickname);
+    uint16_t GetIngress() const;
+    void SetVlan(uint16_t vlan);
+    uint16_t GetVlan() const;
+    void SetProtocol(uint16_t protocol);
+    uint16_t GetProtocol() const;
+    void SetEntropy(uint16_t entropy);
+    uint16_t GetEntropy() const;
+
+private:
+    uint8_t m_flags;
+    uint8_t m_hopCount;
+    uint16_t m_egress;
+    uint16_t m_ingress;
+    uint16_t m_vlan;
+    uint16_t m_protocol;
+    uint16_t m_entropy;
+};
+
+// ============================================================================
+// 控制报文 (Hello / LSP)
+// ============================================================================
+//
+//   字段              长度   说明
+//   Type              1      1 = Hello，2 = LSP
+//   Reserved          1
+//   Origin            2      Hello: 发送者昵称；LSP: 描述的交换机
+//   Port              2      Hello: 发送端口号 (对端据此和本端选择同一条并联链路)
+//   Sequence          4      LSP 序号，越大越新
+//   Count             2      邻接数
+//   每个邻接: Neighbor(2) Cost(4)
+//
+// ============================================================================
+
+class L2LinkStateHeader : public Header
+{
+public:
+    static constexpr uint8_t TYPE_HELLO = 1;
+    static constexpr uint8_t TYPE_LSP = 2;
+
+    /// LSP 中的一个邻接: (邻居昵称, 链路开销)
+    typedef std::pair<uint16_t, uint32_t> Link;
+
+    L2LinkStateHeader();
+
+    static TypeId GetTypeId();
+    TypeId GetInstanceTypeId() const override;
+    uint32_t GetSerializedSize() const override;
+    void Serialize(Buffer::Iterator start) const override;
+    uint32_t Deserialize(Buffer::Iterator start) override;
+    void Print(std::ostream& os) const override;
+
+    void SetType(uint8_t type);
+    uint8_t GetType() const;
+    void SetOrigin(uint16_t nickname);
+    uint16_t GetOrigin() const;
+    void SetPort(uint16_t port);
+    uint16_t GetPort() const;
+    void SetSequence(uint32_t seq);
+    uint32_t GetSequence() const;
+    void SetLinks(const std::vector<Link>& links);
+    const std::vector<Link>& GetLinks() const;
+
+private:
+    uint8_t m_type;
+    uint16_t m_origin;
+    uint16_t m_port;
+    uint32_t m_seq;
+    std::vector<Link> m_links;
+};
+
+// ============================================================================
+// 链路状态协议
+// ============================================================================
+//
+// 【使用方式】
+//   与 L2Rstp 相同: L2SwitchProtocol 为每个端口调用一次 AddPort()，设置回调后调用 Start()，
+//   收到发往 GetGroupAddress() 的控制报文时调用 Receive()。
+//   协议通过回调发送控制报文，并在端口第一次收到 Hello (对端是交换机) 时通知交换机。
+//   转发时交换机直接读取 GetNextHops() / GetTreePorts() / GetRpfPort() 的结果，
+//   它们只在 SPF 运行时重新计算。
+//
+// ============================================================================
+
+class L2LinkState : public Object
+{
+public:
+    static constexpr uint16_t CONTROL_PROTOCOL = 0x22F4;  // 控制报文的 EtherType (L2-IS-IS)
+    static constexpr uint16_t DATA_PROTOCOL = 0x22F3;     // 封装数据帧的 EtherType (TRILL)
+    static constexpr uint16_t NO_PORT = 0xffff;
+    static constexpr uint16_t NO_NICKNAME = 0xffff;
+
+    /// 发送控制报文: (端口号, 报文)
+    typedef Callback<void, uint16_t, Ptr<Packet>> SendCallback;
+    /// 端口成为核心端口 (对端是交换机): (端口号)
+    typedef Callback<void, uint16_t> CoreCallback;
+
+    static TypeId GetTypeId();
+
+    L2LinkState();
+    ~L2LinkState() override;
+
+    /**
+     * @brief 控制报文的目的地址 (All-IS-IS-RBridges)
+     */
+    static Mac48Address GetGroupAddress();
+
+    /**
+     * @brief 设置日志中使用的交换机名称和昵称
+     */
+    void SetBridge(const std::string& name, uint16_t nickname);
+
+    void SetCallbacks(SendCallback send, CoreCallback core);
+
+    /**
+     * @brief 添加一个端口，端口号按添加顺序从 0 开始
+     * @param cost 链路开销
+     * @param edge 是否为边缘端口 (启动时不发 Hello；收到 Hello 后仍会变为核心端口)
+     * @return 端口号
+     */
+    uint16_t AddPort(uint32_t cost, bool edge);
+
+    /**
+     * @brief 启动协议: 在非边缘端口上发送 Hello
+     */
+    void Start();
+
+    /**
+     * @brief 处理一个收到的控制报文
+     */
+    void Receive(uint16_t port, Ptr<const Packet> packet);
+
+    // ========== 转发表 (SPF 的结果) ==========
+
+    uint16_t GetNickname() const;
+
+    /**
+     * @brief 端口是否连接其他交换机 (收到过 Hello)
+     */
+    bool IsCorePort(uint16_t port) const;
+
+    /**
+     * @brief 到出口交换机的所有等价下一跳端口，不可达时为空
+     */
+    const std::vector<uint16_t>& GetNextHops(uint16_t egress) const;
+
+    /**
+     * @brief 入口交换机按熵值选择的分发树，返回树根昵称 (还没有任何树时返回 NO_NICKNAME)
+     */
+    uint16_t SelectTree(uint16_t entropy) const;
+
+    /**
+     * @brief 本交换机在分发树上的所有树边端口 (父端口和子端口)
+     */
+    const std::vector<uint16_t>& GetTreePorts(uint16_t root) const;
+
+    /**
+     * @brief 分发树上来自 ingress 的帧应该从哪个端口进入 (RPF 检查)
+     * @return NO_PORT 表示 ingress 不在这棵树上，帧应丢弃
+     */
+    uint16_t GetRpfPort(uint16_t root, uint16_t ingress) const;
+
+    /**
+     * @brief 可达的交换机数 (含自己)
+     */
+    uint32_t GetNReachable() const;
+
+    /**
+     * @brief SPF 运行次数
+     */
+    uint32_t GetSpfRuns() const;
+
+    /**
+     * @brief 最近一次邻接变化或 SPF 结果变化的时间，用于计算收敛时间
+     */
+    Time GetLastChange() const;
+
+    /**
+     * @brief 打印昵称、LSDB、分发树和每个端口的邻接
+     */
+    void Report(std::ostream& os) const;
+
+protected:
+    void DoDispose() override;
+
+private:
+    struct Port
+    {
+        uint32_t cost;          // 链路开销
+        bool edge;              // 启动时认为对端是主机，不发 Hello
+        bool core;              // 收到过 Hello，对端是交换机
+        bool up;                // 邻接有效
+        uint16_t neighbor;      // 对端昵称
+        uint16_t neighborPort;  // 对端的端口号
+        Time expires;           // 邻接超时时间 (HoldTime 内收不到 Hello)
+    };
+
+    struct Lsp
+    {
+        uint32_t seq;
+        std::vector<L2LinkStateHeader::Link> links;
+    };
+
+    /**
+     * @brief 一棵分发树在本交换机上的部分
+     */
+    struct Tree
+    {
+        uint16_t root;
+        std::vector<uint16_t> ports;                // 树边端口
+        std::unordered_map<uint16_t, uint16_t> rpf;  // 入口昵称 -> 应该进入的端口
+    };
+
+    /// 双向确认后的拓扑: 昵称 -> (邻居, 开销)
+    typedef std::unordered_map<uint16_t, std::vector<L2LinkStateHeader::Link>> Graph;
+
+    void HelloTick();
+    void SendHello(uint16_t port);
+    void SendLsp(uint16_t port, uint16_t origin);
+    void ScheduleOriginate();
+    void Originate();
+    void ScheduleSpf();
+    void RunSpf();
+    Graph BuildGraph() const;
+    Tree BuildTree(const Graph& graph, uint16_t root) const;
+    static std::unordered_map<uint16_t, uint64_t> Distances(const Graph& graph, uint16_t source);
+
+    /**
+     * @brief 到邻居的所有开销等于 cost 的端口 (并联链路)
+     */
+    std::vector<uint16_t> PortsTo(uint16_t neighbor, uint32_t cost) const;
+
+    /**
+     * @brief 分发树在两台相邻交换机之间使用的那条链路 (两端选出同一条)
+     */
+    uint16_t TreeLink(uint16_t neighbor) const;
+
+    // 属性
+    Time m_helloInterval;
+    Time m_holdTime;
+    Time m_lspDelay;
+    Time m_spfDelay;
+    uint32_t m_nTrees;
+
+    std::string m_name;
+    uint16_t m_nickname;
+    std::vector<Port> m_ports;
+    std::map<uint16_t, Lsp> m_lsdb;                                // 昵称 -> 最新的 LSP
+    uint32_t m_seq;                                                // 自己的 LSP 序号
+    std::unordered_map<uint16_t, std::vector<uint16_t>> m_nextHops;  // 出口昵称 -> 等价下一跳
+    std::vector<Tree> m_trees;                                     // 按树根昵称排序
+    uint32_t m_spfRuns;
+    Time m_lastChange;
+    EventId m_helloEvent;
+    EventId m_originateEvent;
+    EventId m_spfEvent;
+
+    SendCallback m_send;
+    CoreCallback m_core;
+};
+
+// ============================================================================
+// L2MultipathHeader 实现
+// ============================================================================
+
+NS_OBJECT_ENSURE_REGISTERED(L2MultipathHeader);
+
+inline L2MultipathHeader::L2MultipathHeader()
+    : m_flags(0),
+      m_hopCount(DEFAULT_HOP_COUNT),
+      m_egress(0),
+      m_ingress(0),
+      m_vlan(0),
+      m_protocol(0),
+      m_entropy(0)
+{
+}
+
+inline TypeId
+L2MultipathHeader::GetTypeId()
+{
+    static TypeId tid = TypeId("ns3::L2MultipathHeader")
+        .SetParent<Header>()
+        .SetGroupName("Network")
+        .AddConstructor<L2MultipathHeader>();
+    return tid;
+}
+
+inline TypeId
+L2MultipathHeader::GetInstanceTypeId() const
+{
+    return GetTypeId();
+}
+
+inline uint32_t
+L2MultipathHeader::GetSerializedSize() const
+{
+    return 12;
+}
+
+inline void
+L2MultipathHeader::Serialize(Buffer::Iterator start) const
+{
+    Buffer::Iterator i = start;
+    i.WriteU8(m_flags);
+    i.WriteU8(m_hopCount);
+    i.WriteHtonU16(m_egress);
+    i.WriteHtonU16(m_ingress);
+    i.WriteHtonU16(m_vlan);
+    i.WriteHtonU16(m_protocol);
+    i.WriteHtonU16(m_entropy);
+}
+
+inline uint32_t
+L2MultipathHeader::Deserialize(Buffer::Iterator start)
+{
+    Buffer::Iterator i = start;
+    m_flags = i.ReadU8();
+    m_hopCount = i.ReadU8();
+    m_egress = i.ReadNtohU16();
+    m_ingress = i.ReadNtohU16();
+    m_vlan = i.ReadNtohU16();
+    m_protocol = i.ReadNtohU16();
+    m_entropy = i.ReadNtohU16();
+    return GetSerializedSize();
+}
+
+inline void
+L2MultipathHeader::Print(std::ostream& os) const
+{
+    os << (IsMultiDestination() ? "multi-destination root=" : "egress=") << m_egress
+       << " ingress=" << m_ingress << " hops=" << unsigned(m_hopCount) << " vlan=" << m_vlan
+       << " protocol=0x" << std::hex << m_protocol << " entropy=0x" << m_entropy << std::dec;
+}
+
+inline void
+L2MultipathHeader::SetMultiDestination(bool multiDestination)
+{
+    m_flags = multiDestination ? (m_flags | FLAG_MULTI_DESTINATION)
+                               : (m_flags & ~FLAG_MULTI_DESTINATION);
+}
+
+inline bool
+L2MultipathHeader::IsMultiDestination() const
+{
+    return (m_flags & FLAG_MULTI_DESTINATION) != 0;
+}
+
+inline void
+L2MultipathHeader::SetHopCount(uint8_t hops)
+{
+    m_hopCount = hops;
+}
+
+inline uint8_t
+L2MultipathHeader::GetHopCount() const
+{
+    return m_hopCount;
+}
+
+inline void
+L2MultipathHeader::SetEgress(uint16_t nickname)
+{
+    m_egress = nickname;
+}
+
+inline uint16_t
+L2MultipathHeader::GetEgress() const
+{
+    return m_egress;
+}
+
+inline void
+L2MultipathHeader::SetIngress(uint16_t nickname)
+{
+    m_ingress = nickname;
+}
+
+inline uint16_t
+L2MultipathHeader::GetIngress() const
+{
+    return m_ingress;
+}
+
+inline void
+L2MultipathHeader::SetVlan(uint16_t vlan)
+{
+    m_vlan = vlan;
+}
+
+inline uint16_t
+L2MultipathHeader::GetVlan() const
+{
+    return m_vlan;
+}
+
+inline void
+L2MultipathHeader::SetProtocol(uint16_t protocol)
+{
+    m_protocol = protocol;
+}
+
+inline uint16_t
+L2MultipathHeader::GetProtocol() const
+{
+    return m_protocol;
+}
+
+inline void
+L2MultipathHeader::SetEntropy(uint16_t entropy)
+{
+    m_entropy = entropy;
+}
+
+inline uint16_t
+L2MultipathHeader::GetEntropy() const
+{
+    return m_entropy;
+}
+
+// ============================================================================
+// L2LinkStateHeader 实现
+// ============================================================================
+
+NS_OBJECT_ENSURE_REGISTERED(L2LinkStateHeader);
+
+inline L2LinkStateHeader::L2LinkStateHeader()
+    : m_type(TYPE_HELLO),
+      m_origin(0),
+      m_port(0),
+      m_seq(0)
+{
+}
+
+inline TypeId
+L2LinkStateHeader::GetTypeId()
+{
+    static TypeId tid = TypeId("ns3::L2LinkStateHeader")
+        .SetParent<Header>()
+        .SetGroupName("Network")
+        .AddConstructor<L2LinkStateHeader>();
+    return tid;
+}
+
+inline TypeId
+L2LinkStateHeader::GetInstanceTypeId() const
+{
+    return GetTypeId();
+}
+
+inline uint32_t
+L2LinkStateHeader::GetSerializedSize() const
+{
+    return 12 + 6 * static_cast<uint32_t>(m_links.size());
+}
+
+inline void
+L2LinkStateHeader::Serialize(Buffer::Iterator start) const
+{
+    Buffer::Iterator i = start;
+    i.WriteU8(m_type);
+    i.WriteU8(0);
+    i.WriteHtonU16(m_origin);
+    i.WriteHtonU16(m_port);
+    i.WriteHtonU32(m_seq);
+    i.WriteHtonU16(static_cast<uint16_t>(m_links.size()));
+    for (const Link& link : m_links)
+    {
+        i.WriteHtonU16(link.first);
+        i.WriteHtonU32(link.second);
+    }
+}
+
+inline uint32_t
+L2LinkStateHeader::Deserialize(Buffer::Iterator start)
+{
+    Buffer::Iterator i = start;
+    m_type = i.ReadU8();
+    i.ReadU8();
+    m_origin = i.ReadNtohU16();
+    m_port = i.ReadNtohU16();
+    m_seq = i.ReadNtohU32();
+    uint16_t count = i.ReadNtohU16();
+    m_links.resize(count);
+    for (Link& link : m_links)
+    {
+        link.first = i.ReadNtohU16();
+        link.second = i.ReadNtohU32();
+    }
+    return GetSerializedSize();
+}
+
+inline void
+L2LinkStateHeader::Print(std::ostream& os) const
+{
+    os << (m_type == TYPE_LSP ? "LSP" : "Hello") << " origin=" << m_origin;
+    if (m_type == TYPE_LSP)
+    {
+        os << " seq=" << m_seq << " links=" << m_links.size();
+    }
+    else
+    {
+        os << " port=" << m_port;
+    }
+}
+
+inline void
+L2LinkStateHeader::SetType(uint8_t type)
+{
+    m_type = type;
+}
+
+inline uint8_t
+L2LinkStateHeader::GetType() const
+{
+    return m_type;
+}
+
+inline void
+L2LinkStateHeader::SetOrigin(uint16_t nickname)
+{
+    m_origin = nickname;
+}
+
+inline uint16_t
+L2LinkStateHeader::GetOrigin() const
+{
+    return m_origin;
+}
+
+inline void
+L2LinkStateHeader::SetPort(uint16_t port)
+{
+    m_port = port;
+}
+
+inline uint16_t
+L2LinkStateHeader::GetPort() const
+{
+    return m_port;
+}
+
+inline void
+L2LinkStateHeader::SetSequence(uint32_t seq)
+{
+    m_seq = seq;
+}
+
+inline uint32_t
+L2LinkStateHeader::GetSequence() const
+{
+    return m_seq;
+}
+
+inline void
+L2LinkStateHeader::SetLinks(const std::vector<Link>& links)
+{
+    m_links = links;
+}
+
+inline const std::vector<L2LinkStateHeader::Link>&
+L2LinkStateHeader::GetLinks() const
+{
+    return m_links;
+}
+
+// ============================================================================
+// L2LinkState 实现
+// ============================================================================
+
+NS_OBJECT_ENSURE_REGISTERED(L2LinkState);
+
+inline TypeId
+L2LinkState::GetTypeId()
+{
+    static TypeId tid = TypeId("ns3::L2LinkState")
+        .SetParent<Object>()
+        .SetGroupName("Network")
+        .AddConstructor<L2LinkState>()
+        .AddAttribute("HelloInterval",
+                      "Interval between Hellos on every port that may lead to a switch",
+                      TimeValue(Seconds(1)),
+                      MakeTimeAccessor(&L2LinkState::m_helloInterval),
+                      MakeTimeChecker(MilliSeconds(1)))
+        .AddAttribute("HoldTime",
+                      "An adjacency is torn down when no Hello arrives for this long",
+                      TimeValue(Seconds(3)),
+                      MakeTimeAccessor(&L2LinkState::m_holdTime),
+                      MakeTimeChecker(MilliSeconds(1)))
+        .AddAttribute("LspGenerationDelay",
+                      "Adjacency changes within this time are combined into one LSP",
+                      TimeValue(MilliSeconds(10)),
+                      MakeTimeAccessor(&L2LinkState::m_lspDelay),
+                      MakeTimeChecker(Seconds(0)))
+        .AddAttribute("SpfDelay",
+                      "LSDB changes within this time are combined into one SPF run",
+                      TimeValue(MilliSeconds(10)),
+                      MakeTimeAccessor(&L2LinkState::m_spfDelay),
+                      MakeTimeChecker(Seconds(0)))
+        .AddAttribute("DistributionTrees",
+                      "Number of distribution trees for multi-destination frames, rooted at the "
+                      "switches with the lowest nicknames",
+                      UintegerValue(2),
+                      MakeUintegerAccessor(&L2LinkState::m_nTrees),
+                      MakeUintegerChecker<uint32_t>(1, 16));
+    return tid;
+}
+
+inline L2LinkState::L2LinkState()
+    : m_nTrees(2),
+      m_name("Switch"),
+      m_nickname(0),
+      m_seq(0),
+      m_spfRuns(0)
+{
+}
+
+inline L2LinkState::~L2LinkState()
+{
+}
+
+inline void
+L2LinkState::DoDispose()
+{
+    m_helloEvent.Cancel();
+    m_originateEvent.Cancel();
+    m_spfEvent.Cancel();
+    m_ports.clear();
+    m_lsdb.clear();
+    m_nextHops.clear();
+    m_trees.clear();
+    m_send = SendCallback();
+    m_core = CoreCallback();
+    Object::DoDispose();
+}
+
+inline Mac48Address
+L2LinkState::GetGroupAddress()
+{
+    return Mac48Address("01:80:c2:00:00:41");
+}
+
+inline void
+L2LinkState::SetBridge(const std::string& name, uint16_t nickname)
+{
+    NS_ASSERT_MSG(nickname != NO_NICKNAME, "Invalid nickname " << nickname);
+    m_name = name;
+    m_nickname = nickname;
+}
+
+inline void
+L2LinkState::SetCallbacks(SendCallback send, CoreCallback core)
+{
+    m_send = send;
+    m_core = core;
+}
+
+inline uint16_t
+L2LinkState::AddPort(uint32_t cost, bool edge)
+{
+    uint16_t port = static_cast<uint16_t>(m_ports.size());
+    m_ports.push_back(Port{cost, edge, false, false, NO_NICKNAME, NO_PORT, Seconds(0)});
+    return port;
+}
+
+inline void
+L2LinkState::Start()
+{
+    NS_LOG_INFO(m_name << ": Link-state multipath starting, nickname " << m_nickname);
+
+    // 只有自己的 LSDB 和一棵以自己为根的树，之后随邻接建立逐步扩大
+    Originate();
+    HelloTick();
+}
+
+inline void
+L2LinkState::Receive(uint16_t port, Ptr<const Packet> packet)
+{
+    L2LinkStateHeader header;
+    if (port >= m_ports.size() || packet->GetSize() < 12)
+    {
+        return;
+    }
+    packet->PeekHeader(header);
+    Port& p = m_ports[port];
+
+    if (header.GetType() == L2LinkStateHeader::TYPE_HELLO)
+    {
+        if (header.GetOrigin() == m_nickname)
+        {
+            return;  // 自己发出的 Hello 绕回来 (端口之间直接相连)
+        }
+        if (!p.core)
+        {
+            NS_LOG_INFO(m_name << ": Hello from " << header.GetOrigin() << " on port " << port
+                       << ", port is a core port");
+            p.core = true;
+            p.edge = false;
+            if (!m_core.IsNull())
+            {
+                m_core(port);
+            }
+        }
+        bool changed = !p.up || p.neighbor != header.GetOrigin() ||
+                       p.neighborPort != header.GetPort();
+        p.expires = Simulator::Now() + m_holdTime;
+        if (changed)
+        {
+            NS_LOG_INFO(m_name << ": Adjacency up on port " << port << " with "
+                       << header.GetOrigin());
+            p.up = true;
+            p.neighbor = header.GetOrigin();
+            p.neighborPort = header.GetPort();
+            m_lastChange = Simulator::Now();
+
+            // 新邻居: 先回一个 Hello 让对端立即建立邻接，再同步整个 LSDB
+            SendHello(port);
+            for (const auto& [origin, lsp] : m_lsdb)
+            {
+                SendLsp(port, origin);
+            }
+            ScheduleOriginate();
+        }
+        return;
+    }
+
+    if (header.GetType() != L2LinkStateHeader::TYPE_LSP || !p.core)
+    {
+        return;
+    }
+    uint16_t origin = header.GetOrigin();
+    uint32_t seq = header.GetSequence();
+    if (origin == m_nickname)
+    {
+        // 重启前自己发出的 LSP 还在网络中，用更大的序号重新生成
+        if (seq >= m_seq)
+        {
+            m_seq = seq;
+            ScheduleOriginate();
+        }
+        return;
+    }
+    auto it = m_lsdb.find(origin);
+    if (it != m_lsdb.end() && it->second.seq >= seq)
+    {
+        return;  // 已经有相同或更新的 LSP
+    }
+    m_lsdb[origin] = Lsp{seq, header.GetLinks()};
+    for (uint16_t i = 0; i < m_ports.size(); ++i)
+    {
+        if (i != port && m_ports[i].up)
+        {
+            SendLsp(i, origin);
+        }
+    }
+    ScheduleSpf();
+}
+
+inline void
+L2LinkState::HelloTick()
+{
+    // 检查邻接是否超时，并在所有可能连接交换机的端口上发送 Hello
+    Time now = Simulator::Now();
+    for (uint16_t i = 0; i < m_ports.size(); ++i)
+    {
+        Port& p = m_ports[i];
+        if (p.up && p.expires <= now)
+        {
+            NS_LOG_INFO(m_name << ": Adjacency with " << p.neighbor << " on port " << i
+                       << " timed out");
+            p.up = false;
+            p.neighbor = NO_NICKNAME;
+            p.neighborPort = NO_PORT;
+            m_lastChange = now;
+            ScheduleOriginate();
+        }
+        if (!p.edge)
+        {
+            SendHello(i);
+        }
+    }
+    m_helloEvent = Simulator::Schedule(m_helloInterval, &L2LinkState::HelloTick, this);
+}
+
+inline void
+L2LinkState::SendHello(uint16_t port)
+{
+    L2LinkStateHeader hello;
+    hello.SetType(L2LinkStateHeader::TYPE_HELLO);
+    hello.SetOrigin(m_nickname);
+    hello.SetPort(port);
+    Ptr<Packet> packet = Create<Packet>();
+    packet->AddHeader(hello);
+    m_send(port, packet);
+}
+
+inline void
+L2LinkState::SendLsp(uint16_t port, uint16_t origin)
+{
+    const Lsp& lsp = m_lsdb.find(origin)->second;
+    L2LinkStateHeader header;
+    header.SetType(L2LinkStateHeader::TYPE_LSP);
+    header.SetOrigin(origin);
+    header.SetSequence(lsp.seq);
+    header.SetLinks(lsp.links);
+    Ptr<Packet> packet = Create<Packet>();
+    packet->AddHeader(header);
+    m_send(port, packet);
+}
+
+inline void
+L2LinkState::ScheduleOriginate()
+{
+    if (!m_originateEvent.IsPending())
+    {
+        m_originateEvent = Simulator::Schedule(m_lspDelay, &L2LinkState::Originate, this);
+    }
+}
+
+inline void
+L2LinkState::Originate()
+{
+    // 并联链路在 LSP 中只出现一次，取最小开销
+    std::map<uint16_t, uint32_t> neighbors;
+    for (const Port& p : m_ports)
+    {
+        if (p.up)
+        {
+            auto [it, inserted] = neighbors.emplace(p.neighbor, p.cost);
+            if (!inserted)
+            {
+                it->second = std::min(it->second, p.cost);
+            }
+        }
+    }
+    Lsp& lsp = m_lsdb[m_nickname];
+    lsp.seq = ++m_seq;
+    lsp.links.assign(neighbors.begin(), neighbors.end());
+    NS_LOG_INFO(m_name << ": Originating LSP " << m_seq << " with " << lsp.links.size()
+               << " neighbors");
+
+    for (uint16_t i = 0; i < m_ports.size(); ++i)
+    {
+        if (m_ports[i].up)
+        {
+            SendLsp(i, m_nickname);
+        }
+    }
+    ScheduleSpf();
+}
+
+inline void
+L2LinkState::ScheduleSpf()
+{
+    if (!m_spfEvent.IsPending())
+    {
+        m_spfEvent = Simulator::Schedule(m_spfDelay, &L2LinkState::RunSpf, this);
+    }
+}
+
+inline L2LinkState::Graph
+L2LinkState::BuildGraph() const
+{
+    // 只使用两端的 LSP 都列出对方的链路 (双向确认)，单向的邻接可能是还没建立完或已经断开
+    std::set<std::pair<uint16_t, uint16_t>> listed;
+    for (const auto& [origin, lsp] : m_lsdb)
+    {
+        for (const auto& link : lsp.links)
+        {
+            listed.emplace(origin, link.first);
+        }
+    }
+    Graph graph;
+    for (const auto& [origin, lsp] : m_lsdb)
+    {
+        std::vector<L2LinkStateHeader::Link>& links = graph[origin];
+        for (const auto& link : lsp.links)
+        {
+            if (listed.count({link.first, origin}))
+            {
+                links.push_back(link);
+            }
+        }
+    }
+    return graph;
+}
+
+inline std::unordered_map<uint16_t, uint64_t>
+L2LinkState::Distances(const Graph& graph, uint16_t source)
+{
+    typedef std::pair<uint64_t, uint16_t> Item;
+    std::unordered_map<uint16_t, uint64_t> dist;
+    std::priority_queue<Item, std::vector<Item>, std::greater<Item>> queue;
+    dist[source] = 0;
+    queue.emplace(0, source);
+    while (!queue.empty())
+    {
+        auto [d, u] = queue.top();
+        queue.pop();
+        auto it = graph.find(u);
+        if (d > dist[u] || it == graph.end())
+        {
+            continue;
+        }
+        for (const auto& [v, cost] : it->second)
+        {
+            uint64_t nd = d + cost;
+            auto dv = dist.find(v);
+            if (dv == dist.end() || nd < dv->second)
+            {
+                dist[v] = nd;
+                queue.emplace(nd, v);
+            }
+        }
+    }
+    return dist;
+}
+
+inline std::vector<uint16_t>
+L2LinkState::PortsTo(uint16_t neighbor, uint32_t cost) const
+{
+    std::vector<uint16_t> ports;
+    for (uint16_t i = 0; i < m_ports.size(); ++i)
+    {
+        if (m_ports[i].up && m_ports[i].neighbor == neighbor && m_ports[i].cost == cost)
+        {
+            ports.push_back(i);
+        }
+    }
+    return ports;
+}
+
+inline uint16_t
+L2LinkState::TreeLink(uint16_t neighbor) const
+{
+    // 并联链路中，昵称小的一端选自己端口号最小的，另一端选对端端口号最小的，两端得到同一条
+    uint16_t best = NO_PORT;
+    for (uint16_t i = 0; i < m_ports.size(); ++i)
+    {
+        const Port& p = m_ports[i];
+        if (!p.up || p.neighbor != neighbor)
+        {
+            continue;
+        }
+        if (best == NO_PORT ||
+            (m_nickname < neighbor ? i < best : p.neighborPort < m_ports[best].neighborPort))
+        {
+            best = i;
+        }
+    }
+    return best;
+}
+
+inline L2LinkState::Tree
+L2LinkState::BuildTree(const Graph& graph, uint16_t root) const
+{
+    // 以 root 为源的最短路径树，等价的父节点取昵称最小的，所有交换机算出同一棵树
+    std::unordered_map<uint16_t, uint64_t> dist = Distances(graph, root);
+    std::unordered_map<uint16_t, std::vector<uint16_t>> adjacent;  // 树的无向邻接表
+    for (const auto& [node, d] : dist)
+    {
+        if (node == root)
+        {
+            continue;
+        }
+        uint16_t parent = NO_NICKNAME;
+        for (const auto& [neighbor, cost] : graph.at(node))
+        {
+            auto dn = dist.find(neighbor);
+            if (dn != dist.end() && dn->second + cost == d && neighbor < parent)
+            {
+                parent = neighbor;
+            }
+        }
+        adjacent[node].push_back(parent);
+        adjacent[parent].push_back(node);
+    }
+
+    // 从自己出发，每条树边另一侧的所有交换机发来的帧都应该从这条树边进入
+    Tree tree;
+    tree.root = root;
+    for (uint16_t neighbor : adjacent[m_nickname])
+    {
+        uint16_t port = TreeLink(neighbor);
+        if (port == NO_PORT)
+        {
+            continue;
+        }
+        tree.ports.push_back(port);
+        std::vector<uint16_t> stack = {neighbor};
+        std::set<uint16_t> seen = {m_nickname, neighbor};
+        while (!stack.empty())
+        {
+            uint16_t node = stack.back();
+            stack.pop_back();
+            tree.rpf[node] = port;
+            for (uint16_t next : adjacent[node])
+            {
+                if (seen.insert(next).second)
+                {
+                    stack.push_back(next);
+                }
+            }
+        }
+    }
+    std::sort(tree.ports.begin(), tree.ports.end());
+    return tree;
+}
+
+inline void
+L2LinkState::RunSpf()
+{
+    ++m_spfRuns;
+    Graph graph = BuildGraph();
+
+    // 单播: Dijkstra 时为每台交换机记录所有等价路径的第一跳端口
+    typedef std::pair<uint64_t, uint16_t> Item;
+    std::unordered_map<uint16_t, uint64_t> dist;
+    std::unordered_map<uint16_t, std::vector<uint16_t>> firstHops;
+    std::priority_queue<Item, std::vector<Item>, std::greater<Item>> queue;
+    dist[m_nickname] = 0;
+    queue.emplace(0, m_nickname);
+    while (!queue.empty())
+    {
+        auto [d, u] = queue.top();
+        queue.pop();
+        auto it = graph.find(u);
+        if (d > dist[u] || it == graph.end())
+        {
+            continue;
+        }
+        for (const auto& [v, cost] : it->second)
+        {
+            uint64_t nd = d + cost;
+            std::vector<uint16_t> hops = (u == m_nickname) ? PortsTo(v, cost) : firstHops[u];
+            auto dv = dist.find(v);
+            if (dv == dist.end() || nd < dv->second)
+            {
+                dist[v] = nd;
+                firstHops[v] = hops;
+                queue.emplace(nd, v);
+            }
+            else if (nd == dv->second)
+            {
+                std::vector<uint16_t>& merged = firstHops[v];
+                merged.insert(merged.end(), hops.begin(), hops.end());
+                std::sort(merged.begin(), merged.end());
+                merged.erase(std::unique(merged.begin(), merged.end()), merged.end());
+            }
+        }
+    }
+    firstHops.erase(m_nickname);
+
+    // 分发树: 树根是可达交换机中昵称最小的几台
+    std::vector<uint16_t> reachable;
+    for (const auto& [node, d] : dist)
+    {
+        reachable.push_back(node);
+    }
+    std::sort(reachable.begin(), reachable.end());
+    reachable.resize(std::min<std::size_t>(reachable.size(), m_nTrees));
+    std::vector<Tree> trees;
+    for (uint16_t root : reachable)
+    {
+        trees.push_back(BuildTree(graph, root));
+    }
+
+    bool changed = firstHops != m_nextHops || trees.size() != m_trees.size();
+    for (std::size_t i = 0; !changed && i < trees.size(); ++i)
+    {
+        changed = trees[i].root != m_trees[i].root || trees[i].ports != m_trees[i].ports ||
+                  trees[i].rpf != m_trees[i].rpf;
+    }
+    m_nextHops = std::move(firstHops);
+    m_trees = std::move(trees);
+    if (changed)
+    {
+        m_lastChange = Simulator::Now();
+        NS_LOG_INFO(m_name << ": SPF run " << m_spfRuns << ", " << dist.size()
+                   << " switches reachable, " << m_trees.size() << " distribution trees");
+    }
+}
+
+inline uint16_t
+L2LinkState::GetNickname() const
+{
+    return m_nickname;
+}
+
+inline bool
+L2LinkState::IsCorePort(uint16_t port) const
+{
+    return port < m_ports.size() && m_ports[port].core;
+}
+
+inline const std::vector<uint16_t>&
+L2LinkState::GetNextHops(uint16_t egress) const
+{
+    static const std::vector<uint16_t> none;
+    auto it = m_nextHops.find(egress);
+    return it == m_nextHops.end() ? none : it->second;
+}
+
+inline uint16_t
+L2LinkState::SelectTree(uint16_t entropy) const
+{
+    return m_trees.empty() ? NO_NICKNAME : m_trees[entropy % m_trees.size()].root;
+}
+
+inline const std::vector<uint16_t>&
+L2LinkState::GetTreePorts(uint16_t root) const
+{
+    static const std::vector<uint16_t> none;
+    for (const Tree& tree : m_trees)
+    {
+        if (tree.root == root)
+        {
+            return tree.ports;
+        }
+    }
+    return none;
+}
+
+inline uint16_t
+L2LinkState::GetRpfPort(uint16_t root, uint16_t ingress) const
+{
+    for (const Tree& tree : m_trees)
+    {
+        if (tree.root == root)
+        {
+            auto it = tree.rpf.find(ingress);
+            return it == tree.rpf.end() ? NO_PORT : it->second;
+        }
+    }
+    return NO_PORT;
+}
+
+inline uint32_t
+L2LinkState::GetNReachable() const
+{
+    return static_cast<uint32_t>(m_nextHops.size()) + 1;
+}
+
+inline uint32_t
+L2LinkState::GetSpfRuns() const
+{
+    return m_spfRuns;
+}
+
+inline Time
+L2LinkState::GetLastChange() const
+{
+    return m_lastChange;
+}
+
+inline void
+L2LinkState::Report(std::ostream& os) const
+{
+    os << m_name << ": nickname " << m_nickname << ", " << GetNReachable()
+       << " switches reachable, LSDB " << m_lsdb.size() << " LSPs, SPF runs " << m_spfRuns
+       << ", last change at " << m_lastChange.As(Time::MS) << std::endl;
+    for (const Tree& tree : m_trees)
+    {
+        os << "  tree " << tree.root << ": ports";
+        for (uint16_t port : tree.ports)
+        {
+            os << " " << port;
+        }
+        os << std::endl;
+    }
+    for (uint16_t i = 0; i < m_ports.size(); ++i)
+    {
+        const Port& p = m_ports[i];
+        if (!p.core)
+        {
+            continue;
+        }
+        os << "  port " << i << ": ";
+        if (p.up)
+        {
+            os << "neighbor " << p.neighbor << " port " << p.neighborPort;
+        }
+        else
+        {
+            os << "down";
+        }
+        os << ", cost " << p.cost << std::endl;
+    }
+}
+
+} // namespace ns3
+
+#endif /* L2_MULTIPATH_H */
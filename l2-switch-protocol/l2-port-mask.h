@@ -0,0 +1,273 @@
+/*
+ * ============================================================================
+ * 标题: 端口位图 (Port Bitmask)
+ * ============================================================================
+ *
+ * 【设计目的】
+ *   交换机泛洪时需要知道 "从某个入端口进来的帧应该发往哪些出端口"。
+ *   这个集合只在端口状态 (阻塞/转发、VLAN 成员) 变化时才会改变，
+ *   可以为每个入端口预先算好，用位图保存:
+ *   - 第 i 位为 1 表示端口 i 在集合中
+ *   - 泛洪时只遍历为 1 的位 (每次用 ctz 找到最低位)，不访问其他端口
+ *   - 集合运算 (与/与非) 按 64 位字批量完成
+ *
+ *   端口数不固定，所以位数在运行时确定 (std::vector<uint64_t>)。
+ *
+ * 作者: Liu Mengxuan
+ * ns-3 版本: 3.44
+ * ============================================================================
+ */
+
+#ifndef L2_PORT_MASK_H
+#define L2_PORT_MASK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ns3
+{
+
+class L2PortMask
+{
+public:
+    static constexpr uint32_t NONE = ~uint32_t(0);  // FindLast() 在空集合上的返回值
+
+    L2PortMask();
+
+    /**
+     * @brief 创建一个可以容纳 nPorts 个端口的空集合
+     */
+    explicit L2PortMask(uint32_t nPorts);
+
+    /**
+     * @brief 调整容量，新增的位为 0
+     */
+    void Resize(uint32_t nPorts);
+
+    uint32_t GetNPorts() const;
+
+    void Set(uint32_t port);
+    void Reset(uint32_t port);
+    bool Test(uint32_t port) const;
+
+    /**
+     * @brief 把 [0, nPorts) 全部置 1
+     */
+    void SetAll();
+    void Clear();
+
+    /**
+     * @brief this &= other
+     */
+    L2PortMask& operator&=(const L2PortMask& other);
+
+    /**
+     * @brief this |= other (超出本集合容量的位被忽略)
+     */
+    L2PortMask& operator|=(const L2PortMask& other);
+
+    /**
+     * @brief this &= ~other
+     */
+    L2PortMask& AndNot(const L2PortMask& other);
+
+    bool operator==(const L2PortMask& other) const;
+
+    bool IsEmpty() const;
+    uint32_t Count() const;
+
+    /**
+     * @brief 编号最大的端口，空集合返回 NONE
+     */
+    uint32_t FindLast() const;
+
+    /**
+     * @brief 按端口号从小到大，对每个为 1 的端口调用 f(uint32_t port)
+     */
+    template <typename F>
+    void ForEach(F f) const;
+
+private:
+    static uint32_t WordsFor(uint32_t nPorts);
+
+    std::vector<uint64_t> m_words;
+    uint32_t m_nPorts;
+};
+
+// ============================================================================
+// 实现
+// ============================================================================
+
+inline L2PortMask::L2PortMask()
+    : m_nPorts(0)
+{
+}
+
+inline L2PortMask::L2PortMask(uint32_t nPorts)
+    : m_words(WordsFor(nPorts), 0),
+      m_nPorts(nPorts)
+{
+}
+
+inline uint32_t
+L2PortMask::WordsFor(uint32_t nPorts)
+{
+    return (nPorts + 63) / 64;
+}
+
+inline void
+L2PortMask::Resize(uint32_t nPorts)
+{
+    m_words.resize(WordsFor(nPorts), 0);
+    m_nPorts = nPorts;
+
+    // 缩小时清掉超出范围的位，保证 Count()/== 只看有效端口
+    if (nPorts & 63)
+    {
+        m_words.back() &= (uint64_t(1) << (nPorts & 63)) - 1;
+    }
+}
+
+inline uint32_t
+L2PortMask::GetNPorts() const
+{
+    return m_nPorts;
+}
+
+inline void
+L2PortMask::Set(uint32_t port)
+{
+    m_words[port >> 6] |= uint64_t(1) << (port & 63);
+}
+
+inline void
+L2PortMask::Reset(uint32_t port)
+{
+    m_words[port >> 6] &= ~(uint64_t(1) << (port & 63));
+}
+
+inline bool
+L2PortMask::Test(uint32_t port) const
+{
+    return port < m_nPorts && ((m_words[port >> 6] >> (port & 63)) & 1);
+}
+
+inline void
+L2PortMask::SetAll()
+{
+    for (auto& w : m_words)
+    {
+        w = ~uint64_t(0);
+    }
+    if (m_nPorts & 63)
+    {
+        m_words.back() = (uint64_t(1) << (m_nPorts & 63)) - 1;
+    }
+}
+
+inline void
+L2PortMask::Clear()
+{
+    for (auto& w : m_words)
+    {
+        w = 0;
+    }
+}
+
+inline L2PortMask&
+L2PortMask::operator&=(const L2PortMask& other)
+{
+    for (std::size_t i = 0; i < m_words.size(); ++i)
+    {
+        m_words[i] &= (i < other.m_words.size()) ? other.m_words[i] : 0;
+    }
+    return *this;
+}
+
+inline L2PortMask&
+L2PortMask::operator|=(const L2PortMask& other)
+{
+    for (std::size_t i = 0; i < m_words.size() && i < other.m_words.size(); ++i)
+    {
+        m_words[i] |= other.m_words[i];
+    }
+    if (m_nPorts & 63)
+    {
+        m_words.back() &= (uint64_t(1) << (m_nPorts & 63)) - 1;
+    }
+    return *this;
+}
+
+inline L2PortMask&
+L2PortMask::AndNot(const L2PortMask& other)
+{
+    for (std::size_t i = 0; i < m_words.size() && i < other.m_words.size(); ++i)
+    {
+        m_words[i] &= ~other.m_words[i];
+    }
+    return *this;
+}
+
+inline bool
+L2PortMask::operator==(const L2PortMask& other) const
+{
+    return m_nPorts == other.m_nPorts && m_words == other.m_words;
+}
+
+inline bool
+L2PortMask::IsEmpty() const
+{
+    for (uint64_t w : m_words)
+    {
+        if (w != 0)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+inline uint32_t
+L2PortMask::Count() const
+{
+    uint32_t n = 0;
+    for (uint64_t w : m_words)
+    {
+        n += static_cast<uint32_t>(__builtin_popcountll(w));
+    }
+    return n;
+}
+
+inline uint32_t
+L2PortMask::FindLast() const
+{
+    for (std::size_t i = m_words.size(); i > 0; --i)
+    {
+        uint64_t w = m_words[i - 1];
+        if (w != 0)
+        {
+            return static_cast<uint32_t>((i - 1) * 64 + 63 - __builtin_clzll(w));
+        }
+    }
+    return NONE;
+}
+
+template <typename F>
+void
+L2PortMask::ForEach(F f) const
+{
+    for (std::size_t i = 0; i < m_words.size(); ++i)
+    {
+        uint64_t w = m_words[i];
+        while (w != 0)
+        {
+            f(static_cast<uint32_t>(i * 64 + __builtin_ctzll(w)));
+            w &= w - 1;  // 清掉最低位的 1
+        }
+    }
+}
+
+} // namespace ns3
+
+#endif /* L2_PORT_MASK_H */
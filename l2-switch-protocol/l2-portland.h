@@ -0,0 +1,519 @@
+/*
+ * ============================================================================
+ * 标题: 层次化伪 MAC 转发 (PortLand 风格)
+ * ============================================================================
+ *
+ * 【设计目的】
+ *   学习型交换机的 MAC 表按主机数增长: Fat-Tree 中每台交换机最终都要记住
+ *   所有主机的地址，k = 48 时就是 27648 个表项，而且每个新地址第一次都要泛洪。
+ *
+ *   PortLand (SIGCOMM 2009) 让地址本身携带位置:
+ *   - 边缘交换机给每个主机分配一个伪 MAC (PMAC)，编码主机在 Fat-Tree 中的位置，
+ *     主机发出的帧在入口把源地址 (真实地址 AMAC) 改写成 PMAC，
+ *     出口边缘交换机再把目的 PMAC 改回 AMAC，主机始终看不到自己的 PMAC
+ *   - 汇聚和核心交换机只按 PMAC 的前缀转发，表项数只和 k 有关，与主机数无关
+ *   - 主机的 ARP 请求由边缘交换机拦截，交给结构管理器 (fabric manager) 查询 IP -> PMAC，
+ *     由交换机直接回复，查不到时才广播
+ *
+ * 【PMAC 格式】
+ *
+ *   字段       位数   说明
+ *   pod        16     主机所在的 pod (只用 0..255，保证第一个字节的组播位为 0)
+ *   position   8      边缘交换机在 pod 中的位置
+ *   port       8      主机连接的边缘交换机端口
+ *   vmid       16     同一端口上的第几个主机 (虚拟机)
+ *
+ * 【转发】
+ *
+ *   交换机      目的 PMAC 在本交换机下方               否则
+ *   边缘        按 (port, vmid) 找到主机，目的改回 AMAC   按流哈希选一条上联
+ *   汇聚        pod 相同: 发往 position 对应的边缘交换机   按流哈希选一条上联
+ *   核心        按 pod 发往对应的汇聚交换机                -
+ *
+ *   广播和组播沿一棵固定的树: 每个 pod 的 0 号汇聚交换机和 0 号核心交换机。
+ *   边缘交换机把主机的广播发往其他主机端口和 0 号上联，汇聚交换机把下联收到的广播
+ *   发往其他下联和 0 号上联，从上联收到的发往所有下联，核心交换机发往其他所有 pod。
+ *
+ * 【与论文的差异】
+ *   - 交换机的层次和位置由 L2TopologyGenerator 配置 (SetPortlandLocation)，
+ *     不运行位置发现协议 (LDP)；Initialize() 时通过链路对端读取邻居的位置
+ *   - 结构管理器是所有交换机共享的对象，查询和登记没有时延，也没有控制报文
+ *   - 不处理主机迁移和链路故障，PMAC 分配后一直有效
+ *   - 只改写 IPv4 ARP 中的硬件地址，不使用 VLAN
+ *
+ * 作者: Liu Mengxuan
+ * ns-3 版本: 3.44
+ * ============================================================================
+ */
+
+#ifndef L2_PORTLAND_H
+#define L2_PORTLAND_H
+
+#include "l2-mac-table.h"
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+
+#include <algorithm>
+#include <ostream>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace ns3
+{
+
+// ============================================================================
+// PMAC 编码
+// ============================================================================
+
+class L2Pmac
+{
+public:
+    static constexpr uint16_t MAX_POD = 255;  // pod 的高字节必须为 0
+
+    /**
+     * @brief 由位置信息构造 PMAC
+     */
+    static Mac48Address Make(uint16_t pod, uint8_t position, uint8_t port, uint16_t vmid);
+
+    static uint16_t GetPod(const Mac48Address& pmac);
+    static uint8_t GetPosition(const Mac48Address& pmac);
+    static uint8_t GetPort(const Mac48Address& pmac);
+    static uint16_t GetVmid(const Mac48Address& pmac);
+};
+
+// ============================================================================
+// 每台交换机的 PMAC 转发表
+// ============================================================================
+
+class L2PortlandTable
+{
+public:
+    static constexpr uint16_t NO_PORT = L2MacTable::NO_PORT;
+
+    /**
+     * @brief 交换机在 Fat-Tree 中的层次
+     */
+    enum Level : uint8_t
+    {
+        EDGE,         // 边缘 (连接主机)
+        AGGREGATION,  // 汇聚
+        CORE          // 核心
+    };
+
+    /**
+     * @brief 边缘交换机上的一个主机
+     */
+    struct Host
+    {
+        Mac48Address amac;  // 主机的真实地址
+        uint16_t port;      // 连接的端口
+    };
+
+    /**
+     * @brief 设置本交换机的位置，清空所有端口和主机
+     * @param position 边缘/汇聚交换机在 pod 中的位置，核心交换机的编号
+     */
+    void SetLocation(Level level, uint16_t pod, uint8_t position);
+
+    Level GetLevel() const;
+    uint16_t GetPod() const;
+    uint8_t GetPosition() const;
+
+    /**
+     * @brief 添加连接主机的端口 (只有边缘交换机有)
+     */
+    void AddHostPort(uint16_t port);
+
+    /**
+     * @brief 添加上联
+     * @param peerPosition 对端交换机的位置 (边缘: 汇聚交换机的位置，汇聚: 核心交换机的编号)，
+     *        上联按它排序，0 号上联是广播树的方向
+     */
+    void AddUplink(uint8_t peerPosition, uint16_t port);
+
+    /**
+     * @brief 添加下联
+     * @param index 汇聚交换机: 对端边缘交换机的位置，核心交换机: 对端所在的 pod
+     */
+    void AddDownlink(uint16_t index, uint16_t port);
+
+    /**
+     * @brief 端口是否连接主机
+     */
+    bool IsHostPort(uint16_t port) const;
+
+    /**
+     * @brief 目的 PMAC 是否就是本边缘交换机下的主机
+     */
+    bool IsLocal(const Mac48Address& pmac) const;
+
+    /**
+     * @brief 主机的 PMAC，第一次出现时分配
+     * @param created 是否新分配
+     */
+    Mac48Address AssignPmac(const Mac48Address& amac, uint16_t port, bool& created);
+
+    /**
+     * @brief 按 PMAC 查找本交换机下的主机，不存在时返回 nullptr
+     */
+    const Host* FindHost(const Mac48Address& pmac) const;
+
+    /**
+     * @brief 目的 PMAC 的出端口 (不处理本地主机)
+     * @param hash 流哈希，在等价的上联中选择
+     * @return 没有路由时返回 NO_PORT
+     */
+    uint16_t Route(const Mac48Address& pmac, uint64_t hash) const;
+
+    /**
+     * @brief 从 inPort 进入的广播/组播帧要发往的端口
+     */
+    void GetFloodPorts(uint16_t inPort, std::vector<uint16_t>& ports) const;
+
+    /**
+     * @brief 本交换机的主机数 (只有边缘交换机不为 0)
+     */
+    uint32_t GetNHosts() const;
+
+    /**
+     * @brief 前缀路由的表项数 (上联 + 下联)，与主机数无关
+     */
+    uint32_t GetNRoutes() const;
+
+    void Clear();
+
+private:
+    Level m_level = EDGE;
+    uint16_t m_pod = 0;
+    uint8_t m_position = 0;
+    std::vector<uint16_t> m_hostPorts;
+    std::vector<bool> m_isHostPort;                              // 下标是端口号
+    std::vector<std::pair<uint8_t, uint16_t>> m_uplinks;         // (对端位置, 端口)，有序
+    std::vector<uint16_t> m_downlinks;                           // 下标是对端位置或 pod
+    std::unordered_map<uint64_t, Mac48Address> m_pmacs;          // AMAC -> PMAC
+    std::unordered_map<uint64_t, Host> m_hosts;                  // PMAC -> 主机
+    std::unordered_map<uint16_t, uint16_t> m_nextVmid;           // 端口 -> 下一个 vmid
+};
+
+// ============================================================================
+// 结构管理器: IP -> PMAC 目录
+// ============================================================================
+
+class L2FabricManager : public Object
+{
+public:
+    /**
+     * @brief 查询和登记的统计
+     */
+    struct Stats
+    {
+        uint64_t registered;  // 新登记的 IP
+        uint64_t updated;     // PMAC 发生变化的 IP
+        uint64_t resolved;    // 查到的 ARP 请求
+        uint64_t missed;      // 没有查到、需要广播的 ARP 请求
+    };
+
+    static TypeId GetTypeId();
+
+    /**
+     * @brief 边缘交换机登记 (或刷新) 主机的 IP -> PMAC
+     */
+    void Register(Ipv4Address ip, const Mac48Address& pmac);
+
+    /**
+     * @brief 查询 IP 对应的 PMAC
+     * @return 没有登记时返回 false
+     */
+    bool Resolve(Ipv4Address ip, Mac48Address& pmac);
+
+    uint32_t GetNHosts() const;
+    Stats GetStats() const;
+    void Report(std::ostream& os) const;
+
+protected:
+    void DoDispose() override;
+
+private:
+    std::unordered_map<uint32_t, Mac48Address> m_directory;  // IPv4 地址 -> PMAC
+    Stats m_stats{};
+};
+
+// ============================================================================
+// 实现
+// ============================================================================
+
+inline Mac48Address
+L2Pmac::Make(uint16_t pod, uint8_t position, uint8_t port, uint16_t vmid)
+{
+    uint8_t buf[6] = {static_cast<uint8_t>(pod >> 8), static_cast<uint8_t>(pod),
+                      position,                       port,
+                      static_cast<uint8_t>(vmid >> 8), static_cast<uint8_t>(vmid)};
+    Mac48Address pmac;
+    pmac.CopyFrom(buf);
+    return pmac;
+}
+
+inline uint16_t
+L2Pmac::GetPod(const Mac48Address& pmac)
+{
+    return static_cast<uint16_t>(L2MacTable::PackMac(pmac) >> 32);
+}
+
+inline uint8_t
+L2Pmac::GetPosition(const Mac48Address& pmac)
+{
+    return static_cast<uint8_t>(L2MacTable::PackMac(pmac) >> 24);
+}
+
+inline uint8_t
+L2Pmac::GetPort(const Mac48Address& pmac)
+{
+    return static_cast<uint8_t>(L2MacTable::PackMac(pmac) >> 16);
+}
+
+inline uint16_t
+L2Pmac::GetVmid(const Mac48Address& pmac)
+{
+    return static_cast<uint16_t>(L2MacTable::PackMac(pmac));
+}
+
+inline void
+L2PortlandTable::SetLocation(Level level, uint16_t pod, uint8_t position)
+{
+    NS_ASSERT_MSG(pod <= L2Pmac::MAX_POD, "PortLand pod " << pod << " does not fit in a PMAC");
+    Clear();
+    m_level = level;
+    m_pod = pod;
+    m_position = position;
+}
+
+inline L2PortlandTable::Level
+L2PortlandTable::GetLevel() const
+{
+    return m_level;
+}
+
+inline uint16_t
+L2PortlandTable::GetPod() const
+{
+    return m_pod;
+}
+
+inline uint8_t
+L2PortlandTable::GetPosition() const
+{
+    return m_position;
+}
+
+inline void
+L2PortlandTable::AddHostPort(uint16_t port)
+{
+    NS_ASSERT_MSG(port <= 0xff, "Host port " << port << " does not fit in a PMAC");
+    if (port >= m_isHostPort.size())
+    {
+        m_isHostPort.resize(port + 1, false);
+    }
+    m_isHostPort[port] = true;
+    m_hostPorts.push_back(port);
+}
+
+inline void
+L2PortlandTable::AddUplink(uint8_t peerPosition, uint16_t port)
+{
+    auto uplink = std::make_pair(peerPosition, port);
+    m_uplinks.insert(std::lower_bound(m_uplinks.begin(), m_uplinks.end(), uplink), uplink);
+}
+
+inline void
+L2PortlandTable::AddDownlink(uint16_t index, uint16_t port)
+{
+    if (index >= m_downlinks.size())
+    {
+        m_downlinks.resize(index + 1, NO_PORT);
+    }
+    m_downlinks[index] = port;
+}
+
+inline bool
+L2PortlandTable::IsHostPort(uint16_t port) const
+{
+    return port < m_isHostPort.size() && m_isHostPort[port];
+}
+
+inline bool
+L2PortlandTable::IsLocal(const Mac48Address& pmac) const
+{
+    return m_level == EDGE && L2Pmac::GetPod(pmac) == m_pod &&
+           L2Pmac::GetPosition(pmac) == m_position;
+}
+
+inline Mac48Address
+L2PortlandTable::AssignPmac(const Mac48Address& amac, uint16_t port, bool& created)
+{
+    uint64_t key = L2MacTable::PackMac(amac);
+    auto it = m_pmacs.find(key);
+    if (it != m_pmacs.end())
+    {
+        created = false;
+        return it->second;
+    }
+
+    uint16_t& vmid = m_nextVmid[port];
+    Mac48Address pmac = L2Pmac::Make(m_pod, m_position, static_cast<uint8_t>(port), vmid++);
+    m_pmacs.emplace(key, pmac);
+    m_hosts.emplace(L2MacTable::PackMac(pmac), Host{amac, port});
+    created = true;
+    return pmac;
+}
+
+inline const L2PortlandTable::Host*
+L2PortlandTable::FindHost(const Mac48Address& pmac) const
+{
+    auto it = m_hosts.find(L2MacTable::PackMac(pmac));
+    return it == m_hosts.end() ? nullptr : &it->second;
+}
+
+inline uint16_t
+L2PortlandTable::Route(const Mac48Address& pmac, uint64_t hash) const
+{
+    uint16_t pod = L2Pmac::GetPod(pmac);
+    uint16_t index = NO_PORT;
+    if (m_level == CORE)
+    {
+        index = pod;
+    }
+    else if (m_level == AGGREGATION && pod == m_pod)
+    {
+        index = L2Pmac::GetPosition(pmac);
+    }
+    else if (!m_uplinks.empty())
+    {
+        return m_uplinks[hash % m_uplinks.size()].second;
+    }
+    return index < m_downlinks.size() ? m_downlinks[index] : NO_PORT;
+}
+
+inline void
+L2PortlandTable::GetFloodPorts(uint16_t inPort, std::vector<uint16_t>& ports) const
+{
+    ports.clear();
+    const std::vector<uint16_t>& down = (m_level == EDGE) ? m_hostPorts : m_downlinks;
+    for (uint16_t port : down)
+    {
+        if (port != inPort && port != NO_PORT)
+        {
+            ports.push_back(port);
+        }
+    }
+
+    // 从下方进入的帧还要沿树向上 (核心交换机没有上联)
+    bool fromBelow = (m_level == EDGE) ? IsHostPort(inPort)
+                                       : std::find(down.begin(), down.end(), inPort) != down.end();
+    if (fromBelow && !m_uplinks.empty())
+    {
+        ports.push_back(m_uplinks.front().second);
+    }
+}
+
+inline uint32_t
+L2PortlandTable::GetNHosts() const
+{
+    return static_cast<uint32_t>(m_hosts.size());
+}
+
+inline uint32_t
+L2PortlandTable::GetNRoutes() const
+{
+    uint32_t routes = static_cast<uint32_t>(m_uplinks.size());
+    for (uint16_t port : m_downlinks)
+    {
+        routes += (port != NO_PORT) ? 1 : 0;
+    }
+    return routes;
+}
+
+inline void
+L2PortlandTable::Clear()
+{
+    m_hostPorts.clear();
+    m_isHostPort.clear();
+    m_uplinks.clear();
+    m_downlinks.clear();
+    m_pmacs.clear();
+    m_hosts.clear();
+    m_nextVmid.clear();
+}
+
+NS_OBJECT_ENSURE_REGISTERED(L2FabricManager);
+
+inline TypeId
+L2FabricManager::GetTypeId()
+{
+    static TypeId tid = TypeId("ns3::L2FabricManager")
+        .SetParent<Object>()
+        .SetGroupName("Network")
+        .AddConstructor<L2FabricManager>();
+    return tid;
+}
+
+inline void
+L2FabricManager::Register(Ipv4Address ip, const Mac48Address& pmac)
+{
+    auto [it, inserted] = m_directory.emplace(ip.Get(), pmac);
+    if (inserted)
+    {
+        ++m_stats.registered;
+    }
+    else if (it->second != pmac)
+    {
+        it->second = pmac;
+        ++m_stats.updated;
+    }
+}
+
+inline bool
+L2FabricManager::Resolve(Ipv4Address ip, Mac48Address& pmac)
+{
+    auto it = m_directory.find(ip.Get());
+    if (it == m_directory.end())
+    {
+        ++m_stats.missed;
+        return false;
+    }
+    ++m_stats.resolved;
+    pmac = it->second;
+    return true;
+}
+
+inline uint32_t
+L2FabricManager::GetNHosts() const
+{
+    return static_cast<uint32_t>(m_directory.size());
+}
+
+inline L2FabricManager::Stats
+L2FabricManager::GetStats() const
+{
+    return m_stats;
+}
+
+inline void
+L2FabricManager::Report(std::ostream& os) const
+{
+    os << "Fabric manager: " << m_directory.size() << " hosts, " << m_stats.registered
+       << " registered, " << m_stats.updated << " updated, ARP resolved " << m_stats.resolved
+       << ", missed " << m_stats.missed << std::endl;
+}
+
+inline void
+L2FabricManager::DoDispose()
+{
+    m_directory.clear();
+    Object::DoDispose();
+}
+
+} // namespace ns3
+
+#endif /* L2_PORTLAND_H */
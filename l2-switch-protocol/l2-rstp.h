@@ -0,0 +1,1187 @@
+/*
+ * ============================================================================
+ * 标题: 快速生成树协议 (RSTP, IEEE 802.1w)
+ * ============================================================================
+ *
+ * 【设计目的】
+ *   L2SwitchProtocol 会把广播帧和未知单播帧泛洪到除入端口以外的所有端口。
+ *   只要拓扑中有环路 (例如用这些交换机搭建的 Fat-Tree)，一个 ARP 请求就会
+ *   在环上无限循环，仿真永远无法结束。
+ *
+ *   RSTP 通过交换 BPDU 在交换机之间选出一棵生成树，把多余的链路阻塞掉:
+ *   - 根桥选举: 桥 ID (优先级 + MAC) 最小的交换机成为根桥
+ *   - 端口角色: Root (通往根桥的最优端口) / Designated (网段上的转发端口) /
+ *               Alternate、Backup (冗余端口，阻塞)
+ *   - 端口状态: Discarding (不学习不转发) / Learning (只学习) / Forwarding
+ *   - 快速收敛: 指定端口发出 Proposal，下游把其他端口同步 (Sync) 后回复
+ *               Agreement，链路无需等待 2 x ForwardDelay 就能进入转发状态
+ *   - 拓扑变化: 非边缘端口进入转发状态时发出 TC，沿途交换机清除学到的 MAC
+ *
+ * 【与标准的差异】
+ *   - BPDU 直接封装在以太网帧中 (EtherType 0x88B5，目的地址 01:80:C2:00:00:00)，
+ *     不使用 LLC 封装
+ *   - 链路故障通过收不到 BPDU 检测 (3 x HelloTime)，ns-3 的 CSMA 设备没有
+ *     链路断开通知
+ *   - 没有实现与 802.1D STP 的兼容模式
+ *
+ * 【注意】
+ *   本文件使用 l2-switch-protocol.cc 的日志组件，
+ *   必须在 NS_LOG_COMPONENT_DEFINE 之后 include。
+ *
+ * 作者: Liu Mengxuan
+ * ns-3 版本: 3.44
+ * ============================================================================
+ */
+
+#ifndef L2_RSTP_H
+#define L2_RSTP_H
+
+#include "l2-mac-table.h"
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+
+#include <iomanip>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * @brief 交换机端口的转发状态
+ */
+enum L2PortState : uint8_t
+{
+    L2_PORT_DISCARDING,  // 不学习、不转发
+    L2_PORT_LEARNING,    // 只学习源地址，不转发
+    L2_PORT_FORWARDING   // 学习并转发
+};
+
+// ============================================================================
+// BPDU 帧头
+// ============================================================================
+//
+//   字段                长度   说明
+//   Protocol ID         2      固定为 0
+//   Version             1      2 = RSTP
+//   BPDU Type           1      0x02 = RST BPDU
+//   Flags               1      TC / Proposal / Role / Learning / Forwarding / Agreement / TCA
+//   Root ID             8      根桥 ID (优先级 16 位 + MAC 48 位)
+//   Root Path Cost      4      到根桥的路径开销
+//   Bridge ID           8      发送者的桥 ID
+//   Port ID             2      发送端口 ID (优先级 8 位 + 端口号 8 位)
+//   Message Age         2      以下 4 个时间字段单位为 1/256 秒
+//   Max Age             2
+//   Hello Time          2
+//   Forward Delay       2
+//   Version 1 Length    1      固定为 0
+//                       --
+//                       36 字节
+//
+// ============================================================================
+
+class L2BpduHeader : public Header
+{
+public:
+    // Flags 字段各位的含义 (802.1w 9.3.3)
+    static constexpr uint8_t FLAG_TC = 0x01;
+    static constexpr uint8_t FLAG_PROPOSAL = 0x02;
+    static constexpr uint8_t FLAG_ROLE_MASK = 0x0c;
+    static constexpr uint8_t FLAG_LEARNING = 0x10;
+    static constexpr uint8_t FLAG_FORWARDING = 0x20;
+    static constexpr uint8_t FLAG_AGREEMENT = 0x40;
+    static constexpr uint8_t FLAG_TC_ACK = 0x80;
+
+    // 端口角色编码 (Flags 的第 2-3 位)
+    static constexpr uint8_t ROLE_UNKNOWN = 0;
+    static constexpr uint8_t ROLE_ALTERNATE_BACKUP = 1;
+    static constexpr uint8_t ROLE_ROOT = 2;
+    static constexpr uint8_t ROLE_DESIGNATED = 3;
+
+    L2BpduHeader();
+
+    static TypeId GetTypeId();
+    TypeId GetInstanceTypeId() const override;
+    uint32_t GetSerializedSize() const override;
+    void Serialize(Buffer::Iterator start) const override;
+    uint32_t Deserialize(Buffer::Iterator start) override;
+    void Print(std::ostream& os) const override;
+
+    bool IsRstBpdu() const;
+
+    void SetFlags(uint8_t flags);
+    uint8_t GetFlags() const;
+    void SetRole(uint8_t role);
+    uint8_t GetRole() const;
+
+    void SetRootId(uint64_t id);
+    uint64_t GetRootId() const;
+    void SetRootPathCost(uint32_t cost);
+    uint32_t GetRootPathCost() const;
+    void SetBridgeId(uint64_t id);
+    uint64_t GetBridgeId() const;
+    void SetPortId(uint16_t id);
+    uint16_t GetPortId() const;
+
+    /**
+     * @brief 设置/获取时间字段 (单位 1/256 秒)
+     */
+    void SetTimers(uint16_t messageAge, uint16_t maxAge, uint16_t helloTime, uint16_t forwardDelay);
+    uint16_t GetMessageAge() const;
+    uint16_t GetMaxAge() const;
+    uint16_t GetHelloTime() const;
+    uint16_t GetForwardDelay() const;
+
+private:
+    uint8_t m_version;
+    uint8_t m_type;
+    uint8_t m_flags;
+    uint64_t m_rootId;
+    uint32_t m_rootPathCost;
+    uint64_t m_bridgeId;
+    uint16_t m_portId;
+    uint16_t m_messageAge;
+    uint16_t m_maxAge;
+    uint16_t m_helloTime;
+    uint16_t m_forwardDelay;
+};
+
+// ============================================================================
+// RSTP 状态机
+// ============================================================================
+//
+// 【使用方式】
+//   L2SwitchProtocol 为每个端口调用一次 AddPort()，设置回调后调用 Start()。
+//   收到发往 01:80:C2:00:00:00 的 BPDU 时调用 Receive()。
+//   RSTP 通过回调:
+//   - 发送 BPDU
+//   - 通知端口状态变化 (交换机据此重新计算泛洪集合)
+//   - 在拓扑变化时清除 MAC 表
+//
+// ============================================================================
+
+class L2Rstp : public Object
+{
+public:
+    static constexpr uint16_t PROTOCOL = 0x88B5;      // BPDU 使用的 EtherType (IEEE 本地实验用)
+    static constexpr uint16_t NO_PORT = 0xffff;
+
+    /**
+     * @brief 端口角色
+     */
+    enum PortRole
+    {
+        ROLE_DISABLED,
+        ROLE_ROOT,
+        ROLE_DESIGNATED,
+        ROLE_ALTERNATE,
+        ROLE_BACKUP
+    };
+
+    /// 发送 BPDU: (端口号, BPDU)
+    typedef Callback<void, uint16_t, Ptr<Packet>> SendCallback;
+    /// 端口状态变化: (端口号, 新状态)
+    typedef Callback<void, uint16_t, L2PortState> StateCallback;
+    /// 拓扑变化: 清除除该端口以外所有端口上学到的 MAC 地址
+    typedef Callback<void, uint16_t> FlushCallback;
+
+    static TypeId GetTypeId();
+
+    L2Rstp();
+    ~L2Rstp() override;
+
+    /**
+     * @brief BPDU 的目的地址 (Bridge Group Address)
+     */
+    static Mac48Address GetGroupAddress();
+
+    /**
+     * @brief 设置日志中使用的交换机名称和桥 MAC 地址 (桥 ID 的低 48 位)
+     */
+    void SetBridge(const std::string& name, Mac48Address bridgeMac);
+
+    void SetCallbacks(SendCallback send, StateCallback state, FlushCallback flush);
+
+    /**
+     * @brief 添加一个端口，端口号按添加顺序从 0 开始
+     * @param pathCost 端口路径开销
+     * @param edge 是否为边缘端口 (连接主机，启动时直接转发)
+     * @return 端口号
+     */
+    uint16_t AddPort(uint32_t pathCost, bool edge);
+
+    /**
+     * @brief 启动协议: 所有端口从 Designated/Discarding 开始，发出 Proposal
+     */
+    void Start();
+
+    /**
+     * @brief 处理一个收到的 BPDU
+     */
+    void Receive(uint16_t port, Ptr<const Packet> packet);
+
+    // ========== 查询 ==========
+    uint64_t GetBridgeId() const;
+    uint64_t GetRootId() const;
+    uint16_t GetRootPort() const;
+    bool IsRoot() const;
+    PortRole GetPortRole(uint16_t port) const;
+    L2PortState GetPortState(uint16_t port) const;
+
+    /**
+     * @brief 最近一次端口角色或状态变化的时间，用于计算收敛时间
+     */
+    Time GetLastChange() const;
+
+    /**
+     * @brief 本交换机检测到或收到的拓扑变化次数
+     */
+    uint32_t GetTopologyChanges() const;
+
+    /**
+     * @brief 打印桥 ID、根桥和每个端口的角色/状态
+     */
+    void Report(std::ostream& os) const;
+
+    static std::string FormatBridgeId(uint64_t id);
+    static const char* RoleName(PortRole role);
+    static const char* StateName(L2PortState state);
+
+protected:
+    void DoDispose() override;
+
+private:
+    /**
+     * @brief 优先级向量，各字段按顺序比较，越小越优
+     */
+    struct Vector
+    {
+        uint64_t rootId;
+        uint32_t rootPathCost;
+        uint64_t bridgeId;
+        uint16_t portId;
+
+        bool operator<(const Vector& o) const
+        {
+            return std::tie(rootId, rootPathCost, bridgeId, portId) <
+                   std::tie(o.rootId, o.rootPathCost, o.bridgeId, o.portId);
+        }
+    };
+
+    struct Port
+    {
+        uint16_t portId;        // 端口 ID (优先级 0x80 + 端口号)
+        uint32_t pathCost;      // 端口路径开销
+        bool edge;              // 边缘端口
+        PortRole role;
+        L2PortState state;
+        bool hasInfo;           // 是否保存了对端的 Designated 信息
+        Vector info;            // 对端的优先级向量
+        uint16_t infoAge;       // 对端信息的 Message Age (1/256 秒)
+        Time infoExpiry;        // 对端信息的过期时间 (3 x HelloTime 收不到 BPDU)
+        bool proposing;         // 指定端口正在等待 Agreement
+        Time tcUntil;           // 在这个时间之前发出的 BPDU 带 TC 标志
+        EventId fdEvent;        // ForwardDelay 定时器 (没有收到 Agreement 时的慢速路径)
+    };
+
+    Vector DesignatedVector(uint16_t port) const;
+    void UpdateRoles();
+    void SetRole(uint16_t port, PortRole role);
+    void SetState(uint16_t port, L2PortState state);
+    void Sync(uint16_t rootPort);
+    void ForwardDelayExpired(uint16_t port);
+    void TopologyChange(uint16_t port);
+    void StartTcWhile(uint16_t port);
+    void SendBpdu(uint16_t port, bool agreement = false);
+    void HelloTick();
+    static uint16_t ToTicks(Time t);
+
+    // 属性
+    uint16_t m_priority;
+    Time m_helloTime;
+    Time m_forwardDelay;
+    Time m_maxAge;
+
+    std::string m_name;
+    uint64_t m_bridgeId;
+    std::vector<Port> m_ports;
+    uint64_t m_rootId;            // 当前根桥 ID
+    uint32_t m_rootPathCost;      // 到根桥的开销
+    uint16_t m_rootPort;          // 根端口，根桥上为 NO_PORT
+    Time m_lastChange;
+    uint32_t m_topologyChanges;
+    EventId m_helloEvent;
+
+    SendCallback m_send;
+    StateCallback m_stateChanged;
+    FlushCallback m_flush;
+};
+
+// ============================================================================
+// L2BpduHeader 实现
+// ============================================================================
+
+NS_OBJECT_ENSURE_REGISTERED(L2BpduHeader);
+
+inline L2BpduHeader::L2BpduHeader()
+    : m_version(2),
+      m_type(0x02),
+      m_flags(0),
+      m_rootId(0),
+      m_rootPathCost(0),
+      m_bridgeId(0),
+      m_portId(0),
+      m_messageAge(0),
+      m_maxAge(0),
+      m_helloTime(0),
+      m_forwardDelay(0)
+{
+}
+
+inline TypeId
+L2BpduHeader::GetTypeId()
+{
+    static TypeId tid = TypeId("ns3::L2BpduHeader")
+        .SetParent<Header>()
+        .SetGroupName("Network")
+        .AddConstructor<L2BpduHeader>();
+    return tid;
+}
+
+inline TypeId
+L2BpduHeader::GetInstanceTypeId() const
+{
+    return GetTypeId();
+}
+
+inline uint32_t
+L2BpduHeader::GetSerializedSize() const
+{
+    return 36;
+}
+
+inline void
+L2BpduHeader::Serialize(Buffer::Iterator start) const
+{
+    Buffer::Iterator i = start;
+    i.WriteHtonU16(0);  // Protocol ID
+    i.WriteU8(m_version);
+    i.WriteU8(m_type);
+    i.WriteU8(m_flags);
+    i.WriteHtonU64(m_rootId);
+    i.WriteHtonU32(m_rootPathCost);
+    i.WriteHtonU64(m_bridgeId);
+    i.WriteHtonU16(m_portId);
+    i.WriteHtonU16(m_messageAge);
+    i.WriteHtonU16(m_maxAge);
+    i.WriteHtonU16(m_helloTime);
+    i.WriteHtonU16(m_forwardDelay);
+    i.WriteU8(0);       // Version 1 Length
+}
+
+inline uint32_t
+L2BpduHeader::Deserialize(Buffer::Iterator start)
+{
+    Buffer::Iterator i = start;
+    i.ReadNtohU16();    // Protocol ID
+    m_version = i.ReadU8();
+    m_type = i.ReadU8();
+    m_flags = i.ReadU8();
+    m_rootId = i.ReadNtohU64();
+    m_rootPathCost = i.ReadNtohU32();
+    m_bridgeId = i.ReadNtohU64();
+    m_portId = i.ReadNtohU16();
+    m_messageAge = i.ReadNtohU16();
+    m_maxAge = i.ReadNtohU16();
+    m_helloTime = i.ReadNtohU16();
+    m_forwardDelay = i.ReadNtohU16();
+    i.ReadU8();         // Version 1 Length
+    return GetSerializedSize();
+}
+
+inline void
+L2BpduHeader::Print(std::ostream& os) const
+{
+    os << "RST BPDU root=" << L2Rstp::FormatBridgeId(m_rootId) << " cost=" << m_rootPathCost
+       << " bridge=" << L2Rstp::FormatBridgeId(m_bridgeId) << " port=0x" << std::hex
+       << m_portId << " flags=0x" << unsigned(m_flags) << std::dec;
+}
+
+inline bool
+L2BpduHeader::IsRstBpdu() const
+{
+    return m_version >= 2 && m_type == 0x02;
+}
+
+inline void
+L2BpduHeader::SetFlags(uint8_t flags)
+{
+    m_flags = flags;
+}
+
+inline uint8_t
+L2BpduHeader::GetFlags() const
+{
+    return m_flags;
+}
+
+inline void
+L2BpduHeader::SetRole(uint8_t role)
+{
+    m_flags = (m_flags & ~FLAG_ROLE_MASK) | ((role << 2) & FLAG_ROLE_MASK);
+}
+
+inline uint8_t
+L2BpduHeader::GetRole() const
+{
+    return (m_flags & FLAG_ROLE_MASK) >> 2;
+}
+
+inline void
+L2BpduHeader::SetRootId(uint64_t id)
+{
+    m_rootId = id;
+}
+
+inline uint64_t
+L2BpduHeader::GetRootId() const
+{
+    return m_rootId;
+}
+
+inline void
+L2BpduHeader::SetRootPathCost(uint32_t cost)
+{
+    m_rootPathCost = cost;
+}
+
+inline uint32_t
+L2BpduHeader::GetRootPathCost() const
+{
+    return m_rootPathCost;
+}
+
+inline void
+L2BpduHeader::SetBridgeId(uint64_t id)
+{
+    m_bridgeId = id;
+}
+
+inline uint64_t
+L2BpduHeader::GetBridgeId() const
+{
+    return m_bridgeId;
+}
+
+inline void
+L2BpduHeader::SetPortId(uint16_t id)
+{
+    m_portId = id;
+}
+
+inline uint16_t
+L2BpduHeader::GetPortId() const
+{
+    return m_portId;
+}
+
+inline void
+L2BpduHeader::SetTimers(uint16_t messageAge,
+                        uint16_t maxAge,
+                        uint16_t helloTime,
+                        uint16_t forwardDelay)
+{
+    m_messageAge = messageAge;
+    m_maxAge = maxAge;
+    m_helloTime = helloTime;
+    m_forwardDelay = forwardDelay;
+}
+
+inline uint16_t
+L2BpduHeader::GetMessageAge() const
+{
+    return m_messageAge;
+}
+
+inline uint16_t
+L2BpduHeader::GetMaxAge() const
+{
+    return m_maxAge;
+}
+
+inline uint16_t
+L2BpduHeader::GetHelloTime() const
+{
+    return m_helloTime;
+}
+
+inline uint16_t
+L2BpduHeader::GetForwardDelay() const
+{
+    return m_forwardDelay;
+}
+
+// ============================================================================
+// L2Rstp 实现
+// ============================================================================
+
+NS_OBJECT_ENSURE_REGISTERED(L2Rstp);
+
+inline TypeId
+L2Rstp::GetTypeId()
+{
+    static TypeId tid = TypeId("ns3::L2Rstp")
+        .SetParent<Object>()
+        .SetGroupName("Network")
+        .AddConstructor<L2Rstp>()
+        .AddAttribute("BridgePriority",
+                      "Bridge priority, the upper 16 bits of the bridge ID (lower wins root election)",
+                      UintegerValue(32768),
+                      MakeUintegerAccessor(&L2Rstp::m_priority),
+                      MakeUintegerChecker<uint16_t>())
+        .AddAttribute("HelloTime",
+                      "Interval between BPDUs on designated ports",
+                      TimeValue(Seconds(2)),
+                      MakeTimeAccessor(&L2Rstp::m_helloTime),
+                      MakeTimeChecker(MilliSeconds(1)))
+        .AddAttribute("ForwardDelay",
+                      "Time spent in each of Discarding and Learning when no Agreement arrives",
+                      TimeValue(Seconds(15)),
+                      MakeTimeAccessor(&L2Rstp::m_forwardDelay),
+                      MakeTimeChecker())
+        .AddAttribute("MaxAge",
+                      "BPDU information older than this (Message Age) is discarded",
+                      TimeValue(Seconds(20)),
+                      MakeTimeAccessor(&L2Rstp::m_maxAge),
+                      MakeTimeChecker());
+    return tid;
+}
+
+inline L2Rstp::L2Rstp()
+    : m_priority(32768),
+      m_name("Switch"),
+      m_bridgeId(0),
+      m_rootId(0),
+      m_rootPathCost(0),
+      m_rootPort(NO_PORT),
+      m_topologyChanges(0)
+{
+}
+
+inline L2Rstp::~L2Rstp()
+{
+}
+
+inline void
+L2Rstp::DoDispose()
+{
+    m_helloEvent.Cancel();
+    for (auto& port : m_ports)
+    {
+        port.fdEvent.Cancel();
+    }
+    m_ports.clear();
+    m_send = SendCallback();
+    m_stateChanged = StateCallback();
+    m_flush = FlushCallback();
+    Object::DoDispose();
+}
+
+inline Mac48Address
+L2Rstp::GetGroupAddress()
+{
+    return Mac48Address("01:80:c2:00:00:00");
+}
+
+inline void
+L2Rstp::SetBridge(const std::string& name, Mac48Address bridgeMac)
+{
+    m_name = name;
+    m_bridgeId = (uint64_t(m_priority) << 48) | L2MacTable::PackMac(bridgeMac);
+    m_rootId = m_bridgeId;
+}
+
+inline void
+L2Rstp::SetCallbacks(SendCallback send, StateCallback state, FlushCallback flush)
+{
+    m_send = send;
+    m_stateChanged = state;
+    m_flush = flush;
+}
+
+inline uint16_t
+L2Rstp::AddPort(uint32_t pathCost, bool edge)
+{
+    uint16_t port = static_cast<uint16_t>(m_ports.size());
+    Port p;
+    p.portId = static_cast<uint16_t>(0x8000 | ((port + 1) & 0x0fff));
+    p.pathCost = pathCost;
+    p.edge = edge;
+    p.role = ROLE_DISABLED;
+    p.state = L2_PORT_DISCARDING;
+    p.hasInfo = false;
+    p.info = Vector{0, 0, 0, 0};
+    p.infoAge = 0;
+    p.proposing = false;
+    m_ports.push_back(p);
+    return port;
+}
+
+inline void
+L2Rstp::Start()
+{
+    NS_LOG_INFO(m_name << ": RSTP starting, bridge " << FormatBridgeId(m_bridgeId));
+
+    // 启动时自己就是根桥，所有端口都是 Designated
+    UpdateRoles();
+    m_helloEvent = Simulator::Schedule(m_helloTime, &L2Rstp::HelloTick, this);
+}
+
+inline L2Rstp::Vector
+L2Rstp::DesignatedVector(uint16_t port) const
+{
+    return Vector{m_rootId, m_rootPathCost, m_bridgeId, m_ports[port].portId};
+}
+
+inline void
+L2Rstp::Receive(uint16_t port, Ptr<const Packet> packet)
+{
+    L2BpduHeader bpdu;
+    if (port >= m_ports.size() || packet->GetSize() < bpdu.GetSerializedSize())
+    {
+        return;
+    }
+    packet->PeekHeader(bpdu);
+    if (!bpdu.IsRstBpdu())
+    {
+        return;
+    }
+
+    Port& p = m_ports[port];
+    if (p.edge)
+    {
+        // 边缘端口收到 BPDU，说明对端其实是交换机
+        NS_LOG_INFO(m_name << ": BPDU on edge port " << port << ", no longer edge");
+        p.edge = false;
+    }
+
+    Vector msg{bpdu.GetRootId(), bpdu.GetRootPathCost(), bpdu.GetBridgeId(), bpdu.GetPortId()};
+    uint8_t role = bpdu.GetRole();
+
+    if (role == L2BpduHeader::ROLE_DESIGNATED)
+    {
+        if (bpdu.GetMessageAge() >= bpdu.GetMaxAge())
+        {
+            // 经过的跳数太多，信息已经过期。端口上保存的信息也作废，
+            // 不能等 3 x HelloTime 超时，否则失效的根信息会在环上继续转圈 (count-to-infinity)
+            if (p.hasInfo)
+            {
+                NS_LOG_INFO(m_name << ": Information on port " << port << " exceeded MaxAge");
+                p.hasInfo = false;
+                UpdateRoles();
+            }
+            return;
+        }
+
+        // 更优的信息，或者同一个指定端口发来的新信息 (可能变差) 都要接受
+        bool sameSender = p.hasInfo && p.info.bridgeId == msg.bridgeId &&
+                          p.info.portId == msg.portId;
+        bool accept = !p.hasInfo || msg < p.info || sameSender;
+        if (accept)
+        {
+            p.hasInfo = true;
+            p.info = msg;
+            p.infoAge = bpdu.GetMessageAge();
+            p.infoExpiry = Simulator::Now() + 3 * m_helloTime;
+        }
+
+        UpdateRoles();
+
+        if (accept && (bpdu.GetFlags() & L2BpduHeader::FLAG_PROPOSAL))
+        {
+            if (p.role == ROLE_ROOT)
+            {
+                // 上游在已有的根端口上重新提议时也要先同步: 所有非边缘的指定端口进入
+                // Discarding 并重新提议，之后才能回复 Agreement，否则可能形成临时环路。
+                // 刚成为根端口时 SetRole 已经同步过，这里不会改变任何端口
+                Sync(port);
+                SendBpdu(port, true);
+            }
+            else if (p.role == ROLE_ALTERNATE || p.role == ROLE_BACKUP)
+            {
+                // 阻塞端口本身不转发，不需要同步，直接回复 Agreement
+                SendBpdu(port, true);
+            }
+        }
+        else if (p.role == ROLE_DESIGNATED && !(msg < DesignatedVector(port)))
+        {
+            // 对端的信息比我们差，立即回复让它尽快更新
+            SendBpdu(port);
+        }
+    }
+    else if (role == L2BpduHeader::ROLE_ROOT || role == L2BpduHeader::ROLE_ALTERNATE_BACKUP)
+    {
+        if ((bpdu.GetFlags() & L2BpduHeader::FLAG_AGREEMENT) && p.role == ROLE_DESIGNATED &&
+            p.proposing)
+        {
+            // 下游同意: 指定端口立即进入转发状态
+            NS_LOG_INFO(m_name << ": Agreement on port " << port);
+            p.proposing = false;
+            p.fdEvent.Cancel();
+            SetState(port, L2_PORT_FORWARDING);
+        }
+    }
+
+    if ((bpdu.GetFlags() & L2BpduHeader::FLAG_TC) &&
+        (p.role == ROLE_ROOT || p.role == ROLE_DESIGNATED))
+    {
+        // 拓扑变化: 清除其他端口上学到的地址，并继续向其他方向传播
+        ++m_topologyChanges;
+        if (!m_flush.IsNull())
+        {
+            m_flush(port);
+        }
+        StartTcWhile(port);
+    }
+}
+
+inline void
+L2Rstp::UpdateRoles()
+{
+    Time now = Simulator::Now();
+
+    // 1. 3 x HelloTime 收不到 BPDU 的信息视为过期 (链路故障或对端停止)
+    for (uint16_t i = 0; i < m_ports.size(); ++i)
+    {
+        Port& p = m_ports[i];
+        if (p.hasInfo && now >= p.infoExpiry)
+        {
+            NS_LOG_INFO(m_name << ": Information on port " << i << " aged out");
+            p.hasInfo = false;
+        }
+    }
+
+    // 2. 选择根端口: 比较 {根桥, 根开销 + 端口开销, 对端桥, 对端端口, 本端口}
+    Vector best{m_bridgeId, 0, m_bridgeId, 0};
+    uint16_t bestPortId = 0;
+    uint16_t rootPort = NO_PORT;
+    for (uint16_t i = 0; i < m_ports.size(); ++i)
+    {
+        const Port& p = m_ports[i];
+        if (!p.hasInfo || p.info.bridgeId == m_bridgeId)
+        {
+            // 自己发出的信息 (同一网段上的另一个端口) 不能作为根端口
+            continue;
+        }
+        Vector candidate{p.info.rootId, p.info.rootPathCost + p.pathCost, p.info.bridgeId,
+                         p.info.portId};
+        if (std::tie(candidate, p.portId) < std::tie(best, bestPortId))
+        {
+            best = candidate;
+            bestPortId = p.portId;
+            rootPort = i;
+        }
+    }
+
+    bool rootChanged = (best.rootId != m_rootId || best.rootPathCost != m_rootPathCost ||
+                        rootPort != m_rootPort);
+    if (rootChanged)
+    {
+        NS_LOG_INFO(m_name << ": Root " << FormatBridgeId(best.rootId) << " cost "
+                   << best.rootPathCost << " via port "
+                   << (rootPort == NO_PORT ? std::string("-") : std::to_string(rootPort)));
+    }
+    m_rootId = best.rootId;
+    m_rootPathCost = best.rootPathCost;
+    m_rootPort = rootPort;
+
+    // 3. 其余端口: 对端信息更优则阻塞 (Alternate/Backup)，否则成为 Designated
+    //    先处理需要阻塞的端口，再打开新的转发端口，避免瞬时环路
+    std::vector<PortRole> roles(m_ports.size());
+    for (uint16_t i = 0; i < m_ports.size(); ++i)
+    {
+        const Port& p = m_ports[i];
+        if (i == rootPort)
+        {
+            roles[i] = ROLE_ROOT;
+        }
+        else if (p.hasInfo && p.info < DesignatedVector(i))
+        {
+            roles[i] = (p.info.bridgeId == m_bridgeId) ? ROLE_BACKUP : ROLE_ALTERNATE;
+        }
+        else
+        {
+            roles[i] = ROLE_DESIGNATED;
+        }
+    }
+    for (uint16_t i = 0; i < m_ports.size(); ++i)
+    {
+        if (roles[i] == ROLE_ALTERNATE || roles[i] == ROLE_BACKUP)
+        {
+            SetRole(i, roles[i]);
+        }
+    }
+    for (uint16_t i = 0; i < m_ports.size(); ++i)
+    {
+        SetRole(i, roles[i]);
+    }
+
+    // 根信息变了，立即通知下游 (不等下一个 Hello)
+    if (rootChanged)
+    {
+        for (uint16_t i = 0; i < m_ports.size(); ++i)
+        {
+            if (m_ports[i].role == ROLE_DESIGNATED && !m_ports[i].edge)
+            {
+                SendBpdu(i);
+            }
+        }
+    }
+}
+
+inline void
+L2Rstp::SetRole(uint16_t port, PortRole role)
+{
+    Port& p = m_ports[port];
+    if (p.role == role)
+    {
+        return;
+    }
+    NS_LOG_INFO(m_name << ": Port " << port << " role " << RoleName(p.role) << " -> "
+               << RoleName(role));
+    p.role = role;
+    m_lastChange = Simulator::Now();
+
+    switch (role)
+    {
+    case ROLE_ROOT:
+        // 新的根端口: 先把其他指定端口同步到 Discarding (它们随后重新发出 Proposal)，
+        // 旧的根端口已经在同一次计算中被阻塞，根端口可以立即转发
+        p.proposing = false;
+        p.fdEvent.Cancel();
+        Sync(port);
+        SetState(port, L2_PORT_FORWARDING);
+        break;
+    case ROLE_DESIGNATED:
+        if (p.edge)
+        {
+            SetState(port, L2_PORT_FORWARDING);
+        }
+        else if (p.state != L2_PORT_FORWARDING)
+        {
+            // 发出 Proposal；收到 Agreement 前按 ForwardDelay 慢速过渡
+            p.proposing = true;
+            p.fdEvent.Cancel();
+            p.fdEvent = Simulator::Schedule(m_forwardDelay, &L2Rstp::ForwardDelayExpired, this, port);
+            SendBpdu(port);
+        }
+        break;
+    case ROLE_ALTERNATE:
+    case ROLE_BACKUP:
+    case ROLE_DISABLED:
+        p.proposing = false;
+        p.fdEvent.Cancel();
+        SetState(port, L2_PORT_DISCARDING);
+        break;
+    }
+}
+
+inline void
+L2Rstp::SetState(uint16_t port, L2PortState state)
+{
+    Port& p = m_ports[port];
+    if (p.state == state)
+    {
+        return;
+    }
+    NS_LOG_INFO(m_name << ": Port " << port << " " << StateName(p.state) << " -> "
+               << StateName(state));
+    p.state = state;
+    m_lastChange = Simulator::Now();
+    if (!m_stateChanged.IsNull())
+    {
+        m_stateChanged(port, state);
+    }
+
+    // 非边缘端口进入转发状态: 拓扑变化
+    if (state == L2_PORT_FORWARDING && !p.edge)
+    {
+        TopologyChange(port);
+    }
+}
+
+inline void
+L2Rstp::Sync(uint16_t rootPort)
+{
+    for (uint16_t i = 0; i < m_ports.size(); ++i)
+    {
+        Port& p = m_ports[i];
+        if (i == rootPort || p.edge || p.role != ROLE_DESIGNATED || p.state == L2_PORT_DISCARDING)
+        {
+            continue;
+        }
+        SetState(i, L2_PORT_DISCARDING);
+        p.proposing = true;
+        p.fdEvent.Cancel();
+        p.fdEvent = Simulator::Schedule(m_forwardDelay, &L2Rstp::ForwardDelayExpired, this, i);
+        SendBpdu(i);
+    }
+}
+
+inline void
+L2Rstp::ForwardDelayExpired(uint16_t port)
+{
+    Port& p = m_ports[port];
+    if (p.role != ROLE_DESIGNATED)
+    {
+        return;
+    }
+    if (p.state == L2_PORT_DISCARDING)
+    {
+        SetState(port, L2_PORT_LEARNING);
+        p.fdEvent = Simulator::Schedule(m_forwardDelay, &L2Rstp::ForwardDelayExpired, this, port);
+    }
+    else if (p.state == L2_PORT_LEARNING)
+    {
+        p.proposing = false;
+        SetState(port, L2_PORT_FORWARDING);
+    }
+}
+
+inline void
+L2Rstp::TopologyChange(uint16_t port)
+{
+    ++m_topologyChanges;
+    if (!m_flush.IsNull())
+    {
+        m_flush(port);
+    }
+
+    StartTcWhile(port);
+}
+
+inline void
+L2Rstp::StartTcWhile(uint16_t port)
+{
+    // 在根端口和其他指定端口上发出 TC。
+    // 和标准中的 tcWhile 一样，只有 TC 定时器没在运行的端口才立即发送，
+    // 否则拓扑不一致期间 (例如计数到无穷) TC 会沿着环路无限传播
+    Time now = Simulator::Now();
+    for (uint16_t i = 0; i < m_ports.size(); ++i)
+    {
+        Port& p = m_ports[i];
+        if (i != port && !p.edge && (p.role == ROLE_ROOT || p.role == ROLE_DESIGNATED) &&
+            !(now < p.tcUntil))
+        {
+            p.tcUntil = now + 2 * m_helloTime;
+            SendBpdu(i);
+        }
+    }
+}
+
+inline void
+L2Rstp::SendBpdu(uint16_t port, bool agreement)
+{
+    if (m_send.IsNull())
+    {
+        return;
+    }
+    const Port& p = m_ports[port];
+
+    L2BpduHeader bpdu;
+    uint8_t flags = 0;
+    if (p.proposing && p.role == ROLE_DESIGNATED)
+    {
+        flags |= L2BpduHeader::FLAG_PROPOSAL;
+    }
+    if (agreement)
+    {
+        flags |= L2BpduHeader::FLAG_AGREEMENT;
+    }
+    if (p.state == L2_PORT_LEARNING || p.state == L2_PORT_FORWARDING)
+    {
+        flags |= L2BpduHeader::FLAG_LEARNING;
+    }
+    if (p.state == L2_PORT_FORWARDING)
+    {
+        flags |= L2BpduHeader::FLAG_FORWARDING;
+    }
+    if (Simulator::Now() < p.tcUntil)
+    {
+        flags |= L2BpduHeader::FLAG_TC;
+    }
+    bpdu.SetFlags(flags);
+    switch (p.role)
+    {
+    case ROLE_ROOT:
+        bpdu.SetRole(L2BpduHeader::ROLE_ROOT);
+        break;
+    case ROLE_DESIGNATED:
+        bpdu.SetRole(L2BpduHeader::ROLE_DESIGNATED);
+        break;
+    case ROLE_ALTERNATE:
+    case ROLE_BACKUP:
+        bpdu.SetRole(L2BpduHeader::ROLE_ALTERNATE_BACKUP);
+        break;
+    default:
+        bpdu.SetRole(L2BpduHeader::ROLE_UNKNOWN);
+        break;
+    }
+
+    bpdu.SetRootId(m_rootId);
+    bpdu.SetRootPathCost(m_rootPathCost);
+    bpdu.SetBridgeId(m_bridgeId);
+    bpdu.SetPortId(p.portId);
+
+    // 每经过一个交换机 Message Age 加 1 秒
+    uint16_t messageAge = 0;
+    if (m_rootPort != NO_PORT)
+    {
+        messageAge = m_ports[m_rootPort].infoAge + 256;
+    }
+    bpdu.SetTimers(messageAge, ToTicks(m_maxAge), ToTicks(m_helloTime), ToTicks(m_forwardDelay));
+
+    Ptr<Packet> packet = Create<Packet>();
+    packet->AddHeader(bpdu);
+    m_send(port, packet);
+}
+
+inline void
+L2Rstp::HelloTick()
+{
+    // 检查信息是否过期，并在指定端口上发送周期 BPDU；根端口只在拓扑变化期间发送
+    UpdateRoles();
+    Time now = Simulator::Now();
+    for (uint16_t i = 0; i < m_ports.size(); ++i)
+    {
+        const Port& p = m_ports[i];
+        if (p.edge)
+        {
+            continue;
+        }
+        if (p.role == ROLE_DESIGNATED || (p.role == ROLE_ROOT && now < p.tcUntil))
+        {
+            SendBpdu(i);
+        }
+    }
+    m_helloEvent = Simulator::Schedule(m_helloTime, &L2Rstp::HelloTick, this);
+}
+
+inline uint16_t
+L2Rstp::ToTicks(Time t)
+{
+    int64_t ticks = t.GetMilliSeconds() * 256 / 1000;
+    return static_cast<uint16_t>(std::min<int64_t>(ticks, 0xffff));
+}
+
+inline uint64_t
+L2Rstp::GetBridgeId() const
+{
+    return m_bridgeId;
+}
+
+inline uint64_t
+L2Rstp::GetRootId() const
+{
+    return m_rootId;
+}
+
+inline uint16_t
+L2Rstp::GetRootPort() const
+{
+    return m_rootPort;
+}
+
+inline bool
+L2Rstp::IsRoot() const
+{
+    return m_rootId == m_bridgeId;
+}
+
+inline L2Rstp::PortRole
+L2Rstp::GetPortRole(uint16_t port) const
+{
+    return m_ports[port].role;
+}
+
+inline L2PortState
+L2Rstp::GetPortState(uint16_t port) const
+{
+    return m_ports[port].state;
+}
+
+inline Time
+L2Rstp::GetLastChange() const
+{
+    return m_lastChange;
+}
+
+inline uint32_t
+L2Rstp::GetTopologyChanges() const
+{
+    return m_topologyChanges;
+}
+
+inline void
+L2Rstp::Report(std::ostream& os) const
+{
+    os << m_name << ": bridge " << FormatBridgeId(m_bridgeId) << ", root "
+       << FormatBridgeId(m_rootId) << (IsRoot() ? " (this bridge)" : "") << ", cost "
+       << m_rootPathCost << ", last change at " << m_lastChange.As(Time::MS)
+       << ", topology changes " << m_topologyChanges << std::endl;
+    for (uint16_t i = 0; i < m_ports.size(); ++i)
+    {
+        const Port& p = m_ports[i];
+        os << "  port " << i << ": " << RoleName(p.role) << "/" << StateName(p.state)
+           << (p.edge ? " edge" : "") << ", cost " << p.pathCost << std::endl;
+    }
+}
+
+inline std::string
+L2Rstp::FormatBridgeId(uint64_t id)
+{
+    // 格式: 优先级.MAC，例如 32768.00:00:00:00:00:07
+    std::ostringstream oss;
+    oss << (id >> 48) << "." << L2MacTable::UnpackMac(id & 0xffffffffffffULL);
+    return oss.str();
+}
+
+inline const char*
+L2Rstp::RoleName(PortRole role)
+{
+    switch (role)
+    {
+    case ROLE_ROOT:
+        return "Root";
+    case ROLE_DESIGNATED:
+        return "Designated";
+    case ROLE_ALTERNATE:
+        return "Alternate";
+    case ROLE_BACKUP:
+        return "Backup";
+    default:
+        return "Disabled";
+    }
+}
+
+inline const char*
+L2Rstp::StateName(L2PortState state)
+{
+    switch (state)
+    {
+    case L2_PORT_LEARNING:
+        return "Learning";
+    case L2_PORT_FORWARDING:
+        return "Forwarding";
+    default:
+        return "Discarding";
+    }
+}
+
+} // namespace ns3
+
+#endif /* L2_RSTP_H */
@@ -0,0 +1,165 @@
+/*
+ * ============================================================================
+ * 标题: 风暴控制 (Storm Control)
+ * ============================================================================
+ *
+ * 【设计目的】
+ *   广播、组播和未知单播都要泛洪到 VLAN 内的所有端口。MAC 表容量不足、
+ *   配置错误的环路或者异常主机都可能让这类帧暴增 (广播风暴)，
+ *   不仅占满所有链路，也会让仿真本身慢到无法运行 (每个帧变成 N 个事件)。
+ *
+ *   风暴控制在入端口上为每类泛洪流量设置令牌桶限速:
+ *   - 按帧数 (pps) 和按字节数 (bps) 两个桶，两个都有足够令牌才放行
+ *   - 超过限速的帧直接丢弃 (源地址仍然学习)，并按类别计数
+ *   - 已知单播不受限制
+ *
+ * 【令牌桶】
+ *   令牌以 rate 的速度累积，最多累积 depth 个 (允许的突发)。
+ *   令牌数只在有帧到达时按经过的时间补充，不需要定时事件。
+ *
+ * 作者: Liu Mengxuan
+ * ns-3 版本: 3.44
+ * ============================================================================
+ */
+
+#ifndef L2_STORM_CONTROL_H
+#define L2_STORM_CONTROL_H
+
+#include "ns3/core-module.h"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace ns3
+{
+
+/**
+ * @brief 受风暴控制的流量类别
+ */
+enum L2StormClass : uint8_t
+{
+    L2_STORM_BROADCAST,        // 目的地址为广播
+    L2_STORM_MULTICAST,        // 目的地址为组播
+    L2_STORM_UNKNOWN_UNICAST,  // MAC 表中找不到的单播
+    L2_STORM_CLASSES
+};
+
+/**
+ * @brief 令牌桶
+ */
+struct L2TokenBucket
+{
+    double rate = 0.0;    // 每秒补充的令牌数，0 表示不限速
+    double depth = 0.0;   // 桶的容量 (允许的突发)
+    double tokens = 0.0;  // 当前令牌数
+    Time last;            // 上次补充的时刻
+
+    /**
+     * @brief 设置速率和容量，桶装满
+     */
+    void Configure(double newRate, double newDepth, Time now)
+    {
+        rate = newRate;
+        depth = newDepth;
+        tokens = newDepth;
+        last = now;
+    }
+
+    bool IsLimited() const
+    {
+        return rate > 0.0;
+    }
+
+    /**
+     * @brief 按经过的时间补充令牌
+     */
+    void Refill(Time now)
+    {
+        tokens = std::min(depth, tokens + (now - last).GetSeconds() * rate);
+        last = now;
+    }
+};
+
+/**
+ * @brief 一个端口的风暴控制状态: 每个类别一个 pps 桶和一个字节桶
+ */
+class L2StormControl
+{
+public:
+    /**
+     * @brief 设置一个类别的限速
+     * @param cls 流量类别
+     * @param pps 每秒帧数，0 表示不限
+     * @param bps 每秒比特数，0 表示不限
+     * @param burst 允许的突发时长 (桶容量 = 速率 × burst，至少一个帧)
+     * @param now 当前时间
+     */
+    void Set(L2StormClass cls, uint64_t pps, uint64_t bps, Time burst, Time now)
+    {
+        double seconds = burst.GetSeconds();
+        m_packets[cls].Configure(double(pps), std::max(1.0, pps * seconds), now);
+        m_bytes[cls].Configure(bps / 8.0, std::max(1518.0, bps / 8.0 * seconds), now);
+        m_enabled = false;
+        for (int i = 0; i < L2_STORM_CLASSES; ++i)
+        {
+            m_enabled = m_enabled || m_packets[i].IsLimited() || m_bytes[i].IsLimited();
+        }
+    }
+
+    /**
+     * @brief 是否有任何类别设置了限速
+     */
+    bool IsEnabled() const
+    {
+        return m_enabled;
+    }
+
+    /**
+     * @brief 一个帧能否通过 (能通过时扣除令牌)
+     * @param cls 流量类别
+     * @param bytes 帧长 (字节)
+     * @param now 当前时间
+     */
+    bool Admit(L2StormClass cls, uint32_t bytes, Time now)
+    {
+        if (!m_enabled)
+        {
+            return true;
+        }
+        L2TokenBucket& packets = m_packets[cls];
+        L2TokenBucket& octets = m_bytes[cls];
+
+        // 两个桶都够才放行，避免一个桶扣了令牌而帧却被另一个桶丢弃
+        if (packets.IsLimited())
+        {
+            packets.Refill(now);
+            if (packets.tokens < 1.0)
+            {
+                return false;
+            }
+        }
+        if (octets.IsLimited())
+        {
+            octets.Refill(now);
+            if (octets.tokens < bytes)
+            {
+                return false;
+            }
+            octets.tokens -= bytes;
+        }
+        if (packets.IsLimited())
+        {
+            packets.tokens -= 1.0;
+        }
+        return true;
+    }
+
+private:
+    L2TokenBucket m_packets[L2_STORM_CLASSES];  // 按帧数限速
+    L2TokenBucket m_bytes[L2_STORM_CLASSES];    // 按字节数限速
+    bool m_enabled = false;
+};
+
+} // namespace ns3
+
+#endif /* L2_STORM_CONTROL_H */
@@ -0,0 +1,1452 @@
+/*
+ * ============================================================================
+ * 标题: L2 交换机微基准测试 (Micro-benchmark)
+ * ============================================================================
+ *
+ * 【用途】
+ *   在不运行完整仿真的情况下，单独测量交换机内部数据结构和转发逻辑的性能，
+ *   用于对比优化前后的效果。
+ *
+ * 【使用方法】
+ *   ./build/scratch/ns3.44-l2-switch-protocol-default --benchmark=mactable
+ *
+ *   mactable: MAC 地址表学习/查找吞吐量 (1k / 100k / 1M 个 MAC 地址)，
+ *             同时给出原来 std::map<Mac48Address, Ptr<NetDevice>> 的基线数据
+ *   flood:    48 端口交换机上的广播风暴，对比 ZeroCopyForwarding 开/关时
+ *             每个转发帧的 Packet::Copy() 次数和墙钟时间
+ *   inject:   绕过信道和主机，通过桩设备 (L2BenchNetDevice) 直接把合成帧送进
+ *             ReceiveFromDevice，分别改变 MAC 数量、未知单播比例、端口数和广播比例，
+ *             给出每秒处理帧数和每帧的分配次数，只衡量交换逻辑本身
+ *   scale:    用 L2TopologyGenerator 生成逐步变大的 tree / leaf-spine / ring 拓扑，
+ *             给出建网时间、每台交换机的内存、泛洪量和仿真速率，找出扩展性的拐点
+ *   multipath: 4x4 leaf-spine 上跨 leaf 的流量，对比 RSTP (单棵生成树) 和
+ *             链路状态多路径转发 (ECMP) 的吞吐量和上联使用数
+ *   portland: 逐步变大的 Fat-Tree 上，对比 MAC 学习 (RSTP) 和 PortLand 伪 MAC 转发时
+ *             边缘/汇聚/核心交换机的表项数和泛洪量
+ *   flowtable: 先检查流表精确表项与通配表项的优先级语义 (不符合时退出码为 1)，
+ *             再测量精确命中时有/没有更高优先级通配表项的查找代价
+ *
+ *   编译时定义 L2_SWITCH_BENCH_COUNT_ALLOCS 会替换全局 operator new，
+ *   inject 额外统计每帧的堆分配次数 (会影响整个程序，只用于基准测试构建)。
+ *
+ * 【注意】
+ *   本文件依赖 l2-switch-protocol.cc 中的类定义和 l2-topology.h，
+ *   必须在 L2SwitchProtocol / L2SwitchHelper 定义之后 include。
+ *
+ * 作者: Liu Mengxuan
+ * ns-3 版本: 3.44
+ * ============================================================================
+ */
+
+#ifndef L2_SWITCH_BENCHMARK_H
+#define L2_SWITCH_BENCHMARK_H
+
+#include "l2-mac-table.h"
+
+#include "ns3/core-module.h"
+#include "ns3/csma-module.h"
+#include "ns3/network-module.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <new>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+// ============================================================================
+// 可选: 统计堆分配次数
+// ============================================================================
+
+#ifdef L2_SWITCH_BENCH_COUNT_ALLOCS
+static uint64_t g_l2BenchAllocs = 0;
+
+void*
+operator new(std::size_t size)
+{
+    ++g_l2BenchAllocs;
+    if (void* p = std::malloc(size ? size : 1))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void
+operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void
+operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+#endif
+
+namespace ns3
+{
+
+// ============================================================================
+// 公共工具
+// ============================================================================
+
+/**
+ * @brief 简单的墙钟计时器 (steady_clock)
+ */
+class L2BenchTimer
+{
+public:
+    L2BenchTimer()
+        : m_start(std::chrono::steady_clock::now())
+    {
+    }
+
+    double Seconds() const
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count();
+    }
+
+private:
+    std::chrono::steady_clock::time_point m_start;
+};
+
+/**
+ * @brief 生成第 i 个测试用 MAC 地址 (本地管理地址 02:xx:xx:xx:xx:xx，连续递增)
+ *
+ * ns-3 的 Mac48Address::Allocate() 也是连续分配的，这里保持相同的分布特征。
+ */
+inline uint64_t
+L2BenchMacKey(uint32_t i)
+{
+    return 0x020000000000ULL | (uint64_t(i) + 1);
+}
+
+/**
+ * @brief 目前为止的堆分配次数 (没有定义 L2_SWITCH_BENCH_COUNT_ALLOCS 时总是 0)
+ */
+inline uint64_t
+L2BenchAllocations()
+{
+#ifdef L2_SWITCH_BENCH_COUNT_ALLOCS
+    return g_l2BenchAllocs;
+#else
+    return 0;
+#endif
+}
+
+/**
+ * @brief 每秒操作数，按百万次输出
+ */
+inline double
+L2BenchMops(uint64_t ops, double seconds)
+{
+    return seconds > 0 ? ops / seconds / 1e6 : 0.0;
+}
+
+// ============================================================================
+// 基准 1: MAC 地址表
+// ============================================================================
+//
+// 对每种规模 N 测量:
+//   learn(new)      - 依次学习 N 个新地址 (包含扩容开销)
+//   learn(refresh)  - 随机顺序重复学习已有地址 (每帧都会发生的刷新)
+//   lookup(hit)     - 随机查找已学习的地址 (已知单播)
+//   lookup(miss)    - 查找不存在的地址 (未知单播，触发泛洪)
+//
+// ============================================================================
+
+inline void
+RunMacTableBenchmark()
+{
+    const uint32_t sizes[] = {1000, 100000, 1000000};
+    const uint32_t kOps = 4000000;  // 每项 refresh/lookup 测试的操作次数
+    const uint16_t kPorts = 48;     // 模拟 48 端口交换机
+
+    std::mt19937_64 rng(12345);
+
+    // 基线: 原来的 std::map 实现需要真实的 Ptr<NetDevice>
+    std::vector<Ptr<NetDevice>> devices;
+    for (uint16_t p = 0; p < kPorts; ++p)
+    {
+        devices.push_back(CreateObject<SimpleNetDevice>());
+    }
+
+    std::printf("\n=== MAC table micro-benchmark (%u ops per lookup/refresh test) ===\n", kOps);
+    std::printf("%-10s %9s %14s %16s %14s %15s %12s\n",
+                "table", "MACs", "learn(new)M/s", "learn(refr)M/s",
+                "lookup(hit)M/s", "lookup(miss)M/s", "bytes/entry");
+
+    for (uint32_t n : sizes)
+    {
+        // 预先生成键和随机访问序列，避免把随机数生成的开销算进去
+        std::vector<uint64_t> keys(n);
+        for (uint32_t i = 0; i < n; ++i)
+        {
+            keys[i] = L2BenchMacKey(i);
+        }
+        std::vector<uint32_t> insertOrder(n);
+        std::iota(insertOrder.begin(), insertOrder.end(), 0);
+        std::shuffle(insertOrder.begin(), insertOrder.end(), rng);
+
+        std::vector<uint32_t> accessOrder(kOps);
+        for (auto& idx : accessOrder)
+        {
+            idx = static_cast<uint32_t>(rng() % n);
+        }
+
+        // 未知地址: 换一个 OUI，保证一定查不到
+        std::vector<uint64_t> missKeys(kOps);
+        for (uint32_t i = 0; i < kOps; ++i)
+        {
+            missKeys[i] = 0x0a0000000000ULL | (rng() & 0xffffffffffULL);
+        }
+
+        uint64_t sink = 0;
+
+        // ----- 开放寻址哈希表 -----
+        {
+            L2MacTable table;
+            L2BenchTimer t1;
+            for (uint32_t i : insertOrder)
+            {
+                table.Learn(keys[i], static_cast<uint16_t>(i % kPorts));
+            }
+            double learnNew = t1.Seconds();
+
+            L2BenchTimer t2;
+            for (uint32_t i : accessOrder)
+            {
+                sink += table.Learn(keys[i], static_cast<uint16_t>(i % kPorts));
+            }
+            double learnRefresh = t2.Seconds();
+
+            L2BenchTimer t3;
+            for (uint32_t i : accessOrder)
+            {
+                sink += table.Lookup(keys[i]);
+            }
+            double lookupHit = t3.Seconds();
+
+            L2BenchTimer t4;
+            for (uint64_t k : missKeys)
+            {
+                sink += table.Lookup(k);
+            }
+            double lookupMiss = t4.Seconds();
+
+            std::printf("%-10s %9u %14.2f %16.2f %14.2f %15.2f %12.1f\n",
+                        "flat-hash", n,
+                        L2BenchMops(n, learnNew), L2BenchMops(kOps, learnRefresh),
+                        L2BenchMops(kOps, lookupHit), L2BenchMops(kOps, lookupMiss),
+                        16.0 * table.GetCapacity() / table.GetSize());
+        }
+
+        // ----- 基线: std::map<Mac48Address, Ptr<NetDevice>> -----
+        {
+            std::vector<Mac48Address> macs(n);
+            for (uint32_t i = 0; i < n; ++i)
+            {
+                macs[i] = L2MacTable::UnpackMac(keys[i]);
+            }
+            std::vector<Mac48Address> missMacs(kOps);
+            for (uint32_t i = 0; i < kOps; ++i)
+            {
+                missMacs[i] = L2MacTable::UnpackMac(missKeys[i]);
+            }
+
+            std::map<Mac48Address, Ptr<NetDevice>> table;
+            L2BenchTimer t1;
+            for (uint32_t i : insertOrder)
+            {
+                table[macs[i]] = devices[i % kPorts];
+            }
+            double learnNew = t1.Seconds();
+
+            L2BenchTimer t2;
+            for (uint32_t i : accessOrder)
+            {
+                // 与原 Learn() 相同: find，端口变化时才写回
+                auto it = table.find(macs[i]);
+                if (it == table.end())
+                {
+                    table[macs[i]] = devices[i % kPorts];
+                }
+                else if (it->second != devices[i % kPorts])
+                {
+                    it->second = devices[i % kPorts];
+                }
+                ++sink;
+            }
+            double learnRefresh = t2.Seconds();
+
+            L2BenchTimer t3;
+            for (uint32_t i : accessOrder)
+            {
+                auto it = table.find(macs[i]);
+                Ptr<NetDevice> dev = (it != table.end()) ? it->second : nullptr;
+                sink += (dev != nullptr);
+            }
+            double lookupHit = t3.Seconds();
+
+            L2BenchTimer t4;
+            for (const auto& mac : missMacs)
+            {
+                auto it = table.find(mac);
+                Ptr<NetDevice> dev = (it != table.end()) ? it->second : nullptr;
+                sink += (dev != nullptr);
+            }
+            double lookupMiss = t4.Seconds();
+
+            // 红黑树节点: 3 个指针 + 颜色 + Mac48Address + Ptr，按 libstdc++ 的布局估算
+            double nodeBytes = 4 * sizeof(void*) + sizeof(Mac48Address) + sizeof(Ptr<NetDevice>);
+            std::printf("%-10s %9u %14.2f %16.2f %14.2f %15.2f %12.1f\n",
+                        "std::map", n,
+                        L2BenchMops(n, learnNew), L2BenchMops(kOps, learnRefresh),
+                        L2BenchMops(kOps, lookupHit), L2BenchMops(kOps, lookupMiss),
+                        nodeBytes);
+        }
+
+        // 防止编译器把整个循环优化掉
+        if (sink == 42)
+        {
+            std::printf("#");
+        }
+    }
+    std::printf("\n");
+}
+
+// ============================================================================
+// 基准 2: 广播风暴 (泛洪转发)
+// ============================================================================
+//
+// 一个 48 端口交换机，每个端口通过 CSMA 链路连接一个主机。每个主机周期性地
+// 直接在设备上发送广播帧 (主机不安装协议栈)，交换机把每一帧泛洪到其余 47 个端口。
+// 交换机节点上没有三层协议栈，开启 ZeroCopyForwarding 时入帧可以直接复用。
+//
+// ============================================================================
+
+/**
+ * @brief 一次广播风暴仿真的结果
+ */
+struct L2FloodResult
+{
+    double seconds;           // Simulator::Run() 的墙钟时间
+    uint64_t frames;          // 交换机转发的帧数
+    uint64_t copies;          // 交换机调用 Packet::Copy() 的次数
+};
+
+/**
+ * @brief 主机发送一个广播帧，并调度下一次发送
+ */
+inline void
+L2FloodSend(Ptr<NetDevice> device, uint32_t remaining, Time interval)
+{
+    device->Send(Create<Packet>(64), Mac48Address::GetBroadcast(), 0x88B6);
+    if (remaining > 1)
+    {
+        Simulator::Schedule(interval, &L2FloodSend, device, remaining - 1, interval);
+    }
+}
+
+inline L2FloodResult
+RunFloodScenario(bool zeroCopy, uint32_t ports, uint32_t framesPerHost)
+{
+    Config::SetDefault("ns3::L2SwitchProtocol::ZeroCopyForwarding", BooleanValue(zeroCopy));
+
+    Ptr<Node> sw = CreateObject<Node>();
+    NodeContainer hosts;
+    hosts.Create(ports);
+
+    CsmaHelper csma;
+    csma.SetChannelAttribute("DataRate", StringValue("10Gbps"));
+    csma.SetChannelAttribute("Delay", TimeValue(NanoSeconds(100)));
+
+    std::vector<Ptr<NetDevice>> hostDevices;
+    for (uint32_t i = 0; i < ports; ++i)
+    {
+        NetDeviceContainer devices = csma.Install(NodeContainer(hosts.Get(i), sw));
+        hostDevices.push_back(devices.Get(0));
+    }
+
+    L2SwitchHelper switchHelper;
+    switchHelper.Install(sw, "FloodSwitch");
+    Ptr<L2SwitchProtocol> protocol = sw->GetObject<L2SwitchProtocol>();
+    protocol->Initialize();
+
+    // 主机错开发送时间，避免 CSMA 链路上的冲突退避占主导
+    const Time interval = MicroSeconds(100);
+    for (uint32_t i = 0; i < ports; ++i)
+    {
+        Time start = MicroSeconds(10) + NanoSeconds(interval.GetNanoSeconds() * i / ports);
+        Simulator::Schedule(start, &L2FloodSend, hostDevices[i], framesPerHost, interval);
+    }
+
+    L2BenchTimer timer;
+    Simulator::Run();
+    L2FloodResult result{timer.Seconds(), protocol->GetForwardedFrames(), protocol->GetPacketCopies()};
+    Simulator::Destroy();
+    return result;
+}
+
+inline void
+RunFloodBenchmark()
+{
+    const uint32_t kPorts = 48;
+    const uint32_t kFramesPerHost = 500;
+
+    std::printf("\n=== Broadcast flood benchmark (%u-port switch, %u broadcasts per host) ===\n",
+                kPorts, kFramesPerHost);
+    std::printf("%-10s %10s %12s %12s %10s\n", "forwarding", "frames", "copies", "copies/frame",
+                "wall(s)");
+
+    L2FloodResult results[2];
+    for (int zeroCopy = 0; zeroCopy < 2; ++zeroCopy)
+    {
+        results[zeroCopy] = RunFloodScenario(zeroCopy != 0, kPorts, kFramesPerHost);
+        const L2FloodResult& r = results[zeroCopy];
+        std::printf("%-10s %10llu %12llu %12.2f %10.3f\n",
+                    zeroCopy ? "zero-copy" : "copy",
+                    static_cast<unsigned long long>(r.frames),
+                    static_cast<unsigned long long>(r.copies),
+                    r.frames ? double(r.copies) / r.frames : 0.0,
+                    r.seconds);
+    }
+
+    const L2FloodResult& copy = results[0];
+    const L2FloodResult& zero = results[1];
+    if (copy.frames > 0 && zero.frames > 0 && zero.seconds > 0)
+    {
+        std::printf("saved %.2f packet allocations per forwarded frame, wall-clock speedup %.2fx\n",
+                    double(copy.copies) / copy.frames - double(zero.copies) / zero.frames,
+                    copy.seconds / zero.seconds);
+    }
+    std::printf("\n");
+
+    // 恢复默认值，避免影响之后在同一进程里创建的交换机
+    Config::SetDefault("ns3::L2SwitchProtocol::ZeroCopyForwarding", BooleanValue(true));
+}
+
+// ============================================================================
+// 基准 3: 直接注入 (只测交换逻辑)
+// ============================================================================
+//
+// 交换机的每个端口是一个桩设备 (L2BenchNetDevice): 没有信道、队列和对端，
+// SendFrom() 只计数。基准直接调用桩设备上注册的混杂回调，也就是
+// L2SwitchProtocol::ReceiveFromDevice，测到的时间只包含交换机自己的处理:
+// 分类、学习、查表、泛洪集合计算和 Packet 复制。
+//
+// 每个场景先让所有主机 MAC 各发一帧完成学习，然后按固定随机种子生成帧序列:
+//   - 源地址: 从主机 MAC 中随机选择 (每个主机固定在一个端口上)
+//   - 目的地址: 按比例选择广播、未知单播 (不存在的地址) 或已知单播
+// 同一个 Packet 对象被反复注入，帧的创建不计入分配次数。
+//
+// ============================================================================
+
+/**
+ * @brief 基准用的桩网络设备: 接收由基准直接注入，发送只计数
+ */
+class L2BenchNetDevice : public NetDevice
+{
+public:
+    static TypeId GetTypeId()
+    {
+        static TypeId tid = TypeId("ns3::L2BenchNetDevice")
+            .SetParent<NetDevice>()
+            .SetGroupName("Network")
+            .AddConstructor<L2BenchNetDevice>();
+        return tid;
+    }
+
+    /**
+     * @brief 模拟设备收到一个帧: 直接调用混杂回调
+     */
+    void Inject(Ptr<const Packet> packet,
+                uint16_t protocol,
+                const Address& source,
+                const Address& destination,
+                PacketType packetType)
+    {
+        m_promiscCallback(this, packet, protocol, source, destination, packetType);
+    }
+
+    uint64_t GetTxFrames() const
+    {
+        return m_txFrames;
+    }
+
+    void SetIfIndex(const uint32_t index) override { m_ifIndex = index; }
+    uint32_t GetIfIndex() const override { return m_ifIndex; }
+    Ptr<Channel> GetChannel() const override { return nullptr; }
+    void SetAddress(Address address) override { m_address = Mac48Address::ConvertFrom(address); }
+    Address GetAddress() const override { return m_address; }
+    bool SetMtu(const uint16_t mtu) override { return mtu == 1500; }
+    uint16_t GetMtu() const override { return 1500; }
+    bool IsLinkUp() const override { return true; }
+    void AddLinkChangeCallback(Callback<void> callback) override {}
+    bool IsBroadcast() const override { return true; }
+    Address GetBroadcast() const override { return Mac48Address::GetBroadcast(); }
+    bool IsMulticast() const override { return true; }
+    Address GetMulticast(Ipv4Address group) const override { return Mac48Address::GetMulticast(group); }
+    Address GetMulticast(Ipv6Address addr) const override { return Mac48Address::GetMulticast(addr); }
+    bool IsBridge() const override { return false; }
+    bool IsPointToPoint() const override { return false; }
+    bool Send(Ptr<Packet> packet, const Address& dest, uint16_t protocol) override
+    {
+        ++m_txFrames;
+        return true;
+    }
+    bool SendFrom(Ptr<Packet> packet,
+                  const Address& source,
+                  const Address& dest,
+                  uint16_t protocol) override
+    {
+        ++m_txFrames;
+        return true;
+    }
+    Ptr<Node> GetNode() const override { return m_node; }
+    void SetNode(Ptr<Node> node) override { m_node = node; }
+    bool NeedsArp() const override { return false; }
+    void SetReceiveCallback(NetDevice::ReceiveCallback cb) override {}
+    void SetPromiscReceiveCallback(NetDevice::PromiscReceiveCallback cb) override
+    {
+        m_promiscCallback = cb;
+    }
+    bool SupportsSendFrom() const override { return true; }
+
+protected:
+    void DoDispose() override
+    {
+        m_node = nullptr;
+        m_promiscCallback = MakeNullCallback<bool, Ptr<NetDevice>, Ptr<const Packet>, uint16_t,
+                                             const Address&, const Address&, PacketType>();
+        NetDevice::DoDispose();
+    }
+
+private:
+    Ptr<Node> m_node;
+    Mac48Address m_address;
+    uint32_t m_ifIndex = 0;
+    uint64_t m_txFrames = 0;
+    NetDevice::PromiscReceiveCallback m_promiscCallback;
+};
+
+/**
+ * @brief 一个直接注入场景的参数
+ */
+struct L2InjectScenario
+{
+    uint32_t ports;          // 交换机端口数
+    uint32_t macs;           // 主机 MAC 数量 (平均分布在各端口上)
+    double unknownRatio;     // 目的地址是未知单播的比例
+    double broadcastRatio;   // 目的地址是广播的比例
+};
+
+/**
+ * @brief 一个直接注入场景的结果
+ */
+struct L2InjectResult
+{
+    double seconds;          // 注入阶段的墙钟时间
+    uint64_t frames;         // 注入的帧数
+    uint64_t txFrames;       // 所有出端口的发送次数
+    uint64_t copies;         // 交换机调用 Packet::Copy() 的次数
+    uint64_t allocations;    // 堆分配次数 (需要 L2_SWITCH_BENCH_COUNT_ALLOCS)
+};
+
+inline L2InjectResult
+RunInjectScenario(const L2InjectScenario& scenario, uint32_t frames)
+{
+    Ptr<Node> sw = CreateObject<Node>();
+    std::vector<Ptr<L2BenchNetDevice>> devices;
+    for (uint32_t i = 0; i < scenario.ports; ++i)
+    {
+        Ptr<L2BenchNetDevice> device = CreateObject<L2BenchNetDevice>();
+        device->SetAddress(Mac48Address::Allocate());
+        sw->AddDevice(device);
+        devices.push_back(device);
+    }
+
+    L2SwitchHelper switchHelper;
+    switchHelper.Install(sw, "InjectSwitch");
+    Ptr<L2SwitchProtocol> protocol = sw->GetObject<L2SwitchProtocol>();
+    protocol->Initialize();
+
+    // 地址都预先转换成 Address，避免把转换开销算进去
+    std::vector<Address> hosts(scenario.macs);
+    for (uint32_t i = 0; i < scenario.macs; ++i)
+    {
+        hosts[i] = L2MacTable::UnpackMac(L2BenchMacKey(i));
+    }
+    const Address broadcast = Mac48Address::GetBroadcast();
+    const uint16_t kProtocol = 0x88B6;
+    Ptr<Packet> packet = Create<Packet>(64);
+
+    // 学习阶段: 每个主机发一帧给下一个主机
+    for (uint32_t i = 0; i < scenario.macs; ++i)
+    {
+        devices[i % scenario.ports]->Inject(packet, kProtocol, hosts[i],
+                                            hosts[(i + 1) % scenario.macs],
+                                            NetDevice::PACKET_OTHERHOST);
+    }
+
+    // 帧序列
+    struct Frame
+    {
+        uint32_t src;
+        uint32_t kind;  // 0 = 已知单播，1 = 未知单播，2 = 广播
+        uint32_t dst;
+    };
+    std::mt19937_64 rng(4242);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    std::vector<Frame> sequence(frames);
+    std::vector<Address> unknown(std::min<uint32_t>(frames, 4096));
+    for (uint32_t i = 0; i < unknown.size(); ++i)
+    {
+        unknown[i] = L2MacTable::UnpackMac(0x0a0000000000ULL | (rng() & 0xffffffffffULL));
+    }
+    for (auto& f : sequence)
+    {
+        f.src = static_cast<uint32_t>(rng() % scenario.macs);
+        double r = uniform(rng);
+        if (r < scenario.broadcastRatio)
+        {
+            f.kind = 2;
+            f.dst = 0;
+        }
+        else if (r < scenario.broadcastRatio + scenario.unknownRatio)
+        {
+            f.kind = 1;
+            f.dst = static_cast<uint32_t>(rng() % unknown.size());
+        }
+        else
+        {
+            f.kind = 0;
+            f.dst = static_cast<uint32_t>(rng() % scenario.macs);
+        }
+    }
+
+    uint64_t txBefore = 0;
+    for (const auto& device : devices)
+    {
+        txBefore += device->GetTxFrames();
+    }
+    uint64_t copiesBefore = protocol->GetPacketCopies();
+    uint64_t allocsBefore = L2BenchAllocations();
+
+    L2BenchTimer timer;
+    for (const Frame& f : sequence)
+    {
+        const Address& dst = (f.kind == 0) ? hosts[f.dst] : (f.kind == 1) ? unknown[f.dst] : broadcast;
+        devices[f.src % scenario.ports]->Inject(packet, kProtocol, hosts[f.src], dst,
+                                                f.kind == 2 ? NetDevice::PACKET_BROADCAST
+                                                            : NetDevice::PACKET_OTHERHOST);
+    }
+    double seconds = timer.Seconds();
+
+    L2InjectResult result{seconds, frames, 0, protocol->GetPacketCopies() - copiesBefore,
+                          L2BenchAllocations() - allocsBefore};
+    for (const auto& device : devices)
+    {
+        result.txFrames += device->GetTxFrames();
+    }
+    result.txFrames -= txBefore;
+
+    Simulator::Destroy();
+    return result;
+}
+
+inline void
+RunInjectBenchmark()
+{
+    const uint32_t kFrames = 1000000;
+
+    // 基线 48 端口 / 10k MAC / 全部已知单播，每组只改变一个维度
+    const L2InjectScenario scenarios[] = {
+        {48, 10000, 0.0, 0.0},
+        {48, 1000, 0.0, 0.0},
+        {48, 100000, 0.0, 0.0},
+        {48, 1000000, 0.0, 0.0},
+        {48, 10000, 0.01, 0.0},
+        {48, 10000, 0.10, 0.0},
+        {48, 10000, 0.0, 0.01},
+        {48, 10000, 0.0, 0.10},
+        {8, 10000, 0.0, 0.0},
+        {8, 10000, 0.0, 0.10},
+        {128, 10000, 0.0, 0.0},
+        {128, 10000, 0.0, 0.10},
+    };
+
+    std::printf("\n=== Direct-injection forwarding benchmark (%u frames per scenario) ===\n",
+                kFrames);
+    std::printf("%6s %8s %8s %7s %10s %9s %9s %12s %12s\n", "ports", "MACs", "unknown",
+                "bcast", "Mframes/s", "ns/frame", "tx/frame", "copies/frame", "allocs/frame");
+
+    for (const auto& scenario : scenarios)
+    {
+        L2InjectResult r = RunInjectScenario(scenario, kFrames);
+        char allocs[32];
+#ifdef L2_SWITCH_BENCH_COUNT_ALLOCS
+        std::snprintf(allocs, sizeof(allocs), "%.2f", double(r.allocations) / r.frames);
+#else
+        std::snprintf(allocs, sizeof(allocs), "n/a");
+#endif
+        std::printf("%6u %8u %7.0f%% %6.0f%% %10.2f %9.1f %9.2f %12.2f %12s\n",
+                    scenario.ports, scenario.macs,
+                    scenario.unknownRatio * 100, scenario.broadcastRatio * 100,
+                    L2BenchMops(r.frames, r.seconds), r.seconds * 1e9 / r.frames,
+                    double(r.txFrames) / r.frames, double(r.copies) / r.frames, allocs);
+    }
+    std::printf("\n");
+}
+
+// ============================================================================
+// 基准 4: 大规模拓扑的扩展性
+// ============================================================================
+//
+// 用 L2TopologyGenerator 生成逐步变大的 tree / leaf-spine / ring 拓扑，主机不安装
+// 协议栈，直接在设备上发送 64 字节的帧:
+//   阶段 1 (学习): 每个主机向一个随机主机发一帧，目的地址还没有被学到，泛洪到全网
+//   阶段 2 (稳态): 1 秒后每个主机再向随机主机发 kFramesPerHost 帧，此时所有地址都已学到
+// 有环路的拓扑先等 RSTP 收敛 (kRstpSettle) 再开始发送。
+//
+// 对每个拓扑给出:
+//   setup      生成节点、链路、安装并初始化交换机的墙钟时间
+//   KB/switch  整个拓扑 (交换机连同它下面的主机和链路) 占用的常驻内存平均到每台交换机
+//   learnKB    其中仿真运行期间增长的部分 (MAC 表等)，平均到每台交换机
+//   flood      所有交换机泛洪发出的副本数，以及平均每个主机帧引起的泛洪副本数
+//   rate       Simulator::Run() 每秒墙钟处理的事件数和交换机转发的帧数
+//
+// 同一类拓扑中某一级的运行时间超过 kBudget 时跳过更大的规模: 表的最后一行就是
+// 这类拓扑在当前机器上开始不可用的规模。
+//
+// ============================================================================
+
+/**
+ * @brief 进程当前的常驻内存 (KB)，不支持的平台返回 0
+ */
+inline uint64_t
+L2BenchResidentKb()
+{
+#ifdef __linux__
+    std::ifstream statm("/proc/self/statm");
+    uint64_t size = 0;
+    uint64_t resident = 0;
+    if (statm >> size >> resident)
+    {
+        return resident * static_cast<uint64_t>(sysconf(_SC_PAGESIZE)) / 1024;
+    }
+#endif
+    return 0;
+}
+
+/**
+ * @brief 一个扩展性场景的结果
+ */
+struct L2ScaleResult
+{
+    uint32_t switches;
+    uint32_t hosts;
+    uint32_t links;
+    double setupSeconds;    // 生成拓扑的墙钟时间
+    double runSeconds;      // Simulator::Run() 的墙钟时间
+    uint64_t totalKb;       // 生成拓扑到仿真结束的常驻内存增量
+    uint64_t runKb;         // 其中 Simulator::Run() 期间的增量
+    uint64_t hostFrames;    // 主机发出的帧数
+    uint64_t flooded;       // 交换机泛洪发出的副本数
+    uint64_t unicast;       // 交换机单播发出的帧数
+    uint64_t forwarded;     // 交换机转发的帧数 (每个入帧计一次)
+    uint64_t events;        // 执行的仿真事件数
+};
+
+/**
+ * @brief 主机向随机主机发送 count 帧，间隔 interval
+ */
+inline void
+L2ScaleSend(Ptr<NetDevice> device, const std::vector<Address>* hosts, uint32_t self,
+            uint32_t count, Time interval, uint32_t seed)
+{
+    // 线性同余序列，每个主机固定种子，结果可复现
+    uint32_t next = seed * 1664525u + 1013904223u;
+    uint32_t dst = next % hosts->size();
+    if (dst == self)
+    {
+        dst = (dst + 1) % hosts->size();
+    }
+    device->Send(Create<Packet>(64), (*hosts)[dst], 0x88B6);
+    if (count > 1)
+    {
+        Simulator::Schedule(interval, &L2ScaleSend, device, hosts, self, count - 1, interval, next);
+    }
+}
+
+inline L2ScaleResult
+RunScaleScenario(const L2TopologyConfig& config, uint32_t framesPerHost)
+{
+    const Time kRstpSettle = Seconds(3);
+    const Time kSpread = MilliSeconds(100);  // 每个阶段的发送分散在这段时间内
+
+    L2ScaleResult result{};
+    uint64_t rssBefore = L2BenchResidentKb();
+
+    L2BenchTimer setupTimer;
+    L2Topology topology = L2TopologyGenerator::Build(config);
+    result.setupSeconds = setupTimer.Seconds();
+    result.switches = topology.switches.GetN();
+    result.hosts = topology.hosts.GetN();
+    result.links = topology.links;
+
+    uint64_t rssTopology = L2BenchResidentKb();
+
+    std::vector<Address> addresses(result.hosts);
+    for (uint32_t h = 0; h < result.hosts; ++h)
+    {
+        addresses[h] = topology.hostDevices.Get(h)->GetAddress();
+    }
+
+    Time start = topology.loops ? kRstpSettle : MilliSeconds(10);
+    Time interval = kSpread / std::max<uint32_t>(framesPerHost, 1);
+    for (uint32_t h = 0; h < result.hosts; ++h)
+    {
+        Time offset = NanoSeconds(kSpread.GetNanoSeconds() * h / result.hosts);
+        Ptr<NetDevice> device = topology.hostDevices.Get(h);
+        Simulator::Schedule(start + offset, &L2ScaleSend, device, &addresses, h, 1, kSpread,
+                            h + 1);
+        Simulator::Schedule(start + Seconds(1) + offset, &L2ScaleSend, device, &addresses, h,
+                            framesPerHost, interval, (h + 1) * 7919u);
+    }
+    result.hostFrames = uint64_t(result.hosts) * (1 + framesPerHost);
+
+    Simulator::Stop(start + Seconds(2));
+    uint64_t eventsBefore = Simulator::GetEventCount();
+    L2BenchTimer runTimer;
+    Simulator::Run();
+    result.runSeconds = runTimer.Seconds();
+    result.events = Simulator::GetEventCount() - eventsBefore;
+
+    // 前一个场景释放的内存可能被复用，增量为负时记为 0
+    uint64_t rssAfter = L2BenchResidentKb();
+    result.totalKb = (rssAfter > rssBefore) ? rssAfter - rssBefore : 0;
+    result.runKb = (rssAfter > rssTopology) ? rssAfter - rssTopology : 0;
+
+    for (uint32_t i = 0; i < result.switches; ++i)
+    {
+        Ptr<L2SwitchProtocol> protocol = topology.switches.Get(i)->GetObject<L2SwitchProtocol>();
+        result.forwarded += protocol->GetForwardedFrames();
+        for (uint16_t p = 0; p < protocol->GetNPorts(); ++p)
+        {
+            L2SwitchProtocol::PortCounters c = protocol->GetPortCounters(p);
+            result.flooded += c.txFlooded;
+            result.unicast += c.txUnicast;
+        }
+    }
+
+    Simulator::Destroy();
+    return result;
+}
+
+inline void
+RunScaleBenchmark()
+{
+    const uint32_t kFramesPerHost = 4;
+    const double kBudget = 120.0;  // 单个场景的墙钟预算 (秒)，超过后跳过同类更大的规模
+
+    auto tree = [](uint32_t depth, uint32_t fanout, uint32_t hosts) {
+        L2TopologyConfig c;
+        c.type = L2TopologyConfig::TREE;
+        c.depth = depth;
+        c.fanout = fanout;
+        c.hostsPerSwitch = hosts;
+        return c;
+    };
+    auto leafSpine = [](uint32_t spines, uint32_t leaves, uint32_t hosts) {
+        L2TopologyConfig c;
+        c.type = L2TopologyConfig::LEAF_SPINE;
+        c.spines = spines;
+        c.leaves = leaves;
+        c.hostsPerSwitch = hosts;
+        return c;
+    };
+    auto ring = [](uint32_t switches, uint32_t hosts) {
+        L2TopologyConfig c;
+        c.type = L2TopologyConfig::RING;
+        c.ringSwitches = switches;
+        c.hostsPerSwitch = hosts;
+        return c;
+    };
+
+    // 每类拓扑从小到大，最大一级是几百台交换机、上万个主机
+    const std::vector<std::vector<L2TopologyConfig>> ladders = {
+        {tree(2, 4, 16), tree(3, 4, 16), tree(3, 8, 16), tree(3, 8, 40)},
+        {leafSpine(2, 8, 16), leafSpine(4, 32, 32), leafSpine(8, 128, 32), leafSpine(16, 256, 48)},
+        {ring(8, 16), ring(16, 32), ring(32, 64)},
+    };
+
+    std::printf("\n=== Scaling benchmark (1 learning frame + %u frames per host, budget %.0f s) ===\n",
+                kFramesPerHost, kBudget);
+    std::printf("%-18s %8s %7s %6s %8s %10s %8s %12s %11s %9s %10s %11s\n", "topology",
+                "switches", "hosts", "links", "setup(s)", "KB/switch", "learnKB", "flooded",
+                "flood/frame", "wall(s)", "kevents/s", "kframes/s");
+
+    for (const auto& ladder : ladders)
+    {
+        for (const L2TopologyConfig& config : ladder)
+        {
+            L2ScaleResult r = RunScaleScenario(config, kFramesPerHost);
+            std::printf("%-18s %8u %7u %6u %8.2f %10.1f %8.1f %12llu %11.1f %9.2f %10.1f %11.1f\n",
+                        L2TopologyGenerator::Describe(config).c_str(), r.switches, r.hosts,
+                        r.links, r.setupSeconds, double(r.totalKb) / r.switches,
+                        double(r.runKb) / r.switches,
+                        static_cast<unsigned long long>(r.flooded),
+                        r.hostFrames ? double(r.flooded) / r.hostFrames : 0.0, r.runSeconds,
+                        r.runSeconds > 0 ? r.events / r.runSeconds / 1e3 : 0.0,
+                        r.runSeconds > 0 ? r.forwarded / r.runSeconds / 1e3 : 0.0);
+            std::fflush(stdout);
+            if (r.setupSeconds + r.runSeconds > kBudget)
+            {
+                std::printf("%-18s over budget, skipping larger sizes\n", "");
+                break;
+            }
+        }
+    }
+    std::printf("\n");
+}
+
+// ============================================================================
+// 多路径转发: ECMP 与生成树的吞吐量对比
+// ============================================================================
+//
+// leaf-spine 拓扑 (4 spine x 4 leaf，每台 leaf 8 个主机，所有链路 1Gbps)，
+// 每个主机以固定速率向下一台 leaf 上同一位置的主机发送帧，所有流量都要经过 spine。
+// 每台 leaf 的上联总带宽是 4Gbps: RSTP 只留下一条上联，多路径转发按 ECMP 使用全部上联。
+//
+// ============================================================================
+
+/**
+ * @brief 一次多路径对比场景的结果
+ */
+struct L2MultipathResult
+{
+    double offeredMbps;    // 主机发出的总速率
+    double deliveredMbps;  // 目的主机收到的总速率
+    uint32_t uplinksUsed;  // 承载了单播流量的 leaf 上联数
+    uint32_t uplinks;      // leaf 上联总数
+    Time converged;        // 生成树或链路状态协议最后一次变化的时间
+    double runSeconds;     // Simulator::Run() 的墙钟时间
+};
+
+static uint64_t g_l2MultipathRxBytes = 0;
+
+/**
+ * @brief 主机节点的协议处理函数: 只统计发给自己的帧
+ */
+inline void
+L2MultipathReceive(Ptr<NetDevice> device,
+                   Ptr<const Packet> packet,
+                   uint16_t protocol,
+                   const Address& from,
+                   const Address& to,
+                   NetDevice::PacketType packetType)
+{
+    if (packetType == NetDevice::PACKET_HOST)
+    {
+        g_l2MultipathRxBytes += packet->GetSize();
+    }
+}
+
+/**
+ * @brief 主机每隔 interval 向 destination 发送一帧，直到 stop
+ */
+inline void
+L2MultipathSend(Ptr<NetDevice> device, Address destination, uint32_t size, Time interval, Time stop)
+{
+    device->Send(Create<Packet>(size), destination, 0x88B6);
+    if (Simulator::Now() + interval < stop)
+    {
+        Simulator::Schedule(interval, &L2MultipathSend, device, destination, size, interval, stop);
+    }
+}
+
+inline L2MultipathResult
+RunMultipathScenario(bool multipath)
+{
+    const uint32_t kSpines = 4;
+    const uint32_t kLeaves = 4;
+    const uint32_t kHostsPerLeaf = 8;
+    const uint32_t kFrameSize = 1400;
+    const DataRate kHostRate("300Mbps");
+    const Time kStart = Seconds(3);           // RSTP 已经收敛
+    const Time kWarmup = MilliSeconds(50);    // 每条流的第一个帧泛洪，之后都已学习
+    const Time kDuration = MilliSeconds(500); // 测量窗口
+
+    L2TopologyConfig config;
+    config.type = L2TopologyConfig::LEAF_SPINE;
+    config.spines = kSpines;
+    config.leaves = kLeaves;
+    config.hostsPerSwitch = kHostsPerLeaf;
+    config.dataRate = "1Gbps";
+    config.multipath = multipath;
+    L2Topology topology = L2TopologyGenerator::Build(config);
+
+    // 主机 h 在 leaf h / kHostsPerLeaf 上，发往下一台 leaf 上同一位置的主机
+    uint32_t nHosts = topology.hosts.GetN();
+    Time interval = kHostRate.CalculateBytesTxTime(kFrameSize);
+    Time stop = kStart + kWarmup + kDuration;
+    for (uint32_t h = 0; h < nHosts; ++h)
+    {
+        Ptr<NetDevice> device = topology.hostDevices.Get(h);
+        topology.hosts.Get(h)->RegisterProtocolHandler(MakeCallback(&L2MultipathReceive), 0x88B6,
+                                                       device, false);
+        uint32_t dst = (h + kHostsPerLeaf) % nHosts;
+        Simulator::Schedule(kStart + NanoSeconds(997 * h), &L2MultipathSend, device,
+                            topology.hostDevices.Get(dst)->GetAddress(), kFrameSize, interval, stop);
+    }
+
+    uint64_t delivered = 0;
+    Simulator::Schedule(kStart + kWarmup, []() { g_l2MultipathRxBytes = 0; });
+    Simulator::Schedule(stop, [&delivered]() { delivered = g_l2MultipathRxBytes; });
+    Simulator::Stop(stop + MilliSeconds(1));
+
+    L2BenchTimer runTimer;
+    Simulator::Run();
+
+    L2MultipathResult result{};
+    result.runSeconds = runTimer.Seconds();
+    result.offeredMbps = double(nHosts) * kHostRate.GetBitRate() / 1e6;
+    result.deliveredMbps = double(delivered) * 8 / kDuration.GetSeconds() / 1e6;
+    for (uint32_t i = 0; i < topology.switches.GetN(); ++i)
+    {
+        Ptr<L2SwitchProtocol> protocol = topology.switches.Get(i)->GetObject<L2SwitchProtocol>();
+        Time last = protocol->GetRstp() ? protocol->GetRstp()->GetLastChange()
+                                        : protocol->GetLinkState()->GetLastChange();
+        result.converged = std::max(result.converged, last);
+
+        // leaf 的端口 0..spines-1 是上联
+        if (i >= kSpines)
+        {
+            for (uint16_t p = 0; p < kSpines; ++p)
+            {
+                result.uplinksUsed += protocol->GetPortCounters(p).txUnicast > 0 ? 1 : 0;
+                ++result.uplinks;
+            }
+        }
+    }
+
+    Simulator::Destroy();
+    return result;
+}
+
+inline void
+RunMultipathBenchmark()
+{
+    std::printf("\n=== Multipath benchmark (leaf-spine 4x4, 8 hosts per leaf, 1Gbps links, "
+                "300Mbps per host to the next leaf) ===\n");
+    std::printf("%-10s %14s %16s %10s %13s %14s %9s\n", "mode", "offered(Mbps)",
+                "delivered(Mbps)", "delivered", "uplinks used", "converged(ms)", "wall(s)");
+
+    double baseline = 0.0;
+    for (bool multipath : {false, true})
+    {
+        L2MultipathResult r = RunMultipathScenario(multipath);
+        std::printf("%-10s %14.0f %16.1f %9.1f%% %8u/%-4u %14.1f %9.2f\n",
+                    multipath ? "multipath" : "rstp", r.offeredMbps, r.deliveredMbps,
+                    100.0 * r.deliveredMbps / r.offeredMbps, r.uplinksUsed, r.uplinks,
+                    r.converged.GetSeconds() * 1e3, r.runSeconds);
+        std::fflush(stdout);
+        if (!multipath)
+        {
+            baseline = r.deliveredMbps;
+        }
+        else if (baseline > 0)
+        {
+            std::printf("multipath delivers %.2fx the RSTP throughput\n", r.deliveredMbps / baseline);
+        }
+    }
+    std::printf("\n");
+}
+
+// ============================================================================
+// PortLand: 每台交换机的转发状态与主机数的关系
+// ============================================================================
+//
+// k 叉 Fat-Tree，每台边缘交换机 k/2 个主机。每个主机先发一个免费 ARP (宣告自己的 IP)，
+// 1 秒后向随机主机发送单播帧。MAC 学习时免费 ARP 沿生成树泛洪，每台交换机最终记住所有主机；
+// PortLand 时免费 ARP 只在结构管理器登记，单播帧的目的地址是从结构管理器查到的 PMAC
+// (相当于主机已经完成了 ARP)。
+//
+// ============================================================================
+
+/**
+ * @brief 一次 Fat-Tree 场景的结果
+ */
+struct L2PortlandResult
+{
+    uint32_t switches;
+    uint32_t hosts;
+    uint32_t edgeState;      // 边缘交换机的最大表项数
+    uint32_t aggState;       // 汇聚交换机的最大表项数
+    uint32_t coreState;      // 核心交换机的最大表项数
+    uint32_t managerHosts;   // 结构管理器登记的主机数 (只有 PortLand)
+    uint64_t flooded;        // 交换机泛洪发出的副本数
+    uint64_t sent;           // 主机发出的单播帧数
+    uint64_t delivered;      // 目的主机收到的单播帧数
+    double runSeconds;       // Simulator::Run() 的墙钟时间
+};
+
+static uint64_t g_l2PortlandRxFrames = 0;
+
+/**
+ * @brief 主机节点的协议处理函数: 只统计发给自己的帧
+ */
+inline void
+L2PortlandReceive(Ptr<NetDevice> device,
+                  Ptr<const Packet> packet,
+                  uint16_t protocol,
+                  const Address& from,
+                  const Address& to,
+                  NetDevice::PacketType packetType)
+{
+    if (packetType == NetDevice::PACKET_HOST)
+    {
+        ++g_l2PortlandRxFrames;
+    }
+}
+
+/**
+ * @brief 主机发送免费 ARP，宣告 ip 在自己的地址上
+ */
+inline void
+L2PortlandAnnounce(Ptr<NetDevice> device, Ipv4Address ip)
+{
+    ArpHeader arp;
+    arp.SetRequest(device->GetAddress(), ip, Mac48Address::GetBroadcast(), ip);
+    Ptr<Packet> packet = Create<Packet>();
+    packet->AddHeader(arp);
+    device->Send(packet, Mac48Address::GetBroadcast(), 0x0806);
+}
+
+inline L2PortlandResult
+RunPortlandScenario(uint32_t k, bool portland)
+{
+    const uint32_t kFramesPerHost = 4;
+    const Time kStart = Seconds(3);           // RSTP 已经收敛
+    const Time kSpread = MilliSeconds(100);   // 每个阶段的发送分散在这段时间内
+
+    L2TopologyConfig config;
+    config.type = L2TopologyConfig::FAT_TREE;
+    config.k = k;
+    config.hostsPerSwitch = k / 2;
+    config.portland = portland;
+    L2Topology topology = L2TopologyGenerator::Build(config);
+
+    L2PortlandResult result{};
+    result.switches = topology.switches.GetN();
+    result.hosts = topology.hosts.GetN();
+
+    // 主机没有协议栈，IP 地址只出现在免费 ARP 中: 主机 h 是 10.0.0.0 + h + 1
+    auto hostIp = [](uint32_t h) { return Ipv4Address(0x0a000001 + h); };
+    for (uint32_t h = 0; h < result.hosts; ++h)
+    {
+        Ptr<NetDevice> device = topology.hostDevices.Get(h);
+        topology.hosts.Get(h)->RegisterProtocolHandler(MakeCallback(&L2PortlandReceive), 0x88B6,
+                                                       device, false);
+        Time offset = NanoSeconds(kSpread.GetNanoSeconds() * h / result.hosts);
+        Simulator::Schedule(kStart + offset, &L2PortlandAnnounce, device, hostIp(h));
+    }
+
+    // 第二阶段开始时确定目的地址: PortLand 向结构管理器查询 PMAC，MAC 学习直接用真实地址
+    std::vector<Address> destinations(result.hosts);
+    Simulator::Schedule(kStart + Seconds(1), [&]() {
+        for (uint32_t h = 0; h < result.hosts; ++h)
+        {
+            Mac48Address pmac;
+            destinations[h] = (topology.fabricManager &&
+                               topology.fabricManager->Resolve(hostIp(h), pmac))
+                                  ? Address(pmac)
+                                  : topology.hostDevices.Get(h)->GetAddress();
+        }
+        Time interval = kSpread / kFramesPerHost;
+        for (uint32_t h = 0; h < result.hosts; ++h)
+        {
+            Time offset = NanoSeconds(kSpread.GetNanoSeconds() * h / result.hosts);
+            Simulator::Schedule(offset, &L2ScaleSend, topology.hostDevices.Get(h), &destinations, h,
+                                kFramesPerHost, interval, (h + 1) * 7919u);
+        }
+    });
+    result.sent = uint64_t(result.hosts) * kFramesPerHost;
+
+    g_l2PortlandRxFrames = 0;
+    Simulator::Stop(kStart + Seconds(2));
+    L2BenchTimer runTimer;
+    Simulator::Run();
+    result.runSeconds = runTimer.Seconds();
+    result.delivered = g_l2PortlandRxFrames;
+
+    // 交换机下标: pod p 的边缘交换机 p*k .. p*k+k/2-1，汇聚交换机随后，最后是核心交换机
+    for (uint32_t i = 0; i < result.switches; ++i)
+    {
+        Ptr<L2SwitchProtocol> protocol = topology.switches.Get(i)->GetObject<L2SwitchProtocol>();
+        uint32_t state = 0;
+        if (protocol->IsPortlandEnabled())
+        {
+            const L2PortlandTable& table = protocol->GetPortlandTable();
+            state = table.GetNHosts() + table.GetNRoutes();
+        }
+        else
+        {
+            state = static_cast<uint32_t>(protocol->GetMacEntries().size());
+        }
+        uint32_t& level = (i >= k * k) ? result.coreState
+                          : (i % k < k / 2) ? result.edgeState
+                                            : result.aggState;
+        level = std::max(level, state);
+
+        for (uint16_t p = 0; p < protocol->GetNPorts(); ++p)
+        {
+            result.flooded += protocol->GetPortCounters(p).txFlooded;
+        }
+    }
+    result.managerHosts = topology.fabricManager ? topology.fabricManager->GetNHosts() : 0;
+
+    Simulator::Destroy();
+    return result;
+}
+
+inline void
+RunPortlandBenchmark()
+{
+    const double kBudget = 120.0;  // 单个场景的墙钟预算 (秒)，超过后跳过更大的 k
+
+    std::printf("\n=== PortLand benchmark (fat-tree, k/2 hosts per edge switch, gratuitous ARP "
+                "then 4 unicast frames per host) ===\n");
+    std::printf("%-4s %7s %8s %-9s %10s %9s %10s %8s %12s %10s %9s\n", "k", "hosts",
+                "switches", "mode", "edge max", "agg max", "core max", "manager", "flooded",
+                "delivered", "wall(s)");
+
+    bool overBudget[2] = {false, false};
+    for (uint32_t k : {4u, 8u, 16u, 24u, 32u})
+    {
+        for (bool portland : {false, true})
+        {
+            if (overBudget[portland])
+            {
+                continue;
+            }
+            L2PortlandResult r = RunPortlandScenario(k, portland);
+            std::printf("%-4u %7u %8u %-9s %10u %9u %10u %8u %12llu %9.1f%% %9.2f\n", k, r.hosts,
+                        r.switches, portland ? "portland" : "learning", r.edgeState, r.aggState,
+                        r.coreState, r.managerHosts, static_cast<unsigned long long>(r.flooded),
+                        r.sent ? 100.0 * r.delivered / r.sent : 0.0, r.runSeconds);
+            std::fflush(stdout);
+            overBudget[portland] = r.runSeconds > kBudget;
+        }
+    }
+    std::printf("\n");
+}
+
+// ============================================================================
+// 流表: 精确表项与通配表项的优先级
+// ============================================================================
+//
+// 先检查两级查找的优先级语义 (任何一项不符合时返回 false，进程退出码为 1):
+//   - 高优先级的通配表项 (ACL 丢弃) 覆盖低优先级的精确表项
+//   - 精确表项的优先级更高或相同时，精确表项生效
+//   - 精确表未命中时按优先级扫描通配表
+// 再测量 N 个精确表项时每秒查找次数: 没有通配表项、通配表项的优先级都更低 (跳过阶段 2)、
+// 有 16 个不匹配的更高优先级通配表项 (每次精确命中都要扫描它们)。
+//
+// ============================================================================
+
+/**
+ * @brief 第 i 个测试流的元组 (UDP，目的地址 10.0.(i/256).(i%256))
+ */
+inline L2FlowKey
+L2BenchFlowKey(uint32_t i)
+{
+    L2FlowKey key;
+    key.ethSrc = L2BenchMacKey(2 * i);
+    key.ethDst = L2BenchMacKey(2 * i + 1);
+    key.ipSrc = 0x0b000000u | i;
+    key.ipDst = 0x0a000000u | (i & 0xffff);
+    key.inPort = static_cast<uint16_t>(i % 48);
+    key.ethType = 0x0800;
+    key.ipProto = 17;
+    key.l4Src = static_cast<uint16_t>(1024 + i % 60000);
+    key.l4Dst = 9;
+    return key;
+}
+
+/**
+ * @brief 只匹配 key 的精确匹配条件
+ */
+inline L2FlowMatch
+L2BenchExactMatch(const L2FlowKey& key)
+{
+    L2FlowMatch match;
+    match.value = key;
+    match.fields = L2FlowMatch::ALL_FIELDS;
+    return match;
+}
+
+inline bool
+RunFlowTableBenchmark()
+{
+    std::printf("\n=== Flow table: exact vs wildcard priority ===\n");
+
+    L2FlowTable table;
+    L2FlowKey blocked = L2BenchFlowKey(1);   // 目的地址被 ACL 丢弃
+    L2FlowKey above = L2BenchFlowKey(2);     // 同一目的地址，精确表项优先级高于 ACL
+    L2FlowKey tie = L2BenchFlowKey(3);       // 同一目的地址，优先级与 ACL 相同
+    L2FlowKey allowed = L2BenchFlowKey(4);   // 其他目的地址的精确表项
+    L2FlowKey unknown = L2BenchFlowKey(5);   // 不在精确表中
+    above.ipDst = tie.ipDst = blocked.ipDst;
+
+    L2FlowMatch acl;
+    acl.SetEthType(0x0800).SetIpDst(Ipv4Address(blocked.ipDst));
+    uint32_t aclId = table.AddFlow(acl, 100, {L2FlowAction::Drop()});
+    uint32_t defaultId = table.AddFlow(L2FlowMatch(), 1, {L2FlowAction::Output(3)});
+    table.AddFlow(L2BenchExactMatch(blocked), 10, {L2FlowAction::Output(1)});
+    uint32_t aboveId = table.AddFlow(L2BenchExactMatch(above), 200, {L2FlowAction::Output(2)});
+    uint32_t tieId = table.AddFlow(L2BenchExactMatch(tie), 100, {L2FlowAction::Output(2)});
+    uint32_t allowedId = table.AddFlow(L2BenchExactMatch(allowed), 10, {L2FlowAction::Output(1)});
+
+    struct Case
+    {
+        const char* name;
+        L2FlowKey key;
+        uint32_t expected;
+    };
+    const Case cases[] = {
+        {"higher-priority wildcard overrides exact", blocked, aclId},
+        {"higher-priority exact overrides wildcard", above, aboveId},
+        {"equal priority: exact wins", tie, tieId},
+        {"exact hit, no overlapping wildcard", allowed, allowedId},
+        {"exact miss falls back to wildcard", unknown, defaultId},
+    };
+    bool ok = true;
+    for (const Case& c : cases)
+    {
+        L2FlowEntry* hit = table.Lookup(c.key, 64);
+        uint32_t got = hit ? hit->id : 0;
+        std::printf("  %-42s flow %u (expected %u) %s\n", c.name, got, c.expected,
+                    got == c.expected ? "ok" : "FAIL");
+        ok = ok && got == c.expected;
+    }
+
+    const uint32_t kEntries = 100000;
+    const uint32_t kOps = 4000000;
+    std::mt19937_64 rng(12345);
+    std::vector<L2FlowKey> keys(kEntries);
+    for (uint32_t i = 0; i < kEntries; ++i)
+    {
+        keys[i] = L2BenchFlowKey(i);
+    }
+    std::vector<uint32_t> accessOrder(kOps);
+    for (auto& idx : accessOrder)
+    {
+        idx = static_cast<uint32_t>(rng() % kEntries);
+    }
+
+    std::printf("\n%-28s %10s %12s %18s\n", "wildcards", "entries", "lookup M/s",
+                "compares/lookup");
+    const char* names[] = {"none", "16 below exact", "16 above exact"};
+    for (int mode = 0; mode < 3; ++mode)
+    {
+        L2FlowTable t;
+        for (const L2FlowKey& key : keys)
+        {
+            t.AddFlow(L2BenchExactMatch(key), 10, {L2FlowAction::Output(1)});
+        }
+        for (uint32_t i = 0; mode > 0 && i < 16; ++i)
+        {
+            // 目的地址在 192.168.0.0/16，不匹配任何测试流
+            L2FlowMatch m;
+            m.SetEthType(0x0800).SetIpDst(Ipv4Address(0xc0a80000u | i));
+            t.AddFlow(m, mode == 1 ? 5 : 100, {L2FlowAction::Drop()});
+        }
+        uint64_t sink = 0;
+        L2BenchTimer timer;
+        for (uint32_t i : accessOrder)
+        {
+            L2FlowEntry* hit = t.Lookup(keys[i], 64);
+            sink += hit ? hit->id : 0;
+        }
+        double seconds = timer.Seconds();
+        L2FlowTable::Stats st = t.GetStats();
+        std::printf("%-28s %10u %12.2f %18.2f\n", names[mode], kEntries,
+                    L2BenchMops(kOps, seconds), double(st.wildcardCompares) / kOps);
+        if (sink == 0)
+        {
+            std::printf("(no hits)\n");
+        }
+    }
+    std::printf("\n");
+    return ok;
+}
+
+// ============================================================================
+// 基准入口
+// ============================================================================
+
+/**
+ * @brief 根据名称运行对应的基准测试
+ * @param name 基准名称 (见文件头说明)
+ * @return 进程退出码
+ */
+inline int
+RunL2Benchmark(const std::string& name)
+{
+    if (name == "mactable")
+    {
+        RunMacTableBenchmark();
+        return 0;
+    }
+    if (name == "flood")
+    {
+        RunFloodBenchmark();
+        return 0;
+    }
+    if (name == "inject")
+    {
+        RunInjectBenchmark();
+        return 0;
+    }
+    if (name == "scale")
+    {
+        RunScaleBenchmark();
+        return 0;
+    }
+    if (name == "multipath")
+    {
+        RunMultipathBenchmark();
+        return 0;
+    }
+    if (name == "portland")
+    {
+        RunPortlandBenchmark();
+        return 0;
+    }
+    if (name == "flowtable")
+    {
+        return RunFlowTableBenchmark() ? 0 : 1;
+    }
+
+    std::cerr << "Unknown benchmark '" << name
+              << "'. Available: mactable, flood, inject, scale, multipath, portland, flowtable"
+              << std::endl;
+    return 1;
+}
+
+} // namespace ns3
+
+#endif /* L2_SWITCH_BENCHMARK_H */
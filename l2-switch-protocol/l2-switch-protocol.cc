@@ -61,12 +61,47 @@
 #include "ns3/internet-module.h"
 #include "ns3/csma-module.h"
 #include "ns3/applications-module.h"
-#include <map>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <unordered_map>
+
+#include "l2-arp-cache.h"
+#include "l2-flow-table.h"
+#include "l2-igmp.h"
+#include "l2-lag.h"
+#include "l2-mac-table.h"
+#include "l2-port-mask.h"
+#include "l2-portland.h"
+#include "l2-storm-control.h"
+#include "l2-timer-wheel.h"
+#include "l2-vlan.h"
 
 using namespace ns3;
 
 NS_LOG_COMPONENT_DEFINE("L2SwitchProtocol");
 
+// 每帧日志 (收到/学习/转发/丢弃)。即使日志没有打开，每帧也要检查一次日志级别；
+// 编译时定义 L2_SWITCH_NO_FRAME_LOG 可以把它们完全去掉，只保留计数器和 trace source。
+// 初始化、端口配置、拓扑变化等低频日志不受影响。
+#ifdef L2_SWITCH_NO_FRAME_LOG
+#define L2_FRAME_LOG_FUNCTION(parameters)
+#define L2_FRAME_LOG_DEBUG(msg)
+#define L2_FRAME_LOG_INFO(msg)
+#else
+#define L2_FRAME_LOG_FUNCTION(parameters) NS_LOG_FUNCTION(parameters)
+#define L2_FRAME_LOG_DEBUG(msg) NS_LOG_DEBUG(msg)
+#define L2_FRAME_LOG_INFO(msg) NS_LOG_INFO(msg)
+#endif
+
+// RSTP、链路状态多路径转发和全双工以太网链路使用上面定义的日志组件，所以在这里 include
+#include "l2-rstp.h"
+#include "l2-multipath.h"
+#include "l2-ethernet.h"
+
 // ============================================================================
 // 【第一部分】自定义 L2 交换协议 (L2SwitchProtocol)
 // ============================================================================
@@ -86,6 +121,146 @@ public:
     // ========== 类型系统 ==========
     static TypeId GetTypeId();
 
+    /**
+     * @brief MAC 表满时对新地址的处理策略
+     */
+    enum FullPolicy
+    {
+        DROP_NEW,      // 不学习新地址 (大多数硬件 CAM 的行为)，发往它的帧继续泛洪
+        EVICT_OLDEST   // 淘汰最久没有出现的表项 (采样近似 LRU)
+    };
+
+    /**
+     * @brief 出端口队列满时的丢弃策略
+     */
+    enum QueueDropPolicy
+    {
+        QUEUE_DROP_TAIL,  // 丢弃新到达的帧
+        QUEUE_DROP_HEAD   // 丢弃队首 (等待最久) 的帧，让新帧入队
+    };
+
+    /**
+     * @brief MAC 表与泛洪统计，用于评估 CAM 容量是否足够
+     */
+    struct MacTableStats
+    {
+        uint64_t learned;          // 新学习的表项数
+        uint64_t agedOut;          // 老化删除的表项数
+        uint64_t evicted;          // 表满时被淘汰的表项数
+        uint64_t rejected;         // 表满时没能学习源地址的帧数
+        uint64_t broadcastFloods;  // 广播帧泛洪次数
+        uint64_t unknownFloods;    // 未知单播泛洪次数
+        uint64_t pressureFloods;   // 其中目的地址因表容量不足 (拒绝/淘汰) 而缺失的次数
+        uint64_t agingFloods;      // 其中目的地址因老化被删除而缺失的次数
+        uint64_t provisioned;      // 控制器下发的静态表项数
+        uint64_t restored;         // 从快照恢复的表项数
+    };
+
+    /**
+     * @brief ARP 抑制统计
+     */
+    struct ArpStats
+    {
+        uint64_t requests;          // 收到的 ARP 请求
+        uint64_t suppressed;        // 由交换机直接回复、没有泛洪的请求
+        uint64_t snooped;           // 新记录的 IP -> MAC 对应关系
+        uint64_t conflicts;         // 同一 IP 被不同 MAC 声明的次数
+        uint64_t floodCopiesSaved;  // 本交换机因此少发出的泛洪副本数
+    };
+
+    /**
+     * @brief IGMP 侦听统计
+     */
+    struct IgmpStats
+    {
+        uint64_t joins;               // 收到的加入记录 (成员报告，IGMPv3 按组记录计)
+        uint64_t leaves;              // 收到的离开记录
+        uint64_t queries;             // 收到的查询
+        uint64_t queriesSent;         // 作为查询器发出的查询 (按端口计)
+        uint64_t registeredFrames;    // 按成员端口转发的组播数据帧
+        uint64_t unregisteredFrames;  // 没有成员记录的组播数据帧
+        uint64_t copiesPruned;        // 与泛洪相比少发出的副本数
+    };
+
+    /**
+     * @brief 链路状态多路径转发统计
+     */
+    struct MultipathStats
+    {
+        uint64_t encapsulated;      // 作为入口封装、按 ECMP 发出的单播帧
+        uint64_t multiDestination;  // 作为入口封装、沿分发树发出的广播/组播/未知单播帧
+        uint64_t transit;           // 作为中间交换机转发的封装帧
+        uint64_t decapsulated;      // 解封装后在本地交付的帧
+        uint64_t rpfDrops;          // 没有通过 RPF 检查的多目的帧
+        uint64_t unreachable;       // 出口交换机不可达或跳数耗尽而丢弃的封装帧
+    };
+
+    /**
+     * @brief PortLand 伪 MAC 转发统计
+     */
+    struct PortlandStats
+    {
+        uint64_t hostsAssigned;  // 分配了 PMAC 的主机 (只有边缘交换机)
+        uint64_t arpResolved;    // 由结构管理器查到、交换机直接回复的 ARP 请求
+        uint64_t arpFlooded;     // 结构管理器查不到、沿广播树发出的 ARP 请求
+        uint64_t upward;         // 按流哈希发往上联的单播帧
+        uint64_t downward;       // 按 PMAC 前缀发往下联的单播帧
+        uint64_t delivered;      // 目的地址改回 AMAC 后交给本地主机的单播帧
+        uint64_t flooded;        // 沿广播树转发的广播/组播帧
+        uint64_t unroutable;     // 没有路由或目的主机不存在而丢弃的帧
+    };
+
+    /**
+     * @brief 每个端口的计数器 (转发路径上只做整数自增，开销可以忽略)
+     */
+    struct PortCounters
+    {
+        uint64_t rxFrames;         // 收到的数据帧 (不含 BPDU)
+        uint64_t txUnicast;        // 单播发出的帧
+        uint64_t txFlooded;        // 泛洪发出的帧
+        uint64_t flooded;          // 从该端口进入、需要泛洪的帧 (广播 + 未知单播)
+        uint64_t learned;          // 在该端口新学习的地址
+        uint64_t moved;            // 从其他端口迁移到该端口的地址
+        uint64_t droppedSamePort;  // 目的地址就在入端口上而丢弃的帧
+        uint64_t droppedFiltered;  // 端口阻塞、VLAN 入口过滤、出端口不可用或流表丢弃的帧
+        uint64_t droppedQueue;     // 出端口队列满而丢弃的帧
+        uint32_t queueHighWater;   // 出端口队列的最大长度 (帧)
+        uint64_t droppedStorm[L2_STORM_CLASSES];  // 风暴控制丢弃的入帧 (按 L2StormClass)
+    };
+
+    /**
+     * @brief 丢弃原因 (Drop trace source 的参数)
+     */
+    enum DropReason
+    {
+        DROP_BLOCKED,         // 入端口处于 Discarding 状态
+        DROP_VLAN,            // 入口过滤: 端口不属于帧的 VLAN
+        DROP_SAME_PORT,       // 目的地址就在入端口上
+        DROP_EGRESS_BLOCKED,  // 出端口不在转发状态或不属于帧的 VLAN
+        DROP_QUEUE_FULL,      // 出端口队列满 (port 参数是出端口)
+        DROP_STORM_CONTROL,   // 入端口的广播/组播/未知单播超过风暴控制限速
+        DROP_FLOW_TABLE,      // 命中的流表项要求丢弃 (DROP 动作或动作列表为空)
+        DROP_MULTIPATH,       // 封装帧来自边缘端口、没有通过 RPF 检查或出口不可达
+        DROP_PORTLAND         // PortLand: 目的 PMAC 没有路由或本地没有这个主机
+    };
+
+    /**
+     * TracedCallback 签名: 收到/发出一个帧
+     * @param packet 数据包 (发出时是交给设备的 Packet)
+     * @param port 端口号
+     */
+    typedef void (*PortPacketCallback)(Ptr<const Packet> packet, uint16_t port);
+
+    /**
+     * TracedCallback 签名: 丢弃一个帧
+     */
+    typedef void (*DropCallback)(Ptr<const Packet> packet, uint16_t port, DropReason reason);
+
+    /**
+     * TracedCallback 签名: 学习到新地址或地址迁移到新端口
+     */
+    typedef void (*LearnCallback)(Mac48Address address, uint16_t vlan, uint16_t port);
+
     L2SwitchProtocol();
     ~L2SwitchProtocol() override;
 
@@ -119,6 +294,331 @@ public:
      */
     void SetSwitchName(const std::string& name);
 
+    /**
+     * @brief 交换机名称
+     */
+    const std::string& GetSwitchName() const;
+
+    /**
+     * @brief 获取 MAC 表与泛洪统计
+     */
+    MacTableStats GetMacTableStats() const;
+
+    /**
+     * @brief 打印 MAC 表占用和表容量压力导致的泛洪
+     * @param os 输出流
+     */
+    void ReportMacTableStats(std::ostream& os) const;
+
+    /**
+     * @brief ARP 抑制统计 (属性 ArpSuppression 为 false 时全为 0)
+     */
+    ArpStats GetArpStats() const;
+
+    // ========== 控制器下发 ==========
+
+    /**
+     * @brief 安装一个静态 MAC 表项 (由 L2SwitchController 在仿真开始前下发)
+     * @param vlan 地址所在的 VLAN
+     * @param address MAC 地址
+     * @param port 出端口 (聚合组成员会换算成逻辑端口)
+     * @return 表满时返回 false
+     *
+     * 静态表项不老化，表满时也不会被淘汰。学习仍然进行: 地址出现在其他端口上时
+     * (主机迁移) 由学习覆盖并恢复老化；拓扑变化时和学到的表项一样被清除，之后重新学习。
+     * 必须在 Initialize() 之后调用。
+     */
+    bool AddStaticMacEntry(uint16_t vlan, Mac48Address address, uint16_t port);
+
+    /**
+     * @brief 向 ARP 抑制缓存写入一个 IP -> MAC 对应关系 (和监听到的一样按 ArpCacheTimeout 老化)
+     * @return 属性 ArpSuppression 为 false 时忽略并返回 false
+     */
+    bool AddStaticArpEntry(uint16_t vlan, Ipv4Address ip, Mac48Address address, uint16_t port);
+
+    // ========== MAC 表快照 ==========
+
+    /**
+     * @brief MAC 表中的一个表项 (用于保存和恢复 MAC 表，见 L2MacSnapshot)
+     */
+    struct MacEntrySnapshot
+    {
+        uint16_t vlan;
+        Mac48Address address;
+        uint16_t port;     // 逻辑端口号
+        bool isStatic;     // 控制器下发的静态表项
+        Time idle;         // 距最后一次学习/刷新的时间 (老化 tick 的整数倍)
+    };
+
+    /**
+     * @brief 导出当前 MAC 表的所有表项
+     */
+    std::vector<MacEntrySnapshot> GetMacEntries() const;
+
+    /**
+     * @brief 老化时钟的当前值 (老化时钟起点 + 当前仿真时间)
+     *
+     * 热启动后老化时钟从快照时间继续，与 Simulator::Now() 相差一个起点；
+     * 保存快照时应记录这个值，再次装入时表项的空闲时间才不会被截短。
+     */
+    Time GetAgingClock() const;
+
+    /**
+     * @brief 把导出的表项装回 MAC 表 (热启动)
+     * @param entries GetMacEntries() 的结果
+     * @param snapshotTime 导出时的老化时钟 (GetAgingClock())，老化时钟从这里继续，表项的空闲时间保持不变
+     * @return 装入的表项数 (端口无效、在当前 AgingTime 下已经过期或表满的表项被跳过)
+     *
+     * 必须在 Initialize() 之后、Simulator::Run() 之前调用。
+     */
+    uint32_t RestoreMacEntries(const std::vector<MacEntrySnapshot>& entries, Time snapshotTime);
+
+    /**
+     * @brief 已转发的帧数 (单播 + 泛洪，每个入帧计一次)
+     */
+    uint64_t GetForwardedFrames() const;
+
+    /**
+     * @brief 转发时调用 Packet::Copy() 的次数
+     */
+    uint64_t GetPacketCopies() const;
+
+    /**
+     * @brief 获取端口计数器
+     * @param port 端口号
+     */
+    PortCounters GetPortCounters(uint16_t port) const;
+
+    /**
+     * @brief 打印每个端口的计数器
+     * @param os 输出流
+     */
+    void ReportPortCounters(std::ostream& os) const;
+
+    /**
+     * @brief 是否启用了交换结构模型 (FabricCapacity 或 ForwardingLatency 不为 0)
+     *
+     * 不启用时帧在混杂回调中直接交给出端口设备 (无限背板、没有交换机内部排队)。
+     */
+    bool IsFabricModelEnabled() const;
+
+    /**
+     * @brief 交换结构忙碌的累计时间，除以仿真时间就是背板利用率
+     */
+    Time GetFabricBusyTime() const;
+
+    // ========== 端口 ==========
+
+    /**
+     * @brief 端口数 (Initialize() 时节点上的设备数)
+     */
+    uint16_t GetNPorts() const;
+
+    /**
+     * @brief 阻塞或放开一个端口
+     *
+     * 阻塞的端口不接收、不学习、不参与泛洪和单播转发。
+     * 状态变化时重新计算所有入端口的泛洪集合。
+     * 启用 RSTP 或多路径转发时端口状态由协议控制，不要手动调用。
+     */
+    void SetPortBlocked(uint16_t port, bool blocked);
+    bool IsPortBlocked(uint16_t port) const;
+
+    /**
+     * @brief 端口当前的转发状态
+     */
+    L2PortState GetPortState(uint16_t port) const;
+
+    // ========== VLAN ==========
+
+    /**
+     * @brief 把端口配置为 Access 端口
+     * @param port 端口号 (设备的 ifIndex)
+     * @param vlan 端口所属的 VLAN，收到的不带标签的帧都属于它，发出的帧不带标签
+     *
+     * 没有配置过的端口都是 VLAN 1 的 Access 端口，此时交换机的行为与不支持 VLAN 时相同。
+     * 可以在 Initialize() 之前调用。
+     */
+    void SetAccessPort(uint16_t port, uint16_t vlan);
+
+    /**
+     * @brief 把端口配置为 Trunk 端口
+     * @param port 端口号
+     * @param vlans 允许通过的 VLAN，发出的帧带 802.1Q 标签
+     * @param nativeVlan Native VLAN: 收到的不带标签的帧属于它，发出时也不带标签；
+     *                   L2VlanTag::NO_VLAN 表示丢弃不带标签的帧
+     */
+    void SetTrunkPort(uint16_t port,
+                      const std::vector<uint16_t>& vlans,
+                      uint16_t nativeVlan = L2VlanTag::DEFAULT_VLAN);
+
+    L2VlanPortMode GetPortVlanMode(uint16_t port) const;
+
+    /**
+     * @brief Access 端口所属的 VLAN，或 Trunk 端口的 Native VLAN
+     */
+    uint16_t GetPortVlan(uint16_t port) const;
+
+    /**
+     * @brief 端口是否属于指定 VLAN
+     */
+    bool IsVlanMember(uint16_t port, uint16_t vlan) const;
+
+    // ========== 风暴控制 ==========
+
+    /**
+     * @brief 设置一个入端口上某类泛洪流量的限速 (覆盖 *StormPps / *StormRate 属性的默认值)
+     * @param port 端口号
+     * @param cls 流量类别 (广播 / 组播 / 未知单播)
+     * @param pps 每秒帧数，0 表示不限
+     * @param rate 速率，0 表示不限
+     *
+     * 可以在 Initialize() 之前调用。
+     */
+    void SetStormControl(uint16_t port, L2StormClass cls, uint64_t pps, DataRate rate);
+
+    // ========== 链路聚合 ==========
+
+    /**
+     * @brief 把几个端口聚合成一个逻辑端口
+     * @param ports 成员端口号 (至少两个，不能已经属于其他聚合组)
+     * @return 逻辑端口号 (成员中最小的端口号)
+     *
+     * MAC 地址学习到逻辑端口上，出端口按 LagHashPolicy 对帧头哈希后选择成员，
+     * 成员链路断开 (设备报告 link down) 时流量转移到其余成员。
+     * 聚合组的 VLAN 配置取逻辑端口的配置。可以在 Initialize() 之前调用。
+     */
+    uint16_t AddLinkAggregation(const std::vector<uint16_t>& ports);
+
+    /**
+     * @brief 物理端口所属的逻辑端口 (不在聚合组中的端口就是它自己)
+     */
+    uint16_t GetLogicalPort(uint16_t port) const;
+
+    /**
+     * @brief 逻辑端口当前可用的成员端口 (不是聚合组时返回它自己)
+     */
+    std::vector<uint16_t> GetActiveLagMembers(uint16_t port) const;
+
+    // ========== 组播 (IGMP 侦听) ==========
+
+    /**
+     * @brief 静态加入组播组 (不老化，也不会被离开报文删除)
+     * @param port 端口号 (聚合组成员会换算成逻辑端口)
+     * @param group 组地址，按对应的组播 MAC 转发 (32 个组共用一个 MAC)
+     * @param vlan 组所在的 VLAN
+     *
+     * 只在属性 IgmpSnooping 为 true 时起作用。可以在 Initialize() 之前调用。
+     */
+    void AddMulticastMember(uint16_t port,
+                            Ipv4Address group,
+                            uint16_t vlan = L2VlanTag::DEFAULT_VLAN);
+
+    /**
+     * @brief 静态指定组播路由器端口 (所有组播数据和 IGMP 报告都发往这里)
+     */
+    void AddMulticastRouterPort(uint16_t port);
+
+    /**
+     * @brief 组播组当前的成员端口 (逻辑端口，不含路由器端口)
+     */
+    std::vector<uint16_t> GetMulticastPorts(uint16_t vlan, Ipv4Address group) const;
+
+    /**
+     * @brief IGMP 侦听统计 (属性 IgmpSnooping 为 false 时全为 0)
+     */
+    IgmpStats GetIgmpStats() const;
+
+    // ========== 流表 (Match-Action) ==========
+
+    /**
+     * @brief 添加一个流表项，流表非空时每个入帧先查流表，未命中再按 MAC 学习转发
+     * @param match 匹配条件 (入端口是物理端口号)
+     * @param priority 优先级，越大越先匹配 (所有字段都精确指定的表项进入精确匹配表，
+     *                 通配表中优先级更高的匹配表项仍然覆盖它)
+     * @param actions 按顺序执行的动作，为空表示丢弃 (输出端口是逻辑端口号)
+     * @return 表项编号，用于 RemoveFlow()
+     */
+    uint32_t AddFlow(const L2FlowMatch& match,
+                     uint16_t priority,
+                     const std::vector<L2FlowAction>& actions);
+
+    /**
+     * @brief 删除一个流表项
+     */
+    bool RemoveFlow(uint32_t id);
+
+    /**
+     * @brief 添加或替换一个组 (GROUP 动作引用)
+     * @param ports 每个桶的输出端口 (逻辑端口号)
+     */
+    void AddFlowGroup(uint32_t id, L2FlowGroup::Type type, const std::vector<uint16_t>& ports);
+
+    /**
+     * @brief 流表 (表项计数器和每个查找阶段的统计)
+     */
+    const L2FlowTable& GetFlowTable() const;
+
+    // ========== 生成树 ==========
+
+    /**
+     * @brief 是否启用了 RSTP (属性 EnableRstp)
+     */
+    bool IsRstpEnabled() const;
+
+    /**
+     * @brief 获取 RSTP 实例，未启用时返回 nullptr
+     */
+    Ptr<L2Rstp> GetRstp() const;
+
+    // ========== 链路状态多路径转发 ==========
+
+    /**
+     * @brief 是否启用了多路径转发 (属性 EnableMultipath)
+     */
+    bool IsMultipathEnabled() const;
+
+    /**
+     * @brief 获取链路状态协议实例，未启用时返回 nullptr
+     */
+    Ptr<L2LinkState> GetLinkState() const;
+
+    /**
+     * @brief 多路径转发统计 (属性 EnableMultipath 为 false 时全为 0)
+     */
+    MultipathStats GetMultipathStats() const;
+
+    // ========== PortLand 伪 MAC 转发 ==========
+
+    /**
+     * @brief 设置交换机在 Fat-Tree 中的位置，启用 PortLand 伪 MAC 转发
+     *
+     * 必须在所有交换机的 Initialize() 之前调用: Initialize() 通过链路读取相邻交换机的位置，
+     * 据此区分主机端口、上联和下联。与 RSTP、多路径转发互斥。
+     *
+     * @param manager 所有交换机共享的结构管理器 (IP -> PMAC 目录)
+     * @param position 边缘/汇聚交换机在 pod 中的位置，核心交换机的编号
+     */
+    void SetPortlandLocation(Ptr<L2FabricManager> manager,
+                             L2PortlandTable::Level level,
+                             uint16_t pod,
+                             uint8_t position);
+
+    /**
+     * @brief 是否启用了 PortLand 伪 MAC 转发
+     */
+    bool IsPortlandEnabled() const;
+
+    /**
+     * @brief PMAC 转发表 (主机和前缀路由)
+     */
+    const L2PortlandTable& GetPortlandTable() const;
+
+    /**
+     * @brief PortLand 转发统计 (未启用时全为 0)
+     */
+    PortlandStats GetPortlandStats() const;
+
 protected:
     void DoDispose() override;
     void DoInitialize() override;
@@ -143,267 +643,3826 @@ private:
 
     /**
      * @brief MAC 地址学习
+     * @param vlan 帧所属的 VLAN
      * @param source 源 MAC 地址
-     * @param inDevice 入端口设备
+     * @param inPort 入端口号 (设备的 ifIndex)
      */
-    void Learn(Mac48Address source, Ptr<NetDevice> inDevice);
+    void Learn(uint16_t vlan, Mac48Address source, uint16_t inPort);
 
     /**
      * @brief 查找学习到的端口
+     * @param vlan 帧所属的 VLAN
      * @param destination 目的 MAC 地址
-     * @return 端口设备，如果未找到返回 nullptr
+     * @return 端口号，如果未找到返回 L2MacTable::NO_PORT
      */
-    Ptr<NetDevice> GetLearnedPort(Mac48Address destination);
+    uint16_t GetLearnedPort(uint16_t vlan, Mac48Address destination) const;
+
+    // ========== MAC 表老化 ==========
 
     /**
-     * @brief 单播转发
-     * @param outDevice 出端口
-     * @param packet 数据包
-     * @param protocol 协议类型
-     * @param destination 目的地址
+     * @brief 当前时间对应的老化 tick
      */
-    void ForwardUnicast(Ptr<NetDevice> outDevice,
-                       Ptr<const Packet> packet,
-                       uint16_t protocol,
-                       const Mac48Address& source,
-                       const Mac48Address& destination);
+    uint32_t GetAgingTick() const;
 
     /**
-     * @brief 广播转发（泛洪）
-     * @param inDevice 入端口（不向它回发）
-     * @param packet 数据包
-     * @param protocol 协议类型
-     * @param destination 目的地址
+     * @brief 为新表项在时间轮上定时
+     * @param key 打包后的 MAC 地址
+     * @param gen 表项代数
+     * @param lastSeen 表项的 lastSeen
      */
-    void ForwardBroadcast(Ptr<NetDevice> inDevice,
-                         Ptr<const Packet> packet,
-                         uint16_t protocol,
-                         const Mac48Address& source,
-                         const Mac48Address& destination);
+    void ScheduleAging(uint64_t key, uint8_t gen, uint32_t lastSeen);
 
-    // ========== 成员变量 ==========
+    /**
+     * @brief 周期性推进时间轮，删除过期的表项
+     *
+     * 整个交换机只有这一个老化事件，而不是每个表项一个事件；
+     * 时间轮为空时停止调度。
+     */
+    void AgingTick();
 
-    std::string m_switchName;                           // 交换机名称
-    Ptr<Node> m_node;                                   // 所属节点
-    std::map<Mac48Address, Ptr<NetDevice>> m_macTable;  // MAC 地址学习表
-    bool m_initialized;                                 // 是否已初始化
-};
+    /**
+     * @brief 记录一个 "被遗忘" 的地址 (表满拒绝/淘汰/老化)，用于统计后续的泛洪原因
+     */
+    void Forget(uint64_t key, uint16_t reason);
 
-// ========== 实现 TypeId ==========
-TypeId
-L2SwitchProtocol::GetTypeId()
-{
-    static TypeId tid = TypeId("ns3::L2SwitchProtocol")
-        .SetParent<Object>()
-        .SetGroupName("Network")
-        .AddConstructor<L2SwitchProtocol>();
-    return tid;
-}
+    /**
+     * @brief 统计一次未知单播泛洪，并根据被遗忘地址记录判断原因
+     * @param key 目的地址的表键 (VLAN + MAC)
+     */
+    void CountUnknownFlood(uint64_t key);
 
-// ========== 构造和析构 ==========
-L2SwitchProtocol::L2SwitchProtocol()
-    : m_switchName("Switch"),
-      m_node(nullptr),
-      m_initialized(false)
-{
-    NS_LOG_FUNCTION(this);
-}
+    // ========== 风暴控制 ==========
 
-L2SwitchProtocol::~L2SwitchProtocol()
-{
-    NS_LOG_FUNCTION(this);
-}
+    /**
+     * @brief 需要泛洪的入帧是否在入端口的风暴控制限速之内，超过时计数并丢弃
+     * @param inPort 入端口号 (物理端口)
+     * @param cls 流量类别
+     * @param packet 入帧
+     * @return true 表示可以泛洪
+     */
+    bool AdmitFlood(uint16_t inPort, L2StormClass cls, Ptr<const Packet> packet);
 
-void
-L2SwitchProtocol::DoDispose()
-{
-    NS_LOG_FUNCTION(this);
-    m_node = nullptr;
-    m_macTable.clear();
-    Object::DoDispose();
+    /**
+     * @brief 按属性和 SetStormControl() 的设置配置所有端口的令牌桶
+     */
+    void ConfigureStormControl();
+
+    // ========== ARP 抑制 ==========
+
+    /**
+     * @brief 监听 ARP 报文，缓存中有请求的目标 IP 时直接回复
+     * @param inPort 入端口号 (物理端口，回复从这里发出)
+     * @param inLogical 入端口所属的逻辑端口
+     * @param packet 入帧 (tagged 时以 802.1Q 标签开头)
+     * @param tagged 入帧是否带标签
+     * @param vlan 帧所属的 VLAN
+     * @param source 帧的源 MAC
+     * @return true 表示已经代为回复，请求不需要再转发
+     */
+    bool HandleArp(uint16_t inPort,
+                   uint16_t inLogical,
+                   Ptr<const Packet> packet,
+                   bool tagged,
+                   uint16_t vlan,
+                   const Mac48Address& source);
+
+    // ========== IGMP 侦听 ==========
+
+    /**
+     * @brief 转发一个组播帧: 按成员端口和路由器端口转发，IGMP 报文先被监听
+     * @param inPort 入端口号 (物理端口)
+     * @param inLogical 入端口所属的逻辑端口
+     */
+    void ForwardMulticast(uint16_t inPort,
+                          uint16_t inLogical,
+                          Ptr<const Packet> packet,
+                          uint16_t protocol,
+                          uint16_t vlan,
+                          bool tagged,
+                          const Mac48Address& source,
+                          const Mac48Address& destination,
+                          bool reuse);
+
+    /**
+     * @brief 按 m_igmpRecords 更新组成员和路由器端口
+     * @param inLogical 收到 IGMP 报文的逻辑端口
+     * @param vlan 报文所属的 VLAN
+     * @param source 报文的源 MAC (查询器选举)
+     * @param sourceIp 报文的 IPv4 源地址
+     * @return true 表示报文是查询 (泛洪给所有主机)，false 表示报告/离开 (只发往路由器端口)
+     */
+    bool SnoopIgmp(uint16_t inLogical,
+                   uint16_t vlan,
+                   const Mac48Address& source,
+                   Ipv4Address sourceIp);
+
+    /**
+     * @brief 把端口加入组播组
+     * @param expires 动态成员的超时时刻 (静态成员忽略)
+     */
+    void JoinGroup(uint16_t vlan, const Mac48Address& group, uint16_t port, Time expires, bool isStatic);
+
+    /**
+     * @brief IGMP 的周期事件: 删除超时的成员和路由器端口，作为查询器时发送查询
+     *
+     * 没有动态状态也不是查询器时停止调度。
+     */
+    void IgmpTick();
+
+    /**
+     * @brief 有动态状态或启用查询器时，确保 IgmpTick 已经调度
+     */
+    void ScheduleIgmpTick();
+
+    /**
+     * @brief 作为查询器，在每个 VLAN 的所有转发端口上发送通用查询
+     */
+    void SendIgmpQuery();
+
+    /**
+     * @brief 在一个逻辑端口上发送查询
+     * @param group 组地址，0.0.0.0 表示通用查询
+     */
+    void SendIgmpQuery(uint16_t port, uint16_t vlan, Ipv4Address group);
+
+    // ========== 流表 ==========
+
+    /**
+     * @brief 查流表并执行命中表项的动作
+     * @param inPort 入端口号 (物理端口)
+     * @param inLogical 入端口所属的逻辑端口
+     * @return true 表示命中 (帧已经按动作处理)，false 表示 table-miss
+     */
+    bool ApplyFlowTable(uint16_t inPort,
+                        uint16_t inLogical,
+                        Ptr<const Packet> packet,
+                        uint16_t protocol,
+                        uint16_t vlan,
+                        bool tagged,
+                        const Mac48Address& source,
+                        const Mac48Address& destination,
+                        bool reuse);
+
+    /**
+     * @brief 执行 OUTPUT 动作: 出端口必须处于转发状态且属于帧的 VLAN
+     * @return 是否发出
+     */
+    bool FlowOutput(uint16_t inPort,
+                    uint16_t inLogical,
+                    uint16_t outPort,
+                    Ptr<const Packet> packet,
+                    uint16_t protocol,
+                    uint16_t vlan,
+                    bool tagged,
+                    const Mac48Address& source,
+                    const Mac48Address& destination,
+                    bool reuse);
+
+    // ========== 转发 ==========
+
+    /**
+     * @brief 入帧在转发后是否不会再被其他人使用，可以直接交给最后一个出端口
+     *
+     * CsmaNetDevice 等设备在混杂回调之后，对 PACKET_OTHERHOST 以外的帧还会把
+     * 同一个 Packet 交给节点的协议栈。只有帧不是发给本机的，或者节点上根本没有
+     * 三层协议栈 (纯交换机节点) 时，原始 Packet 才能安全地复用。
+     */
+    bool CanReuseIngress(NetDevice::PacketType packetType) const;
+
+    /**
+     * @brief 为一个出端口准备要发送的 Packet
+     * @param packet 入帧
+     * @param reuse 为 true 时直接返回入帧本身 (只能用于最后一个出端口)
+     */
+    Ptr<Packet> EgressPacket(Ptr<const Packet> packet, bool reuse);
+
+    /**
+     * @brief 生成标签格式与入帧相反的副本 (加上或去掉 802.1Q 标签)
+     * @param packet 入帧
+     * @param tagged 入帧是否带标签
+     * @param vlan 帧所属的 VLAN
+     * @param protocol 被封装的协议类型
+     */
+    Ptr<Packet> RetagPacket(Ptr<const Packet> packet, bool tagged, uint16_t vlan, uint16_t protocol);
+
+    /**
+     * @brief 单播转发
+     * @param outPort 出端口号
+     * @param packet 数据包 (入帧带标签时包含标签)
+     * @param protocol 协议类型 (去掉标签后的)
+     * @param vlan 帧所属的 VLAN
+     * @param tagged 入帧是否带 802.1Q 标签
+     * @param destination 目的地址
+     * @param reuse 是否可以直接发送入帧而不复制
+     */
+    void ForwardUnicast(uint16_t outPort,
+                       Ptr<const Packet> packet,
+                       uint16_t protocol,
+                       uint16_t vlan,
+                       bool tagged,
+                       const Mac48Address& source,
+                       const Mac48Address& destination,
+                       bool reuse);
+
+    /**
+     * @brief 广播转发（泛洪），只发往同一 VLAN 的成员端口
+     * @param inPort 入端口号（不向它回发）
+     * @param packet 数据包 (入帧带标签时包含标签)
+     * @param protocol 协议类型 (去掉标签后的)
+     * @param vlan 帧所属的 VLAN
+     * @param tagged 入帧是否带 802.1Q 标签
+     * @param destination 目的地址
+     * @param reuse 是否可以把入帧直接交给最后一个出端口
+     * @param egressPorts 不为空时只发往其中的端口 (组播成员端口)
+     */
+    void ForwardBroadcast(uint16_t inPort,
+                         Ptr<const Packet> packet,
+                         uint16_t protocol,
+                         uint16_t vlan,
+                         bool tagged,
+                         const Mac48Address& source,
+                         const Mac48Address& destination,
+                         bool reuse,
+                         const L2PortMask* egressPorts = nullptr);
+
+    // ========== 交换结构与出端口队列 ==========
+
+    /**
+     * @brief 把一个帧交给出端口: 不启用交换结构模型时直接发送，否则经过交换结构进入出端口队列
+     *
+     * 发送计数 (flooded 为 true 时计入 txFlooded，否则计入 txUnicast) 和 Tx trace
+     * 在帧真正交给设备时才记录，被出端口队列丢弃的帧只计为丢弃。
+     */
+    void Transmit(uint16_t outPort,
+                  Ptr<Packet> packet,
+                  const Mac48Address& source,
+                  const Mac48Address& destination,
+                  uint16_t protocol,
+                  bool flooded);
+
+    /**
+     * @brief 帧交给出端口设备: 记录发送计数和 Tx trace，然后发送
+     */
+    void SendToDevice(uint16_t outPort,
+                      Ptr<Packet> packet,
+                      const Mac48Address& source,
+                      const Mac48Address& destination,
+                      uint16_t protocol,
+                      bool flooded);
+
+    /**
+     * @brief 出端口空闲且队列不空时，调度队首帧的发送
+     */
+    void ScheduleDrain(uint16_t port);
+
+    /**
+     * @brief 发送出端口的队首帧，然后调度下一个
+     */
+    void DrainQueue(uint16_t port);
+
+    /**
+     * @brief 端口的链路速率 (bit/s)，未知时返回 0
+     */
+    static uint64_t GetPortRate(Ptr<NetDevice> device);
+
+    // ========== 链路聚合 ==========
+
+    /**
+     * @brief 根据聚合组配置设置每个端口的逻辑端口，并计算可用成员
+     */
+    void RebuildLags();
+
+    /**
+     * @brief 成员设备的链路状态变化 (设备的 link change 回调)
+     */
+    void LinkStateChanged();
+
+    /**
+     * @brief 逻辑端口对应的物理出端口
+     * @param port 逻辑端口号
+     * @param hash 帧的聚合组哈希值
+     * @return 物理端口号，聚合组没有可用成员时返回 L2MacTable::NO_PORT
+     */
+    uint16_t SelectMember(uint16_t port, uint32_t hash) const;
+
+    /**
+     * @brief 重新计算每个入端口的泛洪集合
+     *
+     * 泛洪集合 = 所有端口 - 入端口 - 阻塞端口。
+     * 只在端口状态变化时调用，转发路径上只读取结果。
+     */
+    void RebuildFloodMasks();
+
+    /**
+     * @brief 设置端口的转发状态，并重新计算泛洪集合 (也是 RSTP 的状态回调)
+     */
+    void SetPortState(uint16_t port, L2PortState state);
+
+    // ========== VLAN ==========
+
+    /**
+     * @brief 确定入帧所属的 VLAN (入口过滤)
+     * @param inPort 入端口号
+     * @param packet 入帧
+     * @param protocol [in/out] 入帧的协议类型，带标签时改为被封装的协议类型
+     * @param tagged [out] 入帧是否带标签
+     * @return VLAN ID，端口不属于该 VLAN 时返回 L2VlanTag::NO_VLAN (丢弃)
+     */
+    uint16_t ClassifyVlan(uint16_t inPort, Ptr<const Packet> packet, uint16_t& protocol, bool& tagged);
+
+    /**
+     * @brief 根据端口配置重新计算每个 VLAN 的成员端口和不带标签的出端口
+     */
+    void RebuildVlanMasks();
+
+    /**
+     * @brief 端口的 VLAN 配置变化后，删除在该端口上学到的地址
+     */
+    void FlushPort(uint16_t port);
+
+    // ========== RSTP ==========
+
+    /**
+     * @brief 创建 RSTP 实例并添加所有端口
+     */
+    void StartRstp();
+
+    /**
+     * @brief 通过指定端口发送 BPDU (RSTP 的发送回调)
+     */
+    void SendBpdu(uint16_t port, Ptr<Packet> packet);
+
+    /**
+     * @brief 拓扑变化时清除除 keepPort 以外所有端口上学到的 MAC 地址
+     */
+    void FlushMacTable(uint16_t keepPort);
+
+    /**
+     * @brief 端口是否连接主机 (链路上没有其他启用 RSTP 或多路径转发的交换机)
+     */
+    bool IsEdgePort(Ptr<NetDevice> device) const;
+
+    /**
+     * @brief 按链路速率 (bit/s，聚合组为成员速率之和) 计算 802.1D-2004 推荐的端口路径开销
+     */
+    static uint32_t GetPathCost(uint64_t rate);
+
+    /**
+     * @brief 逻辑端口的速率 (bit/s)，聚合组为所有成员速率之和
+     */
+    uint64_t GetLogicalPortRate(uint16_t port) const;
+
+    // ========== 链路状态多路径转发 ==========
+
+    /**
+     * @brief 创建链路状态协议实例并添加所有端口，连接交换机的端口不再转发原生帧
+     */
+    void StartMultipath();
+
+    /**
+     * @brief 通过指定端口发送控制报文 (链路状态协议的发送回调)
+     */
+    void SendLinkState(uint16_t port, Ptr<Packet> packet);
+
+    /**
+     * @brief 端口收到 Hello，对端是交换机 (链路状态协议的回调): 不再转发原生帧
+     */
+    void SetCorePort(uint16_t port);
+
+    /**
+     * @brief 目的主机在其他交换机上时封装帧，按 ECMP 发往出口交换机
+     * @return false 表示不知道目的主机在哪台交换机上 (或不可达)，由调用者泛洪
+     */
+    bool ForwardToRemote(Ptr<const Packet> packet,
+                         uint16_t protocol,
+                         uint16_t vlan,
+                         bool tagged,
+                         const Mac48Address& source,
+                         const Mac48Address& destination,
+                         bool reuse);
+
+    /**
+     * @brief 把需要泛洪的入帧封装后沿一棵分发树发往所有其他交换机
+     */
+    void FloodToSwitches(Ptr<const Packet> packet,
+                         uint16_t protocol,
+                         uint16_t vlan,
+                         bool tagged,
+                         const Mac48Address& source,
+                         const Mac48Address& destination);
+
+    /**
+     * @brief 处理从核心端口收到的封装帧: 转发、沿分发树复制或在本地解封装
+     */
+    void ReceiveEncapsulated(uint16_t inPort,
+                             uint16_t inLogical,
+                             Ptr<const Packet> packet,
+                             const Mac48Address& source,
+                             const Mac48Address& destination,
+                             bool reuse);
+
+    /**
+     * @brief 解封装并按原生帧的规则转发到本地边缘端口
+     * @param inPort 收到封装帧的核心端口 (它和其他核心端口都不在泛洪集合中)
+     */
+    void DeliverLocal(uint16_t inPort,
+                      Ptr<const Packet> packet,
+                      const L2MultipathHeader& header,
+                      const Mac48Address& source,
+                      const Mac48Address& destination,
+                      bool reuse);
+
+    /**
+     * @brief 在等价下一跳中按熵值选择一个端口发出封装帧
+     */
+    void SendEncapsulated(const std::vector<uint16_t>& hops,
+                          Ptr<Packet> frame,
+                          uint16_t entropy,
+                          const Mac48Address& source,
+                          const Mac48Address& destination);
+
+    /**
+     * @brief 把封装帧发往分发树上除入端口以外的所有树边端口
+     */
+    void SendOnTree(const std::vector<uint16_t>& ports,
+                    uint16_t inLogical,
+                    Ptr<Packet> frame,
+                    uint32_t hash,
+                    const Mac48Address& source,
+                    const Mac48Address& destination);
+
+    /**
+     * @brief 远端主机所在的交换机昵称，不知道或已经过期时返回 L2LinkState::NO_NICKNAME
+     */
+    uint16_t LookupRemoteHost(uint16_t vlan, const Mac48Address& address);
+
+    /**
+     * @brief 从解封装的帧学习远端主机所在的交换机
+     */
+    void LearnRemoteHost(uint16_t vlan, const Mac48Address& address, uint16_t ingress);
+
+    // ========== PortLand 伪 MAC 转发 ==========
+
+    /**
+     * @brief 根据相邻交换机的位置把每个端口登记为主机端口、上联或下联
+     */
+    void StartPortland();
+
+    /**
+     * @brief PortLand 模式下处理所有数据帧: 主机帧改写源地址后按 PMAC 转发
+     */
+    void ReceivePortland(uint16_t inPort,
+                         Ptr<const Packet> packet,
+                         uint16_t protocol,
+                         const Mac48Address& source,
+                         const Mac48Address& destination,
+                         bool reuse);
+
+    /**
+     * @brief 主机发出的 ARP: 登记发送方，向结构管理器查询目标，
+     *        查不到时把发送方硬件地址改写成 PMAC 后转发
+     * @param amac 主机的真实地址 (帧的源地址)
+     * @param pmac 主机的 PMAC
+     */
+    void HandlePortlandArp(uint16_t inPort,
+                           Ptr<const Packet> packet,
+                           const Mac48Address& amac,
+                           const Mac48Address& pmac,
+                           const Mac48Address& destination,
+                           bool reuse);
+
+    /**
+     * @brief 按目的 PMAC 转发 (源地址已经是 PMAC)，广播和组播沿广播树
+     */
+    void ForwardPortland(uint16_t inPort,
+                         Ptr<const Packet> packet,
+                         uint16_t protocol,
+                         const Mac48Address& source,
+                         const Mac48Address& destination,
+                         bool reuse);
+
+    /**
+     * @brief 出端口队列中的一个帧
+     */
+    struct QueuedFrame
+    {
+        Ptr<Packet> packet;
+        Mac48Address source;
+        Mac48Address destination;
+        uint16_t protocol;
+        Time readyAt;  // 穿过交换结构、可以开始发送的时刻
+        bool flooded;  // 发送时计入 txFlooded 还是 txUnicast
+    };
+
+    /**
+     * @brief 端口表中的一项，下标就是端口号 (设备的 ifIndex)
+     */
+    struct Port
+    {
+        Ptr<NetDevice> device;            // 端口对应的设备
+        L2PortState state;                // 转发状态
+        PortCounters counters;            // 端口计数器
+        uint64_t rate;                    // 链路速率 (bit/s)，0 表示未知 (不限速)
+        std::deque<QueuedFrame> queue;    // 出端口队列 (只在启用交换结构模型时使用)
+        Time busyUntil;                   // 端口发送完当前帧的时刻
+        EventId drainEvent;               // 下一次发送队首帧的事件
+        uint16_t logical;                 // 所属的逻辑端口 (不在聚合组中时就是自己)
+        bool lag;                         // 是否属于聚合组
+        L2StormControl storm;             // 入端口风暴控制的令牌桶
+    };
+
+    /**
+     * @brief SetStormControl() 的一次设置 (可以在 Initialize() 之前设置)
+     */
+    struct StormSetting
+    {
+        uint16_t port;
+        L2StormClass cls;
+        uint64_t pps;
+        uint64_t bps;
+    };
+
+    /**
+     * @brief 一个组播组 (VLAN + 组播 MAC) 的成员
+     */
+    struct MulticastGroup
+    {
+        L2PortMask ports;           // 成员端口 (逻辑端口，含静态成员)
+        L2PortMask staticPorts;     // 静态成员，不老化
+        std::vector<Time> expires;  // 动态成员的超时时刻 (按端口号)
+    };
+
+    /**
+     * @brief AddMulticastMember() 的一次设置 (可以在 Initialize() 之前设置)
+     */
+    struct StaticGroup
+    {
+        uint16_t port;
+        uint16_t vlan;
+        Mac48Address group;
+    };
+
+    /**
+     * @brief 端口的 VLAN 配置 (可以在 Initialize() 之前设置，所以不放在 Port 中)
+     */
+    struct PortVlan
+    {
+        L2VlanPortMode mode;          // Access / Trunk
+        uint16_t pvid;                // Access VLAN 或 Native VLAN
+        std::vector<uint16_t> vlans;  // Trunk 允许通过的 VLAN
+    };
+
+    /**
+     * @brief 一个 VLAN 的端口集合
+     */
+    struct VlanPorts
+    {
+        L2PortMask members;   // 成员端口
+        L2PortMask untagged;  // 发出时不带标签的成员端口 (Access 端口和 Native VLAN)
+    };
+
+    // ========== 成员变量 ==========
+
+    std::string m_switchName;                           // 交换机名称
+    Ptr<Node> m_node;                                   // 所属节点
+    L2MacTable m_macTable;                              // MAC 地址学习表 (MAC -> 端口号)
+    bool m_initialized;                                 // 是否已初始化
+    std::vector<Port> m_ports;                          // 端口表 (按端口号)
+    std::vector<L2PortMask> m_floodMasks;               // 每个入端口的泛洪集合
+    std::vector<PortVlan> m_portVlans;                  // 端口的 VLAN 配置 (按端口号)
+    std::unordered_map<uint16_t, VlanPorts> m_vlans;    // 每个 VLAN 的端口集合
+    L2PortMask m_floodSame;                             // 泛洪时复用: 标签格式与入帧相同的出端口
+    L2PortMask m_floodRetag;                            // 泛洪时复用: 需要加/去标签的出端口
+    std::vector<std::vector<uint16_t>> m_lagConfigs;    // 聚合组配置 (可以在 Initialize() 之前设置)
+    std::unordered_map<uint16_t, L2LinkAggregation> m_lags;  // 聚合组 (按逻辑端口号)
+    L2LagHashPolicy m_lagHashPolicy;                    // 选择成员的哈希字段 (属性)
+
+    // 风暴控制 (属性，0 表示不限)
+    uint64_t m_broadcastStormPps;                       // 广播: 每秒帧数
+    DataRate m_broadcastStormRate;                      // 广播: 速率
+    uint64_t m_multicastStormPps;                       // 组播: 每秒帧数
+    DataRate m_multicastStormRate;                      // 组播: 速率
+    uint64_t m_unknownStormPps;                         // 未知单播: 每秒帧数
+    DataRate m_unknownStormRate;                        // 未知单播: 速率
+    Time m_stormBurst;                                  // 允许的突发时长
+    std::vector<StormSetting> m_stormSettings;          // 按端口的设置
+    bool m_stormControl;                                // 是否有端口启用了风暴控制
+
+    // ARP 抑制 (属性)
+    static constexpr uint16_t ARP_PROTOCOL = 0x0806;    // ARP 的 EtherType
+    bool m_arpSuppression;                              // 是否监听 ARP 并代为回复
+    Time m_arpCacheTimeout;                             // ARP 缓存表项的超时时间
+    L2ArpCache m_arpCache;                              // (VLAN, IP) -> MAC
+    ArpStats m_arpStats;                                // ARP 抑制统计
+
+    // IGMP 侦听 (属性)
+    bool m_igmpSnooping;                                // 是否按 IGMP 成员关系转发组播
+    Time m_igmpMembershipTimeout;                       // 成员没有再次报告时的超时时间
+    Time m_igmpLastMemberTime;                          // 收到离开报文后成员的保留时间
+    bool m_igmpQuerier;                                 // 没有其他查询器时由交换机发送查询
+    Time m_igmpQueryInterval;                           // 通用查询的间隔
+    bool m_floodUnregistered;                           // 没有成员记录的组是否泛洪
+    std::unordered_map<uint64_t, MulticastGroup> m_mcastGroups;  // (VLAN, 组 MAC) -> 成员
+    std::vector<StaticGroup> m_staticGroups;            // 静态成员配置
+    std::vector<uint16_t> m_staticRouterPorts;          // 静态路由器端口配置
+    L2PortMask m_routerPorts;                           // 组播路由器端口 (收到查询的端口)
+    std::vector<Time> m_routerExpires;                  // 动态路由器端口的超时时刻 (按端口号)
+    Time m_otherQuerierUntil;                           // 在此之前有其他查询器，本机不发查询
+    Time m_nextQuery;                                   // 下一次发送查询的时刻
+    uint32_t m_startupQueries;                          // 启动阶段剩余的快速查询次数
+    EventId m_igmpEvent;                                // IgmpTick 事件
+    L2PortMask m_mcastEgress;                           // 组播转发时复用: 出端口集合
+    std::vector<uint8_t> m_igmpBuffer;                  // 解析 IGMP 报文时复用的缓冲区
+    std::vector<L2IgmpRecord> m_igmpRecords;            // 解析出的 IGMP 记录
+    IgmpStats m_igmpStats;                              // IGMP 侦听统计
+
+    L2FlowTable m_flowTable;                            // 匹配-动作流表 (为空时不查)
+
+    bool m_enableRstp;                                  // 是否启用 RSTP (属性)
+    Ptr<L2Rstp> m_rstp;                                 // 生成树协议实例
+    bool m_enableMultipath;                             // 是否启用链路状态多路径转发 (属性)
+    Ptr<L2LinkState> m_linkState;                       // 链路状态协议实例
+    L2MacTable m_remoteHosts;                           // 远端主机: (VLAN, MAC) -> 所在交换机的昵称
+    MultipathStats m_multipathStats;                    // 多路径转发统计
+    Ptr<L2FabricManager> m_fabricManager;               // PortLand 结构管理器，为空时不启用
+    L2PortlandTable m_portland;                         // PMAC 转发表
+    std::vector<uint16_t> m_portlandFlood;              // 计算广播树出端口时复用的缓冲区
+    PortlandStats m_portlandStats;                      // PortLand 转发统计
+    bool m_zeroCopy;                                    // 是否复用入帧 (属性 ZeroCopyForwarding)
+    bool m_pureL2;                                      // 节点上没有 IPv4/IPv6 协议栈
+    TracedValue<uint64_t> m_forwardedFrames;            // 已转发的帧数
+    uint64_t m_packetCopies;                            // Packet::Copy() 次数
+
+    // 交换结构与出端口队列 (属性)
+    DataRate m_fabricCapacity;                          // 背板总交换容量，0 表示无限
+    Time m_forwardingLatency;                           // 转发时延 (查表 + 流水线)
+    uint32_t m_egressQueueSize;                         // 出端口队列长度 (帧)
+    QueueDropPolicy m_queueDropPolicy;                  // 出端口队列满时的策略
+    bool m_fabricModel;                                 // 是否启用交换结构模型
+    Time m_fabricFreeAt;                                // 交换结构空闲的时刻
+    Time m_fabricBusy;                                  // 交换结构累计忙碌时间
+
+    // MAC 表容量与老化 (属性)
+    Time m_agingTime;                                   // 表项空闲多久后删除，0 表示不老化
+    Time m_agingGranularity;                            // 时间轮 tick 长度
+    uint32_t m_maxMacEntries;                           // 最大表项数，0 表示不限制
+    FullPolicy m_fullPolicy;                            // 表满时的处理策略
+
+    uint32_t m_agingTicks;                              // 老化时间换算成的 tick 数
+    Time m_agingEpoch;                                  // 老化时钟的起点 (从快照恢复时为快照时间)
+    L2TimerWheel m_agingWheel;                          // 老化时间轮
+    EventId m_agingEvent;                               // 推进时间轮的周期事件
+
+    // 被遗忘地址记录: 端口字段保存遗忘原因 (FORGOTTEN_*)
+    static constexpr uint16_t FORGOTTEN_CAPACITY = 0;   // 表满被拒绝或被淘汰
+    static constexpr uint16_t FORGOTTEN_AGED = 1;       // 老化删除
+    static constexpr uint32_t EVICTION_SAMPLES = 8;     // 近似 LRU 的采样数
+    L2MacTable m_forgotten;
+    MacTableStats m_stats;                              // 统计计数
+
+    // Trace source: 没有连接时每次调用只检查一次回调列表是否为空
+    TracedCallback<Ptr<const Packet>, uint16_t> m_rxTrace;              // 收到数据帧
+    TracedCallback<Ptr<const Packet>, uint16_t> m_txTrace;              // 发出数据帧
+    TracedCallback<Ptr<const Packet>, uint16_t, DropReason> m_dropTrace;  // 丢弃数据帧
+    TracedCallback<Mac48Address, uint16_t, uint16_t> m_learnTrace;      // 学习/迁移地址
+};
+
+NS_OBJECT_ENSURE_REGISTERED(L2SwitchProtocol);
+
+// ========== 实现 TypeId ==========
+TypeId
+L2SwitchProtocol::GetTypeId()
+{
+    static TypeId tid = TypeId("ns3::L2SwitchProtocol")
+        .SetParent<Object>()
+        .SetGroupName("Network")
+        .AddConstructor<L2SwitchProtocol>()
+        .AddAttribute("MacAgingTime",
+                      "Idle time after which a learned MAC entry is removed (0 disables aging)",
+                      TimeValue(Seconds(300)),
+                      MakeTimeAccessor(&L2SwitchProtocol::m_agingTime),
+                      MakeTimeChecker())
+        .AddAttribute("AgingGranularity",
+                      "Tick length of the MAC aging timer wheel",
+                      TimeValue(Seconds(1)),
+                      MakeTimeAccessor(&L2SwitchProtocol::m_agingGranularity),
+                      MakeTimeChecker(NanoSeconds(1)))
+        .AddAttribute("MaxMacEntries",
+                      "Maximum number of MAC table entries, i.e. the CAM size (0 = unlimited)",
+                      UintegerValue(0),
+                      MakeUintegerAccessor(&L2SwitchProtocol::m_maxMacEntries),
+                      MakeUintegerChecker<uint32_t>())
+        .AddAttribute("MacTableFullPolicy",
+                      "What to do with a new source MAC when the table is full",
+                      EnumValue(L2SwitchProtocol::DROP_NEW),
+                      MakeEnumAccessor<FullPolicy>(&L2SwitchProtocol::m_fullPolicy),
+                      MakeEnumChecker(L2SwitchProtocol::DROP_NEW, "DropNew",
+                                      L2SwitchProtocol::EVICT_OLDEST, "EvictOldest"))
+        .AddAttribute("ZeroCopyForwarding",
+                      "Hand the received packet itself to the last egress port instead of a copy, "
+                      "when nothing else on the node will read it",
+                      BooleanValue(true),
+                      MakeBooleanAccessor(&L2SwitchProtocol::m_zeroCopy),
+                      MakeBooleanChecker())
+        .AddAttribute("EnableRstp",
+                      "Run the Rapid Spanning Tree Protocol so that topologies with loops "
+                      "do not cause broadcast storms (timers are attributes of ns3::L2Rstp)",
+                      BooleanValue(false),
+                      MakeBooleanAccessor(&L2SwitchProtocol::m_enableRstp),
+                      MakeBooleanChecker())
+        .AddAttribute("EnableMultipath",
+                      "Forward between switches by link-state shortest-path bridging instead of "
+                      "a spanning tree: ECMP over all equal-cost paths for known unicast, "
+                      "distribution trees for flooding (timers are attributes of ns3::L2LinkState)",
+                      BooleanValue(false),
+                      MakeBooleanAccessor(&L2SwitchProtocol::m_enableMultipath),
+                      MakeBooleanChecker())
+        .AddAttribute("FabricCapacity",
+                      "Aggregate switching capacity of the backplane, shared by all egress "
+                      "copies (0 = infinite)",
+                      DataRateValue(DataRate(0)),
+                      MakeDataRateAccessor(&L2SwitchProtocol::m_fabricCapacity),
+                      MakeDataRateChecker())
+        .AddAttribute("ForwardingLatency",
+                      "Time from leaving the fabric until a frame may be transmitted",
+                      TimeValue(Seconds(0)),
+                      MakeTimeAccessor(&L2SwitchProtocol::m_forwardingLatency),
+                      MakeTimeChecker(Seconds(0)))
+        .AddAttribute("EgressQueueSize",
+                      "Output queue length of each port in frames (used when FabricCapacity or "
+                      "ForwardingLatency is set)",
+                      UintegerValue(100),
+                      MakeUintegerAccessor(&L2SwitchProtocol::m_egressQueueSize),
+                      MakeUintegerChecker<uint32_t>(1))
+        .AddAttribute("EgressDropPolicy",
+                      "Which frame to drop when an output queue is full",
+                      EnumValue(L2SwitchProtocol::QUEUE_DROP_TAIL),
+                      MakeEnumAccessor<QueueDropPolicy>(&L2SwitchProtocol::m_queueDropPolicy),
+                      MakeEnumChecker(L2SwitchProtocol::QUEUE_DROP_TAIL, "DropTail",
+                                      L2SwitchProtocol::QUEUE_DROP_HEAD, "DropHead"))
+        .AddAttribute("BroadcastStormPps",
+                      "Per-port limit on received broadcast frames per second (0 = unlimited)",
+                      UintegerValue(0),
+                      MakeUintegerAccessor(&L2SwitchProtocol::m_broadcastStormPps),
+                      MakeUintegerChecker<uint64_t>())
+        .AddAttribute("BroadcastStormRate",
+                      "Per-port limit on the received broadcast data rate (0 = unlimited)",
+                      DataRateValue(DataRate(0)),
+                      MakeDataRateAccessor(&L2SwitchProtocol::m_broadcastStormRate),
+                      MakeDataRateChecker())
+        .AddAttribute("MulticastStormPps",
+                      "Per-port limit on received multicast frames per second (0 = unlimited)",
+                      UintegerValue(0),
+                      MakeUintegerAccessor(&L2SwitchProtocol::m_multicastStormPps),
+                      MakeUintegerChecker<uint64_t>())
+        .AddAttribute("MulticastStormRate",
+                      "Per-port limit on the received multicast data rate (0 = unlimited)",
+                      DataRateValue(DataRate(0)),
+                      MakeDataRateAccessor(&L2SwitchProtocol::m_multicastStormRate),
+                      MakeDataRateChecker())
+        .AddAttribute("UnknownUnicastStormPps",
+                      "Per-port limit on received unknown-unicast frames per second (0 = unlimited)",
+                      UintegerValue(0),
+                      MakeUintegerAccessor(&L2SwitchProtocol::m_unknownStormPps),
+                      MakeUintegerChecker<uint64_t>())
+        .AddAttribute("UnknownUnicastStormRate",
+                      "Per-port limit on the received unknown-unicast data rate (0 = unlimited)",
+                      DataRateValue(DataRate(0)),
+                      MakeDataRateAccessor(&L2SwitchProtocol::m_unknownStormRate),
+                      MakeDataRateChecker())
+        .AddAttribute("StormControlBurst",
+                      "Burst allowed by the storm-control token buckets, as time at the limit rate",
+                      TimeValue(MilliSeconds(100)),
+                      MakeTimeAccessor(&L2SwitchProtocol::m_stormBurst),
+                      MakeTimeChecker(Seconds(0)))
+        .AddAttribute("ArpSuppression",
+                      "Snoop ARP packets into an IP-to-MAC cache and answer requests for known "
+                      "addresses locally instead of flooding them",
+                      BooleanValue(false),
+                      MakeBooleanAccessor(&L2SwitchProtocol::m_arpSuppression),
+                      MakeBooleanChecker())
+        .AddAttribute("ArpCacheTimeout",
+                      "Time after which an unconfirmed ARP cache entry is no longer used",
+                      TimeValue(Seconds(300)),
+                      MakeTimeAccessor(&L2SwitchProtocol::m_arpCacheTimeout),
+                      MakeTimeChecker(NanoSeconds(1)))
+        .AddAttribute("IgmpSnooping",
+                      "Snoop IGMP reports and forward multicast frames only to member ports "
+                      "and multicast router ports instead of flooding them",
+                      BooleanValue(false),
+                      MakeBooleanAccessor(&L2SwitchProtocol::m_igmpSnooping),
+                      MakeBooleanChecker())
+        .AddAttribute("IgmpMembershipTimeout",
+                      "Time after which a member port that has not reported again leaves the "
+                      "group; also the timeout of learned multicast router ports",
+                      TimeValue(Seconds(260)),
+                      MakeTimeAccessor(&L2SwitchProtocol::m_igmpMembershipTimeout),
+                      MakeTimeChecker(NanoSeconds(1)))
+        .AddAttribute("IgmpLastMemberTime",
+                      "Time a member port stays in the group after a leave message",
+                      TimeValue(Seconds(1)),
+                      MakeTimeAccessor(&L2SwitchProtocol::m_igmpLastMemberTime),
+                      MakeTimeChecker(Seconds(0)))
+        .AddAttribute("IgmpQuerier",
+                      "Send IGMP general queries when no other querier is present",
+                      BooleanValue(false),
+                      MakeBooleanAccessor(&L2SwitchProtocol::m_igmpQuerier),
+                      MakeBooleanChecker())
+        .AddAttribute("IgmpQueryInterval",
+                      "Interval between general queries sent by the switch as querier",
+                      TimeValue(Seconds(125)),
+                      MakeTimeAccessor(&L2SwitchProtocol::m_igmpQueryInterval),
+                      MakeTimeChecker(MilliSeconds(1)))
+        .AddAttribute("FloodUnregisteredMulticast",
+                      "Flood multicast frames for groups without members; otherwise they are "
+                      "sent to multicast router ports only",
+                      BooleanValue(true),
+                      MakeBooleanAccessor(&L2SwitchProtocol::m_floodUnregistered),
+                      MakeBooleanChecker())
+        .AddAttribute("LagHashPolicy",
+                      "Header fields hashed to choose the member link of an aggregated port",
+                      EnumValue(L2_LAG_HASH_L2L3L4),
+                      MakeEnumAccessor<L2LagHashPolicy>(&L2SwitchProtocol::m_lagHashPolicy),
+                      MakeEnumChecker(L2_LAG_HASH_L2, "L2",
+                                      L2_LAG_HASH_L2L3, "L2L3",
+                                      L2_LAG_HASH_L2L3L4, "L2L3L4"))
+        .AddTraceSource("Rx",
+                        "A data frame was received on a port",
+                        MakeTraceSourceAccessor(&L2SwitchProtocol::m_rxTrace),
+                        "ns3::L2SwitchProtocol::PortPacketCallback")
+        .AddTraceSource("Tx",
+                        "A frame was handed to an egress port device (after any egress queue)",
+                        MakeTraceSourceAccessor(&L2SwitchProtocol::m_txTrace),
+                        "ns3::L2SwitchProtocol::PortPacketCallback")
+        .AddTraceSource("Drop",
+                        "A data frame was dropped",
+                        MakeTraceSourceAccessor(&L2SwitchProtocol::m_dropTrace),
+                        "ns3::L2SwitchProtocol::DropCallback")
+        .AddTraceSource("Learn",
+                        "A MAC address was learned on, or moved to, a port",
+                        MakeTraceSourceAccessor(&L2SwitchProtocol::m_learnTrace),
+                        "ns3::L2SwitchProtocol::LearnCallback")
+        .AddTraceSource("ForwardedFrames",
+                        "Number of frames forwarded (unicast or flooded)",
+                        MakeTraceSourceAccessor(&L2SwitchProtocol::m_forwardedFrames),
+                        "ns3::TracedValueCallback::Uint64");
+    return tid;
+}
+
+// ========== 构造和析构 ==========
+L2SwitchProtocol::L2SwitchProtocol()
+    : m_switchName("Switch"),
+      m_node(nullptr),
+      m_initialized(false),
+      m_lagHashPolicy(L2_LAG_HASH_L2L3L4),
+      m_broadcastStormPps(0),
+      m_multicastStormPps(0),
+      m_unknownStormPps(0),
+      m_stormControl(false),
+      m_arpSuppression(false),
+      m_arpStats(),
+      m_igmpSnooping(false),
+      m_igmpQuerier(false),
+      m_floodUnregistered(true),
+      m_startupQueries(0),
+      m_igmpStats(),
+      m_enableRstp(false),
+      m_enableMultipath(false),
+      m_multipathStats(),
+      m_portlandStats(),
+      m_zeroCopy(true),
+      m_pureL2(false),
+      m_forwardedFrames(0),
+      m_packetCopies(0),
+      m_egressQueueSize(100),
+      m_queueDropPolicy(QUEUE_DROP_TAIL),
+      m_fabricModel(false),
+      m_maxMacEntries(0),
+      m_fullPolicy(DROP_NEW),
+      m_agingTicks(0),
+      m_stats()
+{
+    NS_LOG_FUNCTION(this);
+}
+
+L2SwitchProtocol::~L2SwitchProtocol()
+{
+    NS_LOG_FUNCTION(this);
+}
+
+void
+L2SwitchProtocol::DoDispose()
+{
+    NS_LOG_FUNCTION(this);
+    m_agingEvent.Cancel();
+    m_igmpEvent.Cancel();
+    for (auto& port : m_ports)
+    {
+        port.drainEvent.Cancel();
+        port.queue.clear();
+    }
+    if (m_rstp)
+    {
+        m_rstp->Dispose();
+        m_rstp = nullptr;
+    }
+    if (m_linkState)
+    {
+        m_linkState->Dispose();
+        m_linkState = nullptr;
+    }
+    m_remoteHosts.Clear();
+    m_fabricManager = nullptr;
+    m_portland.Clear();
+    m_ports.clear();
+    m_floodMasks.clear();
+    m_vlans.clear();
+    m_lags.clear();
+    m_arpCache.Clear();
+    m_mcastGroups.clear();
+    m_flowTable.Clear();
+    m_node = nullptr;
+    m_macTable.Clear();
+    m_forgotten.Clear();
+    m_agingWheel.Reset(0);
+    Object::DoDispose();
+}
+
+void
+L2SwitchProtocol::DoInitialize()
+{
+    NS_LOG_FUNCTION(this);
+    Object::DoInitialize();
+}
+
+// ========== Getter/Setter ==========
+void
+L2SwitchProtocol::SetNode(Ptr<Node> node)
+{
+    NS_LOG_FUNCTION(this << node);
+    m_node = node;
+}
+
+Ptr<Node>
+L2SwitchProtocol::GetNode() const
+{
+    return m_node;
+}
+
+void
+L2SwitchProtocol::SetSwitchName(const std::string& name)
+{
+    m_switchName = name;
+}
+
+const std::string&
+L2SwitchProtocol::GetSwitchName() const
+{
+    return m_switchName;
+}
+
+// ========== 初始化协议 ==========
+void
+L2SwitchProtocol::Initialize()
+{
+    NS_LOG_FUNCTION(this);
+
+    if (m_initialized)
+    {
+        return;
+    }
+
+    NS_ASSERT_MSG(m_node != nullptr, "Node must be set before Initialize()");
+
+    // MAC 表容量与老化参数 (属性在 CreateObject 后已经设置好)
+    m_macTable.SetMaxEntries(m_maxMacEntries);
+    m_agingTicks = 0;
+    if (m_agingTime.IsStrictlyPositive())
+    {
+        m_agingTicks = static_cast<uint32_t>(
+            std::max<int64_t>(1, m_agingTime.GetTimeStep() / m_agingGranularity.GetTimeStep()));
+    }
+    m_agingWheel.Reset(GetAgingTick());
+    m_arpCache.SetTimeout(m_arpCacheTimeout);
+
+    // 交换结构模型: 设置了背板容量或转发时延时，帧经过交换结构和出端口队列
+    m_fabricModel = (m_fabricCapacity.GetBitRate() > 0 || m_forwardingLatency.IsStrictlyPositive());
+    m_fabricFreeAt = Seconds(0);
+    m_fabricBusy = Seconds(0);
+
+    // 纯交换机节点上没有人会在混杂回调之后读取入帧
+    m_pureL2 = (m_node->GetObject<Ipv4>() == nullptr && m_node->GetObject<Ipv6>() == nullptr);
+
+    // 遍历节点上的所有网络设备
+    uint32_t nDevices = m_node->GetNDevices();
+    NS_LOG_INFO(m_switchName << ": Initializing with " << nDevices << " devices");
+    NS_ASSERT_MSG(nDevices < L2MacTable::NO_PORT, "Too many ports on " << m_switchName);
+
+    // 端口表: 转发时直接按端口号访问，不再经过 Node::GetDevice()
+    m_ports.clear();
+    m_ports.reserve(nDevices);
+
+    for (uint32_t i = 0; i < nDevices; ++i)
+    {
+        Ptr<NetDevice> device = m_node->GetDevice(i);
+        Port port;
+        port.device = device;
+        port.state = L2_PORT_FORWARDING;
+        port.counters = PortCounters();
+        port.rate = GetPortRate(device);
+        port.logical = static_cast<uint16_t>(i);
+        port.lag = false;
+        m_ports.push_back(std::move(port));
+
+        // 注册混杂模式回调
+        // 这样我们就能监听所有经过这个设备的数据包
+        device->SetPromiscReceiveCallback(
+            MakeCallback(&L2SwitchProtocol::ReceiveFromDevice, this));
+
+        NS_LOG_INFO(m_switchName << ": Registered callback on device " << i
+                   << " (MAC: " << Mac48Address::ConvertFrom(device->GetAddress()) << ")");
+    }
+
+    // 链路状态回调只用于聚合组成员的故障切换，回调里重新计算所有聚合组
+    for (const auto& config : m_lagConfigs)
+    {
+        for (uint16_t member : config)
+        {
+            NS_ASSERT_MSG(member < nDevices, "Invalid LAG member port " << member);
+            m_ports[member].device->AddLinkChangeCallback(
+                MakeCallback(&L2SwitchProtocol::LinkStateChanged, this));
+        }
+    }
+
+    RebuildLags();
+    RebuildFloodMasks();
+    RebuildVlanMasks();
+    ConfigureStormControl();
+    m_initialized = true;
+
+    // IGMP 侦听: 应用静态配置，作为查询器时启动阶段连续发送两次查询
+    m_routerPorts = L2PortMask(nDevices);
+    m_routerExpires.assign(nDevices, Seconds(0));
+    m_mcastEgress.Resize(nDevices);
+    if (m_igmpSnooping)
+    {
+        for (const StaticGroup& config : m_staticGroups)
+        {
+            NS_ASSERT_MSG(config.port < nDevices, "Invalid multicast member port " << config.port);
+            JoinGroup(config.vlan, config.group, m_ports[config.port].logical, Seconds(0), true);
+        }
+        for (uint16_t port : m_staticRouterPorts)
+        {
+            NS_ASSERT_MSG(port < nDevices, "Invalid multicast router port " << port);
+            m_routerPorts.Set(m_ports[port].logical);
+            m_routerExpires[m_ports[port].logical] = Time::Max();
+        }
+        m_startupQueries = m_igmpQuerier ? 2 : 0;
+        m_nextQuery = Simulator::Now();
+        ScheduleIgmpTick();
+    }
+
+    NS_ASSERT_MSG(!(m_enableRstp && m_enableMultipath),
+                  "EnableRstp and EnableMultipath are mutually exclusive on " << m_switchName);
+    NS_ASSERT_MSG(!(m_fabricManager && (m_enableRstp || m_enableMultipath)),
+                  "PortLand cannot be combined with RSTP or multipath on " << m_switchName);
+    if (m_enableRstp)
+    {
+        StartRstp();
+    }
+    else if (m_enableMultipath)
+    {
+        StartMultipath();
+    }
+    else if (m_fabricManager)
+    {
+        StartPortland();
+    }
+}
+
+// ========== 端口表与泛洪集合 ==========
+
+uint16_t
+L2SwitchProtocol::GetNPorts() const
+{
+    return static_cast<uint16_t>(m_ports.size());
+}
+
+void
+L2SwitchProtocol::SetPortBlocked(uint16_t port, bool blocked)
+{
+    NS_LOG_INFO(m_switchName << ": Port " << port << (blocked ? " blocked" : " unblocked"));
+    SetPortState(port, blocked ? L2_PORT_DISCARDING : L2_PORT_FORWARDING);
+}
+
+bool
+L2SwitchProtocol::IsPortBlocked(uint16_t port) const
+{
+    return port < m_ports.size() && m_ports[port].state != L2_PORT_FORWARDING;
+}
+
+L2PortState
+L2SwitchProtocol::GetPortState(uint16_t port) const
+{
+    NS_ASSERT_MSG(port < m_ports.size(), "Invalid port " << port);
+    return m_ports[port].state;
+}
+
+void
+L2SwitchProtocol::SetPortState(uint16_t port, L2PortState state)
+{
+    NS_ASSERT_MSG(port < m_ports.size(), "Invalid port " << port);
+    if (m_ports[port].state == state)
+    {
+        return;
+    }
+    m_ports[port].state = state;
+    if (state != L2_PORT_FORWARDING)
+    {
+        // 不再转发的端口丢弃队列中还没发出的帧 (聚合组是所有成员的队列)
+        for (auto& member : m_ports)
+        {
+            if (member.logical == port)
+            {
+                member.drainEvent.Cancel();
+                member.queue.clear();
+            }
+        }
+    }
+    RebuildFloodMasks();
+}
+
+void
+L2SwitchProtocol::RebuildFloodMasks()
+{
+    uint32_t nPorts = static_cast<uint32_t>(m_ports.size());
+
+    // 所有可以转发的逻辑端口: 聚合组只保留逻辑端口，且至少要有一个可用成员
+    L2PortMask forwarding(nPorts);
+    for (uint32_t p = 0; p < nPorts; ++p)
+    {
+        if (m_ports[p].state == L2_PORT_FORWARDING && m_ports[p].logical == p &&
+            (!m_ports[p].lag || !m_lags[p].active.empty()))
+        {
+            forwarding.Set(p);
+        }
+    }
+
+    // 不回发到入端口所在的逻辑端口
+    m_floodMasks.assign(nPorts, forwarding);
+    for (uint32_t p = 0; p < nPorts; ++p)
+    {
+        m_floodMasks[p].Reset(m_ports[p].logical);
+    }
+}
+
+// ========== VLAN ==========
+
+void
+L2SwitchProtocol::SetAccessPort(uint16_t port, uint16_t vlan)
+{
+    NS_ASSERT_MSG(vlan >= 1 && vlan <= L2VlanTag::MAX_VLAN, "Invalid VLAN " << vlan);
+    NS_LOG_INFO(m_switchName << ": Port " << port << " access VLAN " << vlan);
+
+    if (m_portVlans.size() <= port)
+    {
+        m_portVlans.resize(port + 1, PortVlan{L2_VLAN_ACCESS, L2VlanTag::DEFAULT_VLAN, {}});
+    }
+    m_portVlans[port] = PortVlan{L2_VLAN_ACCESS, vlan, {}};
+
+    if (m_initialized)
+    {
+        FlushPort(port);
+        RebuildVlanMasks();
+    }
+}
+
+void
+L2SwitchProtocol::SetTrunkPort(uint16_t port,
+                               const std::vector<uint16_t>& vlans,
+                               uint16_t nativeVlan)
+{
+    NS_ASSERT_MSG(nativeVlan <= L2VlanTag::MAX_VLAN, "Invalid native VLAN " << nativeVlan);
+    NS_LOG_INFO(m_switchName << ": Port " << port << " trunk, " << vlans.size()
+               << " VLANs, native VLAN " << nativeVlan);
+
+    if (m_portVlans.size() <= port)
+    {
+        m_portVlans.resize(port + 1, PortVlan{L2_VLAN_ACCESS, L2VlanTag::DEFAULT_VLAN, {}});
+    }
+    m_portVlans[port] = PortVlan{L2_VLAN_TRUNK, nativeVlan, vlans};
+
+    if (m_initialized)
+    {
+        FlushPort(port);
+        RebuildVlanMasks();
+    }
+}
+
+L2VlanPortMode
+L2SwitchProtocol::GetPortVlanMode(uint16_t port) const
+{
+    return port < m_portVlans.size() ? m_portVlans[port].mode : L2_VLAN_ACCESS;
+}
+
+uint16_t
+L2SwitchProtocol::GetPortVlan(uint16_t port) const
+{
+    return port < m_portVlans.size() ? m_portVlans[port].pvid : L2VlanTag::DEFAULT_VLAN;
+}
+
+bool
+L2SwitchProtocol::IsVlanMember(uint16_t port, uint16_t vlan) const
+{
+    auto it = m_vlans.find(vlan);
+    return it != m_vlans.end() && it->second.members.Test(port);
+}
+
+void
+L2SwitchProtocol::RebuildVlanMasks()
+{
+    uint32_t nPorts = static_cast<uint32_t>(m_ports.size());
+    m_portVlans.resize(nPorts, PortVlan{L2_VLAN_ACCESS, L2VlanTag::DEFAULT_VLAN, {}});
+
+    m_vlans.clear();
+    auto vlanPorts = [this, nPorts](uint16_t vlan) -> VlanPorts& {
+        auto it = m_vlans.find(vlan);
+        if (it == m_vlans.end())
+        {
+            it = m_vlans.emplace(vlan, VlanPorts{L2PortMask(nPorts), L2PortMask(nPorts)}).first;
+        }
+        return it->second;
+    };
+
+    for (uint32_t p = 0; p < nPorts; ++p)
+    {
+        // 聚合组成员使用逻辑端口的配置
+        const PortVlan& config = m_portVlans[m_ports[p].logical];
+        if (config.pvid != L2VlanTag::NO_VLAN)
+        {
+            VlanPorts& native = vlanPorts(config.pvid);
+            native.members.Set(p);
+            native.untagged.Set(p);
+        }
+        if (config.mode == L2_VLAN_TRUNK)
+        {
+            for (uint16_t vlan : config.vlans)
+            {
+                if (vlan >= 1 && vlan <= L2VlanTag::MAX_VLAN)
+                {
+                    vlanPorts(vlan).members.Set(p);
+                }
+            }
+        }
+    }
+
+    m_floodSame.Resize(nPorts);
+    m_floodRetag.Resize(nPorts);
+}
+
+void
+L2SwitchProtocol::FlushPort(uint16_t port)
+{
+    std::vector<uint64_t> keys;
+    m_macTable.ForEach([&keys, port](uint64_t key, uint16_t entryPort) {
+        if (entryPort == port)
+        {
+            keys.push_back(key);
+        }
+    });
+    for (uint64_t key : keys)
+    {
+        m_macTable.Remove(key);
+    }
+}
+
+uint16_t
+L2SwitchProtocol::ClassifyVlan(uint16_t inPort,
+                               Ptr<const Packet> packet,
+                               uint16_t& protocol,
+                               bool& tagged)
+{
+    const PortVlan& config = m_portVlans[inPort];
+    uint16_t vlan = config.pvid;
+    tagged = false;
+
+    if (protocol == L2VlanTag::PROTOCOL)
+    {
+        L2VlanTag tag;
+        if (packet->GetSize() < tag.GetSerializedSize())
+        {
+            return L2VlanTag::NO_VLAN;
+        }
+        packet->PeekHeader(tag);
+        protocol = tag.GetEncapsulatedProtocol();
+        tagged = true;
+        if (tag.GetVid() != L2VlanTag::NO_VLAN)
+        {
+            vlan = tag.GetVid();
+        }
+    }
+
+    // 入口过滤: 只接受端口所属 VLAN 的帧
+    if (vlan == L2VlanTag::NO_VLAN || !IsVlanMember(inPort, vlan))
+    {
+        return L2VlanTag::NO_VLAN;
+    }
+    return vlan;
+}
+
+// ========== 核心转发逻辑 ==========
+bool
+L2SwitchProtocol::ReceiveFromDevice(Ptr<NetDevice> inDevice,
+                                   Ptr<const Packet> packet,
+                                   uint16_t protocol,
+                                   const Address& from,
+                                   const Address& to,
+                                   NetDevice::PacketType packetType)
+{
+    L2_FRAME_LOG_FUNCTION(this << inDevice << packet << protocol << from << to << packetType);
+
+    // 将地址转换为 MAC 地址（真实的数据帧来源和目的）
+    Mac48Address srcMac = Mac48Address::ConvertFrom(from);
+    Mac48Address dstMac = Mac48Address::ConvertFrom(to);
+
+    L2_FRAME_LOG_DEBUG(m_switchName << ": Received packet from " << srcMac << " to " << dstMac
+                << " on device " << inDevice->GetIfIndex());
+
+    // 端口号就是设备在节点上的 ifIndex，MAC 表中只保存这个小整数。
+    // 聚合组成员收到的帧按逻辑端口学习和过滤，计数器仍然记在物理端口上
+    uint16_t inPort = static_cast<uint16_t>(inDevice->GetIfIndex());
+    uint16_t inLogical = m_ports[inPort].logical;
+
+    // BPDU 交给 RSTP 处理，交换机从不转发发往 01:80:C2:00:00:00 的帧
+    if (m_rstp && protocol == L2Rstp::PROTOCOL && dstMac == L2Rstp::GetGroupAddress())
+    {
+        m_rstp->Receive(inLogical, packet);
+        return true;
+    }
+
+    // 链路状态控制报文 (Hello / LSP) 同样只在相邻交换机之间交换
+    if (m_linkState && protocol == L2LinkState::CONTROL_PROTOCOL &&
+        dstMac == L2LinkState::GetGroupAddress())
+    {
+        m_linkState->Receive(inLogical, packet);
+        return true;
+    }
+
+    PortCounters& inCounters = m_ports[inPort].counters;
+    ++inCounters.rxFrames;
+    m_rxTrace(packet, inPort);
+
+    // PortLand: 所有数据帧都按 PMAC 转发，不学习、不查 MAC 表
+    if (m_fabricManager)
+    {
+        ReceivePortland(inPort, packet, protocol, srcMac, dstMac, CanReuseIngress(packetType));
+        return true;
+    }
+
+    // 封装帧从核心端口进入，核心端口对原生帧是 Discarding，所以在状态检查之前处理
+    if (m_linkState && protocol == L2LinkState::DATA_PROTOCOL)
+    {
+        ReceiveEncapsulated(inPort, inLogical, packet, srcMac, dstMac,
+                            CanReuseIngress(packetType));
+        return true;
+    }
+
+    // 阻塞端口上的帧既不学习也不转发
+    L2PortState inState = m_ports[inLogical].state;
+    if (inState == L2_PORT_DISCARDING)
+    {
+        L2_FRAME_LOG_DEBUG(m_switchName << ": Dropping packet received on blocked port " << inPort);
+        ++inCounters.droppedFiltered;
+        m_dropTrace(packet, inPort, DROP_BLOCKED);
+        return true;
+    }
+
+    // 确定帧所属的 VLAN，protocol 变为去掉标签后的协议类型
+    bool tagged = false;
+    uint16_t vlan = ClassifyVlan(inLogical, packet, protocol, tagged);
+    if (vlan == L2VlanTag::NO_VLAN)
+    {
+        L2_FRAME_LOG_DEBUG(m_switchName << ": Dropping packet on port " << inPort
+                          << ", port is not a member of its VLAN");
+        ++inCounters.droppedFiltered;
+        m_dropTrace(packet, inPort, DROP_VLAN);
+        return true;
+    }
+
+    // Learning 状态的端口只学习
+    if (inState == L2_PORT_LEARNING)
+    {
+        Learn(vlan, srcMac, inLogical);
+        return true;
+    }
+
+    // 步骤 1: 学习源 MAC 地址
+    Learn(vlan, srcMac, inLogical);
+
+    // 流表: 命中的帧按表项的动作处理，table-miss 继续按 MAC 学习转发
+    bool reuse = CanReuseIngress(packetType);
+    if (!m_flowTable.IsEmpty() &&
+        ApplyFlowTable(inPort, inLogical, packet, protocol, vlan, tagged, srcMac, dstMac, reuse))
+    {
+        return true;
+    }
+
+    // ARP 抑制: 缓存中有目标 IP 时直接回复，请求不再泛洪
+    if (m_arpSuppression && protocol == ARP_PROTOCOL &&
+        HandleArp(inPort, inLogical, packet, tagged, vlan, srcMac))
+    {
+        return true;
+    }
+
+    // 步骤 2: 转发决策
+    if (m_igmpSnooping && dstMac.IsGroup() && !dstMac.IsBroadcast())
+    {
+        // 组播帧 - 按 IGMP 成员关系转发
+        ForwardMulticast(inPort, inLogical, packet, protocol, vlan, tagged, srcMac, dstMac, reuse);
+    }
+    else if (dstMac.IsBroadcast())
+    {
+        if (!AdmitFlood(inPort, L2_STORM_BROADCAST, packet))
+        {
+            return true;
+        }
+
+        // 广播帧 - 泛洪到同一 VLAN 的所有端口
+        L2_FRAME_LOG_INFO(m_switchName << ": Broadcasting packet from " << srcMac << " in VLAN "
+                          << vlan);
+        ++m_stats.broadcastFloods;
+        ++inCounters.flooded;
+        ForwardBroadcast(inPort, packet, protocol, vlan, tagged, srcMac, dstMac, reuse);
+    }
+    else
+    {
+        // 单播帧 - 在帧所属 VLAN 的表中查找目的端口
+        uint16_t outPort = GetLearnedPort(vlan, dstMac);
+
+        if (outPort != L2MacTable::NO_PORT && outPort != inLogical &&
+            m_ports[outPort].state == L2_PORT_FORWARDING && IsVlanMember(outPort, vlan))
+        {
+            // 已知目的端口，单播转发
+            L2_FRAME_LOG_INFO(m_switchName << ": Forwarding " << srcMac << " -> " << dstMac
+                              << " via port " << outPort);
+            ForwardUnicast(outPort, packet, protocol, vlan, tagged, srcMac, dstMac, reuse);
+        }
+        else if (outPort == L2MacTable::NO_PORT)
+        {
+            // 多路径: 目的主机在其他交换机上时封装后按 ECMP 发往那台交换机，不泛洪
+            if (m_linkState &&
+                ForwardToRemote(packet, protocol, vlan, tagged, srcMac, dstMac, reuse))
+            {
+                return true;
+            }
+
+            if (!AdmitFlood(inPort,
+                            dstMac.IsGroup() ? L2_STORM_MULTICAST : L2_STORM_UNKNOWN_UNICAST,
+                            packet))
+            {
+                return true;
+            }
+
+            // 未知目的端口，泛洪
+            L2_FRAME_LOG_INFO(m_switchName << ": Unknown destination " << dstMac << ", flooding");
+            ++inCounters.flooded;
+            CountUnknownFlood(L2MacTable::PackKey(vlan, dstMac));
+            ForwardBroadcast(inPort, packet, protocol, vlan, tagged, srcMac, dstMac, reuse);
+        }
+        else if (outPort == inLogical)
+        {
+            // 目的端口就是入端口（避免环路），丢弃
+            L2_FRAME_LOG_DEBUG(m_switchName << ": Dropping packet, destination on same port");
+            ++inCounters.droppedSamePort;
+            m_dropTrace(packet, inPort, DROP_SAME_PORT);
+        }
+        else
+        {
+            // 目的端口已被阻塞或不属于帧的 VLAN，丢弃
+            L2_FRAME_LOG_DEBUG(m_switchName << ": Dropping packet, destination port " << outPort
+                              << " is not forwarding");
+            ++inCounters.droppedFiltered;
+            m_dropTrace(packet, inPort, DROP_EGRESS_BLOCKED);
+        }
+    }
+
+    return true;  // 返回 true 表示数据包已处理
+}
+
+// ========== RSTP ==========
+
+bool
+L2SwitchProtocol::IsRstpEnabled() const
+{
+    return m_enableRstp;
+}
+
+Ptr<L2Rstp>
+L2SwitchProtocol::GetRstp() const
+{
+    return m_rstp;
+}
+
+void
+L2SwitchProtocol::StartRstp()
+{
+    NS_LOG_FUNCTION(this);
+
+    // 桥 MAC 取所有端口中最小的 MAC 地址
+    Mac48Address bridgeMac = Mac48Address::ConvertFrom(m_ports[0].device->GetAddress());
+    for (const auto& port : m_ports)
+    {
+        Mac48Address mac = Mac48Address::ConvertFrom(port.device->GetAddress());
+        if (L2MacTable::PackMac(mac) < L2MacTable::PackMac(bridgeMac))
+        {
+            bridgeMac = mac;
+        }
+    }
+
+    m_rstp = CreateObject<L2Rstp>();
+    m_rstp->SetBridge(m_switchName, bridgeMac);
+    m_rstp->SetCallbacks(MakeCallback(&L2SwitchProtocol::SendBpdu, this),
+                         MakeCallback(&L2SwitchProtocol::SetPortState, this),
+                         MakeCallback(&L2SwitchProtocol::FlushMacTable, this));
+
+    // 所有端口先进入 Discarding，由 RSTP 决定何时转发 (边缘端口会立即转发)。
+    // 聚合组在 RSTP 中只有逻辑端口这一个端口，路径开销按成员速率之和计算；
+    // 其余成员仍占一个 RSTP 端口号 (保持编号一致)，当作边缘端口，既不收也不发 BPDU，
+    // 它们的状态也不会被使用
+    for (uint16_t i = 0; i < m_ports.size(); ++i)
+    {
+        m_ports[i].state = L2_PORT_DISCARDING;
+        if (m_ports[i].logical != i)
+        {
+            m_rstp->AddPort(GetPathCost(m_ports[i].rate), true);
+            continue;
+        }
+        m_rstp->AddPort(GetPathCost(GetLogicalPortRate(i)), IsEdgePort(m_ports[i].device));
+    }
+    RebuildFloodMasks();
+
+    m_rstp->Start();
+}
+
+void
+L2SwitchProtocol::SendBpdu(uint16_t port, Ptr<Packet> packet)
+{
+    // 聚合组的 BPDU 从第一个可用成员发出，其余成员不发
+    uint16_t member = port;
+    if (m_ports[port].lag)
+    {
+        member = (m_ports[port].logical == port) ? SelectMember(port, 0) : L2MacTable::NO_PORT;
+        if (member == L2MacTable::NO_PORT)
+        {
+            return;
+        }
+    }
+    m_ports[member].device->Send(packet, L2Rstp::GetGroupAddress(), L2Rstp::PROTOCOL);
+}
+
+void
+L2SwitchProtocol::FlushMacTable(uint16_t keepPort)
+{
+    // 先收集再删除: 后移删除会移动表项，不能在遍历中删除
+    std::vector<uint64_t> keys;
+    m_macTable.ForEach([&keys, keepPort](uint64_t key, uint16_t port) {
+        if (port != keepPort)
+        {
+            keys.push_back(key);
+        }
+    });
+    for (uint64_t key : keys)
+    {
+        m_macTable.Remove(key);
+    }
+    NS_LOG_INFO(m_switchName << ": Topology change, flushed " << keys.size() << " MAC entries");
+}
+
+bool
+L2SwitchProtocol::IsEdgePort(Ptr<NetDevice> device) const
+{
+    Ptr<Channel> channel = device->GetChannel();
+    if (channel == nullptr)
+    {
+        return true;
+    }
+    for (std::size_t i = 0; i < channel->GetNDevices(); ++i)
+    {
+        Ptr<NetDevice> peer = channel->GetDevice(i);
+        if (peer == device)
+        {
+            continue;
+        }
+        Ptr<L2SwitchProtocol> peerSwitch = peer->GetNode()->GetObject<L2SwitchProtocol>();
+        if (peerSwitch && (peerSwitch->IsRstpEnabled() || peerSwitch->IsMultipathEnabled()))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+uint32_t
+L2SwitchProtocol::GetPathCost(uint64_t rate)
+{
+    if (rate == 0)
+    {
+        return 200000;  // 未知速率按 100Mbps 计算
+    }
+
+    // 802.1D-2004: 开销 = 20 Tbps / 链路速率，100Mbps = 200000，1Gbps = 20000
+    uint64_t cost = 20000000000000ULL / rate;
+    return static_cast<uint32_t>(std::clamp<uint64_t>(cost, 1, 200000000));
+}
+
+uint64_t
+L2SwitchProtocol::GetLogicalPortRate(uint16_t port) const
+{
+    if (!m_ports[port].lag)
+    {
+        return m_ports[port].rate;
+    }
+    uint64_t rate = 0;
+    for (uint16_t member : m_lags.find(port)->second.members)
+    {
+        rate += m_ports[member].rate;
+    }
+    return rate;
+}
+
+// ========== 链路状态多路径转发 ==========
+//
+// 核心端口 (连接其他交换机) 对原生帧始终是 Discarding，交换机之间只传递封装帧:
+//   边缘端口进入的帧 -> 本地 MAC 表命中: 和普通交换机一样转发
+//                    -> 远端主机表命中: 封装，出口是主机所在的交换机，按 ECMP 逐跳转发
+//                    -> 都不知道: 本地泛洪，同时封装后沿一棵分发树发往所有交换机
+//   出口交换机解封装，从封装头学习 "源主机在入口交换机上"，再按本地 MAC 表转发。
+
+bool
+L2SwitchProtocol::IsMultipathEnabled() const
+{
+    return m_enableMultipath;
+}
+
+Ptr<L2LinkState>
+L2SwitchProtocol::GetLinkState() const
+{
+    return m_linkState;
+}
+
+L2SwitchProtocol::MultipathStats
+L2SwitchProtocol::GetMultipathStats() const
+{
+    return m_multipathStats;
+}
+
+void
+L2SwitchProtocol::StartMultipath()
+{
+    NS_LOG_FUNCTION(this);
+
+    // 昵称就是节点 ID，在整个仿真中唯一
+    m_linkState = CreateObject<L2LinkState>();
+    m_linkState->SetBridge(m_switchName, static_cast<uint16_t>(m_node->GetId()));
+    m_linkState->SetCallbacks(MakeCallback(&L2SwitchProtocol::SendLinkState, this),
+                              MakeCallback(&L2SwitchProtocol::SetCorePort, this));
+
+    // 与 RSTP 相同，聚合组只有逻辑端口参与，其余成员占一个端口号但不发 Hello。
+    // 对端是多路径交换机的端口一开始就不转发原生帧，收到 Hello 后成为核心端口
+    for (uint16_t i = 0; i < m_ports.size(); ++i)
+    {
+        if (m_ports[i].logical != i)
+        {
+            m_linkState->AddPort(GetPathCost(m_ports[i].rate), true);
+            continue;
+        }
+        bool edge = IsEdgePort(m_ports[i].device);
+        m_linkState->AddPort(GetPathCost(GetLogicalPortRate(i)), edge);
+        if (!edge)
+        {
+            m_ports[i].state = L2_PORT_DISCARDING;
+        }
+    }
+    RebuildFloodMasks();
+
+    m_linkState->Start();
+}
+
+void
+L2SwitchProtocol::SendLinkState(uint16_t port, Ptr<Packet> packet)
+{
+    // 聚合组的控制报文从第一个可用成员发出，其余成员不发
+    uint16_t member = port;
+    if (m_ports[port].lag)
+    {
+        member = (m_ports[port].logical == port) ? SelectMember(port, 0) : L2MacTable::NO_PORT;
+        if (member == L2MacTable::NO_PORT)
+        {
+            return;
+        }
+    }
+    m_ports[member].device->Send(packet, L2LinkState::GetGroupAddress(),
+                                 L2LinkState::CONTROL_PROTOCOL);
+}
+
+void
+L2SwitchProtocol::SetCorePort(uint16_t port)
+{
+    // 原来当作边缘端口的端口对端其实是交换机: 不再转发原生帧，在它上面学到的地址作废
+    if (m_ports[port].state != L2_PORT_DISCARDING)
+    {
+        NS_LOG_INFO(m_switchName << ": Port " << port
+                   << " connects to a multipath switch, native frames no longer forwarded");
+        SetPortState(port, L2_PORT_DISCARDING);
+        FlushPort(port);
+    }
+}
+
+uint16_t
+L2SwitchProtocol::LookupRemoteHost(uint16_t vlan, const Mac48Address& address)
+{
+    uint64_t key = L2MacTable::PackKey(vlan, address);
+    const L2MacTable::Entry* entry = m_remoteHosts.Find(key);
+    if (entry == nullptr)
+    {
+        return L2LinkState::NO_NICKNAME;
+    }
+
+    // 远端主机表不上时间轮，查到过期的表项时才删除
+    if (m_agingTicks > 0 && entry->lastSeen + m_agingTicks <= GetAgingTick())
+    {
+        m_remoteHosts.Remove(key);
+        return L2LinkState::NO_NICKNAME;
+    }
+    return entry->port;
+}
+
+void
+L2SwitchProtocol::LearnRemoteHost(uint16_t vlan, const Mac48Address& address, uint16_t ingress)
+{
+    uint64_t key = L2MacTable::PackKey(vlan, address);
+    m_remoteHosts.Learn(key, ingress, GetAgingTick());
+
+    // 主机从本交换机的边缘端口迁移到了其他交换机，本地表项优先级更高，必须删除
+    if (m_macTable.Lookup(key) != L2MacTable::NO_PORT)
+    {
+        m_macTable.Remove(key);
+    }
+}
+
+bool
+L2SwitchProtocol::ForwardToRemote(Ptr<const Packet> packet,
+                                  uint16_t protocol,
+                                  uint16_t vlan,
+                                  bool tagged,
+                                  const Mac48Address& source,
+                                  const Mac48Address& destination,
+                                  bool reuse)
+{
+    uint16_t egress = LookupRemoteHost(vlan, destination);
+    if (egress == L2LinkState::NO_NICKNAME)
+    {
+        return false;
+    }
+    const std::vector<uint16_t>& hops = m_linkState->GetNextHops(egress);
+    if (hops.empty())
+    {
+        return false;  // 出口交换机暂时不可达，按未知单播泛洪
+    }
+
+    // 熵值取原始帧头的哈希，同一条流始终走同一条路径 (不乱序)
+    uint32_t hash = L2LagHash(packet, tagged, protocol, source, destination, m_lagHashPolicy);
+    L2MultipathHeader header;
+    header.SetEgress(egress);
+    header.SetIngress(m_linkState->GetNickname());
+    header.SetVlan(vlan);
+    header.SetProtocol(protocol);
+    header.SetEntropy(static_cast<uint16_t>(hash ^ (hash >> 16)));
+
+    Ptr<Packet> frame = EgressPacket(packet, reuse);
+    if (tagged)
+    {
+        L2VlanTag tag;
+        frame->RemoveHeader(tag);
+    }
+    frame->AddHeader(header);
+
+    L2_FRAME_LOG_INFO(m_switchName << ": Encapsulating " << source << " -> " << destination
+                      << " to switch " << egress);
+    ++m_forwardedFrames;
+    ++m_multipathStats.encapsulated;
+    SendEncapsulated(hops, frame, header.GetEntropy(), source, destination);
+    return true;
+}
+
+void
+L2SwitchProtocol::FloodToSwitches(Ptr<const Packet> packet,
+                                  uint16_t protocol,
+                                  uint16_t vlan,
+                                  bool tagged,
+                                  const Mac48Address& source,
+                                  const Mac48Address& destination)
+{
+    // 按熵值选择分发树，不同的流分散在几棵树上
+    uint32_t hash = L2LagHash(packet, tagged, protocol, source, destination, m_lagHashPolicy);
+    uint16_t entropy = static_cast<uint16_t>(hash ^ (hash >> 16));
+    uint16_t root = m_linkState->SelectTree(entropy);
+    const std::vector<uint16_t>& ports = m_linkState->GetTreePorts(root);
+    if (ports.empty())
+    {
+        return;  // 没有其他可达的交换机
+    }
+
+    L2MultipathHeader header;
+    header.SetMultiDestination(true);
+    header.SetEgress(root);
+    header.SetIngress(m_linkState->GetNickname());
+    header.SetVlan(vlan);
+    header.SetProtocol(protocol);
+    header.SetEntropy(entropy);
+
+    // 入帧还要在本地泛洪，这里总是复制
+    ++m_packetCopies;
+    Ptr<Packet> frame = packet->Copy();
+    if (tagged)
+    {
+        L2VlanTag tag;
+        frame->RemoveHeader(tag);
+    }
+    frame->AddHeader(header);
+
+    ++m_multipathStats.multiDestination;
+    SendOnTree(ports, L2LinkState::NO_PORT, frame, hash, source, destination);
+}
+
+void
+L2SwitchProtocol::ReceiveEncapsulated(uint16_t inPort,
+                                      uint16_t inLogical,
+                                      Ptr<const Packet> packet,
+                                      const Mac48Address& source,
+                                      const Mac48Address& destination,
+                                      bool reuse)
+{
+    L2MultipathHeader header;
+    if (!m_linkState->IsCorePort(inLogical) || packet->GetSize() < header.GetSerializedSize())
+    {
+        // 封装帧只能来自其他交换机
+        ++m_ports[inPort].counters.droppedFiltered;
+        m_dropTrace(packet, inPort, DROP_MULTIPATH);
+        return;
+    }
+    packet->PeekHeader(header);
+    uint16_t self = m_linkState->GetNickname();
+
+    if (header.IsMultiDestination())
+    {
+        // RPF 检查: 只接受从这棵树上通往入口交换机的端口进入的帧，
+        // 拓扑变化期间各交换机的树暂时不一致时，宁可丢帧也不形成环路
+        uint16_t root = header.GetEgress();
+        if (header.GetIngress() == self ||
+            m_linkState->GetRpfPort(root, header.GetIngress()) != inLogical)
+        {
+            L2_FRAME_LOG_DEBUG(m_switchName << ": Dropping multi-destination frame from "
+                              << header.GetIngress() << ", RPF check failed on port " << inPort);
+            ++m_multipathStats.rpfDrops;
+            ++m_ports[inPort].counters.droppedFiltered;
+            m_dropTrace(packet, inPort, DROP_MULTIPATH);
+            return;
+        }
+
+        // 先沿树转发给下游交换机 (跳数减 1)，再在本地解封装
+        const std::vector<uint16_t>& ports = m_linkState->GetTreePorts(root);
+        bool downstream = std::any_of(ports.begin(), ports.end(),
+                                      [inLogical](uint16_t p) { return p != inLogical; });
+        if (downstream && header.GetHopCount() > 0)
+        {
+            ++m_packetCopies;
+            Ptr<Packet> transit = packet->Copy();
+            L2MultipathHeader outer;
+            transit->RemoveHeader(outer);
+            outer.SetHopCount(outer.GetHopCount() - 1);
+            transit->AddHeader(outer);
+            ++m_multipathStats.transit;
+            SendOnTree(ports, inLogical, transit, header.GetEntropy(), source, destination);
+        }
+        DeliverLocal(inPort, packet, header, source, destination, reuse);
+        return;
+    }
+
+    if (header.GetEgress() == self)
+    {
+        DeliverLocal(inPort, packet, header, source, destination, reuse);
+        return;
+    }
+
+    // 中间交换机: 只看出口昵称，不查主机 MAC
+    const std::vector<uint16_t>& hops = m_linkState->GetNextHops(header.GetEgress());
+    if (hops.empty() || header.GetHopCount() == 0)
+    {
+        L2_FRAME_LOG_DEBUG(m_switchName << ": Dropping frame for switch " << header.GetEgress()
+                          << (hops.empty() ? ", unreachable" : ", hop count exhausted"));
+        ++m_multipathStats.unreachable;
+        ++m_ports[inPort].counters.droppedFiltered;
+        m_dropTrace(packet, inPort, DROP_MULTIPATH);
+        return;
+    }
+    Ptr<Packet> frame = EgressPacket(packet, reuse);
+    frame->RemoveHeader(header);
+    header.SetHopCount(header.GetHopCount() - 1);
+    frame->AddHeader(header);
+    ++m_forwardedFrames;
+    ++m_multipathStats.transit;
+    SendEncapsulated(hops, frame, header.GetEntropy(), source, destination);
+}
+
+void
+L2SwitchProtocol::DeliverLocal(uint16_t inPort,
+                               Ptr<const Packet> packet,
+                               const L2MultipathHeader& header,
+                               const Mac48Address& source,
+                               const Mac48Address& destination,
+                               bool reuse)
+{
+    uint16_t vlan = header.GetVlan();
+    if (m_vlans.find(vlan) == m_vlans.end())
+    {
+        return;  // 本交换机上没有这个 VLAN 的端口
+    }
+    uint16_t protocol = header.GetProtocol();
+    Ptr<Packet> inner = EgressPacket(packet, reuse);
+    L2MultipathHeader outer;
+    inner->RemoveHeader(outer);
+    ++m_multipathStats.decapsulated;
+    LearnRemoteHost(vlan, source, header.GetIngress());
+
+    // 解封装后的帧不带标签，入端口是核心端口，泛洪集合中已经没有任何核心端口，
+    // 所以下面的泛洪只会到达本地的边缘端口
+    uint16_t inLogical = m_ports[inPort].logical;
+    if (m_igmpSnooping && destination.IsGroup() && !destination.IsBroadcast())
+    {
+        ForwardMulticast(inPort, inLogical, inner, protocol, vlan, false, source, destination, true);
+        return;
+    }
+    uint16_t outPort =
+        destination.IsGroup() ? L2MacTable::NO_PORT : GetLearnedPort(vlan, destination);
+    if (outPort != L2MacTable::NO_PORT && m_ports[outPort].state == L2_PORT_FORWARDING &&
+        IsVlanMember(outPort, vlan))
+    {
+        ForwardUnicast(outPort, inner, protocol, vlan, false, source, destination, true);
+    }
+    else
+    {
+        ForwardBroadcast(inPort, inner, protocol, vlan, false, source, destination, true);
+    }
+}
+
+void
+L2SwitchProtocol::SendEncapsulated(const std::vector<uint16_t>& hops,
+                                   Ptr<Packet> frame,
+                                   uint16_t entropy,
+                                   const Mac48Address& source,
+                                   const Mac48Address& destination)
+{
+    // 每台交换机把自己的昵称混进哈希，否则所有交换机对同一条流做出相同的选择 (哈希极化)
+    uint64_t h = L2LagMix(entropy ^ (uint64_t(m_linkState->GetNickname()) << 32));
+    uint16_t port = hops[h % hops.size()];
+    uint16_t member = SelectMember(port, static_cast<uint32_t>(h));
+    if (member == L2MacTable::NO_PORT)
+    {
+        ++m_ports[port].counters.droppedFiltered;
+        m_dropTrace(frame, port, DROP_MULTIPATH);
+        return;
+    }
+    Transmit(member, frame, source, destination, L2LinkState::DATA_PROTOCOL, false);
+}
+
+void
+L2SwitchProtocol::SendOnTree(const std::vector<uint16_t>& ports,
+                             uint16_t inLogical,
+                             Ptr<Packet> frame,
+                             uint32_t hash,
+                             const Mac48Address& source,
+                             const Mac48Address& destination)
+{
+    // frame 是本交换机自己的副本，最后一个树边端口直接发送它
+    uint16_t last = ports.back();
+    if (last == inLogical && ports.size() > 1)
+    {
+        last = ports[ports.size() - 2];
+    }
+    for (uint16_t port : ports)
+    {
+        uint16_t member = (port == inLogical) ? L2MacTable::NO_PORT : SelectMember(port, hash);
+        if (member == L2MacTable::NO_PORT)
+        {
+            continue;
+        }
+        Ptr<Packet> egress = EgressPacket(frame, port == last);
+        Transmit(member, egress, source, destination, L2LinkState::DATA_PROTOCOL, true);
+    }
+}
+
+// ========== PortLand 伪 MAC 转发 ==========
+//
+// 交换机之间只传递以 PMAC 为源/目的地址的帧:
+//   边缘交换机从主机端口收到帧 -> 源地址 AMAC 换成 PMAC (SendFrom 直接用新的源地址，不复制)
+//   目的 PMAC 在本边缘交换机下 -> 目的地址换回 AMAC，从主机端口发出
+//   否则按 PMAC 前缀逐层转发: 向上按流哈希选上联，向下按 pod / position 选下联
+
+void
+L2SwitchProtocol::SetPortlandLocation(Ptr<L2FabricManager> manager,
+                                      L2PortlandTable::Level level,
+                                      uint16_t pod,
+                                      uint8_t position)
+{
+    NS_LOG_FUNCTION(this << manager << +level << pod << +position);
+    NS_ASSERT_MSG(!m_initialized, "SetPortlandLocation() must be called before Initialize()");
+    NS_ASSERT_MSG(manager, "PortLand needs a fabric manager");
+    m_fabricManager = manager;
+    m_portland.SetLocation(level, pod, position);
+}
+
+bool
+L2SwitchProtocol::IsPortlandEnabled() const
+{
+    return m_fabricManager != nullptr;
+}
+
+const L2PortlandTable&
+L2SwitchProtocol::GetPortlandTable() const
+{
+    return m_portland;
+}
+
+L2SwitchProtocol::PortlandStats
+L2SwitchProtocol::GetPortlandStats() const
+{
+    return m_portlandStats;
+}
+
+void
+L2SwitchProtocol::StartPortland()
+{
+    NS_LOG_FUNCTION(this);
+    NS_ASSERT_MSG(m_lags.empty(), "PortLand does not support link aggregation on " << m_switchName);
+
+    // 代替位置发现协议: 对端是交换机时直接读取它的层次和位置，否则是主机
+    L2PortlandTable::Level level = m_portland.GetLevel();
+    for (uint16_t i = 0; i < m_ports.size(); ++i)
+    {
+        Ptr<L2SwitchProtocol> peer;
+        Ptr<Channel> channel = m_ports[i].device->GetChannel();
+        for (std::size_t d = 0; channel && d < channel->GetNDevices(); ++d)
+        {
+            Ptr<NetDevice> device = channel->GetDevice(d);
+            if (device != m_ports[i].device)
+            {
+                peer = device->GetNode()->GetObject<L2SwitchProtocol>();
+                break;
+            }
+        }
+
+        if (peer == nullptr)
+        {
+            if (level == L2PortlandTable::EDGE)
+            {
+                m_portland.AddHostPort(i);
+            }
+            else
+            {
+                NS_LOG_WARN(m_switchName << ": Port " << i
+                            << " does not lead to a switch, ignored above the edge level");
+            }
+            continue;
+        }
+
+        NS_ASSERT_MSG(peer->IsPortlandEnabled(), m_switchName << ": Port " << i
+                      << " connects to a switch without a PortLand location");
+        const L2PortlandTable& other = peer->GetPortlandTable();
+        if (other.GetLevel() > level)
+        {
+            m_portland.AddUplink(other.GetPosition(), i);
+        }
+        else if (other.GetLevel() < level)
+        {
+            // 汇聚交换机按边缘交换机的位置、核心交换机按 pod 索引下联
+            m_portland.AddDownlink(
+                level == L2PortlandTable::CORE ? other.GetPod() : other.GetPosition(), i);
+        }
+        else
+        {
+            NS_LOG_WARN(m_switchName << ": Port " << i
+                        << " connects two switches on the same level, ignored");
+        }
+    }
+
+    NS_LOG_INFO(m_switchName << ": PortLand level " << +level << ", pod " << m_portland.GetPod()
+               << ", position " << +m_portland.GetPosition() << ", "
+               << m_portland.GetNRoutes() << " routes");
+}
+
+void
+L2SwitchProtocol::ReceivePortland(uint16_t inPort,
+                                  Ptr<const Packet> packet,
+                                  uint16_t protocol,
+                                  const Mac48Address& source,
+                                  const Mac48Address& destination,
+                                  bool reuse)
+{
+    if (!m_portland.IsHostPort(inPort))
+    {
+        ForwardPortland(inPort, packet, protocol, source, destination, reuse);
+        return;
+    }
+
+    // 主机的第一个帧决定它的 PMAC: 位置 + 端口 + 端口上的第几个主机
+    bool created = false;
+    Mac48Address pmac = m_portland.AssignPmac(source, inPort, created);
+    if (created)
+    {
+        ++m_portlandStats.hostsAssigned;
+        NS_LOG_INFO(m_switchName << ": Host " << source << " on port " << inPort << " is "
+                   << pmac);
+    }
+
+    if (protocol == ARP_PROTOCOL)
+    {
+        HandlePortlandArp(inPort, packet, source, pmac, destination, reuse);
+        return;
+    }
+    ForwardPortland(inPort, packet, protocol, pmac, destination, reuse);
+}
+
+void
+L2SwitchProtocol::HandlePortlandArp(uint16_t inPort,
+                                    Ptr<const Packet> packet,
+                                    const Mac48Address& amac,
+                                    const Mac48Address& pmac,
+                                    const Mac48Address& destination,
+                                    bool reuse)
+{
+    ArpHeader arp;
+    if (packet->GetSize() < arp.GetSerializedSize())
+    {
+        ForwardPortland(inPort, packet, ARP_PROTOCOL, pmac, destination, reuse);
+        return;
+    }
+    packet->PeekHeader(arp);
+
+    // 发送方硬件地址与帧的源地址不一致的报文不可信，不登记也不改写
+    Mac48Address senderMac = Mac48Address::ConvertFrom(arp.GetSourceHardwareAddress());
+    if (senderMac != amac)
+    {
+        ForwardPortland(inPort, packet, ARP_PROTOCOL, pmac, destination, reuse);
+        return;
+    }
+
+    // ARP 探测的发送方 IP 是 0.0.0.0，不登记也不代答
+    Ipv4Address senderIp = arp.GetSourceIpv4Address();
+    Ipv4Address targetIp = arp.GetDestinationIpv4Address();
+    if (!senderIp.IsAny())
+    {
+        m_fabricManager->Register(senderIp, pmac);
+
+        if (arp.IsRequest())
+        {
+            // 免费 ARP 只是在宣告自己的地址，登记之后不再广播
+            if (targetIp == senderIp)
+            {
+                return;
+            }
+
+            Mac48Address targetPmac;
+            if (m_fabricManager->Resolve(targetIp, targetPmac))
+            {
+                ArpHeader replyHeader;
+                replyHeader.SetReply(targetPmac, targetIp, amac, senderIp);
+                Ptr<Packet> reply = Create<Packet>();
+                reply->AddHeader(replyHeader);
+                ++m_portlandStats.arpResolved;
+                L2_FRAME_LOG_INFO(m_switchName << ": PortLand ARP, answering " << targetIp
+                                  << " is at " << targetPmac << " to " << amac);
+                Transmit(inPort, reply, targetPmac, amac, ARP_PROTOCOL, false);
+                return;
+            }
+            ++m_portlandStats.arpFlooded;
+        }
+    }
+
+    // 其他主机会缓存 ARP 中的发送方硬件地址，它也必须是 PMAC
+    ++m_packetCopies;
+    Ptr<Packet> rewritten = packet->Copy();
+    rewritten->RemoveHeader(arp);
+    ArpHeader header;
+    if (arp.IsRequest())
+    {
+        header.SetRequest(pmac, senderIp, arp.GetDestinationHardwareAddress(), targetIp);
+    }
+    else
+    {
+        header.SetReply(pmac, senderIp, arp.GetDestinationHardwareAddress(), targetIp);
+    }
+    rewritten->AddHeader(header);
+    ForwardPortland(inPort, rewritten, ARP_PROTOCOL, pmac, destination, true);
+}
+
+void
+L2SwitchProtocol::ForwardPortland(uint16_t inPort,
+                                  Ptr<const Packet> packet,
+                                  uint16_t protocol,
+                                  const Mac48Address& source,
+                                  const Mac48Address& destination,
+                                  bool reuse)
+{
+    L2_FRAME_LOG_FUNCTION(this << inPort << packet << protocol << source << destination);
+    PortCounters& inCounters = m_ports[inPort].counters;
+
+    if (destination.IsGroup())
+    {
+        m_portland.GetFloodPorts(inPort, m_portlandFlood);
+        if (m_portlandFlood.empty())
+        {
+            return;
+        }
+        ++m_portlandStats.flooded;
+        ++inCounters.flooded;
+        ++m_forwardedFrames;
+        uint16_t last = m_portlandFlood.back();
+        for (uint16_t port : m_portlandFlood)
+        {
+            Ptr<Packet> egress = EgressPacket(packet, reuse && port == last);
+            Transmit(port, egress, source, destination, protocol, true);
+        }
+        return;
+    }
+
+    // 本边缘交换机下的主机: 目的地址改回 AMAC
+    Mac48Address target = destination;
+    uint16_t outPort = L2PortlandTable::NO_PORT;
+    bool upward = false;
+    if (m_portland.IsLocal(destination))
+    {
+        const L2PortlandTable::Host* host = m_portland.FindHost(destination);
+        if (host != nullptr)
+        {
+            outPort = host->port;
+            target = host->amac;
+        }
+    }
+    else
+    {
+        // 与多路径转发相同，把节点 ID 混进哈希，避免每一层对同一条流做出相同的选择
+        uint32_t hash = L2LagHash(packet, false, protocol, source, destination, m_lagHashPolicy);
+        outPort = m_portland.Route(destination, L2LagMix(hash ^ (uint64_t(m_node->GetId()) << 32)));
+        upward = m_portland.GetLevel() == L2PortlandTable::EDGE ||
+                 (m_portland.GetLevel() == L2PortlandTable::AGGREGATION &&
+                  L2Pmac::GetPod(destination) != m_portland.GetPod());
+    }
+
+    if (outPort == L2PortlandTable::NO_PORT)
+    {
+        L2_FRAME_LOG_DEBUG(m_switchName << ": No PortLand route to " << destination);
+        ++m_portlandStats.unroutable;
+        ++inCounters.droppedFiltered;
+        m_dropTrace(packet, inPort, DROP_PORTLAND);
+        return;
+    }
+    if (outPort == inPort)
+    {
+        ++inCounters.droppedSamePort;
+        m_dropTrace(packet, inPort, DROP_SAME_PORT);
+        return;
+    }
+
+    if (target != destination)
+    {
+        ++m_portlandStats.delivered;
+    }
+    else if (upward)
+    {
+        ++m_portlandStats.upward;
+    }
+    else
+    {
+        ++m_portlandStats.downward;
+    }
+    ++m_forwardedFrames;
+    Ptr<Packet> egress = EgressPacket(packet, reuse);
+    Transmit(outPort, egress, source, target, protocol, false);
+}
+
+// ========== 交换结构与出端口队列 ==========
+//
+// 启用后每个出端口副本的路径是:
+//   转发决策 -> 进入出端口队列 (满了按 EgressDropPolicy 丢弃)
+//            -> 交换结构按 FabricCapacity 串行搬运 (所有端口共享)
+//            -> 等待 ForwardingLatency
+//            -> 出端口按链路速率逐帧交给设备
+// 出端口按链路速率发送，所以设备自己的队列基本为空，拥塞体现在交换机的出端口队列上。
+
+bool
+L2SwitchProtocol::IsFabricModelEnabled() const
+{
+    return m_fabricModel;
+}
+
+Time
+L2SwitchProtocol::GetFabricBusyTime() const
+{
+    return m_fabricBusy;
+}
+
+uint64_t
+L2SwitchProtocol::GetPortRate(Ptr<NetDevice> device)
+{
+    // 速率可能是设备的属性 (PointToPoint) 或信道的属性 (CSMA)
+    DataRateValue rate;
+    bool found = device->GetAttributeFailSafe("DataRate", rate);
+    if (!found && device->GetChannel())
+    {
+        found = device->GetChannel()->GetAttributeFailSafe("DataRate", rate);
+    }
+    return found ? rate.Get().GetBitRate() : 0;
+}
+
+void
+L2SwitchProtocol::Transmit(uint16_t outPort,
+                           Ptr<Packet> packet,
+                           const Mac48Address& source,
+                           const Mac48Address& destination,
+                           uint16_t protocol,
+                           bool flooded)
+{
+    Port& port = m_ports[outPort];
+    if (!m_fabricModel)
+    {
+        SendToDevice(outPort, packet, source, destination, protocol, flooded);
+        return;
+    }
+
+    if (port.queue.size() >= m_egressQueueSize)
+    {
+        ++port.counters.droppedQueue;
+        if (m_queueDropPolicy == QUEUE_DROP_TAIL)
+        {
+            m_dropTrace(packet, outPort, DROP_QUEUE_FULL);
+            return;
+        }
+        // DropHead: 队首的帧如果已经在等待发送事件，下面会重新调度
+        m_dropTrace(port.queue.front().packet, outPort, DROP_QUEUE_FULL);
+        port.queue.pop_front();
+        port.drainEvent.Cancel();
+    }
+
+    // 交换结构按总容量串行搬运帧 (以太网帧头 14 字节 + FCS 4 字节)
+    Time now = Simulator::Now();
+    Time readyAt = now;
+    if (m_fabricCapacity.GetBitRate() > 0)
+    {
+        Time start = std::max(now, m_fabricFreeAt);
+        Time transfer = m_fabricCapacity.CalculateBytesTxTime(packet->GetSize() + 18);
+        m_fabricFreeAt = start + transfer;
+        m_fabricBusy += transfer;
+        readyAt = m_fabricFreeAt;
+    }
+    readyAt += m_forwardingLatency;
+
+    port.queue.push_back(QueuedFrame{packet, source, destination, protocol, readyAt, flooded});
+    port.counters.queueHighWater =
+        std::max(port.counters.queueHighWater, static_cast<uint32_t>(port.queue.size()));
+    ScheduleDrain(outPort);
+}
+
+void
+L2SwitchProtocol::SendToDevice(uint16_t outPort,
+                               Ptr<Packet> packet,
+                               const Mac48Address& source,
+                               const Mac48Address& destination,
+                               uint16_t protocol,
+                               bool flooded)
+{
+    Port& port = m_ports[outPort];
+    if (flooded)
+    {
+        ++port.counters.txFlooded;
+    }
+    else
+    {
+        ++port.counters.txUnicast;
+    }
+    m_txTrace(packet, outPort);
+    port.device->SendFrom(packet, source, destination, protocol);
+}
+
+void
+L2SwitchProtocol::ScheduleDrain(uint16_t port)
+{
+    Port& p = m_ports[port];
+    if (p.queue.empty() || p.drainEvent.IsPending())
+    {
+        return;
+    }
+    Time at = std::max({Simulator::Now(), p.busyUntil, p.queue.front().readyAt});
+    p.drainEvent = Simulator::Schedule(at - Simulator::Now(), &L2SwitchProtocol::DrainQueue, this, port);
+}
+
+void
+L2SwitchProtocol::DrainQueue(uint16_t port)
+{
+    Port& p = m_ports[port];
+    QueuedFrame frame = p.queue.front();
+    p.queue.pop_front();
+
+    // 端口在发送完这个帧之前不再取下一个
+    if (p.rate > 0)
+    {
+        p.busyUntil = Simulator::Now() + DataRate(p.rate).CalculateBytesTxTime(
+                                             frame.packet->GetSize() + 18);
+    }
+    SendToDevice(port, frame.packet, frame.source, frame.destination, frame.protocol, frame.flooded);
+    ScheduleDrain(port);
+}
+
+// ========== 链路聚合 ==========
+
+uint16_t
+L2SwitchProtocol::AddLinkAggregation(const std::vector<uint16_t>& ports)
+{
+    NS_ASSERT_MSG(ports.size() >= 2, "A link aggregation needs at least two ports");
+    std::vector<uint16_t> members(ports);
+    std::sort(members.begin(), members.end());
+    members.erase(std::unique(members.begin(), members.end()), members.end());
+    for (const auto& config : m_lagConfigs)
+    {
+        for (uint16_t member : members)
+        {
+            NS_ASSERT_MSG(std::find(config.begin(), config.end(), member) == config.end(),
+                          "Port " << member << " already belongs to a link aggregation");
+        }
+    }
+    m_lagConfigs.push_back(members);
+    NS_LOG_INFO(m_switchName << ": Link aggregation on port " << members.front() << " with "
+               << members.size() << " members");
+
+    if (m_initialized)
+    {
+        for (uint16_t member : members)
+        {
+            FlushPort(member);
+            m_ports[member].device->AddLinkChangeCallback(
+                MakeCallback(&L2SwitchProtocol::LinkStateChanged, this));
+        }
+        RebuildLags();
+        RebuildFloodMasks();
+        RebuildVlanMasks();
+    }
+    return members.front();
+}
+
+uint16_t
+L2SwitchProtocol::GetLogicalPort(uint16_t port) const
+{
+    NS_ASSERT_MSG(port < m_ports.size(), "Invalid port " << port);
+    return m_ports[port].logical;
+}
+
+std::vector<uint16_t>
+L2SwitchProtocol::GetActiveLagMembers(uint16_t port) const
+{
+    auto it = m_lags.find(port);
+    return it != m_lags.end() ? it->second.active : std::vector<uint16_t>{port};
+}
+
+void
+L2SwitchProtocol::RebuildLags()
+{
+    m_lags.clear();
+    for (auto& port : m_ports)
+    {
+        port.lag = false;
+    }
+    for (uint16_t p = 0; p < m_ports.size(); ++p)
+    {
+        m_ports[p].logical = p;
+    }
+
+    for (const auto& config : m_lagConfigs)
+    {
+        uint16_t logical = config.front();
+        L2LinkAggregation& lag = m_lags[logical];
+        lag.members = config;
+        for (uint16_t member : config)
+        {
+            m_ports[member].logical = logical;
+            m_ports[member].lag = true;
+            if (m_ports[member].device->IsLinkUp())
+            {
+                lag.active.push_back(member);
+            }
+        }
+    }
+}
+
+void
+L2SwitchProtocol::LinkStateChanged()
+{
+    for (auto& [logical, lag] : m_lags)
+    {
+        std::vector<uint16_t> active;
+        for (uint16_t member : lag.members)
+        {
+            if (m_ports[member].device->IsLinkUp())
+            {
+                active.push_back(member);
+            }
+            else
+            {
+                // 断开的成员丢弃还没发出的帧
+                m_ports[member].drainEvent.Cancel();
+                m_ports[member].queue.clear();
+            }
+        }
+        if (active != lag.active)
+        {
+            NS_LOG_INFO(m_switchName << ": LAG " << logical << " now has " << active.size()
+                       << "/" << lag.members.size() << " active members");
+            lag.active = std::move(active);
+        }
+    }
+    RebuildFloodMasks();
+}
+
+uint16_t
+L2SwitchProtocol::SelectMember(uint16_t port, uint32_t hash) const
+{
+    if (!m_ports[port].lag)
+    {
+        return port;
+    }
+    return m_lags.find(port)->second.Select(hash);
+}
+
+// ========== MAC 地址学习 ==========
+void
+L2SwitchProtocol::Learn(uint16_t vlan, Mac48Address source, uint16_t inPort)
+{
+    uint64_t key = L2MacTable::PackKey(vlan, source);
+    uint32_t now = GetAgingTick();
+
+    L2MacTable::LearnResult result = m_macTable.Learn(key, inPort, now);
+    if (result == L2MacTable::LEARN_FULL && m_fullPolicy == EVICT_OLDEST)
+    {
+        // 表满: 淘汰采样到的最久没出现的表项，再学习一次
+        uint64_t victim = m_macTable.SampleOldest(key, EVICTION_SAMPLES);
+        if (victim != L2MacTable::EMPTY_KEY)
+        {
+            NS_LOG_INFO(m_switchName << ": MAC table full, evicting "
+                       << L2MacTable::UnpackMac(victim));
+            m_macTable.Remove(victim);
+            Forget(victim, FORGOTTEN_CAPACITY);
+            ++m_stats.evicted;
+            result = m_macTable.Learn(key, inPort, now);
+        }
+    }
+
+    switch (result)
+    {
+    case L2MacTable::LEARN_NEW:
+        // 新 MAC 地址
+        L2_FRAME_LOG_INFO(m_switchName << ": Learned " << source << " on port " << inPort
+                          << " (VLAN " << vlan << ")");
+        ++m_stats.learned;
+        ++m_ports[inPort].counters.learned;
+        m_learnTrace(source, vlan, inPort);
+        m_forgotten.Remove(key);
+        if (m_agingTicks > 0)
+        {
+            ScheduleAging(key, m_macTable.Find(key)->gen, now);
+        }
+        break;
+    case L2MacTable::LEARN_MOVED: {
+        // MAC 地址对应的端口变了
+        L2_FRAME_LOG_INFO(m_switchName << ": Updated " << source << " to port " << inPort);
+        ++m_ports[inPort].counters.moved;
+        m_learnTrace(source, vlan, inPort);
+
+        // 控制器下发的表项被学习覆盖后变为普通表项，开始老化
+        const L2MacTable::Entry* entry = m_macTable.Find(key);
+        if (entry->flags & L2MacTable::FLAG_STATIC)
+        {
+            m_macTable.SetFlags(key, 0);
+            if (m_agingTicks > 0)
+            {
+                ScheduleAging(key, entry->gen, now);
+            }
+        }
+        break;
+    }
+    case L2MacTable::LEARN_REFRESHED:
+        // lastSeen 已在表中更新，不需要操作时间轮
+        break;
+    case L2MacTable::LEARN_FULL:
+        // 表满且策略为 DropNew: 不学习，发往该地址的帧会继续泛洪
+        L2_FRAME_LOG_DEBUG(m_switchName << ": MAC table full, not learning " << source);
+        ++m_stats.rejected;
+        Forget(key, FORGOTTEN_CAPACITY);
+        break;
+    }
+}
+
+// ========== MAC 表老化 ==========
+
+Time
+L2SwitchProtocol::GetAgingClock() const
+{
+    return m_agingEpoch + Simulator::Now();
+}
+
+uint32_t
+L2SwitchProtocol::GetAgingTick() const
+{
+    return static_cast<uint32_t>(GetAgingClock().GetTimeStep() / m_agingGranularity.GetTimeStep());
+}
+
+void
+L2SwitchProtocol::ScheduleAging(uint64_t key, uint8_t gen, uint32_t lastSeen)
+{
+    m_agingWheel.Schedule(key, lastSeen + m_agingTicks, gen);
+
+    // 时间轮从空变为非空时，启动周期事件
+    if (!m_agingEvent.IsPending())
+    {
+        m_agingEvent = Simulator::Schedule(m_agingGranularity, &L2SwitchProtocol::AgingTick, this);
+    }
+}
+
+void
+L2SwitchProtocol::AgingTick()
+{
+    uint32_t now = GetAgingTick();
+
+    m_agingWheel.Advance(now, [this, now](const L2TimerWheel::Item& item) {
+        const L2MacTable::Entry* entry = m_macTable.Find(item.key);
+        if (entry == nullptr || entry->gen != static_cast<uint8_t>(item.cookie) ||
+            (entry->flags & L2MacTable::FLAG_STATIC))
+        {
+            // 表项已经被删除 (淘汰/老化后重新学习) 或已变为静态表项，这是过期的定时项
+            return;
+        }
+        if (entry->lastSeen + m_agingTicks > now)
+        {
+            // 期间被刷新过，按最后一次出现的时间重新定时
+            m_agingWheel.Schedule(item.key, entry->lastSeen + m_agingTicks, item.cookie);
+            return;
+        }
+        NS_LOG_INFO(m_switchName << ": Aged out " << L2MacTable::UnpackMac(item.key)
+                   << " on port " << entry->port);
+        m_macTable.Remove(item.key);
+        Forget(item.key, FORGOTTEN_AGED);
+        ++m_stats.agedOut;
+    });
+
+    if (!m_agingWheel.IsEmpty())
+    {
+        m_agingEvent = Simulator::Schedule(m_agingGranularity, &L2SwitchProtocol::AgingTick, this);
+    }
+}
+
+// ========== 泛洪原因统计 ==========
+
+void
+L2SwitchProtocol::Forget(uint64_t key, uint16_t reason)
+{
+    // 被遗忘地址的记录本身也要有上限，满了就整体清空重新统计
+    uint32_t limit = std::max<uint32_t>(m_maxMacEntries, 4096);
+    if (m_forgotten.GetSize() >= limit)
+    {
+        m_forgotten.Clear();
+    }
+    m_forgotten.Learn(key, reason);
+}
+
+void
+L2SwitchProtocol::CountUnknownFlood(uint64_t key)
+{
+    ++m_stats.unknownFloods;
+    switch (m_forgotten.Lookup(key))
+    {
+    case FORGOTTEN_CAPACITY:
+        ++m_stats.pressureFloods;
+        break;
+    case FORGOTTEN_AGED:
+        ++m_stats.agingFloods;
+        break;
+    default:
+        // 从未学习过的地址
+        break;
+    }
+}
+
+L2SwitchProtocol::MacTableStats
+L2SwitchProtocol::GetMacTableStats() const
+{
+    return m_stats;
+}
+
+void
+L2SwitchProtocol::ReportMacTableStats(std::ostream& os) const
+{
+    os << m_switchName << ": MAC table " << m_macTable.GetSize();
+    if (m_maxMacEntries > 0)
+    {
+        os << "/" << m_maxMacEntries;
+    }
+    os << " entries";
+    if (m_stats.provisioned > 0)
+    {
+        os << ", provisioned " << m_stats.provisioned;
+    }
+    if (m_stats.restored > 0)
+    {
+        os << ", restored " << m_stats.restored;
+    }
+    os << ", learned " << m_stats.learned
+       << ", aged out " << m_stats.agedOut
+       << ", evicted " << m_stats.evicted
+       << ", rejected " << m_stats.rejected << std::endl;
+    os << m_switchName << ": floods: broadcast " << m_stats.broadcastFloods
+       << ", unknown unicast " << m_stats.unknownFloods
+       << " (table pressure " << m_stats.pressureFloods
+       << ", aging " << m_stats.agingFloods << ")" << std::endl;
+    if (m_arpSuppression)
+    {
+        os << m_switchName << ": ARP suppression: " << m_arpStats.suppressed << "/"
+           << m_arpStats.requests << " requests answered locally";
+        if (m_arpStats.requests > 0)
+        {
+            os << " (" << 100.0 * m_arpStats.suppressed / m_arpStats.requests << "%)";
+        }
+        os << ", " << m_arpStats.floodCopiesSaved << " flood copies avoided, "
+           << m_arpCache.GetSize() << " cached, " << m_arpStats.snooped << " snooped, "
+           << m_arpStats.conflicts << " conflicts" << std::endl;
+    }
+    if (m_igmpSnooping)
+    {
+        os << m_switchName << ": IGMP snooping: " << m_mcastGroups.size() << " groups, "
+           << m_routerPorts.Count() << " router ports, " << m_igmpStats.joins << " joins, "
+           << m_igmpStats.leaves << " leaves, " << m_igmpStats.queries << " queries received, "
+           << m_igmpStats.queriesSent << " sent; multicast frames: "
+           << m_igmpStats.registeredFrames << " registered, "
+           << m_igmpStats.unregisteredFrames << " unregistered, "
+           << m_igmpStats.copiesPruned << " flood copies pruned" << std::endl;
+    }
+    if (m_linkState)
+    {
+        os << m_switchName << ": multipath: nickname " << m_linkState->GetNickname() << ", "
+           << m_linkState->GetNReachable() << " switches reachable, " << m_remoteHosts.GetSize()
+           << " remote hosts; encapsulated " << m_multipathStats.encapsulated
+           << ", multi-destination " << m_multipathStats.multiDestination << ", transit "
+           << m_multipathStats.transit << ", decapsulated " << m_multipathStats.decapsulated
+           << ", RPF drops " << m_multipathStats.rpfDrops << ", unreachable "
+           << m_multipathStats.unreachable << std::endl;
+    }
+    if (m_fabricManager)
+    {
+        os << m_switchName << ": PortLand: " << m_portland.GetNHosts() << " hosts, "
+           << m_portland.GetNRoutes() << " routes; ARP resolved " << m_portlandStats.arpResolved
+           << ", flooded " << m_portlandStats.arpFlooded << "; unicast up "
+           << m_portlandStats.upward << ", down " << m_portlandStats.downward << ", delivered "
+           << m_portlandStats.delivered << "; flooded " << m_portlandStats.flooded
+           << ", unroutable " << m_portlandStats.unroutable << std::endl;
+    }
+    if (!m_flowTable.IsEmpty())
+    {
+        m_flowTable.Report(os, m_switchName);
+    }
+}
+
+// ========== 控制器下发 ==========
+
+bool
+L2SwitchProtocol::AddStaticMacEntry(uint16_t vlan, Mac48Address address, uint16_t port)
+{
+    NS_ASSERT_MSG(m_initialized, "AddStaticMacEntry() must be called after Initialize()");
+    NS_ASSERT_MSG(port < m_ports.size(), "Invalid port " << port);
+    uint16_t logical = m_ports[port].logical;
+    uint64_t key = L2MacTable::PackKey(vlan, address);
+
+    L2MacTable::LearnResult result = m_macTable.Learn(key, logical, GetAgingTick());
+    if (result == L2MacTable::LEARN_FULL)
+    {
+        NS_LOG_WARN(m_switchName << ": MAC table full, cannot install " << address);
+        return false;
+    }
+    m_macTable.SetFlags(key, L2MacTable::FLAG_STATIC);
+    if (result == L2MacTable::LEARN_NEW)
+    {
+        ++m_stats.provisioned;
+        m_forgotten.Remove(key);
+    }
+    return true;
+}
+
+bool
+L2SwitchProtocol::AddStaticArpEntry(uint16_t vlan, Ipv4Address ip, Mac48Address address, uint16_t port)
+{
+    if (!m_arpSuppression)
+    {
+        return false;
+    }
+    NS_ASSERT_MSG(port < m_ports.size(), "Invalid port " << port);
+    m_arpCache.Learn(vlan, ip, address, m_ports[port].logical, Simulator::Now());
+    return true;
+}
+
+// ========== 流表 ==========
+
+uint32_t
+L2SwitchProtocol::AddFlow(const L2FlowMatch& match,
+                          uint16_t priority,
+                          const std::vector<L2FlowAction>& actions)
+{
+    uint32_t id = m_flowTable.AddFlow(match, priority, actions);
+    NS_LOG_INFO(m_switchName << ": Flow " << id << " added (priority " << priority << ", "
+               << actions.size() << " actions" << (match.IsExact() ? ", exact" : "") << ")");
+    return id;
+}
+
+bool
+L2SwitchProtocol::RemoveFlow(uint32_t id)
+{
+    return m_flowTable.RemoveFlow(id);
+}
+
+void
+L2SwitchProtocol::AddFlowGroup(uint32_t id, L2FlowGroup::Type type, const std::vector<uint16_t>& ports)
+{
+    m_flowTable.SetGroup(id, type, ports);
+}
+
+const L2FlowTable&
+L2SwitchProtocol::GetFlowTable() const
+{
+    return m_flowTable;
+}
+
+bool
+L2SwitchProtocol::ApplyFlowTable(uint16_t inPort,
+                                 uint16_t inLogical,
+                                 Ptr<const Packet> packet,
+                                 uint16_t protocol,
+                                 uint16_t vlan,
+                                 bool tagged,
+                                 const Mac48Address& source,
+                                 const Mac48Address& destination,
+                                 bool reuse)
+{
+    L2FlowKey key =
+        L2FlowKey::Extract(packet, tagged, protocol, inPort, vlan, source, destination);
+    L2FlowEntry* entry = m_flowTable.Lookup(key, packet->GetSize());
+    if (entry == nullptr)
+    {
+        return false;
+    }
+    L2_FRAME_LOG_INFO(m_switchName << ": Flow " << entry->id << " matched " << source << " -> "
+                      << destination << " on port " << inPort);
+
+    // SET_* 动作只修改这里的局部值，之后的输出动作使用修改后的帧头。
+    // 带标签的帧改 VLAN 时标签在帧里，需要生成一个重写了标签的副本
+    Mac48Address src = source;
+    Mac48Address dst = destination;
+    uint16_t frameVlan = vlan;
+    Ptr<const Packet> frame = packet;
+    bool attempted = false;
+
+    const std::vector<L2FlowAction>& actions = entry->actions;
+    for (std::size_t i = 0; i < actions.size(); ++i)
+    {
+        const L2FlowAction& action = actions[i];
+        if (action.type == L2FlowAction::DROP)
+        {
+            break;
+        }
+
+        // 最后一个动作可以把入帧 (或自己生成的副本) 交给最后一个出端口
+        bool last = (i + 1 == actions.size()) && (reuse || frame != packet);
+        switch (action.type)
+        {
+        case L2FlowAction::OUTPUT:
+            attempted = true;
+            FlowOutput(inPort, inLogical, static_cast<uint16_t>(action.value), frame, protocol,
+                       frameVlan, tagged, src, dst, last);
+            break;
+        case L2FlowAction::FLOOD:
+            attempted = true;
+            if (m_vlans.count(frameVlan) > 0)
+            {
+                ++m_ports[inPort].counters.flooded;
+                ForwardBroadcast(inPort, frame, protocol, frameVlan, tagged, src, dst, last);
+            }
+            break;
+        case L2FlowAction::SET_ETH_SRC:
+            src = action.mac;
+            break;
+        case L2FlowAction::SET_ETH_DST:
+            dst = action.mac;
+            break;
+        case L2FlowAction::SET_VLAN:
+            frameVlan = static_cast<uint16_t>(action.value);
+            if (tagged)
+            {
+                ++m_packetCopies;
+                Ptr<Packet> copy = frame->Copy();
+                L2VlanTag tag;
+                copy->RemoveHeader(tag);
+                tag.SetVid(frameVlan);
+                copy->AddHeader(tag);
+                frame = copy;
+            }
+            break;
+        case L2FlowAction::GROUP: {
+            const L2FlowGroup* group = m_flowTable.GetGroup(action.value);
+            if (group == nullptr || group->ports.empty())
+            {
+                NS_LOG_WARN(m_switchName << ": Flow " << entry->id << " refers to unknown group "
+                           << action.value);
+                break;
+            }
+            attempted = true;
+            if (group->type == L2FlowGroup::SELECT)
+            {
+                // 同一条流总是选中同一个桶
+                uint16_t port = group->ports[key.Hash() % group->ports.size()];
+                FlowOutput(inPort, inLogical, port, frame, protocol, frameVlan, tagged, src, dst,
+                           last);
+                break;
+            }
+            for (std::size_t b = 0; b < group->ports.size(); ++b)
+            {
+                FlowOutput(inPort, inLogical, group->ports[b], frame, protocol, frameVlan, tagged,
+                           src, dst, last && b + 1 == group->ports.size());
+            }
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    // DROP 动作、动作列表为空或者只有 SET_* 动作
+    if (!attempted)
+    {
+        L2_FRAME_LOG_DEBUG(m_switchName << ": Dropping packet, flow " << entry->id);
+        ++m_ports[inPort].counters.droppedFiltered;
+        m_dropTrace(packet, inPort, DROP_FLOW_TABLE);
+    }
+    return true;
+}
+
+bool
+L2SwitchProtocol::FlowOutput(uint16_t inPort,
+                             uint16_t inLogical,
+                             uint16_t outPort,
+                             Ptr<const Packet> packet,
+                             uint16_t protocol,
+                             uint16_t vlan,
+                             bool tagged,
+                             const Mac48Address& source,
+                             const Mac48Address& destination,
+                             bool reuse)
+{
+    // 表项中写的是聚合组成员时换算成逻辑端口
+    uint16_t outLogical =
+        (outPort < m_ports.size()) ? m_ports[outPort].logical : L2MacTable::NO_PORT;
+    if (outLogical == L2MacTable::NO_PORT || outLogical == inLogical ||
+        m_ports[outLogical].state != L2_PORT_FORWARDING || !IsVlanMember(outLogical, vlan))
+    {
+        L2_FRAME_LOG_DEBUG(m_switchName << ": Flow output port " << outPort
+                          << " is not forwarding in VLAN " << vlan);
+        ++m_ports[inPort].counters.droppedFiltered;
+        m_dropTrace(packet, inPort, DROP_EGRESS_BLOCKED);
+        return false;
+    }
+    ForwardUnicast(outLogical, packet, protocol, vlan, tagged, source, destination, reuse);
+    return true;
+}
+
+// ========== MAC 表快照 ==========
+
+std::vector<L2SwitchProtocol::MacEntrySnapshot>
+L2SwitchProtocol::GetMacEntries() const
+{
+    std::vector<MacEntrySnapshot> entries;
+    entries.reserve(m_macTable.GetSize());
+    uint32_t now = GetAgingTick();
+    m_macTable.ForEach([&](uint64_t key, uint16_t port) {
+        const L2MacTable::Entry* entry = m_macTable.Find(key);
+        entries.push_back(MacEntrySnapshot{L2MacTable::UnpackVlan(key),
+                                           L2MacTable::UnpackMac(key),
+                                           port,
+                                           (entry->flags & L2MacTable::FLAG_STATIC) != 0,
+                                           m_agingGranularity * int64_t(now - entry->lastSeen)});
+    });
+    return entries;
+}
+
+uint32_t
+L2SwitchProtocol::RestoreMacEntries(const std::vector<MacEntrySnapshot>& entries, Time snapshotTime)
+{
+    NS_ASSERT_MSG(m_initialized, "RestoreMacEntries() must be called after Initialize()");
+    NS_ASSERT_MSG(Simulator::Now().IsZero(), "RestoreMacEntries() must be called before Simulator::Run()");
+
+    // 老化时钟从快照时间继续，表项的 lastSeen 与保存时的相对关系不变。
+    // 运行开始前时间轮里只可能有这里定时的表项，可以直接重置
+    m_agingEpoch = snapshotTime;
+    m_agingWheel.Reset(GetAgingTick());
+    uint32_t now = GetAgingTick();
+
+    uint32_t restored = 0;
+    for (const MacEntrySnapshot& e : entries)
+    {
+        if (e.port >= m_ports.size() || m_ports[e.port].logical != e.port)
+        {
+            NS_LOG_WARN(m_switchName << ": Snapshot entry " << e.address << " on invalid port "
+                       << e.port << ", skipped");
+            continue;
+        }
+        uint32_t idle = static_cast<uint32_t>(
+            std::min<int64_t>(now, e.idle.GetTimeStep() / m_agingGranularity.GetTimeStep()));
+        if (!e.isStatic && m_agingTicks > 0 && idle >= m_agingTicks)
+        {
+            continue;  // 在当前的 AgingTime 下已经过期
+        }
+
+        uint64_t key = L2MacTable::PackKey(e.vlan, e.address);
+        uint32_t lastSeen = now - idle;
+        L2MacTable::LearnResult result = m_macTable.Learn(key, e.port, lastSeen);
+        if (result == L2MacTable::LEARN_FULL)
+        {
+            ++m_stats.rejected;
+            continue;
+        }
+        const L2MacTable::Entry* entry = m_macTable.Find(key);
+        if (e.isStatic)
+        {
+            m_macTable.SetFlags(key, L2MacTable::FLAG_STATIC);
+        }
+        else if (m_agingTicks > 0 && result == L2MacTable::LEARN_NEW)
+        {
+            ScheduleAging(key, entry->gen, lastSeen);
+        }
+        m_forgotten.Remove(key);
+        ++restored;
+    }
+    m_stats.restored += restored;
+    NS_LOG_INFO(m_switchName << ": Restored " << restored << " of " << entries.size()
+               << " MAC entries (snapshot at " << snapshotTime.As(Time::S) << ")");
+    return restored;
+}
+
+// ========== 风暴控制 ==========
+
+void
+L2SwitchProtocol::SetStormControl(uint16_t port, L2StormClass cls, uint64_t pps, DataRate rate)
+{
+    NS_ASSERT_MSG(cls < L2_STORM_CLASSES, "Invalid storm-control class");
+    NS_LOG_INFO(m_switchName << ": Port " << port << " storm control class " << unsigned(cls)
+               << ": " << pps << " pps, " << rate);
+    m_stormSettings.push_back(StormSetting{port, cls, pps, rate.GetBitRate()});
+    if (m_initialized)
+    {
+        ConfigureStormControl();
+    }
+}
+
+void
+L2SwitchProtocol::ConfigureStormControl()
+{
+    Time now = Simulator::Now();
+    for (auto& port : m_ports)
+    {
+        port.storm.Set(L2_STORM_BROADCAST, m_broadcastStormPps,
+                       m_broadcastStormRate.GetBitRate(), m_stormBurst, now);
+        port.storm.Set(L2_STORM_MULTICAST, m_multicastStormPps,
+                       m_multicastStormRate.GetBitRate(), m_stormBurst, now);
+        port.storm.Set(L2_STORM_UNKNOWN_UNICAST, m_unknownStormPps,
+                       m_unknownStormRate.GetBitRate(), m_stormBurst, now);
+    }
+    for (const StormSetting& setting : m_stormSettings)
+    {
+        NS_ASSERT_MSG(setting.port < m_ports.size(), "Invalid port " << setting.port);
+        m_ports[setting.port].storm.Set(setting.cls, setting.pps, setting.bps, m_stormBurst, now);
+    }
+
+    m_stormControl = false;
+    for (const auto& port : m_ports)
+    {
+        m_stormControl = m_stormControl || port.storm.IsEnabled();
+    }
+}
+
+bool
+L2SwitchProtocol::AdmitFlood(uint16_t inPort, L2StormClass cls, Ptr<const Packet> packet)
+{
+    Port& port = m_ports[inPort];
+    // 以太网帧头 14 字节 + FCS 4 字节
+    if (port.storm.Admit(cls, packet->GetSize() + 18, Simulator::Now()))
+    {
+        return true;
+    }
+    L2_FRAME_LOG_DEBUG(m_switchName << ": Storm control dropped a frame of class "
+                       << unsigned(cls) << " on port " << inPort);
+    ++port.counters.droppedStorm[cls];
+    m_dropTrace(packet, inPort, DROP_STORM_CONTROL);
+    return false;
+}
+
+// ========== ARP 抑制 ==========
+
+bool
+L2SwitchProtocol::HandleArp(uint16_t inPort,
+                            uint16_t inLogical,
+                            Ptr<const Packet> packet,
+                            bool tagged,
+                            uint16_t vlan,
+                            const Mac48Address& source)
+{
+    ArpHeader arp;
+    uint32_t tagSize = tagged ? L2VlanTag().GetSerializedSize() : 0;
+    if (packet->GetSize() < tagSize + arp.GetSerializedSize())
+    {
+        return false;
+    }
+    if (tagged)
+    {
+        // ARP 很少，带标签时复制一份去掉标签再解析
+        ++m_packetCopies;
+        Ptr<Packet> copy = packet->Copy();
+        L2VlanTag tag;
+        copy->RemoveHeader(tag);
+        copy->PeekHeader(arp);
+    }
+    else
+    {
+        packet->PeekHeader(arp);
+    }
+
+    Mac48Address senderMac = Mac48Address::ConvertFrom(arp.GetSourceHardwareAddress());
+    Ipv4Address senderIp = arp.GetSourceIpv4Address();
+    Time now = Simulator::Now();
+
+    // 监听请求和回复中的发送方。ARP 探测的发送方 IP 是 0.0.0.0，不记录；
+    // 发送方 MAC 与帧的源 MAC 不一致的报文不可信，也不记录
+    if (senderMac == source && !senderIp.IsAny())
+    {
+        switch (m_arpCache.Learn(vlan, senderIp, senderMac, inLogical, now))
+        {
+        case L2ArpCache::ARP_NEW:
+            ++m_arpStats.snooped;
+            break;
+        case L2ArpCache::ARP_CONFLICT:
+            NS_LOG_WARN(m_switchName << ": ARP conflict for " << senderIp << " (now claimed by "
+                        << senderMac << "), no longer answering for it");
+            ++m_arpStats.conflicts;
+            break;
+        default:
+            break;
+        }
+    }
+
+    if (!arp.IsRequest())
+    {
+        return false;
+    }
+    ++m_arpStats.requests;
+
+    // 免费 ARP 是主机在宣告自己的地址，照常泛洪
+    Ipv4Address targetIp = arp.GetDestinationIpv4Address();
+    if (targetIp == senderIp)
+    {
+        return false;
+    }
+    const L2ArpCache::Entry* entry = m_arpCache.Lookup(vlan, targetIp, now);
+    if (entry == nullptr || entry->port == inLogical)
+    {
+        // 不知道，或者目标就在入端口那一侧 (它自己会回复)
+        return false;
+    }
+    Mac48Address targetMac = entry->mac;
+
+    // 代替目标主机回复，按入端口的 VLAN 配置决定是否带标签
+    ArpHeader replyHeader;
+    replyHeader.SetReply(targetMac, targetIp, senderMac, senderIp);
+    Ptr<Packet> reply = Create<Packet>();
+    reply->AddHeader(replyHeader);
+    uint16_t replyProtocol = ARP_PROTOCOL;
+    if (!m_vlans[vlan].untagged.Test(inLogical))
+    {
+        reply->AddHeader(L2VlanTag(vlan, ARP_PROTOCOL));
+        replyProtocol = L2VlanTag::PROTOCOL;
+    }
+
+    // 记录本来要泛洪到多少个端口
+    m_floodSame = m_floodMasks[inPort];
+    m_floodSame &= m_vlans[vlan].members;
+    m_arpStats.floodCopiesSaved += m_floodSame.Count();
+    ++m_arpStats.suppressed;
+
+    L2_FRAME_LOG_INFO(m_switchName << ": ARP suppression, answering " << targetIp << " is at "
+                      << targetMac << " to " << senderMac);
+    Transmit(inPort, reply, targetMac, senderMac, replyProtocol, false);
+    return true;
+}
+
+L2SwitchProtocol::ArpStats
+L2SwitchProtocol::GetArpStats() const
+{
+    return m_arpStats;
+}
+
+// ========== IGMP 侦听 ==========
+
+void
+L2SwitchProtocol::AddMulticastMember(uint16_t port, Ipv4Address group, uint16_t vlan)
+{
+    NS_ASSERT_MSG(vlan >= 1 && vlan <= L2VlanTag::MAX_VLAN, "Invalid VLAN " << vlan);
+    NS_LOG_INFO(m_switchName << ": Port " << port << " static member of " << group << " in VLAN "
+               << vlan);
+    Mac48Address mac = Mac48Address::GetMulticast(group);
+    m_staticGroups.push_back(StaticGroup{port, vlan, mac});
+    if (m_initialized && m_igmpSnooping)
+    {
+        NS_ASSERT_MSG(port < m_ports.size(), "Invalid port " << port);
+        JoinGroup(vlan, mac, m_ports[port].logical, Seconds(0), true);
+    }
+}
+
+void
+L2SwitchProtocol::AddMulticastRouterPort(uint16_t port)
+{
+    NS_LOG_INFO(m_switchName << ": Port " << port << " static multicast router port");
+    m_staticRouterPorts.push_back(port);
+    if (m_initialized && m_igmpSnooping)
+    {
+        NS_ASSERT_MSG(port < m_ports.size(), "Invalid port " << port);
+        m_routerPorts.Set(m_ports[port].logical);
+        m_routerExpires[m_ports[port].logical] = Time::Max();
+    }
+}
+
+std::vector<uint16_t>
+L2SwitchProtocol::GetMulticastPorts(uint16_t vlan, Ipv4Address group) const
+{
+    std::vector<uint16_t> ports;
+    auto it = m_mcastGroups.find(L2MacTable::PackKey(vlan, Mac48Address::GetMulticast(group)));
+    if (it != m_mcastGroups.end())
+    {
+        it->second.ports.ForEach([&ports](uint32_t port) {
+            ports.push_back(static_cast<uint16_t>(port));
+        });
+    }
+    return ports;
+}
+
+L2SwitchProtocol::IgmpStats
+L2SwitchProtocol::GetIgmpStats() const
+{
+    return m_igmpStats;
+}
+
+void
+L2SwitchProtocol::ForwardMulticast(uint16_t inPort,
+                                   uint16_t inLogical,
+                                   Ptr<const Packet> packet,
+                                   uint16_t protocol,
+                                   uint16_t vlan,
+                                   bool tagged,
+                                   const Mac48Address& source,
+                                   const Mac48Address& destination,
+                                   bool reuse)
+{
+    if (!AdmitFlood(inPort, L2_STORM_MULTICAST, packet))
+    {
+        return;
+    }
+
+    // IGMP 报文: 查询泛洪给所有主机；报告和离开只发往路由器端口 (RFC 4541)，
+    // 这样其他主机听不到报告、不会抑制自己的报告，每个成员端口都能被学到
+    const L2PortMask* egress = nullptr;  // nullptr 表示泛洪
+    Ipv4Address sourceIp;
+    if (protocol == L2Igmp::IPV4_PROTOCOL &&
+        L2Igmp::Parse(packet, tagged ? L2VlanTag().GetSerializedSize() : 0, m_igmpBuffer,
+                      m_igmpRecords, sourceIp))
+    {
+        if (!SnoopIgmp(inLogical, vlan, source, sourceIp))
+        {
+            m_mcastEgress = m_routerPorts;
+            egress = &m_mcastEgress;
+        }
+    }
+    else if (!L2Igmp::IsLinkLocalGroup(destination))
+    {
+        // 224.0.0.x 是路由协议等使用的本地控制组，主机不会为它们发送报告，总是泛洪
+        auto it = m_mcastGroups.find(L2MacTable::PackKey(vlan, destination));
+        if (it != m_mcastGroups.end())
+        {
+            m_mcastEgress = it->second.ports;
+            m_mcastEgress |= m_routerPorts;
+            egress = &m_mcastEgress;
+            ++m_igmpStats.registeredFrames;
+        }
+        else
+        {
+            ++m_igmpStats.unregisteredFrames;
+            if (!m_floodUnregistered)
+            {
+                m_mcastEgress = m_routerPorts;
+                egress = &m_mcastEgress;
+            }
+        }
+    }
+
+    PortCounters& inCounters = m_ports[inPort].counters;
+    if (egress == nullptr)
+    {
+        L2_FRAME_LOG_INFO(m_switchName << ": Flooding multicast " << destination << " in VLAN "
+                          << vlan);
+        ++inCounters.flooded;
+        ForwardBroadcast(inPort, packet, protocol, vlan, tagged, source, destination, reuse);
+        return;
+    }
+
+    // 与泛洪相比少发的副本 (m_floodSame 只是借用，ForwardBroadcast 会重新计算)
+    m_floodSame = m_floodMasks[inPort];
+    m_floodSame &= m_vlans[vlan].members;
+    uint32_t floodCopies = m_floodSame.Count();
+    m_floodSame.AndNot(*egress);
+    uint32_t pruned = m_floodSame.Count();
+    m_igmpStats.copiesPruned += pruned;
+    if (pruned == floodCopies)
+    {
+        L2_FRAME_LOG_DEBUG(m_switchName << ": No member port for " << destination << " in VLAN "
+                           << vlan);
+        return;
+    }
+
+    L2_FRAME_LOG_INFO(m_switchName << ": Forwarding multicast " << destination << " to "
+                      << floodCopies - pruned << " member/router ports");
+    ForwardBroadcast(inPort, packet, protocol, vlan, tagged, source, destination, reuse, egress);
+}
+
+bool
+L2SwitchProtocol::SnoopIgmp(uint16_t inLogical,
+                            uint16_t vlan,
+                            const Mac48Address& source,
+                            Ipv4Address sourceIp)
+{
+    Time now = Simulator::Now();
+    bool query = false;
+    for (const L2IgmpRecord& record : m_igmpRecords)
+    {
+        Mac48Address group = Mac48Address::GetMulticast(record.group);
+        switch (record.kind)
+        {
+        case L2IgmpRecord::IGMP_QUERY: {
+            query = true;
+            ++m_igmpStats.queries;
+
+            // 收到查询的端口通向组播路由器 (或查询器)，组播数据和报告都要发往这里
+            if (!m_routerPorts.Test(inLogical))
+            {
+                NS_LOG_INFO(m_switchName << ": Multicast router port " << inLogical);
+            }
+            m_routerPorts.Set(inLogical);
+            if (m_routerExpires[inLogical] != Time::Max())
+            {
+                m_routerExpires[inLogical] = now + m_igmpMembershipTimeout;
+            }
+
+            // 查询器选举: 有 IP 地址的查询器 (组播路由器) 总是优先；
+            // 源地址都是 0.0.0.0 (其他交换机) 时 MAC 地址小的优先
+            Mac48Address bridgeMac = Mac48Address::ConvertFrom(m_ports[0].device->GetAddress());
+            if (m_igmpQuerier && (sourceIp.Get() != 0 ||
+                                  L2MacTable::PackMac(source) < L2MacTable::PackMac(bridgeMac)))
+            {
+                m_otherQuerierUntil = now + m_igmpMembershipTimeout;
+            }
+            break;
+        }
+        case L2IgmpRecord::IGMP_JOIN:
+            ++m_igmpStats.joins;
+            if (!L2Igmp::IsLinkLocalGroup(group))
+            {
+                JoinGroup(vlan, group, inLogical, now + m_igmpMembershipTimeout, false);
+            }
+            break;
+        case L2IgmpRecord::IGMP_LEAVE: {
+            ++m_igmpStats.leaves;
+            auto it = m_mcastGroups.find(L2MacTable::PackKey(vlan, group));
+            if (it == m_mcastGroups.end() || !it->second.ports.Test(inLogical) ||
+                it->second.staticPorts.Test(inLogical))
+            {
+                break;
+            }
+
+            // 同一端口上可能还有其他成员 (共享网段或下游交换机)，不立即删除:
+            // 保留 LastMemberTime，期间其他成员的报告会重新刷新超时
+            Time& expires = it->second.expires[inLogical];
+            expires = std::min(expires, now + m_igmpLastMemberTime);
+            L2_FRAME_LOG_INFO(m_switchName << ": Leave for " << record.group << " on port "
+                              << inLogical << ", member until " << expires.As(Time::S));
+
+            // 本机是查询器时向该端口发送特定组查询，让剩下的成员及时回应
+            if (m_igmpQuerier && now >= m_otherQuerierUntil)
+            {
+                SendIgmpQuery(inLogical, vlan, record.group);
+            }
+            break;
+        }
+        }
+    }
+    ScheduleIgmpTick();
+    return query;
+}
+
+void
+L2SwitchProtocol::JoinGroup(uint16_t vlan,
+                            const Mac48Address& group,
+                            uint16_t port,
+                            Time expires,
+                            bool isStatic)
+{
+    uint32_t nPorts = static_cast<uint32_t>(m_ports.size());
+    auto [it, inserted] = m_mcastGroups.try_emplace(L2MacTable::PackKey(vlan, group));
+    MulticastGroup& entry = it->second;
+    if (inserted)
+    {
+        entry.ports = L2PortMask(nPorts);
+        entry.staticPorts = L2PortMask(nPorts);
+        entry.expires.assign(nPorts, Seconds(0));
+    }
+    if (!entry.ports.Test(port))
+    {
+        L2_FRAME_LOG_INFO(m_switchName << ": Port " << port << " joined " << group << " in VLAN "
+                          << vlan);
+    }
+    entry.ports.Set(port);
+    if (isStatic)
+    {
+        entry.staticPorts.Set(port);
+    }
+    else
+    {
+        entry.expires[port] = expires;
+    }
 }
 
 void
-L2SwitchProtocol::DoInitialize()
+L2SwitchProtocol::ScheduleIgmpTick()
 {
-    NS_LOG_FUNCTION(this);
-    Object::DoInitialize();
+    if (!m_igmpEvent.IsPending())
+    {
+        m_igmpEvent = Simulator::Schedule(Seconds(0), &L2SwitchProtocol::IgmpTick, this);
+    }
 }
 
-// ========== Getter/Setter ==========
 void
-L2SwitchProtocol::SetNode(Ptr<Node> node)
+L2SwitchProtocol::IgmpTick()
 {
-    NS_LOG_FUNCTION(this << node);
-    m_node = node;
-}
+    Time now = Simulator::Now();
+    bool dynamic = false;  // 是否还有会超时的状态
 
-Ptr<Node>
-L2SwitchProtocol::GetNode() const
-{
-    return m_node;
+    // 删除超时的动态成员，组没有成员时删除整个组
+    for (auto it = m_mcastGroups.begin(); it != m_mcastGroups.end();)
+    {
+        MulticastGroup& entry = it->second;
+        L2PortMask dynamicPorts = entry.ports;
+        dynamicPorts.AndNot(entry.staticPorts);
+        dynamicPorts.ForEach([&](uint32_t port) {
+            if (entry.expires[port] <= now)
+            {
+                entry.ports.Reset(port);
+                L2_FRAME_LOG_INFO(m_switchName << ": Port " << port << " left multicast group "
+                                  << "(membership timed out)");
+            }
+            else
+            {
+                dynamic = true;
+            }
+        });
+        it = entry.ports.IsEmpty() ? m_mcastGroups.erase(it) : std::next(it);
+    }
+
+    // 路由器端口同样超时 (静态路由器端口的超时时刻是 Time::Max())
+    L2PortMask routers = m_routerPorts;
+    routers.ForEach([&](uint32_t port) {
+        if (m_routerExpires[port] <= now)
+        {
+            m_routerPorts.Reset(port);
+            NS_LOG_INFO(m_switchName << ": Multicast router port " << port << " timed out");
+        }
+        else if (m_routerExpires[port] != Time::Max())
+        {
+            dynamic = true;
+        }
+    });
+
+    // 查询器: 没有其他查询器时按间隔发送通用查询，启动阶段间隔为 1/4
+    if (m_igmpQuerier && now >= m_otherQuerierUntil && now >= m_nextQuery)
+    {
+        SendIgmpQuery();
+        Time interval = m_igmpQueryInterval;
+        if (m_startupQueries > 0)
+        {
+            --m_startupQueries;
+            interval = m_igmpQueryInterval / 4;
+        }
+        m_nextQuery = now + interval;
+    }
+
+    // 每秒检查一次超时；查询间隔更短时按查询时刻调度
+    if (m_igmpQuerier || dynamic)
+    {
+        Time next = Seconds(1);
+        if (m_igmpQuerier && m_nextQuery > now)
+        {
+            next = std::min(next, m_nextQuery - now);
+        }
+        m_igmpEvent = Simulator::Schedule(next, &L2SwitchProtocol::IgmpTick, this);
+    }
 }
 
 void
-L2SwitchProtocol::SetSwitchName(const std::string& name)
+L2SwitchProtocol::SendIgmpQuery()
 {
-    m_switchName = name;
+    NS_LOG_INFO(m_switchName << ": Sending IGMP general queries");
+    for (const auto& [vlan, vlanPorts] : m_vlans)
+    {
+        vlanPorts.members.ForEach([&, vlanId = vlan](uint32_t port) {
+            if (m_ports[port].logical == port && m_ports[port].state == L2_PORT_FORWARDING)
+            {
+                SendIgmpQuery(static_cast<uint16_t>(port), vlanId, Ipv4Address::GetZero());
+            }
+        });
+    }
 }
 
-// ========== 初始化协议 ==========
 void
-L2SwitchProtocol::Initialize()
+L2SwitchProtocol::SendIgmpQuery(uint16_t port, uint16_t vlan, Ipv4Address group)
 {
-    NS_LOG_FUNCTION(this);
-
-    if (m_initialized)
+    uint16_t member = SelectMember(port, 0);
+    if (member == L2MacTable::NO_PORT)
     {
         return;
     }
 
-    NS_ASSERT_MSG(m_node != nullptr, "Node must be set before Initialize()");
-
-    // 遍历节点上的所有网络设备
-    uint32_t nDevices = m_node->GetNDevices();
-    NS_LOG_INFO(m_switchName << ": Initializing with " << nDevices << " devices");
-
-    for (uint32_t i = 0; i < nDevices; ++i)
+    // 通用查询发往 224.0.0.1 (所有主机)，特定组查询发往组地址本身。
+    // 交换机没有 IP 地址，源地址用 0.0.0.0 (RFC 4541 2.1.1)
+    bool general = (group.Get() == 0);
+    Ipv4Address destination = general ? Ipv4Address("224.0.0.1") : group;
+    uint8_t maxResponse = general ? 100
+                                  : static_cast<uint8_t>(std::clamp<int64_t>(
+                                        m_igmpLastMemberTime.GetMilliSeconds() / 100, 1, 255));
+    Ptr<Packet> query = L2Igmp::MakeMessage(L2Igmp::TYPE_QUERY, group, Ipv4Address::GetZero(),
+                                            destination, maxResponse);
+    uint16_t protocol = L2Igmp::IPV4_PROTOCOL;
+    if (!m_vlans[vlan].untagged.Test(port))
     {
-        Ptr<NetDevice> device = m_node->GetDevice(i);
+        query->AddHeader(L2VlanTag(vlan, protocol));
+        protocol = L2VlanTag::PROTOCOL;
+    }
 
-        // 注册混杂模式回调
-        // 这样我们就能监听所有经过这个设备的数据包
-        device->SetPromiscReceiveCallback(
-            MakeCallback(&L2SwitchProtocol::ReceiveFromDevice, this));
+    ++m_igmpStats.queriesSent;
+    Transmit(member, query, Mac48Address::ConvertFrom(m_ports[0].device->GetAddress()),
+             Mac48Address::GetMulticast(destination), protocol, true);
+}
 
-        NS_LOG_INFO(m_switchName << ": Registered callback on device " << i
-                   << " (MAC: " << Mac48Address::ConvertFrom(device->GetAddress()) << ")");
-    }
+// ========== 查找学习到的端口 ==========
 
-    m_initialized = true;
+uint16_t
+L2SwitchProtocol::GetLearnedPort(uint16_t vlan, Mac48Address destination) const
+{
+    return m_macTable.Lookup(L2MacTable::PackKey(vlan, destination));
 }
 
-// ========== 核心转发逻辑 ==========
+// ========== 零拷贝转发 ==========
+//
+// ns-3 的 Packet::Copy() 只复制 Packet 对象本身，字节缓冲区是写时复制共享的；
+// 但每个出端口仍然需要一个独立的 Packet 对象，因为设备会在上面添加以太网帧头、
+// 放进自己的队列。因此一个入帧转发到 N 个端口至少需要 N 个 Packet 对象。
+//
+// 入帧本身就是其中一个: 如果转发之后没有人再读取它，就把它直接交给最后一个
+// 出端口，于是单播转发不再复制，泛洪少复制一次。
+
 bool
-L2SwitchProtocol::ReceiveFromDevice(Ptr<NetDevice> inDevice,
-                                   Ptr<const Packet> packet,
-                                   uint16_t protocol,
-                                   const Address& from,
-                                   const Address& to,
-                                   NetDevice::PacketType packetType)
+L2SwitchProtocol::CanReuseIngress(NetDevice::PacketType packetType) const
 {
-    NS_LOG_FUNCTION(this << inDevice << packet << protocol << from << to << packetType);
+    return m_zeroCopy && (packetType == NetDevice::PACKET_OTHERHOST || m_pureL2);
+}
 
-    // 将地址转换为 MAC 地址（真实的数据帧来源和目的）
-    Mac48Address srcMac = Mac48Address::ConvertFrom(from);
-    Mac48Address dstMac = Mac48Address::ConvertFrom(to);
+Ptr<Packet>
+L2SwitchProtocol::EgressPacket(Ptr<const Packet> packet, bool reuse)
+{
+    if (reuse)
+    {
+        return ConstCast<Packet>(packet);
+    }
+    ++m_packetCopies;
+    return packet->Copy();
+}
 
-    NS_LOG_DEBUG(m_switchName << ": Received packet from " << srcMac << " to " << dstMac
-                << " on device " << inDevice->GetIfIndex());
+uint64_t
+L2SwitchProtocol::GetForwardedFrames() const
+{
+    return m_forwardedFrames;
+}
 
-    // 步骤 1: 学习源 MAC 地址
-    Learn(srcMac, inDevice);
+uint64_t
+L2SwitchProtocol::GetPacketCopies() const
+{
+    return m_packetCopies;
+}
 
-    // 步骤 2: 转发决策
-    if (dstMac.IsBroadcast())
+// ========== 端口计数器 ==========
+
+L2SwitchProtocol::PortCounters
+L2SwitchProtocol::GetPortCounters(uint16_t port) const
+{
+    NS_ASSERT_MSG(port < m_ports.size(), "Invalid port " << port);
+    return m_ports[port].counters;
+}
+
+void
+L2SwitchProtocol::ReportPortCounters(std::ostream& os) const
+{
+    os << m_switchName << ": forwarded " << m_forwardedFrames << " frames, "
+       << m_packetCopies << " packet copies";
+    if (m_fabricModel)
     {
-        // 广播帧 - 泛洪到所有端口
-        NS_LOG_INFO(m_switchName << ": Broadcasting packet from " << srcMac);
-        ForwardBroadcast(inDevice, packet, protocol, srcMac, dstMac);
+        os << ", fabric busy " << m_fabricBusy.As(Time::S);
     }
-    else
+    os << std::endl;
+    for (uint16_t i = 0; i < m_ports.size(); ++i)
     {
-        // 单播帧 - 查找目的端口
-        Ptr<NetDevice> outDevice = GetLearnedPort(dstMac);
-
-        if (outDevice && outDevice != inDevice)
+        const PortCounters& c = m_ports[i].counters;
+        os << "  port " << i;
+        if (m_ports[i].lag)
         {
-            // 已知目的端口，单播转发
-            NS_LOG_INFO(m_switchName << ": Forwarding " << srcMac << " -> " << dstMac
-                       << " via port " << outDevice->GetIfIndex());
-            ForwardUnicast(outDevice, packet, protocol, srcMac, dstMac);
+            os << " (LAG " << m_ports[i].logical
+               << (m_ports[i].device->IsLinkUp() ? "" : ", link down") << ")";
         }
-        else if (!outDevice)
+        os << ": rx " << c.rxFrames
+           << ", tx unicast " << c.txUnicast
+           << ", tx flooded " << c.txFlooded
+           << ", flooded in " << c.flooded
+           << ", learned " << c.learned
+           << ", moved " << c.moved
+           << ", dropped same-port " << c.droppedSamePort
+           << ", dropped filtered " << c.droppedFiltered;
+        if (m_fabricModel)
         {
-            // 未知目的端口，泛洪
-            NS_LOG_INFO(m_switchName << ": Unknown destination " << dstMac << ", flooding");
-            ForwardBroadcast(inDevice, packet, protocol, srcMac, dstMac);
+            os << ", dropped queue-full " << c.droppedQueue
+               << ", queue high water " << c.queueHighWater;
         }
-        else
+        if (m_stormControl)
         {
-            // 目的端口就是入端口，丢弃（避免环路）
-            NS_LOG_DEBUG(m_switchName << ": Dropping packet, destination on same port");
+            os << ", storm-suppressed broadcast " << c.droppedStorm[L2_STORM_BROADCAST]
+               << " multicast " << c.droppedStorm[L2_STORM_MULTICAST]
+               << " unknown-unicast " << c.droppedStorm[L2_STORM_UNKNOWN_UNICAST];
         }
+        os << std::endl;
     }
-
-    return true;  // 返回 true 表示数据包已处理
 }
 
-// ========== MAC 地址学习 ==========
-void
-L2SwitchProtocol::Learn(Mac48Address source, Ptr<NetDevice> inDevice)
-{
-    auto it = m_macTable.find(source);
+// ========== 802.1Q 标签 ==========
 
-    if (it == m_macTable.end())
+Ptr<Packet>
+L2SwitchProtocol::RetagPacket(Ptr<const Packet> packet, bool tagged, uint16_t vlan, uint16_t protocol)
+{
+    ++m_packetCopies;
+    Ptr<Packet> copy = packet->Copy();
+    if (tagged)
     {
-        // 新 MAC 地址
-        m_macTable[source] = inDevice;
-        NS_LOG_INFO(m_switchName << ": Learned " << source
-                   << " on port " << inDevice->GetIfIndex());
+        L2VlanTag tag;
+        copy->RemoveHeader(tag);
     }
-    else if (it->second != inDevice)
+    else
     {
-        // MAC 地址对应的端口变了
-        it->second = inDevice;
-        NS_LOG_INFO(m_switchName << ": Updated " << source
-                   << " to port " << inDevice->GetIfIndex());
+        copy->AddHeader(L2VlanTag(vlan, protocol));
     }
-}
-
-// ========== 查找学习到的端口 ==========
-
-Ptr<NetDevice>
-L2SwitchProtocol::GetLearnedPort(Mac48Address destination)
-{
-    auto it = m_macTable.find(destination);
-    return (it != m_macTable.end()) ? it->second : nullptr;
+    return copy;
 }
 
 // ========== 单播转发 ==========
 void
-L2SwitchProtocol::ForwardUnicast(Ptr<NetDevice> outDevice,
+L2SwitchProtocol::ForwardUnicast(uint16_t outPort,
                                 Ptr<const Packet> packet,
                                 uint16_t protocol,
+                                uint16_t vlan,
+                                bool tagged,
                                 const Mac48Address& source,
-                                const Mac48Address& destination)
+                                const Mac48Address& destination,
+                                bool reuse)
 {
-    NS_LOG_FUNCTION(this << outDevice << packet << protocol << destination);
+    L2_FRAME_LOG_FUNCTION(this << outPort << packet << protocol << vlan << destination);
+
+    // 聚合组: 按帧头哈希选择一个可用成员
+    uint16_t member = outPort;
+    if (m_ports[outPort].lag)
+    {
+        member = SelectMember(
+            outPort, L2LagHash(packet, tagged, protocol, source, destination, m_lagHashPolicy));
+        if (member == L2MacTable::NO_PORT)
+        {
+            ++m_ports[outPort].counters.droppedFiltered;
+            m_dropTrace(packet, outPort, DROP_EGRESS_BLOCKED);
+            return;
+        }
+    }
+
+    ++m_forwardedFrames;
+
+    // 出端口要求的标签格式与入帧不同时，发送加/去标签后的副本
+    bool egressTagged = !m_vlans[vlan].untagged.Test(outPort);
+    Ptr<Packet> egress = (egressTagged == tagged) ? EgressPacket(packet, reuse)
+                                                  : RetagPacket(packet, tagged, vlan, protocol);
 
     // 保留原始源 MAC，使用 SendFrom 发送
-    outDevice->SendFrom(packet->Copy(), source, destination, protocol);
+    Transmit(member, egress, source, destination, egressTagged ? L2VlanTag::PROTOCOL : protocol,
+             false);
 }
 
 // ========== 广播转发 ==========
 void
-L2SwitchProtocol::ForwardBroadcast(Ptr<NetDevice> inDevice,
+L2SwitchProtocol::ForwardBroadcast(uint16_t inPort,
                                   Ptr<const Packet> packet,
                                   uint16_t protocol,
+                                  uint16_t vlan,
+                                  bool tagged,
                                   const Mac48Address& source,
-                                  const Mac48Address& destination)
+                                  const Mac48Address& destination,
+                                  bool reuse,
+                                  const L2PortMask* egressPorts)
 {
-    NS_LOG_FUNCTION(this << inDevice << packet << protocol << destination);
+    L2_FRAME_LOG_FUNCTION(this << inPort << packet << protocol << vlan << destination);
 
-    // 向所有端口转发（除了入端口）
-    uint32_t nDevices = m_node->GetNDevices();
-    for (uint32_t i = 0; i < nDevices; ++i)
+    ++m_forwardedFrames;
+
+    // 多路径: 从边缘端口进入的帧还要沿分发树发往其他交换机。
+    // 必须在本地端口拿到入帧之前封装，因为最后一个本地端口可能直接发送入帧本身
+    if (m_linkState && !m_linkState->IsCorePort(m_ports[inPort].logical))
     {
-        Ptr<NetDevice> device = m_node->GetDevice(i);
-        if (device != inDevice)
-        {
-            device->SendFrom(packet->Copy(), source, destination, protocol);
-        }
+        FloodToSwitches(packet, protocol, vlan, tagged, source, destination);
+    }
+
+    // 预先算好的泛洪集合（已排除入端口和阻塞端口）与 VLAN 成员取交集，
+    // 再按出端口要求的标签格式分成两组
+    const VlanPorts& vlanPorts = m_vlans[vlan];
+    m_floodSame = m_floodMasks[inPort];
+    m_floodSame &= vlanPorts.members;
+    if (egressPorts)
+    {
+        m_floodSame &= *egressPorts;
+    }
+    m_floodRetag = m_floodSame;
+    if (tagged)
+    {
+        m_floodSame.AndNot(vlanPorts.untagged);
+        m_floodRetag &= vlanPorts.untagged;
+    }
+    else
+    {
+        m_floodSame &= vlanPorts.untagged;
+        m_floodRetag.AndNot(vlanPorts.untagged);
+    }
+
+    // 泛洪集合中只有逻辑端口，聚合组按帧头哈希选择成员 (整个帧只算一次哈希)
+    uint32_t hash = m_lags.empty()
+                        ? 0
+                        : L2LagHash(packet, tagged, protocol, source, destination, m_lagHashPolicy);
+
+    // 需要加/去标签的出端口共用一个副本。必须在入帧交给设备之前生成，
+    // 因为设备会在入帧上添加以太网帧头
+    if (!m_floodRetag.IsEmpty())
+    {
+        Ptr<Packet> retagged = RetagPacket(packet, tagged, vlan, protocol);
+        uint16_t retaggedProtocol = tagged ? protocol : L2VlanTag::PROTOCOL;
+        uint32_t lastRetag = m_zeroCopy ? m_floodRetag.FindLast() : L2PortMask::NONE;
+        m_floodRetag.ForEach([&](uint32_t port) {
+            uint16_t member = SelectMember(static_cast<uint16_t>(port), hash);
+            Ptr<Packet> egress = EgressPacket(retagged, port == lastRetag);
+            Transmit(member, egress, source, destination, retaggedProtocol, true);
+        });
     }
+
+    // 最后一个出端口: 入帧可以复用时，它拿到的是入帧本身
+    uint16_t sameProtocol = tagged ? L2VlanTag::PROTOCOL : protocol;
+    uint32_t lastPort = reuse ? m_floodSame.FindLast() : L2PortMask::NONE;
+    m_floodSame.ForEach([&](uint32_t port) {
+        uint16_t member = SelectMember(static_cast<uint16_t>(port), hash);
+        Ptr<Packet> egress = EgressPacket(packet, port == lastPort);
+        Transmit(member, egress, source, destination, sameProtocol, true);
+    });
 }
 
 // ============================================================================
@@ -436,6 +4495,34 @@ public:
      * @param nodes 节点容器
      */
     void Install(NodeContainer nodes);
+
+    /**
+     * @brief 把交换机的一个端口配置为 Access 端口 (需要先 Install)
+     * @param node 交换机节点
+     * @param port 端口号 (设备的 ifIndex)
+     * @param vlan 端口所属的 VLAN
+     */
+    void SetAccessPort(Ptr<Node> node, uint16_t port, uint16_t vlan);
+
+    /**
+     * @brief 把交换机的一个端口配置为 Trunk 端口 (需要先 Install)
+     * @param node 交换机节点
+     * @param port 端口号 (设备的 ifIndex)
+     * @param vlans 允许通过的 VLAN
+     * @param nativeVlan 不带标签的帧所属的 VLAN，L2VlanTag::NO_VLAN 表示没有
+     */
+    void SetTrunkPort(Ptr<Node> node,
+                      uint16_t port,
+                      const std::vector<uint16_t>& vlans,
+                      uint16_t nativeVlan = L2VlanTag::DEFAULT_VLAN);
+
+    /**
+     * @brief 把交换机的几个端口聚合成一个逻辑端口 (需要先 Install)
+     * @param node 交换机节点
+     * @param ports 成员端口号 (设备的 ifIndex)
+     * @return 逻辑端口号
+     */
+    uint16_t AddLinkAggregation(Ptr<Node> node, const std::vector<uint16_t>& ports);
 };
 
 // ========== 实现 L2SwitchHelper ==========
@@ -478,6 +4565,39 @@ L2SwitchHelper::Install(NodeContainer nodes)
     }
 }
 
+void
+L2SwitchHelper::SetAccessPort(Ptr<Node> node, uint16_t port, uint16_t vlan)
+{
+    Ptr<L2SwitchProtocol> protocol = node->GetObject<L2SwitchProtocol>();
+    NS_ASSERT_MSG(protocol, "L2SwitchProtocol is not installed on node " << node->GetId());
+    protocol->SetAccessPort(port, vlan);
+}
+
+void
+L2SwitchHelper::SetTrunkPort(Ptr<Node> node,
+                             uint16_t port,
+                             const std::vector<uint16_t>& vlans,
+                             uint16_t nativeVlan)
+{
+    Ptr<L2SwitchProtocol> protocol = node->GetObject<L2SwitchProtocol>();
+    NS_ASSERT_MSG(protocol, "L2SwitchProtocol is not installed on node " << node->GetId());
+    protocol->SetTrunkPort(port, vlans, nativeVlan);
+}
+
+uint16_t
+L2SwitchHelper::AddLinkAggregation(Ptr<Node> node, const std::vector<uint16_t>& ports)
+{
+    Ptr<L2SwitchProtocol> protocol = node->GetObject<L2SwitchProtocol>();
+    NS_ASSERT_MSG(protocol, "L2SwitchProtocol is not installed on node " << node->GetId());
+    return protocol->AddLinkAggregation(ports);
+}
+
+// 控制器、拓扑生成器和基准测试依赖上面定义的 L2SwitchProtocol / L2SwitchHelper，所以在这里 include
+#include "l2-controller.h"
+#include "l2-mac-snapshot.h"
+#include "l2-topology.h"
+#include "l2-switch-benchmark.h"
+
 // ============================================================================
 // 【第三部分】主函数 - 多交换机拓扑
 // ============================================================================
@@ -491,8 +4611,28 @@ L2SwitchHelper::Install(NodeContainer nodes)
 //                          |
 //                       Host B
 //
+//   --ring 时再加一条 Switch2 -- Switch0 链路构成环路 (需要 --rstp 或 --multipath，否则广播风暴)，
+//   --failLinkAt=t 在 t 秒时断开 Switch0 -- Switch1 链路，观察 RSTP 重新收敛。
+//   --multipath 时交换机之间运行链路状态协议代替 RSTP: 配合 --ring 环上的链路都不阻塞，
+//   Switch0 与 Switch2 之间的流量走直连链路，帧在交换机之间封装传递。
+//   --vlan 时 Host A、Host C 属于 VLAN 10，Host B 属于 VLAN 20，交换机之间是 Trunk，
+//   Host B 的请求 (包括 ARP 广播) 不会到达 Host C。
+//   --link=ethernet 时所有链路改用全双工点到点以太网 (L2EthernetNetDevice)，
+//   速率由 --linkRate 指定 (如 10Gbps、40Gbps、100Gbps)。
+//   --lag=n 时 Switch0 -- Switch1 和 Switch1 -- Switch2 各用 n 条并联链路组成链路聚合，
+//   配合 --link=ethernet --failLinkAt=t 可以观察成员链路故障后的切换。
+//   --igmp 时交换机启用 IGMP 侦听 (Switch0 是查询器)，Host B 加入 239.1.1.1，
+//   Host A 发往该组的请求只转发到 Host B。
+//   --provision 时控制器在仿真开始前算出并下发所有交换机的 MAC 表，
+//   配合 --arpSuppression 可以去掉全部预热泛洪。
+//   --flowTable 时 Switch1 上安装一条通配流表项: 从 Switch0 进入、发往 UDP 9 端口的
+//   IPv4 帧直接从通往 Switch2 的端口发出，其余帧 (回复、ARP) 走 table-miss。
+//   --saveMacTables=f 在仿真结束时把所有交换机的 MAC 表保存到 f，下一次运行用
+//   --loadMacTables=f 在开始前装回 (热启动，学习阶段不再泛洪)。两个选项可以同时使用，
+//   一次接一次地链式热启动；保存后会重新读入文件校验它能原样装回。
+//
 //   关键技术点：
-//   1. 使用 CSMA 链路保持 MAC 地址不变
+//   1. 使用 CSMA 或全双工以太网链路保持 MAC 地址不变
 //   2. 每个交换机独立运行 L2SwitchProtocol
 //   3. 数据包通过多跳转发到达目的地
 //
@@ -500,8 +4640,105 @@ L2SwitchHelper::Install(NodeContainer nodes)
 
 int main(int argc, char* argv[])
 {
+    // ========== 步骤 0: 命令行参数 ==========
+    CommandLine cmd;
+    std::string benchmark = "";  // 非空时只运行对应的微基准测试，不运行仿真
+    bool rstp = false;           // 在所有交换机上运行 RSTP
+    bool multipath = false;      // 交换机之间改用链路状态多路径转发
+    bool ring = false;           // 增加 Switch2 -- Switch0 链路，形成环路
+    double failLinkAt = 0.0;     // 大于 0 时在该时刻断开 Switch0 -- Switch1 链路
+    bool vlan = false;           // Host A/C 在 VLAN 10，Host B 在 VLAN 20
+    bool verbose = true;         // 打开交换机的 INFO 日志 (每帧一行)
+    std::string linkType = "csma";    // 链路类型: csma (半双工共享介质) 或 ethernet (全双工)
+    std::string linkRate = "100Mbps"; // 链路速率
+    uint32_t lag = 1;                 // 交换机之间每个聚合组的链路数 (1 = 不聚合)
+    bool arpSuppression = false;      // 交换机监听 ARP 并代为回复
+    uint64_t stormPps = 0;            // 每个端口广播/组播/未知单播的限速 (帧/秒，0 = 不限)
+    bool igmp = false;                // IGMP 侦听: Host B 加入组播组，Host A 向组发送
+    bool provision = false;           // 仿真开始前由控制器下发 MAC 表
+    bool flowTable = false;           // Switch1 上安装一条通配流表项
+    std::string saveMacTables = "";   // 仿真结束时保存 MAC 表的文件
+    std::string loadMacTables = "";   // 仿真开始前装入 MAC 表的文件
+    std::string summary = "";         // 仿真结束时写入汇总计数 (name=value 行) 的文件
+    cmd.AddValue("benchmark", "Run a micro-benchmark instead of the simulation (mactable, flood, inject, scale, multipath, portland, flowtable)", benchmark);
+    cmd.AddValue("rstp", "Enable the Rapid Spanning Tree Protocol on all switches", rstp);
+    cmd.AddValue("multipath",
+                 "Forward between switches with link-state multipath (ECMP) instead of RSTP",
+                 multipath);
+    cmd.AddValue("ring", "Add a Switch2 <-> Switch0 link to close a loop", ring);
+    cmd.AddValue("failLinkAt", "Time (s) at which the Switch0 <-> Switch1 link fails (0 = never)",
+                 failLinkAt);
+    cmd.AddValue("vlan", "Put Host A and Host C in VLAN 10 and Host B in VLAN 20", vlan);
+    cmd.AddValue("verbose", "Enable per-frame switch logging (counters are always printed)", verbose);
+    cmd.AddValue("link", "Link type: csma (half-duplex shared medium) or ethernet (full-duplex)",
+                 linkType);
+    cmd.AddValue("linkRate", "Data rate of every link", linkRate);
+    cmd.AddValue("lag", "Number of aggregated links between neighbouring switches", lag);
+    cmd.AddValue("arpSuppression", "Answer ARP requests for known hosts at the switches",
+                 arpSuppression);
+    cmd.AddValue("stormPps",
+                 "Storm-control limit for broadcast, multicast and unknown unicast per port "
+                 "(frames/s, 0 = unlimited)",
+                 stormPps);
+    cmd.AddValue("igmp",
+                 "Enable IGMP snooping (Switch0 is the querier); Host B joins 239.1.1.1 and "
+                 "Host A sends echo requests to the group",
+                 igmp);
+    cmd.AddValue("provision",
+                 "Install controller-computed MAC tables before the run (learning stays on)",
+                 provision);
+    cmd.AddValue("flowTable",
+                 "Install a wildcard flow on Switch1 that sends UDP port 9 traffic from Switch0 "
+                 "straight to Switch2",
+                 flowTable);
+    cmd.AddValue("saveMacTables", "Write every switch's MAC table to this file at the end of the run",
+                 saveMacTables);
+    cmd.AddValue("loadMacTables",
+                 "Preload MAC tables saved by --saveMacTables before the run (warm start)",
+                 loadMacTables);
+    cmd.AddValue("summary",
+                 "Write aggregate switch counters and the wall time to this file as name=value lines",
+                 summary);
+    cmd.Parse(argc, argv);
+
+    if (linkType != "csma" && linkType != "ethernet")
+    {
+        NS_LOG_UNCOND("Unknown link type: " << linkType << " (expected csma or ethernet)");
+        return 1;
+    }
+    bool ethernet = (linkType == "ethernet");
+
+    if (rstp && multipath)
+    {
+        NS_LOG_UNCOND("--rstp and --multipath are mutually exclusive");
+        return 1;
+    }
+    if (ring && !rstp && !multipath)
+    {
+        NS_LOG_UNCOND("Warning: --ring without --rstp creates a forwarding loop (broadcast storm)"
+                      << (stormPps > 0 ? ", limited by storm control" : ""));
+    }
+    Config::SetDefault("ns3::L2SwitchProtocol::EnableRstp", BooleanValue(rstp));
+    Config::SetDefault("ns3::L2SwitchProtocol::EnableMultipath", BooleanValue(multipath));
+    Config::SetDefault("ns3::L2SwitchProtocol::ArpSuppression", BooleanValue(arpSuppression));
+    Config::SetDefault("ns3::L2SwitchProtocol::BroadcastStormPps", UintegerValue(stormPps));
+    Config::SetDefault("ns3::L2SwitchProtocol::MulticastStormPps", UintegerValue(stormPps));
+    Config::SetDefault("ns3::L2SwitchProtocol::UnknownUnicastStormPps", UintegerValue(stormPps));
+    Config::SetDefault("ns3::L2SwitchProtocol::IgmpSnooping", BooleanValue(igmp));
+
+    // 有链路故障时延长仿真，让客户端在故障前后都发送数据
+    double stopTime = (failLinkAt > 0.0) ? std::max(10.0, failLinkAt + 10.0) : 10.0;
+
+    if (!benchmark.empty())
+    {
+        return RunL2Benchmark(benchmark);
+    }
+
     // ========== 步骤 1: 启用日志 ==========
-    LogComponentEnable("L2SwitchProtocol", LOG_LEVEL_INFO);
+    if (verbose)
+    {
+        LogComponentEnable("L2SwitchProtocol", LOG_LEVEL_INFO);
+    }
     LogComponentEnable("UdpEchoClientApplication", LOG_LEVEL_INFO);
     LogComponentEnable("UdpEchoServerApplication", LOG_LEVEL_INFO);
 
@@ -518,11 +4755,19 @@ int main(int argc, char* argv[])
 
     NS_LOG_INFO("Topology: [Host A]-SW0-SW1-SW2-[Host C], [Host B]-SW1");
 
-    // ========== 步骤 3: 创建 CSMA 链路 ==========
+    // ========== 步骤 3: 创建链路 (CSMA 或全双工以太网，都保留 MAC 地址) ==========
     CsmaHelper csma;
-    csma.SetChannelAttribute("DataRate", StringValue("100Mbps"));
+    csma.SetChannelAttribute("DataRate", StringValue(linkRate));
     csma.SetChannelAttribute("Delay", TimeValue(NanoSeconds(6560)));
 
+    L2EthernetHelper ethernetLink;
+    ethernetLink.SetDeviceAttribute("DataRate", StringValue(linkRate));
+    ethernetLink.SetChannelAttribute("Delay", TimeValue(NanoSeconds(6560)));
+
+    auto installLink = [&](const NodeContainer& link) {
+        return ethernet ? ethernetLink.Install(link) : csma.Install(link);
+    };
+
     // 用于存储主机设备
     NetDeviceContainer hostDevices;
 
@@ -531,17 +4776,18 @@ int main(int argc, char* argv[])
         NodeContainer link;
         link.Add(hosts.Get(0));      // Host A
         link.Add(switches.Get(0));   // Switch 0
-        NetDeviceContainer devices = csma.Install(link);
+        NetDeviceContainer devices = installLink(link);
         hostDevices.Add(devices.Get(0));  // Host A 的设备
         NS_LOG_INFO("Created link: Host A <-> Switch0");
     }
 
     // ----- 链路 2: Switch 0 <-> Switch 1 -----
+    NetDeviceContainer failingLink;  // --failLinkAt 断开的就是这条链路
     {
         NodeContainer link;
         link.Add(switches.Get(0));   // Switch 0
         link.Add(switches.Get(1));   // Switch 1
-        csma.Install(link);
+        failingLink = installLink(link);
         NS_LOG_INFO("Created link: Switch0 <-> Switch1");
     }
 
@@ -550,7 +4796,7 @@ int main(int argc, char* argv[])
         NodeContainer link;
         link.Add(hosts.Get(1));      // Host B
         link.Add(switches.Get(1));   // Switch 1
-        NetDeviceContainer devices = csma.Install(link);
+        NetDeviceContainer devices = installLink(link);
         hostDevices.Add(devices.Get(0));  // Host B 的设备
         NS_LOG_INFO("Created link: Host B <-> Switch1");
     }
@@ -560,7 +4806,7 @@ int main(int argc, char* argv[])
         NodeContainer link;
         link.Add(switches.Get(1));   // Switch 1
         link.Add(switches.Get(2));   // Switch 2
-        csma.Install(link);
+        installLink(link);
         NS_LOG_INFO("Created link: Switch1 <-> Switch2");
     }
 
@@ -569,11 +4815,41 @@ int main(int argc, char* argv[])
         NodeContainer link;
         link.Add(hosts.Get(2));      // Host C
         link.Add(switches.Get(2));   // Switch 2
-        NetDeviceContainer devices = csma.Install(link);
+        NetDeviceContainer devices = installLink(link);
         hostDevices.Add(devices.Get(0));  // Host C 的设备
         NS_LOG_INFO("Created link: Host C <-> Switch2");
     }
 
+    // ----- 链路 6 (可选): Switch 2 <-> Switch 0，形成环路 -----
+    if (ring)
+    {
+        NodeContainer link;
+        link.Add(switches.Get(2));   // Switch 2
+        link.Add(switches.Get(0));   // Switch 0
+        installLink(link);
+        NS_LOG_INFO("Created link: Switch2 <-> Switch0 (ring)");
+    }
+
+    // ----- 链路聚合 (可选): SW0-SW1 和 SW1-SW2 各再并联 lag - 1 条链路 -----
+    // 每个聚合组的成员端口，第一个是上面创建的链路
+    std::vector<uint16_t> lag01Sw0 = {1};
+    std::vector<uint16_t> lag01Sw1 = {0};
+    std::vector<uint16_t> lag12Sw1 = {2};
+    std::vector<uint16_t> lag12Sw2 = {0};
+    for (uint32_t i = 1; i < lag; ++i)
+    {
+        NetDeviceContainer devices01 = installLink(NodeContainer(switches.Get(0), switches.Get(1)));
+        lag01Sw0.push_back(static_cast<uint16_t>(devices01.Get(0)->GetIfIndex()));
+        lag01Sw1.push_back(static_cast<uint16_t>(devices01.Get(1)->GetIfIndex()));
+        NetDeviceContainer devices12 = installLink(NodeContainer(switches.Get(1), switches.Get(2)));
+        lag12Sw1.push_back(static_cast<uint16_t>(devices12.Get(0)->GetIfIndex()));
+        lag12Sw2.push_back(static_cast<uint16_t>(devices12.Get(1)->GetIfIndex()));
+    }
+    if (lag > 1)
+    {
+        NS_LOG_INFO("Created " << lag << " parallel links for SW0-SW1 and SW1-SW2");
+    }
+
     // ========== 步骤 4: 在所有交换机上安装 L2SwitchProtocol ==========
     L2SwitchHelper switchHelper;
 
@@ -582,6 +4858,42 @@ int main(int argc, char* argv[])
     switchHelper.Install(switches.Get(1), "Switch1");
     switchHelper.Install(switches.Get(2), "Switch2");
 
+    // 并联链路组成聚合组 (成员沿用第一条链路的 VLAN 配置)
+    if (lag > 1)
+    {
+        switchHelper.AddLinkAggregation(switches.Get(0), lag01Sw0);
+        switchHelper.AddLinkAggregation(switches.Get(1), lag01Sw1);
+        switchHelper.AddLinkAggregation(switches.Get(1), lag12Sw1);
+        switchHelper.AddLinkAggregation(switches.Get(2), lag12Sw2);
+    }
+
+    // 端口号就是设备的创建顺序: Switch0 = {Host A, SW1, (SW2)},
+    // Switch1 = {SW0, Host B, SW2}, Switch2 = {SW1, Host C, (SW0)}，聚合的并联链路排在最后
+    if (vlan)
+    {
+        std::vector<uint16_t> trunkVlans = {10, 20};
+        switchHelper.SetAccessPort(switches.Get(0), 0, 10);
+        switchHelper.SetTrunkPort(switches.Get(0), 1, trunkVlans);
+        switchHelper.SetTrunkPort(switches.Get(1), 0, trunkVlans);
+        switchHelper.SetAccessPort(switches.Get(1), 1, 20);
+        switchHelper.SetTrunkPort(switches.Get(1), 2, trunkVlans);
+        switchHelper.SetTrunkPort(switches.Get(2), 0, trunkVlans);
+        switchHelper.SetAccessPort(switches.Get(2), 1, 10);
+        if (ring)
+        {
+            switchHelper.SetTrunkPort(switches.Get(0), 2, trunkVlans);
+            switchHelper.SetTrunkPort(switches.Get(2), 2, trunkVlans);
+        }
+        NS_LOG_INFO("VLANs: Host A, Host C in VLAN 10; Host B in VLAN 20");
+    }
+
+    // Switch0 作为 IGMP 查询器，其他交换机从查询到达的端口学到路由器端口
+    if (igmp)
+    {
+        switches.Get(0)->GetObject<L2SwitchProtocol>()->SetAttribute("IgmpQuerier",
+                                                                    BooleanValue(true));
+    }
+
     // 初始化每个交换机的协议
     for (uint32_t i = 0; i < switches.GetN(); ++i)
     {
@@ -590,6 +4902,16 @@ int main(int argc, char* argv[])
         protocol->Initialize();
     }
 
+    // 流表: Switch1 端口 0 (来自 Switch0) 进入的 UDP Echo 请求直接发往端口 2 (Switch2)，
+    // 不查 MAC 表；Echo 回复和 ARP 没有命中，走 table-miss (MAC 学习)
+    if (flowTable)
+    {
+        L2FlowMatch match;
+        match.SetInPort(0).SetEthType(0x0800).SetIpProto(17).SetL4Dst(9);
+        switches.Get(1)->GetObject<L2SwitchProtocol>()->AddFlow(match, 100,
+                                                                {L2FlowAction::Output(2)});
+    }
+
     // ========== 步骤 5: 在主机节点上安装标准协议栈 ==========
     InternetStackHelper stack;
     stack.Install(hosts);
@@ -605,23 +4927,49 @@ int main(int argc, char* argv[])
     NS_LOG_INFO("  Host B: " << hostInterfaces.GetAddress(1));
     NS_LOG_INFO("  Host C: " << hostInterfaces.GetAddress(2));
 
+    // 控制器根据拓扑和主机位置下发 MAC 表 (启用 ArpSuppression 时还有 ARP 表)，
+    // 第一个帧不再因为未知单播而泛洪
+    if (provision)
+    {
+        L2SwitchController controller;
+        L2SwitchController::Stats provisioned = controller.Provision(switches);
+        NS_LOG_UNCOND("Controller installed " << provisioned.macEntries << " MAC entries and "
+                      << provisioned.arpEntries << " ARP entries on " << provisioned.switches
+                      << " switches (" << provisioned.hosts << " hosts)");
+    }
+
+    // 热启动: 装入上一次运行保存的 MAC 表 (拓扑必须相同)
+    if (!loadMacTables.empty())
+    {
+        L2MacSnapshot::Stats loaded = L2MacSnapshot::Load(loadMacTables, switches);
+        if (!loaded.valid)
+        {
+            NS_LOG_UNCOND("Cannot load MAC tables from " << loadMacTables);
+            Simulator::Destroy();
+            return 1;
+        }
+        NS_LOG_UNCOND("Loaded " << loaded.entries << " MAC entries from " << loadMacTables << " ("
+                      << loaded.skipped << " skipped, " << loaded.mismatched
+                      << " switches did not match the topology)");
+    }
+
     // ========== 步骤 7: 安装应用程序 ==========
     // 在 Host C 上安装 UDP Echo Server
     UdpEchoServerHelper echoServer(9);
     ApplicationContainer serverApps = echoServer.Install(hosts.Get(2));
     serverApps.Start(Seconds(0.0));
-    serverApps.Stop(Seconds(10.0));
+    serverApps.Stop(Seconds(stopTime));
 
     // 在 Host A 上安装 UDP Echo Client (发送到 Host C)
     // 数据包路径: Host A -> Switch0 -> Switch1 -> Switch2 -> Host C
     UdpEchoClientHelper echoClientA(hostInterfaces.GetAddress(2), 9);
-    echoClientA.SetAttribute("MaxPackets", UintegerValue(3));
+    echoClientA.SetAttribute("MaxPackets", UintegerValue(failLinkAt > 0.0 ? static_cast<uint32_t>(stopTime - 2.0) : 3));
     echoClientA.SetAttribute("Interval", TimeValue(Seconds(1.0)));
     echoClientA.SetAttribute("PacketSize", UintegerValue(512));
 
     ApplicationContainer clientAppsA = echoClientA.Install(hosts.Get(0));
     clientAppsA.Start(Seconds(1.0));
-    clientAppsA.Stop(Seconds(10.0));
+    clientAppsA.Stop(Seconds(stopTime));
 
     // 在 Host B 上安装 UDP Echo Client (发送到 Host C)
     // 数据包路径: Host B -> Switch1 -> Switch2 -> Host C
@@ -632,13 +4980,191 @@ int main(int argc, char* argv[])
 
     ApplicationContainer clientAppsB = echoClientB.Install(hosts.Get(1));
     clientAppsB.Start(Seconds(2.0));
-    clientAppsB.Stop(Seconds(10.0));
+    clientAppsB.Stop(Seconds(stopTime));
+
+    // 组播: Host B 加入 239.1.1.1，Host A 向组发送 Echo 请求。
+    // ns-3 的主机协议栈不实现 IGMP，这里直接从 Host B 的设备发出成员报告。
+    // 启用侦听时只有 Host B 回复；不启用时请求被泛洪，Host C 也会回复
+    if (igmp)
+    {
+        Ipv4Address group("239.1.1.1");
+        Simulator::Schedule(Seconds(0.5), [&hostDevices, &hostInterfaces, group]() {
+            hostDevices.Get(1)->Send(L2Igmp::MakeMessage(L2Igmp::TYPE_V2_REPORT, group,
+                                                         hostInterfaces.GetAddress(1), group),
+                                     Mac48Address::GetMulticast(group),
+                                     L2Igmp::IPV4_PROTOCOL);
+        });
+
+        UdpEchoServerHelper groupServer(9);
+        ApplicationContainer groupServerApps = groupServer.Install(hosts.Get(1));
+        groupServerApps.Start(Seconds(0.0));
+        groupServerApps.Stop(Seconds(stopTime));
+
+        Ipv4StaticRoutingHelper multicastRouting;
+        multicastRouting.SetDefaultMulticastRoute(hosts.Get(0), hostDevices.Get(0));
+        UdpEchoClientHelper groupClient(group, 9);
+        groupClient.SetAttribute("MaxPackets", UintegerValue(2));
+        groupClient.SetAttribute("Interval", TimeValue(Seconds(1.0)));
+        groupClient.SetAttribute("PacketSize", UintegerValue(256));
+        ApplicationContainer groupClientApps = groupClient.Install(hosts.Get(0));
+        groupClientApps.Start(Seconds(4.0));
+        groupClientApps.Stop(Seconds(stopTime));
+    }
 
     // ========== 步骤 8: 运行仿真 ==========
     NS_LOG_INFO("=== Starting Simulation ===");
 
-    Simulator::Stop(Seconds(10.0));
+    // 所有交换机中最后一次端口角色/状态变化的时刻，即生成树收敛的时刻
+    auto lastRstpChange = [&switches]() {
+        Time last;
+        for (uint32_t i = 0; i < switches.GetN(); ++i)
+        {
+            Ptr<L2Rstp> rstpInstance = switches.Get(i)->GetObject<L2SwitchProtocol>()->GetRstp();
+            if (rstpInstance && rstpInstance->GetLastChange() > last)
+            {
+                last = rstpInstance->GetLastChange();
+            }
+        }
+        return last;
+    };
+
+    Time initialConvergence;
+    if (failLinkAt > 0.0)
+    {
+        Simulator::Schedule(Seconds(failLinkAt), [&]() {
+            initialConvergence = lastRstpChange();
+            NS_LOG_UNCOND("Link Switch0 <-> Switch1 fails at " << Simulator::Now().As(Time::S));
+            for (uint32_t i = 0; i < failingLink.GetN(); ++i)
+            {
+                if (Ptr<L2EthernetNetDevice> device =
+                        DynamicCast<L2EthernetNetDevice>(failingLink.Get(i)))
+                {
+                    device->SetLinkUp(false);
+                }
+                else
+                {
+                    Ptr<CsmaNetDevice> csmaDevice = DynamicCast<CsmaNetDevice>(failingLink.Get(i));
+                    csmaDevice->SetSendEnable(false);
+                    csmaDevice->SetReceiveEnable(false);
+                }
+            }
+        });
+    }
+
+    Simulator::Stop(Seconds(stopTime));
+    auto wallStart = std::chrono::steady_clock::now();
     Simulator::Run();
+    double wallSeconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+
+    // 打印每个交换机的 MAC 表统计
+    for (uint32_t i = 0; i < switches.GetN(); ++i)
+    {
+        switches.Get(i)->GetObject<L2SwitchProtocol>()->ReportMacTableStats(std::cout);
+        switches.Get(i)->GetObject<L2SwitchProtocol>()->ReportPortCounters(std::cout);
+    }
+
+    if (!saveMacTables.empty())
+    {
+        L2MacSnapshot::Stats saved = L2MacSnapshot::Save(saveMacTables, switches);
+        NS_LOG_UNCOND((saved.valid ? "Saved " : "Failed to save ") << saved.entries
+                      << " MAC entries to " << saveMacTables);
+        // 往返校验: 文件重新读入后必须与当前的表逐项相同，并且能按原样热启动
+        // (热启动的运行再保存时也一样，快照时间必须是连续的老化时钟)。
+        // 校验失败的文件删除，下一次运行 (或扫描脚本的重试) 不会装入它
+        if (!saved.valid || !L2MacSnapshot::Check(saveMacTables, switches))
+        {
+            NS_LOG_UNCOND("MAC table snapshot " << saveMacTables << " does not round-trip, removed");
+            std::remove(saveMacTables.c_str());
+            Simulator::Destroy();
+            return 1;
+        }
+    }
+
+    // 所有交换机所有端口的计数之和，供参数扫描脚本合并成结果表
+    if (!summary.empty())
+    {
+        L2SwitchProtocol::PortCounters total{};
+        uint64_t droppedStorm = 0;
+        uint64_t unknownFloods = 0;
+        uint64_t broadcastFloods = 0;
+        for (uint32_t i = 0; i < switches.GetN(); ++i)
+        {
+            Ptr<L2SwitchProtocol> protocol = switches.Get(i)->GetObject<L2SwitchProtocol>();
+            for (uint16_t port = 0; port < protocol->GetNPorts(); ++port)
+            {
+                L2SwitchProtocol::PortCounters c = protocol->GetPortCounters(port);
+                total.rxFrames += c.rxFrames;
+                total.txUnicast += c.txUnicast;
+                total.txFlooded += c.txFlooded;
+                total.learned += c.learned;
+                total.moved += c.moved;
+                total.droppedSamePort += c.droppedSamePort;
+                total.droppedFiltered += c.droppedFiltered;
+                total.droppedQueue += c.droppedQueue;
+                total.queueHighWater = std::max(total.queueHighWater, c.queueHighWater);
+                for (uint64_t dropped : c.droppedStorm)
+                {
+                    droppedStorm += dropped;
+                }
+            }
+            L2SwitchProtocol::MacTableStats mac = protocol->GetMacTableStats();
+            unknownFloods += mac.unknownFloods;
+            broadcastFloods += mac.broadcastFloods;
+        }
+
+        std::ofstream out(summary);
+        out << "rxFrames=" << total.rxFrames << "\n"
+            << "txUnicast=" << total.txUnicast << "\n"
+            << "txFlooded=" << total.txFlooded << "\n"
+            << "learned=" << total.learned << "\n"
+            << "moved=" << total.moved << "\n"
+            << "droppedSamePort=" << total.droppedSamePort << "\n"
+            << "droppedFiltered=" << total.droppedFiltered << "\n"
+            << "droppedQueue=" << total.droppedQueue << "\n"
+            << "droppedStorm=" << droppedStorm << "\n"
+            << "queueHighWater=" << total.queueHighWater << "\n"
+            << "unknownFloods=" << unknownFloods << "\n"
+            << "broadcastFloods=" << broadcastFloods << "\n"
+            << "events=" << Simulator::GetEventCount() << "\n"
+            << "wallSeconds=" << wallSeconds << "\n";
+        if (!out)
+        {
+            NS_LOG_UNCOND("Cannot write summary to " << summary);
+            Simulator::Destroy();
+            return 1;
+        }
+    }
+
+    // 打印生成树状态和收敛时间
+    if (rstp)
+    {
+        for (uint32_t i = 0; i < switches.GetN(); ++i)
+        {
+            switches.Get(i)->GetObject<L2SwitchProtocol>()->GetRstp()->Report(std::cout);
+        }
+        if (failLinkAt > 0.0)
+        {
+            std::cout << "Initial convergence at " << initialConvergence.As(Time::S)
+                      << ", re-converged at " << lastRstpChange().As(Time::S) << " ("
+                      << (lastRstpChange() - Seconds(failLinkAt)).As(Time::S)
+                      << " after the link failure)" << std::endl;
+        }
+        else
+        {
+            std::cout << "Converged at " << lastRstpChange().As(Time::S) << std::endl;
+        }
+    }
+
+    // 打印链路状态数据库和分发树
+    if (multipath)
+    {
+        for (uint32_t i = 0; i < switches.GetN(); ++i)
+        {
+            switches.Get(i)->GetObject<L2SwitchProtocol>()->GetLinkState()->Report(std::cout);
+        }
+    }
+
     Simulator::Destroy();
 
     NS_LOG_INFO("=== Simulation Complete ===");
@@ -0,0 +1,232 @@
+/*
+ * ============================================================================
+ * 标题: 分层时间轮 (Hierarchical Timer Wheel)
+ * ============================================================================
+ *
+ * 【设计目的】
+ *   MAC 表老化需要为每个表项维护一个超时时间。如果每个表项都调度一个
+ *   ns-3 事件，10 万个 MAC 就是 10 万个事件，而且每次刷新表项都要
+ *   Cancel + Schedule，事件队列会成为瓶颈。
+ *
+ *   时间轮把所有超时统一挂在若干个槽位上，整个交换机只需要一个周期性的
+ *   ns-3 事件来推进时间轮:
+ *   - 插入: O(1)，按到期时间放入对应层的槽位
+ *   - 推进: 每个 tick 只处理一个槽位；低层转完一圈时把高一层的槽位 "降级" 下来
+ *   - 刷新: 不需要操作时间轮，到期时由调用者检查 lastSeen，没到期就重新插入
+ *
+ * 【结构】
+ *   4 层，每层 64 个槽位:
+ *     第 0 层: 每个槽位 1 tick      覆盖 64 tick
+ *     第 1 层: 每个槽位 64 tick     覆盖 4096 tick
+ *     第 2 层: 每个槽位 4096 tick   覆盖 262144 tick
+ *     第 3 层: 每个槽位 262144 tick 覆盖 16777216 tick (1s tick 时约 194 天)
+ *   超出范围的到期时间先放在最高层，降级时再重新计算位置。
+ *
+ * 作者: Liu Mengxuan
+ * ns-3 版本: 3.44
+ * ============================================================================
+ */
+
+#ifndef L2_TIMER_WHEEL_H
+#define L2_TIMER_WHEEL_H
+
+#include <cstdint>
+#include <vector>
+
+namespace ns3
+{
+
+class L2TimerWheel
+{
+public:
+    /**
+     * @brief 时间轮中的一个定时项
+     */
+    struct Item
+    {
+        uint64_t key;     // 调用者定义的键 (MAC 表中是打包后的 MAC 地址)
+        uint32_t expiry;  // 到期 tick
+        uint32_t cookie;  // 调用者定义的附加数据 (MAC 表中是表项的代数，用于识别过期的定时项)
+    };
+
+    L2TimerWheel();
+
+    /**
+     * @brief 插入一个定时项
+     * @param key 键
+     * @param expiry 到期 tick (不晚于当前 tick 的会在下一个 tick 到期)
+     * @param cookie 附加数据
+     */
+    void Schedule(uint64_t key, uint32_t expiry, uint32_t cookie = 0);
+
+    /**
+     * @brief 把时间轮推进到 now，对每个到期的定时项调用 onExpire(const Item&)
+     *
+     * 回调中可以再次调用 Schedule() (例如表项被刷新过，需要重新定时)。
+     */
+    template <typename F>
+    void Advance(uint32_t now, F onExpire);
+
+    /**
+     * @brief 清空所有定时项，并把当前 tick 设为 now
+     */
+    void Reset(uint32_t now);
+
+    bool IsEmpty() const;
+    uint32_t GetSize() const;
+    uint32_t GetNow() const;
+
+private:
+    static constexpr uint32_t SLOT_BITS = 6;
+    static constexpr uint32_t SLOTS = 1u << SLOT_BITS;
+    static constexpr uint32_t SLOT_MASK = SLOTS - 1;
+    static constexpr uint32_t LEVELS = 4;
+
+    void Place(const Item& item);
+    void Cascade(uint32_t level);
+
+    std::vector<Item> m_wheel[LEVELS][SLOTS];
+    std::vector<Item> m_scratch;  // 处理到期槽位时复用的缓冲区
+    uint32_t m_now;               // 当前 tick (已经处理完的最后一个 tick)
+    uint32_t m_size;              // 定时项总数
+};
+
+// ============================================================================
+// 实现
+// ============================================================================
+
+inline L2TimerWheel::L2TimerWheel()
+    : m_now(0),
+      m_size(0)
+{
+}
+
+inline void
+L2TimerWheel::Schedule(uint64_t key, uint32_t expiry, uint32_t cookie)
+{
+    if (expiry <= m_now)
+    {
+        expiry = m_now + 1;
+    }
+    Place(Item{key, expiry, cookie});
+    ++m_size;
+}
+
+inline void
+L2TimerWheel::Place(const Item& item)
+{
+    uint64_t delta = uint64_t(item.expiry) - m_now;
+
+    // 超出最高层覆盖范围的先放在最高层最远的槽位上，降级时再重新放置
+    const uint64_t horizon = uint64_t(1) << (SLOT_BITS * LEVELS);
+    uint64_t placeAt = (delta < horizon) ? item.expiry : uint64_t(m_now) + horizon - 1;
+    if (delta >= horizon)
+    {
+        delta = horizon - 1;
+    }
+
+    uint32_t level = 0;
+    while (level + 1 < LEVELS && delta >= (uint64_t(1) << (SLOT_BITS * (level + 1))))
+    {
+        ++level;
+    }
+    uint32_t slot = static_cast<uint32_t>(placeAt >> (SLOT_BITS * level)) & SLOT_MASK;
+    m_wheel[level][slot].push_back(item);
+}
+
+inline void
+L2TimerWheel::Cascade(uint32_t level)
+{
+    uint32_t slot = (m_now >> (SLOT_BITS * level)) & SLOT_MASK;
+    std::vector<Item> items;
+    items.swap(m_wheel[level][slot]);
+    for (const auto& item : items)
+    {
+        Place(item);
+    }
+}
+
+template <typename F>
+void
+L2TimerWheel::Advance(uint32_t now, F onExpire)
+{
+    if (m_size == 0)
+    {
+        // 空的时间轮可以直接跳到目标时间
+        if (now > m_now)
+        {
+            m_now = now;
+        }
+        return;
+    }
+
+    while (m_now < now)
+    {
+        ++m_now;
+
+        // 低层转完一圈时，从最高层开始依次把对应槽位降级
+        for (uint32_t level = LEVELS - 1; level > 0; --level)
+        {
+            uint32_t lowBits = SLOT_BITS * level;
+            if ((m_now & ((1u << lowBits) - 1)) == 0)
+            {
+                Cascade(level);
+            }
+        }
+
+        std::vector<Item>& slot = m_wheel[0][m_now & SLOT_MASK];
+        if (slot.empty())
+        {
+            continue;
+        }
+        m_scratch.clear();
+        m_scratch.swap(slot);
+        m_size -= static_cast<uint32_t>(m_scratch.size());
+        for (const auto& item : m_scratch)
+        {
+            onExpire(item);
+        }
+
+        if (m_size == 0 && m_now < now)
+        {
+            m_now = now;
+            break;
+        }
+    }
+}
+
+inline void
+L2TimerWheel::Reset(uint32_t now)
+{
+    for (auto& level : m_wheel)
+    {
+        for (auto& slot : level)
+        {
+            slot.clear();
+        }
+    }
+    m_now = now;
+    m_size = 0;
+}
+
+inline bool
+L2TimerWheel::IsEmpty() const
+{
+    return m_size == 0;
+}
+
+inline uint32_t
+L2TimerWheel::GetSize() const
+{
+    return m_size;
+}
+
+inline uint32_t
+L2TimerWheel::GetNow() const
+{
+    return m_now;
+}
+
+} // namespace ns3
+
+#endif /* L2_TIMER_WHEEL_H */
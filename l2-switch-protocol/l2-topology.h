@@ -0,0 +1,362 @@
+/*
+ * ============================================================================
+ * 标题: 大规模 L2 拓扑生成器 (Tree / Leaf-Spine / Ring / Fat-Tree)
+ * ============================================================================
+ *
+ * 【设计目的】
+ *   示例程序手工搭建了 3 台交换机、3 个主机的链状拓扑。评估协议能否支撑
+ *   园区或数据中心规模 (几百台交换机、几万个主机) 时，需要按参数批量生成拓扑:
+ *
+ *   类型         交换机                         主机             环路
+ *   tree         根 + fanout + fanout^2 + ...   挂在最底层       无
+ *   leaf-spine   spines + leaves，全互联        挂在 leaf 上     有 (启用 RSTP)
+ *   ring         ringSwitches 台首尾相连        每台都挂主机     有 (启用 RSTP)
+ *   fat-tree     k 个 pod，每个 pod k/2 台边缘    挂在边缘交换机上 有 (启用 RSTP)
+ *                + k/2 台汇聚，(k/2)^2 台核心
+ *
+ *   交换机用 L2SwitchHelper 安装，生成完毕时已经调用过 Initialize()。
+ *   有环路的拓扑自动在所有交换机上启用 RSTP，连接主机的端口由 RSTP 自动识别为边缘端口。
+ *   设置 multipath 时所有交换机改为启用链路状态多路径转发 (没有环路也启用)，冗余链路同时使用。
+ *   fat-tree 设置 portland 时改为 PortLand 伪 MAC 转发: 生成器按拓扑位置配置每台交换机
+ *   (SetPortlandLocation)，并创建所有交换机共享的结构管理器 (L2Topology::fabricManager)。
+ *
+ * 【端口编号】
+ *   端口号是设备的创建顺序。tree 中每台交换机的端口 0 是上联 (根除外)，
+ *   leaf-spine 中 leaf 的端口 0..spines-1 依次连接每台 spine，
+ *   ring 中端口 0 连接上一台、端口 1 连接下一台。
+ *   fat-tree 中边缘交换机的端口 0..k/2-1 依次连接本 pod 的每台汇聚交换机，
+ *   汇聚交换机的端口 0..k/2-1 依次连接本 pod 的每台边缘交换机，k/2..k-1 连接核心交换机
+ *   (汇聚交换机 a 连接核心 a*k/2 .. a*k/2+k/2-1)，核心交换机的端口 p 连接 pod p。
+ *   主机端口排在交换机间链路之后。
+ *
+ * 【注意】
+ *   - 主机节点不安装协议栈，由调用者直接在 hostDevices 上发送帧
+ *     (安装 InternetStackHelper 也可以，但几万个主机的 ARP 泛洪本身就是 O(主机数^2))
+ *   - ring 的交换机数超过 2 * MaxAge (默认 40) 时 RSTP 无法覆盖整个环
+ *   - fat-tree 的 k 必须是偶数；PortLand 的 PMAC 只能编码 256 个 pod 和 256 台核心交换机，
+ *     所以 portland 时 k 不超过 32
+ *   - 本文件依赖 l2-switch-protocol.cc 中的类定义，必须在 L2SwitchHelper 定义之后 include
+ *
+ * 作者: Liu Mengxuan
+ * ns-3 版本: 3.44
+ * ============================================================================
+ */
+
+#ifndef L2_TOPOLOGY_H
+#define L2_TOPOLOGY_H
+
+#include "l2-ethernet.h"
+#include "l2-portland.h"
+
+#include "ns3/core-module.h"
+#include "ns3/csma-module.h"
+#include "ns3/network-module.h"
+
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * @brief 拓扑参数
+ */
+struct L2TopologyConfig
+{
+    enum Type : uint8_t
+    {
+        TREE,        // 树: depth 层，每台交换机 fanout 个下级
+        LEAF_SPINE,  // 叶脊: 每台 leaf 连接所有 spine
+        RING,        // 环
+        FAT_TREE     // k 叉 Fat-Tree: 边缘 / 汇聚 / 核心三层
+    };
+
+    Type type = TREE;
+    uint32_t depth = 2;              // tree: 根以下的层数
+    uint32_t fanout = 4;             // tree: 每台交换机的下级数
+    uint32_t spines = 4;             // leaf-spine: spine 数
+    uint32_t leaves = 16;            // leaf-spine: leaf 数
+    uint32_t ringSwitches = 16;      // ring: 交换机数
+    uint32_t k = 4;                  // fat-tree: pod 数 (偶数)
+    uint32_t hostsPerSwitch = 8;     // 每台接入交换机 (树的最底层、leaf、环上每台、边缘) 的主机数
+    bool ethernet = true;            // true: 全双工以太网，false: CSMA
+    std::string dataRate = "10Gbps"; // 所有链路的速率
+    Time delay = NanoSeconds(500);   // 所有链路的传播时延
+    bool multipath = false;          // true: 用链路状态多路径转发代替 RSTP (所有链路都转发)
+    bool portland = false;           // fat-tree: 用 PortLand 伪 MAC 转发代替 RSTP
+};
+
+/**
+ * @brief 生成的拓扑
+ */
+struct L2Topology
+{
+    NodeContainer switches;           // 所有交换机 (已安装 L2SwitchProtocol 并初始化)
+    NodeContainer hosts;              // 所有主机 (没有协议栈)
+    NetDeviceContainer hostDevices;   // 每个主机的设备，与 hosts 一一对应
+    uint32_t links = 0;               // 交换机间链路数
+    bool loops = false;               // 是否有环路 (已启用 RSTP，或按 multipath 启用多路径转发)
+    Ptr<L2FabricManager> fabricManager;  // portland 时所有交换机共享的结构管理器，否则为空
+};
+
+class L2TopologyGenerator
+{
+public:
+    /**
+     * @brief 按参数生成拓扑
+     * @param config 拓扑参数
+     * @return 生成的节点和设备
+     */
+    static L2Topology Build(const L2TopologyConfig& config);
+
+    /**
+     * @brief 拓扑的简短描述，例如 "leaf-spine 4x16"
+     */
+    static std::string Describe(const L2TopologyConfig& config);
+
+    /**
+     * @brief 解析拓扑类型名 (tree / leaf-spine / ring / fat-tree)
+     * @return 名称无效时返回 false
+     */
+    static bool ParseType(const std::string& name, L2TopologyConfig::Type& type);
+};
+
+// ============================================================================
+// 实现
+// ============================================================================
+
+inline std::string
+L2TopologyGenerator::Describe(const L2TopologyConfig& config)
+{
+    switch (config.type)
+    {
+    case L2TopologyConfig::TREE:
+        return "tree d" + std::to_string(config.depth) + "f" + std::to_string(config.fanout);
+    case L2TopologyConfig::LEAF_SPINE:
+        return "leaf-spine " + std::to_string(config.spines) + "x" + std::to_string(config.leaves);
+    case L2TopologyConfig::RING:
+        return "ring " + std::to_string(config.ringSwitches);
+    case L2TopologyConfig::FAT_TREE:
+        return "fat-tree k" + std::to_string(config.k);
+    }
+    return "unknown";
+}
+
+inline bool
+L2TopologyGenerator::ParseType(const std::string& name, L2TopologyConfig::Type& type)
+{
+    if (name == "tree")
+    {
+        type = L2TopologyConfig::TREE;
+    }
+    else if (name == "leaf-spine" || name == "leafspine")
+    {
+        type = L2TopologyConfig::LEAF_SPINE;
+    }
+    else if (name == "ring")
+    {
+        type = L2TopologyConfig::RING;
+    }
+    else if (name == "fat-tree" || name == "fattree")
+    {
+        type = L2TopologyConfig::FAT_TREE;
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
+inline L2Topology
+L2TopologyGenerator::Build(const L2TopologyConfig& config)
+{
+    L2Topology topology;
+
+    CsmaHelper csma;
+    csma.SetChannelAttribute("DataRate", StringValue(config.dataRate));
+    csma.SetChannelAttribute("Delay", TimeValue(config.delay));
+
+    L2EthernetHelper ethernetLink;
+    ethernetLink.SetDeviceAttribute("DataRate", StringValue(config.dataRate));
+    ethernetLink.SetChannelAttribute("Delay", TimeValue(config.delay));
+
+    auto connect = [&](Ptr<Node> a, Ptr<Node> b) {
+        NodeContainer link(a, b);
+        return config.ethernet ? ethernetLink.Install(link) : csma.Install(link);
+    };
+    auto connectSwitches = [&](uint32_t a, uint32_t b) {
+        connect(topology.switches.Get(a), topology.switches.Get(b));
+        ++topology.links;
+    };
+
+    // 步骤 1: 交换机和交换机间链路，names 与 switches 一一对应，edges 是挂主机的交换机。
+    // locations 只有 fat-tree 填写: 每台交换机的 (层次, pod, 位置)
+    std::vector<std::string> names;
+    std::vector<uint32_t> edges;
+    std::vector<std::tuple<L2PortlandTable::Level, uint16_t, uint8_t>> locations;
+    switch (config.type)
+    {
+    case L2TopologyConfig::TREE: {
+        // 按层创建，第 l 层第 i 台的上级是第 l-1 层第 i / fanout 台
+        uint32_t levelStart = 0;
+        uint32_t levelSize = 1;
+        topology.switches.Create(1);
+        names.push_back("Tree0.0");
+        for (uint32_t level = 1; level <= config.depth; ++level)
+        {
+            uint32_t nextStart = topology.switches.GetN();
+            uint32_t nextSize = levelSize * config.fanout;
+            topology.switches.Create(nextSize);
+            for (uint32_t i = 0; i < nextSize; ++i)
+            {
+                names.push_back("Tree" + std::to_string(level) + "." + std::to_string(i));
+                connectSwitches(nextStart + i, levelStart + i / config.fanout);
+            }
+            levelStart = nextStart;
+            levelSize = nextSize;
+        }
+        for (uint32_t i = 0; i < levelSize; ++i)
+        {
+            edges.push_back(levelStart + i);
+        }
+        break;
+    }
+    case L2TopologyConfig::LEAF_SPINE:
+        topology.switches.Create(config.spines + config.leaves);
+        for (uint32_t s = 0; s < config.spines; ++s)
+        {
+            names.push_back("Spine" + std::to_string(s));
+        }
+        for (uint32_t l = 0; l < config.leaves; ++l)
+        {
+            names.push_back("Leaf" + std::to_string(l));
+            edges.push_back(config.spines + l);
+            for (uint32_t s = 0; s < config.spines; ++s)
+            {
+                connectSwitches(config.spines + l, s);
+            }
+        }
+        topology.loops = config.spines > 1 && config.leaves > 1;
+        break;
+    case L2TopologyConfig::RING:
+        topology.switches.Create(config.ringSwitches);
+        for (uint32_t i = 0; i < config.ringSwitches; ++i)
+        {
+            names.push_back("Ring" + std::to_string(i));
+            edges.push_back(i);
+            if (i > 0)
+            {
+                connectSwitches(i, i - 1);
+            }
+        }
+        if (config.ringSwitches > 2)
+        {
+            connectSwitches(0, config.ringSwitches - 1);
+            topology.loops = true;
+        }
+        break;
+    case L2TopologyConfig::FAT_TREE: {
+        // pod p 的边缘交换机 e 是 p*k + e，汇聚交换机 a 是 p*k + k/2 + a，核心交换机 c 是 k*k + c
+        NS_ASSERT_MSG(config.k >= 2 && config.k % 2 == 0, "Fat-tree k must be even");
+        NS_ASSERT_MSG(!config.portland || config.k <= 32, "PortLand supports k <= 32");
+        uint32_t half = config.k / 2;
+        uint32_t cores = half * half;
+        topology.switches.Create(config.k * config.k + cores);
+        for (uint32_t p = 0; p < config.k; ++p)
+        {
+            for (uint32_t e = 0; e < half; ++e)
+            {
+                names.push_back("Edge" + std::to_string(p) + "." + std::to_string(e));
+                locations.emplace_back(L2PortlandTable::EDGE, p, e);
+                edges.push_back(p * config.k + e);
+            }
+            for (uint32_t a = 0; a < half; ++a)
+            {
+                names.push_back("Agg" + std::to_string(p) + "." + std::to_string(a));
+                locations.emplace_back(L2PortlandTable::AGGREGATION, p, a);
+            }
+            for (uint32_t e = 0; e < half; ++e)
+            {
+                for (uint32_t a = 0; a < half; ++a)
+                {
+                    connectSwitches(p * config.k + e, p * config.k + half + a);
+                }
+            }
+        }
+        for (uint32_t c = 0; c < cores; ++c)
+        {
+            names.push_back("Core" + std::to_string(c));
+            locations.emplace_back(L2PortlandTable::CORE, 0, c);
+        }
+        for (uint32_t p = 0; p < config.k; ++p)
+        {
+            for (uint32_t a = 0; a < half; ++a)
+            {
+                for (uint32_t m = 0; m < half; ++m)
+                {
+                    connectSwitches(p * config.k + half + a, config.k * config.k + a * half + m);
+                }
+            }
+        }
+        topology.loops = config.k > 2;
+        break;
+    }
+    }
+
+    // 步骤 2: 主机
+    topology.hosts.Create(static_cast<uint32_t>(edges.size()) * config.hostsPerSwitch);
+    uint32_t h = 0;
+    for (uint32_t sw : edges)
+    {
+        for (uint32_t i = 0; i < config.hostsPerSwitch; ++i, ++h)
+        {
+            NetDeviceContainer devices = connect(topology.hosts.Get(h), topology.switches.Get(sw));
+            topology.hostDevices.Add(devices.Get(0));
+        }
+    }
+
+    // 步骤 3: 安装并初始化交换机，有环路时启用 RSTP (或者按配置启用多路径转发 / PortLand)。
+    // PortLand 在 Initialize() 时读取相邻交换机的位置，所以先配置所有交换机再初始化
+    bool portland = config.portland && config.type == L2TopologyConfig::FAT_TREE;
+    if (portland)
+    {
+        topology.fabricManager = CreateObject<L2FabricManager>();
+    }
+    L2SwitchHelper switchHelper;
+    for (uint32_t i = 0; i < topology.switches.GetN(); ++i)
+    {
+        switchHelper.Install(topology.switches.Get(i), names[i]);
+        Ptr<L2SwitchProtocol> protocol = topology.switches.Get(i)->GetObject<L2SwitchProtocol>();
+        if (portland)
+        {
+            auto [level, pod, position] = locations[i];
+            protocol->SetPortlandLocation(topology.fabricManager, level, pod, position);
+        }
+        else if (config.multipath)
+        {
+            protocol->SetAttribute("EnableMultipath", BooleanValue(true));
+        }
+        else if (topology.loops)
+        {
+            protocol->SetAttribute("EnableRstp", BooleanValue(true));
+        }
+    }
+    for (uint32_t i = 0; i < topology.switches.GetN(); ++i)
+    {
+        topology.switches.Get(i)->GetObject<L2SwitchProtocol>()->Initialize();
+    }
+
+    NS_LOG_INFO("Generated " << Describe(config) << ": " << topology.switches.GetN()
+               << " switches, " << topology.links << " inter-switch links, "
+               << topology.hosts.GetN() << " hosts"
+               << (portland ? " (PortLand)"
+                            : config.multipath ? " (multipath)"
+                                               : (topology.loops ? " (RSTP)" : "")));
+    return topology;
+}
+
+} // namespace ns3
+
+#endif /* L2_TOPOLOGY_H */
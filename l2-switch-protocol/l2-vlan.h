@@ -0,0 +1,206 @@
+/*
+ * ============================================================================
+ * 标题: 802.1Q VLAN 标签 (VLAN Tag)
+ * ============================================================================
+ *
+ * 【设计目的】
+ *   一台交换机上的端口可以划分成多个互相隔离的二层网段 (VLAN):
+ *   - 每个 VLAN 有自己的 MAC 学习表 (同一个 MAC 在不同 VLAN 中可以对应不同端口)
+ *   - 广播和未知单播只泛洪到同一个 VLAN 的成员端口
+ *
+ *   端口有两种模式:
+ *   - Access: 只属于一个 VLAN，收发的都是不带标签的帧 (连接主机)
+ *   - Trunk:  属于多个 VLAN，帧带 802.1Q 标签区分 VLAN (连接交换机)；
+ *             Native VLAN 的帧不带标签
+ *
+ * 【帧格式】
+ *   ns-3 的 CSMA 设备把以太网类型字段交给上层 (protocol 参数)，
+ *   带标签的帧类型为 0x8100，负载以 4 字节的标签开头:
+ *
+ *   字段                长度   说明
+ *   PCP                 3 位   优先级
+ *   DEI                 1 位   可丢弃标记
+ *   VID                 12 位  VLAN ID (1 - 4094)
+ *   EtherType           2      被封装的协议类型 (如 0x0800 = IPv4)
+ *
+ *   这与真实以太网上 802.1Q 帧的字节顺序完全相同。
+ *
+ * 作者: Liu Mengxuan
+ * ns-3 版本: 3.44
+ * ============================================================================
+ */
+
+#ifndef L2_VLAN_H
+#define L2_VLAN_H
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+
+#include <ostream>
+
+namespace ns3
+{
+
+/**
+ * @brief 端口的 VLAN 模式
+ */
+enum L2VlanPortMode : uint8_t
+{
+    L2_VLAN_ACCESS,  // 只属于一个 VLAN，不带标签
+    L2_VLAN_TRUNK    // 属于多个 VLAN，除 Native VLAN 外都带标签
+};
+
+class L2VlanTag : public Header
+{
+public:
+    static constexpr uint16_t PROTOCOL = 0x8100;  // 802.1Q 标签的 EtherType (TPID)
+    static constexpr uint16_t NO_VLAN = 0;        // 优先级标签 / 没有 Native VLAN
+    static constexpr uint16_t DEFAULT_VLAN = 1;   // 未配置端口所在的 VLAN
+    static constexpr uint16_t MAX_VLAN = 4094;    // 最大的合法 VLAN ID (4095 保留)
+
+    L2VlanTag();
+
+    /**
+     * @brief 创建一个标签
+     * @param vid VLAN ID
+     * @param protocol 被封装的协议类型
+     * @param pcp 优先级 (0 - 7)
+     */
+    L2VlanTag(uint16_t vid, uint16_t protocol, uint8_t pcp = 0);
+
+    static TypeId GetTypeId();
+    TypeId GetInstanceTypeId() const override;
+    uint32_t GetSerializedSize() const override;
+    void Serialize(Buffer::Iterator start) const override;
+    uint32_t Deserialize(Buffer::Iterator start) override;
+    void Print(std::ostream& os) const override;
+
+    void SetVid(uint16_t vid);
+    uint16_t GetVid() const;
+    void SetPcp(uint8_t pcp);
+    uint8_t GetPcp() const;
+    void SetDei(bool dei);
+    bool GetDei() const;
+    void SetEncapsulatedProtocol(uint16_t protocol);
+    uint16_t GetEncapsulatedProtocol() const;
+
+private:
+    uint16_t m_tci;       // PCP(3) | DEI(1) | VID(12)
+    uint16_t m_protocol;  // 被封装的协议类型
+};
+
+// ============================================================================
+// 实现
+// ============================================================================
+
+NS_OBJECT_ENSURE_REGISTERED(L2VlanTag);
+
+inline L2VlanTag::L2VlanTag()
+    : m_tci(0),
+      m_protocol(0)
+{
+}
+
+inline L2VlanTag::L2VlanTag(uint16_t vid, uint16_t protocol, uint8_t pcp)
+    : m_tci(static_cast<uint16_t>(((pcp & 0x7) << 13) | (vid & 0x0fff))),
+      m_protocol(protocol)
+{
+}
+
+inline TypeId
+L2VlanTag::GetTypeId()
+{
+    static TypeId tid = TypeId("ns3::L2VlanTag")
+        .SetParent<Header>()
+        .SetGroupName("Network")
+        .AddConstructor<L2VlanTag>();
+    return tid;
+}
+
+inline TypeId
+L2VlanTag::GetInstanceTypeId() const
+{
+    return GetTypeId();
+}
+
+inline uint32_t
+L2VlanTag::GetSerializedSize() const
+{
+    return 4;
+}
+
+inline void
+L2VlanTag::Serialize(Buffer::Iterator start) const
+{
+    Buffer::Iterator i = start;
+    i.WriteHtonU16(m_tci);
+    i.WriteHtonU16(m_protocol);
+}
+
+inline uint32_t
+L2VlanTag::Deserialize(Buffer::Iterator start)
+{
+    Buffer::Iterator i = start;
+    m_tci = i.ReadNtohU16();
+    m_protocol = i.ReadNtohU16();
+    return GetSerializedSize();
+}
+
+inline void
+L2VlanTag::Print(std::ostream& os) const
+{
+    os << "802.1Q vid=" << GetVid() << " pcp=" << unsigned(GetPcp()) << " type=0x" << std::hex
+       << m_protocol << std::dec;
+}
+
+inline void
+L2VlanTag::SetVid(uint16_t vid)
+{
+    m_tci = static_cast<uint16_t>((m_tci & 0xf000) | (vid & 0x0fff));
+}
+
+inline uint16_t
+L2VlanTag::GetVid() const
+{
+    return m_tci & 0x0fff;
+}
+
+inline void
+L2VlanTag::SetPcp(uint8_t pcp)
+{
+    m_tci = static_cast<uint16_t>((m_tci & 0x1fff) | ((pcp & 0x7) << 13));
+}
+
+inline uint8_t
+L2VlanTag::GetPcp() const
+{
+    return static_cast<uint8_t>(m_tci >> 13);
+}
+
+inline void
+L2VlanTag::SetDei(bool dei)
+{
+    m_tci = static_cast<uint16_t>(dei ? (m_tci | 0x1000) : (m_tci & ~0x1000));
+}
+
+inline bool
+L2VlanTag::GetDei() const
+{
+    return (m_tci & 0x1000) != 0;
+}
+
+inline void
+L2VlanTag::SetEncapsulatedProtocol(uint16_t protocol)
+{
+    m_protocol = protocol;
+}
+
+inline uint16_t
+L2VlanTag::GetEncapsulatedProtocol() const
+{
+    return m_protocol;
+}
+
+} // namespace ns3
+
+#endif /* L2_VLAN_H */
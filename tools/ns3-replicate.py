@@ -0,0 +1,369 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+============================================================================
+标题: 按置信区间宽度自动停止的独立重复运行
+============================================================================
+
+【设计目的】
+  单个随机种子的结果带有噪声，固定跑很多次又浪费核。本脚本用一组独立的
+  RngRun 值并行重复运行同一场景，每完成一次就重新计算目标指标的均值和
+  Student-t 置信区间，当区间的相对半宽 (半宽 / |均值|) 不超过给定值时停止，
+  报告均值、置信区间和实际用到的运行次数。
+
+【约定】
+  - 程序参数、--binary / --ns3-dir / --program 与 tools/ns3-sweep.py 相同，
+    每次运行追加 --RngRun=<种子> 和 --summary=<文件>，指标从摘要中读取
+  - 停止判断只使用种子编号连续的前缀 (first-seed 起没有空缺的已完成运行)，
+    因此结果不依赖于哪些运行先结束，避免"跑得快的种子"带来的偏差；
+    停止后仍在运行的进程被终止
+  - 失败的种子 (返回非 0、超时或没有摘要) 不参与统计，在结果表中记录，
+    并由后续种子补足
+  - --metric 可以列出多个指标，全部满足宽度要求才停止
+  - DCN_FatTree 的 --partitions 运行由 LP 0 按五元组合并各分区的记录后写出摘要，
+    跨分区的流同样完整，可以重复；MPI 运行只写各 rank 的部分摘要 (<summary>.rank<N>)，
+    不能用于统计，这些运行会因为没有摘要而失败
+
+【示例】
+  # p99 FCT 的 95% 置信区间相对半宽不超过 5%，至少 5 次、最多 60 次
+  python3 tools/ns3-replicate.py --program DCN_FatTree --metric p99FctUs \\
+      --rel-width 0.05 --min-runs 5 --max-runs 60 \\
+      --args "--k=8 --permutationBytes=1000000 --pcap=false --netanim=false"
+
+作者: Liu Mengxuan
+ns-3 版本: 3.44
+============================================================================
+"""
+
+import argparse
+import concurrent.futures
+import csv
+import importlib.util
+import math
+import os
+import shlex
+import subprocess
+import sys
+import threading
+import time
+
+
+def load_sweep():
+    """加载同目录的 ns3-sweep.py (文件名含连字符，不能直接 import)，复用其中的程序定位和摘要读取"""
+    path = os.path.join(os.path.dirname(os.path.abspath(__file__)), "ns3-sweep.py")
+    spec = importlib.util.spec_from_file_location("ns3_sweep", path)
+    module = importlib.util.module_from_spec(spec)
+    spec.loader.exec_module(module)
+    return module
+
+
+sweep = load_sweep()
+
+
+# ---------------------------------------------------------------------------
+# Student-t 分位数
+# ---------------------------------------------------------------------------
+# 不依赖 scipy: 用正则化不完全 Beta 函数 (连分式展开) 计算 t 分布的 CDF，再二分求分位数
+
+def _betacf(a, b, x):
+    """不完全 Beta 函数的连分式部分 (Lentz 方法)"""
+    tiny = 1e-300
+    c, d = 1.0, 1.0 - (a + b) * x / (a + 1.0)
+    d = 1.0 / (d if abs(d) > tiny else tiny)
+    h = d
+    for m in range(1, 300):
+        m2 = 2 * m
+        aa = m * (b - m) * x / ((a + m2 - 1.0) * (a + m2))
+        d = 1.0 + aa * d
+        d = 1.0 / (d if abs(d) > tiny else tiny)
+        c = 1.0 + aa / c
+        c = c if abs(c) > tiny else tiny
+        h *= d * c
+        aa = -(a + m) * (a + b + m) * x / ((a + m2) * (a + m2 + 1.0))
+        d = 1.0 + aa * d
+        d = 1.0 / (d if abs(d) > tiny else tiny)
+        c = 1.0 + aa / c
+        c = c if abs(c) > tiny else tiny
+        delta = d * c
+        h *= delta
+        if abs(delta - 1.0) < 1e-14:
+            break
+    return h
+
+
+def _betainc(a, b, x):
+    """正则化不完全 Beta 函数 I_x(a, b)"""
+    if x <= 0.0:
+        return 0.0
+    if x >= 1.0:
+        return 1.0
+    front = math.exp(math.lgamma(a + b) - math.lgamma(a) - math.lgamma(b)
+                     + a * math.log(x) + b * math.log(1.0 - x))
+    if x < (a + 1.0) / (a + b + 2.0):
+        return front * _betacf(a, b, x) / a
+    return 1.0 - front * _betacf(b, a, 1.0 - x) / b
+
+
+def t_cdf(t, df):
+    """自由度为 df 的 Student-t 分布 CDF"""
+    tail = 0.5 * _betainc(df / 2.0, 0.5, df / (df + t * t))
+    return 1.0 - tail if t >= 0 else tail
+
+
+def t_quantile(p, df):
+    """Student-t 分布的 p 分位数 (p > 0.5)，二分求解"""
+    lo, hi = 0.0, 1.0
+    while t_cdf(hi, df) < p:
+        hi *= 2.0
+    for _ in range(200):
+        mid = 0.5 * (lo + hi)
+        if t_cdf(mid, df) < p:
+            lo = mid
+        else:
+            hi = mid
+    return 0.5 * (lo + hi)
+
+
+def confidence_interval(values, confidence):
+    """样本均值、标准差和置信区间半宽 (至少两个样本)"""
+    n = len(values)
+    mean = sum(values) / n
+    var = sum((v - mean) ** 2 for v in values) / (n - 1)
+    std = math.sqrt(var)
+    half = t_quantile(0.5 + confidence / 2.0, n - 1) * std / math.sqrt(n)
+    return mean, std, half
+
+
+def relative_width(mean, half):
+    """相对半宽; 均值为 0 时只有零宽度的区间算作收敛"""
+    if mean == 0.0:
+        return 0.0 if half == 0.0 else float("inf")
+    return half / abs(mean)
+
+
+# ---------------------------------------------------------------------------
+# 重复运行控制
+# ---------------------------------------------------------------------------
+
+class Replicator(object):
+    """管理并行的种子运行: 按种子顺序发放任务，收集结果，满足停止条件后终止剩余进程"""
+
+    def __init__(self, command, args, metrics, log):
+        self.command = command
+        self.args = args
+        self.metrics = metrics
+        self.log = log
+        self.lock = threading.Lock()
+        self.stopped = threading.Event()
+        self.procs = set()
+        self.results = {}  # seed -> 结果记录
+
+    def run_seed(self, seed):
+        """运行一个种子; 被停止时返回 None"""
+        if self.stopped.is_set():
+            return None
+        workdir = os.path.join(self.args.out_dir, "seed-%04d" % seed)
+        os.makedirs(workdir, exist_ok=True)
+        summary = os.path.join(workdir, "summary.txt")
+        if os.path.exists(summary):
+            os.remove(summary)
+        argv = list(self.command) + shlex.split(self.args.args)
+        argv += ["--RngRun=%d" % seed, "--summary=" + os.path.abspath(summary)]
+
+        record = {"seed": seed, "status": "", "seconds": 0.0, "metrics": {}}
+        start = time.time()
+        with open(os.path.join(workdir, "stdout.log"), "w") as out:
+            out.write("# " + " ".join(shlex.quote(a) for a in argv) + "\n")
+            out.flush()
+            proc = subprocess.Popen(argv, cwd=workdir, stdout=out, stderr=subprocess.STDOUT)
+            with self.lock:
+                self.procs.add(proc)
+            try:
+                code = proc.wait(timeout=self.args.timeout)
+                status = "exit %d" % code if code != 0 else "ok"
+            except subprocess.TimeoutExpired:
+                proc.kill()
+                proc.wait()
+                status = "timeout"
+            with self.lock:
+                self.procs.discard(proc)
+        record["seconds"] = time.time() - start
+        if self.stopped.is_set() and status != "ok":
+            return None
+        if status == "ok":
+            if not os.path.exists(summary):
+                status = "no summary"
+            else:
+                record["metrics"] = sweep.read_summary(summary)
+                missing = [m for m in self.metrics if m not in record["metrics"]]
+                if missing:
+                    status = "missing " + ",".join(missing)
+        record["status"] = status
+        return record
+
+    def stop(self):
+        """停止发放新任务并终止仍在运行的进程"""
+        self.stopped.set()
+        with self.lock:
+            for proc in self.procs:
+                proc.terminate()
+
+    def prefix(self):
+        """种子编号连续的已完成前缀中成功的运行"""
+        ok = []
+        seed = self.args.first_seed
+        while seed in self.results:
+            if self.results[seed]["status"] == "ok":
+                ok.append(self.results[seed])
+            seed += 1
+        return ok
+
+    def evaluate(self):
+        """对前缀计算每个指标的统计量; 返回 (统计表, 是否全部收敛)"""
+        runs = self.prefix()
+        stats = {}
+        converged = len(runs) >= max(2, self.args.min_runs)
+        for name in self.metrics:
+            values = [float(r["metrics"][name]) for r in runs]
+            if len(values) < 2:
+                stats[name] = (len(values), values[0] if values else float("nan"), 0.0,
+                               float("inf"), float("inf"))
+                converged = False
+                continue
+            mean, std, half = confidence_interval(values, self.args.confidence)
+            rel = relative_width(mean, half)
+            stats[name] = (len(values), mean, std, half, rel)
+            if rel > self.args.rel_width:
+                converged = False
+        return stats, converged
+
+
+def print_stats(stats, confidence):
+    """打印每个指标的均值、标准差、置信区间和相对半宽"""
+    header = ["metric", "runs", "mean", "stddev", "ci%d_low" % round(confidence * 100),
+              "ci%d_high" % round(confidence * 100), "rel_halfwidth"]
+    rows = [header]
+    for name, (n, mean, std, half, rel) in stats.items():
+        rows.append([name, str(n), "%.6g" % mean, "%.6g" % std, "%.6g" % (mean - half),
+                     "%.6g" % (mean + half), "%.4f" % rel])
+    widths = [max(len(row[i]) for row in rows) for i in range(len(header))]
+    for n, row in enumerate(rows):
+        print("  ".join(cell.rjust(w) for cell, w in zip(row, widths)))
+        if n == 0:
+            print("  ".join("-" * w for w in widths))
+
+
+def write_runs(path, metrics, records):
+    """每个种子一行: 种子、状态、耗时、目标指标"""
+    with open(path, "w", newline="") as f:
+        writer = csv.writer(f)
+        writer.writerow(["seed", "status", "seconds"] + metrics)
+        for r in records:
+            writer.writerow([r["seed"], r["status"], "%.3f" % r["seconds"]]
+                            + [r["metrics"].get(m, "") for m in metrics])
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Replicate an ns-3 scenario over independent RngRun values in parallel "
+                    "until the confidence interval of the target metrics is narrow enough.")
+    target = parser.add_argument_group("program")
+    target.add_argument("--binary", help="path of the built executable")
+    target.add_argument("--ns3-dir", default=".",
+                        help="ns-3 root used to build and locate --program (default: .)")
+    target.add_argument("--program", default="DCN_FatTree",
+                        help="ns-3 program name, e.g. DCN_FatTree or l2-switch-protocol")
+    parser.add_argument("--args", default="", help="fixed arguments passed to every run")
+    parser.add_argument("--metric", default="p99FctUs",
+                        help="comma-separated summary metrics to converge (default: p99FctUs)")
+    parser.add_argument("--confidence", type=float, default=0.95,
+                        help="confidence level of the interval (default: 0.95)")
+    parser.add_argument("--rel-width", type=float, default=0.05,
+                        help="stop when half-width / |mean| <= this (default: 0.05)")
+    parser.add_argument("--min-runs", type=int, default=5,
+                        help="successful runs required before stopping (default: 5)")
+    parser.add_argument("--max-runs", type=int, default=100,
+                        help="upper bound on launched runs (default: 100)")
+    parser.add_argument("--first-seed", type=int, default=1,
+                        help="first RngRun value; later runs use consecutive values (default: 1)")
+    parser.add_argument("--jobs", type=int, default=os.cpu_count() or 1,
+                        help="concurrent runs (default: number of cores)")
+    parser.add_argument("--timeout", type=float, default=None,
+                        help="per-run timeout in seconds (default: none)")
+    parser.add_argument("--out-dir", default="replicate-out",
+                        help="directory for per-seed working directories (default: replicate-out)")
+    args = parser.parse_args()
+
+    metrics = [m for m in args.metric.split(",") if m]
+    if not metrics:
+        parser.error("--metric must name at least one summary metric")
+    if not 0.0 < args.confidence < 1.0:
+        parser.error("--confidence must be in (0, 1)")
+    if args.rel_width <= 0.0:
+        parser.error("--rel-width must be positive")
+    if args.jobs < 1 or args.max_runs < 2 or args.min_runs > args.max_runs:
+        parser.error("need --jobs >= 1 and 2 <= --min-runs <= --max-runs")
+
+    os.makedirs(args.out_dir, exist_ok=True)
+    command = sweep.resolve_command(args)
+
+    print_lock = threading.Lock()
+
+    def log(message):
+        with print_lock:
+            print(message, file=sys.stderr, flush=True)
+
+    rep = Replicator(command, args, metrics, log)
+    jobs = min(args.jobs, args.max_runs)
+    log("replicating with %d workers, target %s within %.1f%% at %.0f%% confidence"
+        % (jobs, ",".join(metrics), args.rel_width * 100, args.confidence * 100))
+
+    start = time.time()
+    next_seed = args.first_seed
+    last_seed = args.first_seed + args.max_runs - 1
+    converged = False
+    stats = {}
+    with concurrent.futures.ThreadPoolExecutor(max_workers=jobs) as pool:
+        pending = set()
+        # 始终保持 jobs 个运行在进行中，直到收敛或达到 --max-runs
+        while True:
+            while not rep.stopped.is_set() and len(pending) < jobs and next_seed <= last_seed:
+                pending.add(pool.submit(rep.run_seed, next_seed))
+                next_seed += 1
+            if not pending:
+                break
+            done, pending = concurrent.futures.wait(
+                pending, return_when=concurrent.futures.FIRST_COMPLETED)
+            for future in done:
+                record = future.result()
+                if record is None:
+                    continue
+                rep.results[record["seed"]] = record
+                if record["status"] != "ok":
+                    log("seed %d failed (%s), see %s" % (record["seed"], record["status"],
+                        os.path.join(args.out_dir, "seed-%04d" % record["seed"], "stdout.log")))
+            if rep.stopped.is_set():
+                continue
+            stats, converged = rep.evaluate()
+            first = stats[metrics[0]]
+            log("%d/%d runs in prefix, %s mean %.6g, relative half-width %.4f"
+                % (first[0], len(rep.results), metrics[0], first[1], first[4]))
+            if converged:
+                rep.stop()
+
+    stats, converged = rep.evaluate()
+    records = [rep.results[s] for s in sorted(rep.results)]
+    write_runs(os.path.join(args.out_dir, "runs.csv"), metrics, records)
+    print_stats(stats, args.confidence)
+    used = len(rep.prefix())
+    failed = sum(1 for r in records if r["status"] != "ok")
+    log("%s after %d runs (%d failed) in %.1f s, per-seed results in %s"
+        % ("converged" if converged else "NOT converged", used, failed, time.time() - start,
+           os.path.join(args.out_dir, "runs.csv")))
+    if used < 2:
+        return 1
+    return 0 if converged else 2
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,208 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+============================================================================
+标题: DCN_FatTree 单机并行仿真的实测加速比
+============================================================================
+
+【设计目的】
+  --partitions=N 运行结束时 FatTreeShmSimulatorImpl 只输出估计加速比
+  (各 LP busy 时间之和 / 墙钟时间)，它忽略了缓存效应和分区本身带来的额外工作。
+  本脚本在同一场景上先运行顺序仿真 (--partitions=0)，再运行各个分区数，
+  用墙钟时间之比得到实测加速比，并与同一次运行的同步开销占比、估计加速比并列输出。
+
+【约定】
+  - --binary / --ns3-dir / --program 与 tools/ns3-sweep.py 相同，
+    --args 中的固定参数对所有运行相同，脚本只改变 --k 和 --partitions
+  - 各次运行依次执行而不是并行，避免互相争用核心影响墙钟时间；
+    --repeat 大于 1 时每个点重复运行，取最短的墙钟时间
+  - 墙钟时间、同步时间从程序输出中读取:
+      顺序仿真  "rank 0: ... wall time <秒> s"
+      并行仿真  "<N> partitions: wall time <秒> s"，
+                "  lp <i>: ... busy <秒> s, sync <秒> s (...)"，
+                "  estimated speedup over sequential: <倍数>x"
+  - 同步占比为所有 LP 的 sync 之和 / (busy + sync) 之和，最大值为单个 LP 的最大占比
+  - 每次运行在独立的工作目录 (<out>/k<k>-p<N>/) 中进行，标准输出写入该目录的 stdout.log
+
+【示例】
+  # k=8 和 k=16，顺序仿真与 2、4、8 个分区
+  python3 tools/ns3-speedup.py --program DCN_FatTree --k 8,16 --partitions 2,4,8 \\
+      --args "--permutationBytes=1000000 --pcap=false --netanim=false"
+
+作者: Liu Mengxuan
+ns-3 版本: 3.44
+============================================================================
+"""
+
+import argparse
+import csv
+import importlib.util
+import os
+import re
+import shlex
+import subprocess
+import sys
+import time
+
+
+def load_sweep():
+    """加载同目录的 ns3-sweep.py (文件名含连字符，不能直接 import)，复用其中的程序定位和结果表打印"""
+    path = os.path.join(os.path.dirname(os.path.abspath(__file__)), "ns3-sweep.py")
+    spec = importlib.util.spec_from_file_location("ns3_sweep", path)
+    module = importlib.util.module_from_spec(spec)
+    spec.loader.exec_module(module)
+    return module
+
+
+sweep = load_sweep()
+
+NUMBER = r"([0-9.eE+-]+)"
+SEQUENTIAL_WALL = re.compile(r"^rank 0: .*wall time " + NUMBER + r" s")
+PARALLEL_WALL = re.compile(r"^\d+ partitions: wall time " + NUMBER + r" s")
+LP_LINE = re.compile(r"^\s+lp (\d+): .*busy " + NUMBER + r" s, sync " + NUMBER + r" s")
+ESTIMATED = re.compile(r"estimated speedup over sequential: " + NUMBER + r"x")
+
+
+def parse_output(text, partitions):
+    """从程序输出中取出墙钟时间、各 LP 的 busy/sync 时间和估计加速比; 找不到墙钟时间时返回 None"""
+    result = {"wall": None, "busy": [], "sync": [], "estimated": None}
+    wall = SEQUENTIAL_WALL if partitions == 0 else PARALLEL_WALL
+    for line in text.splitlines():
+        m = wall.search(line)
+        if m:
+            result["wall"] = float(m.group(1))
+            continue
+        m = LP_LINE.search(line)
+        if m:
+            result["busy"].append(float(m.group(2)))
+            result["sync"].append(float(m.group(3)))
+            continue
+        m = ESTIMATED.search(line)
+        if m:
+            result["estimated"] = float(m.group(1))
+    if result["wall"] is None or (partitions > 0 and not result["busy"]):
+        return None
+    return result
+
+
+def run_point(command, args, k, partitions, log):
+    """运行一个 (k, 分区数) 点 --repeat 次，返回墙钟时间最短的一次的解析结果; 全部失败时返回 None"""
+    workdir = os.path.join(args.out_dir, "k%s-p%d" % (k, partitions))
+    os.makedirs(workdir, exist_ok=True)
+    argv = list(command) + ["--k=%s" % k, "--partitions=%d" % partitions] + shlex.split(args.args)
+    command_line = " ".join(shlex.quote(a) for a in argv)
+
+    best = None
+    for attempt in range(1, args.repeat + 1):
+        name = "stdout.log" if args.repeat == 1 else "stdout.%d.log" % attempt
+        log_path = os.path.join(workdir, name)
+        start = time.time()
+        try:
+            proc = subprocess.run(argv, cwd=workdir, stdout=subprocess.PIPE,
+                                  stderr=subprocess.STDOUT, universal_newlines=True,
+                                  timeout=args.timeout)
+            output, status = proc.stdout, "exit %d" % proc.returncode if proc.returncode else "ok"
+        except subprocess.TimeoutExpired as e:
+            output, status = e.stdout or "", "timeout"
+            if isinstance(output, bytes):
+                output = output.decode(errors="replace")
+        with open(log_path, "w") as f:
+            f.write("# " + command_line + "\n")
+            f.write(output)
+        parsed = parse_output(output, partitions) if status == "ok" else None
+        if parsed is None:
+            reason = status if status != "ok" else "no wall time in output"
+            log("k=%s partitions=%d run %d failed (%s), see %s" % (k, partitions, attempt, reason,
+                                                                 log_path))
+            continue
+        log("k=%s partitions=%d run %d: wall %.3f s (%.1f s total)" % (k, partitions, attempt,
+                                                                     parsed["wall"],
+                                                                     time.time() - start))
+        if best is None or parsed["wall"] < best["wall"]:
+            best = parsed
+    return best
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Run DCN_FatTree sequentially and on N shared-memory partitions on the same "
+                    "scenario and print the measured wall-time speedup next to the sync share.")
+    target = parser.add_argument_group("program")
+    target.add_argument("--binary", help="path of the built executable")
+    target.add_argument("--ns3-dir", default=".",
+                        help="ns-3 root used to build and locate --program (default: .)")
+    target.add_argument("--program", default="DCN_FatTree", help="ns-3 program name")
+    parser.add_argument("--k", default="8,16",
+                        help="comma-separated Fat-Tree sizes (default: 8,16)")
+    parser.add_argument("--partitions", default="2,4,8",
+                        help="comma-separated partition counts compared with --partitions=0 "
+                             "(default: 2,4,8)")
+    parser.add_argument("--args", default="", help="fixed arguments appended to every run")
+    parser.add_argument("--repeat", type=int, default=1,
+                        help="runs per point; the shortest wall time is used (default: 1)")
+    parser.add_argument("--timeout", type=float, default=None,
+                        help="per-run timeout in seconds (default: none)")
+    parser.add_argument("--out-dir", default="speedup-out",
+                        help="directory for per-run working directories (default: speedup-out)")
+    parser.add_argument("--results", default=None,
+                        help="CSV table (default: <out-dir>/speedup.csv)")
+    args = parser.parse_args()
+
+    ks = [v for v in args.k.split(",") if v]
+    try:
+        counts = sorted({int(v) for v in args.partitions.split(",") if v})
+    except ValueError:
+        parser.error("--partitions expects comma-separated integers")
+    if not ks or not counts or counts[0] < 1:
+        parser.error("--k and --partitions need at least one value, partitions must be positive")
+    if args.repeat < 1:
+        parser.error("--repeat must be at least 1")
+    for a in shlex.split(args.args):
+        if a.startswith(("--k=", "--partitions=")):
+            parser.error("--args must not set --k or --partitions (" + a + ")")
+
+    os.makedirs(args.out_dir, exist_ok=True)
+    results = args.results or os.path.join(args.out_dir, "speedup.csv")
+    command = sweep.resolve_command(args)
+
+    def log(message):
+        print(message, file=sys.stderr, flush=True)
+
+    header = ["k", "partitions", "wallSeconds", "measuredSpeedup", "estimatedSpeedup",
+              "syncShare%", "maxLpSyncShare%"]
+    rows = []
+    failed = 0
+    for k in ks:
+        sequential = run_point(command, args, k, 0, log)
+        if sequential is None:
+            rows.append([k, 0, "", "", "", "", ""])
+            failed += 1
+            continue
+        rows.append([k, 0, "%.3f" % sequential["wall"], "1.00", "", "", ""])
+        for n in counts:
+            parallel = run_point(command, args, k, n, log)
+            if parallel is None:
+                rows.append([k, n, "", "", "", "", ""])
+                failed += 1
+                continue
+            busy, sync = sum(parallel["busy"]), sum(parallel["sync"])
+            estimated = parallel["estimated"]
+            shares = [100.0 * s / (b + s) if b + s > 0 else 0.0
+                      for b, s in zip(parallel["busy"], parallel["sync"])]
+            measured = sequential["wall"] / parallel["wall"] if parallel["wall"] > 0 else 0.0
+            rows.append([k, n, "%.3f" % parallel["wall"], "%.2f" % measured,
+                         "%.2f" % estimated if estimated is not None else "",
+                         "%.1f" % (100.0 * sync / (busy + sync) if busy + sync > 0 else 0.0),
+                         "%.1f" % max(shares)])
+
+    with open(results, "w", newline="") as f:
+        writer = csv.writer(f)
+        writer.writerow(header)
+        writer.writerows(rows)
+    sweep.print_table(results, [])
+    log("%d/%d points succeeded, results in %s" % (len(rows) - failed, len(rows), results))
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,275 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+============================================================================
+标题: ns-3 仿真程序的并行参数扫描
+============================================================================
+
+【设计目的】
+  DCN_FatTree 和 l2-switch-protocol 的每次运行都是单线程的，手工循环调用
+  只能用到一个核。本脚本展开参数网格，把每个参数点作为独立进程放进一个
+  大小等于核数的工作池并行运行，最后把各次运行的摘要合并成一张结果表。
+
+【约定】
+  - 每个参数点以 --name=value 的形式传给程序，ns-3 的全局值也可以扫描
+    (例如 RngRun 即随机数的独立运行编号)
+  - 程序通过 --summary=<文件> 写出 name=value 行的摘要，
+    DCN_FatTree 和 l2-switch-protocol 都支持
+  - 每个参数点在独立的工作目录中运行 (<out>/<编号>/)，避免 flowmon、pcap 等输出互相覆盖，
+    标准输出和标准错误写入该目录的 stdout.log
+  - 进程返回非 0、超时或没有写出摘要时视为失败，重试 --retries 次后跳过，
+    结果表中记录失败状态
+
+【示例】
+  # 在 ns-3 根目录下运行: k 与 ECMP 开关、两种核心队列、5 个随机种子
+  python3 tools/ns3-sweep.py --ns3-dir ~/ns-3.44 --program DCN_FatTree \\
+      --param k=4,8 --param ECMProuting=true,false --param coreQueue=8,32 \\
+      --param permutationBytes=100000 --param RngRun=1:5 \\
+      --args "--pcap=false --netanim=false"
+
+作者: Liu Mengxuan
+ns-3 版本: 3.44
+============================================================================
+"""
+
+import argparse
+import concurrent.futures
+import csv
+import itertools
+import os
+import shlex
+import subprocess
+import sys
+import threading
+import time
+
+
+def parse_values(text):
+    """解析一个参数的取值: "a,b,c" 逐个列出，"lo:hi" 或 "lo:hi:step" 为整数闭区间"""
+    if ":" in text and "," not in text:
+        parts = text.split(":")
+        if len(parts) in (2, 3) and all(p.lstrip("-").isdigit() for p in parts):
+            lo, hi = int(parts[0]), int(parts[1])
+            step = int(parts[2]) if len(parts) == 3 else 1
+            if step <= 0:
+                raise ValueError("range step must be positive: " + text)
+            return [str(v) for v in range(lo, hi + 1, step)]
+    return [v for v in text.split(",") if v != ""]
+
+
+def expand_grid(params):
+    """参数 [(name, [values])] 的笛卡尔积，按给出的顺序展开 (最后一个参数变化最快)"""
+    names = [name for name, _ in params]
+    grid = []
+    for combo in itertools.product(*[values for _, values in params]):
+        grid.append(dict(zip(names, combo)))
+    return grid
+
+
+def read_summary(path):
+    """读取 name=value 行的摘要，保持行的顺序"""
+    metrics = {}
+    with open(path) as f:
+        for line in f:
+            line = line.strip()
+            if not line or line.startswith("#") or "=" not in line:
+                continue
+            name, value = line.split("=", 1)
+            metrics[name.strip()] = value.strip()
+    return metrics
+
+
+def resolve_command(args):
+    """得到可执行程序的命令前缀: 直接给出 --binary，或者通过 ns3 脚本构建并查询程序路径"""
+    if args.binary:
+        return [os.path.abspath(args.binary)]
+
+    ns3 = os.path.join(os.path.abspath(args.ns3_dir), "ns3")
+    if not os.path.exists(ns3):
+        sys.exit("ns3 script not found in %s (use --ns3-dir or --binary)" % args.ns3_dir)
+    # 只构建一次；之后每个参数点直接运行可执行文件，不经过 ns3 脚本 (它会检查构建并串行化)
+    subprocess.run([ns3, "build", args.program], cwd=args.ns3_dir, check=True)
+    out = subprocess.run([ns3, "run", "--no-build", args.program, "--command-template=echo %s"],
+                         cwd=args.ns3_dir, check=True, stdout=subprocess.PIPE,
+                         universal_newlines=True).stdout
+    lines = [l for l in out.splitlines() if l.strip()]
+    if not lines or not os.path.exists(lines[-1].strip()):
+        sys.exit("cannot locate the executable of %s (got %r)" % (args.program, out))
+    return [lines[-1].strip()]
+
+
+def run_point(index, point, command, args, log):
+    """运行一个参数点，失败时重试; 返回结果记录 (参数、状态、尝试次数、耗时、摘要指标)"""
+    workdir = os.path.join(args.out_dir, "%04d" % index)
+    os.makedirs(workdir, exist_ok=True)
+    summary = os.path.join(workdir, "summary.txt")
+    record = {"index": index, "params": point, "status": "", "attempts": 0, "seconds": 0.0,
+              "metrics": {}}
+
+    argv = list(command)
+    argv += ["--%s=%s" % (name, value) for name, value in point.items()]
+    argv += shlex.split(args.args)
+    argv.append("--summary=" + os.path.abspath(summary))
+
+    # --resume: 已有摘要、且上次运行的命令行与本次完全相同的参数点不再运行;
+    # 编号只表示网格中的位置，参数列表改变后同一编号对应的是另一个参数点
+    command_file = os.path.join(workdir, "command.txt")
+    command_line = " ".join(shlex.quote(a) for a in argv)
+    if args.resume and os.path.exists(summary) and os.path.exists(command_file):
+        with open(command_file) as f:
+            if f.read().strip() == command_line:
+                record["status"] = "ok"
+                record["metrics"] = read_summary(summary)
+                return record
+    with open(command_file, "w") as f:
+        f.write(command_line + "\n")
+
+    for attempt in range(1, args.retries + 2):
+        record["attempts"] = attempt
+        if os.path.exists(summary):
+            os.remove(summary)
+        start = time.time()
+        with open(os.path.join(workdir, "stdout.log"), "w") as out:
+            out.write("# " + command_line + "\n")
+            out.flush()
+            try:
+                proc = subprocess.run(argv, cwd=workdir, stdout=out, stderr=subprocess.STDOUT,
+                                      timeout=args.timeout)
+                status = "exit %d" % proc.returncode if proc.returncode != 0 else "ok"
+            except subprocess.TimeoutExpired:
+                status = "timeout"
+        record["seconds"] = time.time() - start
+        if status == "ok" and not os.path.exists(summary):
+            status = "no summary"
+        record["status"] = status
+        if status == "ok":
+            record["metrics"] = read_summary(summary)
+            return record
+        log("point %d attempt %d failed (%s), see %s" % (index, attempt, status,
+                                                       os.path.join(workdir, "stdout.log")))
+    return record
+
+
+def write_results(path, params, records):
+    """合并所有参数点为一张 CSV 表: 编号、参数列、状态、尝试次数、耗时、各指标列 (按首次出现的顺序)"""
+    metric_names = []
+    for r in records:
+        for name in r["metrics"]:
+            if name not in metric_names:
+                metric_names.append(name)
+    header = ["index"] + params + ["status", "attempts", "seconds"] + metric_names
+    with open(path, "w", newline="") as f:
+        writer = csv.writer(f)
+        writer.writerow(header)
+        for r in records:
+            row = [r["index"]] + [r["params"][p] for p in params]
+            row += [r["status"], r["attempts"], "%.3f" % r["seconds"]]
+            row += [r["metrics"].get(m, "") for m in metric_names]
+            writer.writerow(row)
+    return header
+
+
+def print_table(path, columns):
+    """把结果 CSV 以对齐的文本表格打印出来; columns 非空时只打印这些列"""
+    with open(path, newline="") as f:
+        rows = list(csv.reader(f))
+    if not rows:
+        return
+    header = rows[0]
+    keep = [i for i, name in enumerate(header) if not columns or name in columns]
+    rows = [[row[i] for i in keep] for row in rows]
+    widths = [max(len(row[i]) for row in rows) for i in range(len(keep))]
+    for n, row in enumerate(rows):
+        print("  ".join(cell.rjust(w) for cell, w in zip(row, widths)))
+        if n == 0:
+            print("  ".join("-" * w for w in widths))
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Run an ns-3 program over a parameter grid on a bounded worker pool "
+                    "and merge the per-run summaries into one table.")
+    target = parser.add_argument_group("program")
+    target.add_argument("--binary", help="path of the built executable")
+    target.add_argument("--ns3-dir", default=".",
+                        help="ns-3 root used to build and locate --program (default: .)")
+    target.add_argument("--program", default="DCN_FatTree",
+                        help="ns-3 program name, e.g. DCN_FatTree or l2-switch-protocol")
+    parser.add_argument("--param", action="append", default=[], metavar="NAME=VALUES",
+                        help="grid axis; VALUES is a,b,c or an integer range lo:hi[:step] "
+                             "(repeatable)")
+    parser.add_argument("--args", default="", help="fixed arguments appended to every run")
+    parser.add_argument("--jobs", type=int, default=os.cpu_count() or 1,
+                        help="concurrent runs (default: number of cores)")
+    parser.add_argument("--retries", type=int, default=1,
+                        help="retries of a failed point before it is skipped (default: 1)")
+    parser.add_argument("--timeout", type=float, default=None,
+                        help="per-run timeout in seconds (default: none)")
+    parser.add_argument("--out-dir", default="sweep-out",
+                        help="directory for per-run working directories (default: sweep-out)")
+    parser.add_argument("--results", default=None,
+                        help="merged CSV table (default: <out-dir>/results.csv)")
+    parser.add_argument("--show", default="",
+                        help="comma-separated columns to print (default: all)")
+    parser.add_argument("--resume", action="store_true",
+                        help="reuse points whose summary already exists in --out-dir "
+                             "and whose command line is unchanged")
+    parser.add_argument("--dry-run", action="store_true",
+                        help="print the expanded grid and exit")
+    args = parser.parse_args()
+
+    params = []
+    for spec in args.param:
+        if "=" not in spec:
+            parser.error("--param expects NAME=VALUES, got " + spec)
+        name, text = spec.split("=", 1)
+        values = parse_values(text)
+        if not values:
+            parser.error("no values for parameter " + name)
+        params.append((name, values))
+    grid = expand_grid(params)
+    names = [name for name, _ in params]
+    if args.jobs < 1:
+        parser.error("--jobs must be at least 1")
+
+    if args.dry_run:
+        for index, point in enumerate(grid):
+            print("%04d  %s" % (index, " ".join("--%s=%s" % kv for kv in point.items())))
+        print("%d points" % len(grid))
+        return 0
+
+    os.makedirs(args.out_dir, exist_ok=True)
+    results = args.results or os.path.join(args.out_dir, "results.csv")
+    command = resolve_command(args)
+
+    lock = threading.Lock()
+
+    def log(message):
+        with lock:
+            print(message, file=sys.stderr, flush=True)
+
+    jobs = min(args.jobs, max(1, len(grid)))
+    log("%d points, %d workers: %s" % (len(grid), jobs, " ".join(command)))
+    start = time.time()
+    records = []
+    with concurrent.futures.ThreadPoolExecutor(max_workers=jobs) as pool:
+        futures = [pool.submit(run_point, i, point, command, args, log)
+                   for i, point in enumerate(grid)]
+        for done, future in enumerate(concurrent.futures.as_completed(futures), 1):
+            record = future.result()
+            records.append(record)
+            log("[%d/%d] point %d %s in %.1f s" % (done, len(grid), record["index"],
+                                                  record["status"], record["seconds"]))
+    records.sort(key=lambda r: r["index"])
+
+    write_results(results, names, records)
+    print_table(results, [c for c in args.show.split(",") if c])
+    failed = [r for r in records if r["status"] != "ok"]
+    log("%d/%d points succeeded in %.1f s, results in %s" % (len(records) - len(failed),
+                                                          len(records), time.time() - start,
+                                                          results))
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())